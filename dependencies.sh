@@ -107,6 +107,7 @@ SYSTEM_PACKAGES="build-essential \
                   libibverbs-dev \
                   libgoogle-glog-dev \
                   libgtest-dev \
+                  libbenchmark-dev \
                   libjsoncpp-dev \
                   libunwind-dev \
                   libnuma-dev \
@@ -119,6 +120,8 @@ SYSTEM_PACKAGES="build-essential \
                   protobuf-compiler-grpc \
                   libcurl4-openssl-dev \
                   libhiredis-dev \
+                  zlib1g-dev \
+                  libxxhash-dev \
                   pkg-config \
                   patchelf"
 
@@ -2,12 +2,16 @@
 
 #include <netinet/in.h>
 #include <pybind11/gil.h>  // For GIL management
+#include <pybind11/stl.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include <cstdlib>  // for atexit
 #include <random>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "trace.h"
 #include "types.h"
 
 namespace py = pybind11;
@@ -33,6 +37,32 @@ class SliceGuard {
     std::vector<Slice> slices_;
 };
 
+// The batch APIs key their slices by object key, so keys must be unique
+static bool hasDuplicateKeys(const std::vector<std::string> &keys) {
+    std::unordered_set<std::string> seen;
+    for (const auto &key : keys) {
+        if (!seen.insert(key).second) {
+            LOG(ERROR) << "Duplicate key not supported for batch API, key: "
+                       << key;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Split a buffer into slices of at most kMaxSliceSize bytes
+static std::vector<Slice> splitIntoSlices(void *buffer, size_t size) {
+    std::vector<Slice> slices;
+    uint64_t offset = 0;
+    while (offset < size) {
+        auto chunk_size = std::min(size - offset, kMaxSliceSize);
+        void *chunk_ptr = static_cast<char *>(buffer) + offset;
+        slices.emplace_back(Slice{chunk_ptr, chunk_size});
+        offset += chunk_size;
+    }
+    return slices;
+}
+
 // ResourceTracker implementation using singleton pattern
 ResourceTracker &ResourceTracker::getInstance() {
     static ResourceTracker instance;
@@ -187,6 +217,9 @@ int DistributedObjectStore::setup(const std::string &local_hostname,
                    << toString(error_code);
         return 1;
     }
+    // Large get_buffer() results are cached up to the local buffer size
+    large_buffer_pool_ =
+        std::make_unique<LargeBufferPool>(client_, local_buffer_size);
     // Skip mount segment if global_segment_size is 0
     if (global_segment_size == 0) {
         return 0;
@@ -301,8 +334,7 @@ int DistributedObjectStore::allocateSlices(
     length = 0;
     if (object_info.replica_list.empty()) return -1;
     auto &replica = object_info.replica_list[0];
-    for (auto &handle : replica.buffer_descriptors) {
-        auto chunk_size = handle.size_;
+    for (auto chunk_size : replica.data_slice_sizes()) {
         assert(chunk_size <= kMaxSliceSize);
         auto ptr = client_buffer_allocator_->allocate(chunk_size);
         if (!ptr) {
@@ -314,16 +346,15 @@ int DistributedObjectStore::allocateSlices(
     return 0;
 }
 
-char *DistributedObjectStore::exportSlices(
-    const std::vector<mooncake::Slice> &slices, uint64_t length) {
-    char *buf = new char[length + 1];
-    buf[length] = '\0';
-    uint64_t offset = 0;
-    for (auto slice : slices) {
-        memcpy(buf + offset, slice.ptr, slice.size);
-        offset += slice.size;
+void *DistributedObjectStore::allocateBuffer(uint64_t size,
+                                             bool &use_allocator_free) {
+    // SimpleAllocator cannot hand out more than one slab contiguously
+    if (size <= kMaxSliceSize) {
+        use_allocator_free = true;
+        return client_buffer_allocator_->allocate(size);
     }
-    return buf;
+    use_allocator_free = false;
+    return large_buffer_pool_->allocate(size);
 }
 
 int DistributedObjectStore::freeSlices(
@@ -339,7 +370,8 @@ int DistributedObjectStore::tearDownAll() {
         LOG(ERROR) << "Client is not initialized";
         return 1;
     }
-    // Reset all resources
+    // Reset all resources. The pool unregisters its buffers via the client.
+    large_buffer_pool_.reset();
     client_.reset();
     client_buffer_allocator_.reset();
     segment_ptr_.reset();
@@ -411,8 +443,6 @@ pybind11::bytes DistributedObjectStore::get(const std::string &key) {
     SliceGuard guard(*this);  // Use SliceGuard for RAII
     uint64_t str_length = 0;
     ErrorCode error_code;
-    char *exported_str_ptr = nullptr;
-    bool use_exported_str = false;
 
     const auto kNullString = pybind11::bytes("\0", 0);
 
@@ -436,33 +466,33 @@ pybind11::bytes DistributedObjectStore::get(const std::string &key) {
             py::gil_scoped_acquire acquire_gil;
             return kNullString;
         }
-
-        if (guard.slices().size() == 1 &&
-            guard.slices()[0].size == str_length) {
-        } else {
-            exported_str_ptr = exportSlices(guard.slices(), str_length);
-            if (!exported_str_ptr) {
-                py::gil_scoped_acquire acquire_gil;
-                return kNullString;
-            }
-            use_exported_str = true;
-        }
     }
 
-    py::gil_scoped_acquire acquire_gil;
-
-    pybind11::bytes result;
-    if (use_exported_str) {
-        result = pybind11::bytes(exported_str_ptr, str_length);
-        delete[] exported_str_ptr;
-    } else if (!guard.slices().empty()) {
-        result = pybind11::bytes(static_cast<char *>(guard.slices()[0].ptr),
-                                 str_length);
-    } else {
-        result = kNullString;
+    if (guard.slices().empty()) {
+        return kNullString;
     }
 
-    return result;
+    // A bytes object owns its storage, so gather the slices straight into it.
+    // Use get_buffer() to avoid this copy altogether.
+    PyObject *bytes =
+        PyBytes_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(str_length));
+    if (!bytes) {
+        PyErr_Clear();
+        LOG(ERROR) << "Failed to allocate bytes of size " << str_length
+                   << " for key: " << key;
+        return kNullString;
+    }
+    char *dest = PyBytes_AS_STRING(bytes);
+    {
+        // The bytes object is not visible to other threads yet
+        py::gil_scoped_release release_gil;
+        uint64_t offset = 0;
+        for (const auto &slice : guard.slices()) {
+            memcpy(dest + offset, slice.ptr, slice.size);
+            offset += slice.size;
+        }
+    }
+    return py::reinterpret_steal<py::bytes>(bytes);
 }
 
 int DistributedObjectStore::remove(const std::string &key) {
@@ -475,6 +505,21 @@ int DistributedObjectStore::remove(const std::string &key) {
     return 0;
 }
 
+std::vector<int> DistributedObjectStore::batchRemove(
+    const std::vector<std::string> &keys) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return std::vector<int>(keys.size(), -1);
+    }
+    std::vector<int> results;
+    results.reserve(keys.size());
+    for (ErrorCode error_code : client_->BatchRemove(keys)) {
+        results.push_back(error_code == ErrorCode::OK ? 0
+                                                      : toInt(error_code));
+    }
+    return results;
+}
+
 long DistributedObjectStore::removeAll() {
     if (!client_) {
         LOG(ERROR) << "Client is not initialized";
@@ -494,6 +539,52 @@ int DistributedObjectStore::isExist(const std::string &key) {
     return toInt(err);                                 // Error
 }
 
+std::vector<int> DistributedObjectStore::batchIsExist(
+    const std::vector<std::string> &keys) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return std::vector<int>(keys.size(), -1);
+    }
+    std::vector<int> results;
+    results.reserve(keys.size());
+    for (ErrorCode err : client_->BatchIsExist(keys)) {
+        if (err == ErrorCode::OK) {
+            results.push_back(1);  // Yes
+        } else if (err == ErrorCode::OBJECT_NOT_FOUND) {
+            results.push_back(0);  // No
+        } else {
+            results.push_back(toInt(err));  // Error
+        }
+    }
+    return results;
+}
+
+int64_t DistributedObjectStore::longestCachedPrefix(
+    const std::vector<std::string> &keys) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return -1;
+    }
+    size_t prefix_length = 0;
+    ErrorCode err = client_->LongestCachedPrefix(keys, prefix_length);
+    if (err != ErrorCode::OK) {
+        return toInt(err);
+    }
+    return static_cast<int64_t>(prefix_length);
+}
+
+std::string DistributedObjectStore::getMetrics() {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return "";
+    }
+    return client_->GetMetrics();
+}
+
+int DistributedObjectStore::dumpTrace(const std::string &path) {
+    return mooncake::Tracer::instance().dumpChromeTrace(path);
+}
+
 int64_t DistributedObjectStore::getSize(const std::string &key) {
     if (!client_) {
         LOG(ERROR) << "Client is not initialized";
@@ -510,10 +601,7 @@ int64_t DistributedObjectStore::getSize(const std::string &key) {
     // Calculate total size from all replicas' handles
     int64_t total_size = 0;
     if (!object_info.replica_list.empty()) {
-        auto &replica = object_info.replica_list[0];
-        for (auto &handle : replica.buffer_descriptors) {
-            total_size += handle.size_;
-        }
+        total_size = object_info.replica_list[0].data_size();
     } else {
         LOG(ERROR) << "Internal error: object_info.replica_list_size() is 0";
         return -1;  // Internal error
@@ -522,6 +610,78 @@ int64_t DistributedObjectStore::getSize(const std::string &key) {
     return total_size;
 }
 
+// LargeBufferPool implementation
+LargeBufferPool::LargeBufferPool(std::shared_ptr<mooncake::Client> client,
+                                 size_t max_cached_bytes)
+    : client_(std::move(client)), max_cached_bytes_(max_cached_bytes) {}
+
+LargeBufferPool::~LargeBufferPool() {
+    for (auto &[capacity, buffers] : free_buffers_) {
+        for (void *ptr : buffers) {
+            releaseBuffer(ptr);
+        }
+    }
+}
+
+size_t LargeBufferPool::capacityOf(size_t size) {
+    size_t capacity = kBufferAlignment;
+    while (capacity < size) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+void *LargeBufferPool::allocate(size_t size) {
+    const size_t capacity = capacityOf(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = free_buffers_.find(capacity);
+        if (it != free_buffers_.end() && !it->second.empty()) {
+            void *ptr = it->second.back();
+            it->second.pop_back();
+            cached_bytes_ -= capacity;
+            return ptr;
+        }
+    }
+
+    void *ptr = std::aligned_alloc(kBufferAlignment, capacity);
+    if (!ptr) {
+        LOG(ERROR) << "Failed to allocate large buffer of size " << capacity;
+        return nullptr;
+    }
+    ErrorCode error_code = client_->RegisterLocalMemory(
+        ptr, capacity, kWildcardLocation, false, false);
+    if (error_code != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to register large buffer: "
+                   << toString(error_code);
+        free(ptr);
+        return nullptr;
+    }
+    return ptr;
+}
+
+void LargeBufferPool::deallocate(void *ptr, size_t size) {
+    const size_t capacity = capacityOf(size);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cached_bytes_ + capacity <= max_cached_bytes_) {
+            free_buffers_[capacity].push_back(ptr);
+            cached_bytes_ += capacity;
+            return;
+        }
+    }
+    releaseBuffer(ptr);
+}
+
+void LargeBufferPool::releaseBuffer(void *ptr) {
+    ErrorCode error_code = client_->unregisterLocalMemory(ptr, false);
+    if (error_code != ErrorCode::OK) {
+        LOG(WARNING) << "Failed to unregister large buffer: "
+                     << toString(error_code);
+    }
+    free(ptr);
+}
+
 // SliceBuffer implementation
 SliceBuffer::SliceBuffer(DistributedObjectStore &store, void *buffer,
                          uint64_t size, bool use_allocator_free)
@@ -533,11 +693,17 @@ SliceBuffer::SliceBuffer(DistributedObjectStore &store, void *buffer,
 SliceBuffer::~SliceBuffer() {
     if (buffer_) {
         if (use_allocator_free_) {
-            // Use SimpleAllocator to deallocate memory
-            store_.client_buffer_allocator_->deallocate(buffer_, size_);
+            // Use SimpleAllocator to deallocate memory. The allocator frees
+            // its whole region itself if the store was torn down first.
+            if (store_.client_buffer_allocator_) {
+                store_.client_buffer_allocator_->deallocate(buffer_, size_);
+            }
+        } else if (store_.large_buffer_pool_) {
+            // Return the registered buffer for reuse
+            store_.large_buffer_pool_->deallocate(buffer_, size_);
         } else {
-            // Use delete[] for memory allocated with new[]
-            delete[] static_cast<char *>(buffer_);
+            // The pool and client are gone, only the memory is left
+            free(buffer_);
         }
         buffer_ = nullptr;
     }
@@ -556,7 +722,6 @@ std::shared_ptr<SliceBuffer> DistributedObjectStore::get_buffer(
     }
 
     mooncake::Client::ObjectInfo object_info;
-    SliceGuard guard(*this);  // Use SliceGuard for RAII
     uint64_t total_length = 0;
     ErrorCode error_code;
     std::shared_ptr<SliceBuffer> result = nullptr;
@@ -572,33 +737,40 @@ std::shared_ptr<SliceBuffer> DistributedObjectStore::get_buffer(
         return nullptr;
     }
 
-    // Allocate slices for the object using the guard
-    int ret = allocateSlices(guard.slices(), object_info, total_length);
-    if (ret) {
-        LOG(ERROR) << "Failed to allocate slices for key: " << key;
+    if (object_info.replica_list.empty()) {
+        LOG(ERROR) << "Internal error: replica_list is empty for key: " << key;
         return nullptr;
     }
+    total_length = object_info.replica_list[0].data_size();
+
+    // Read straight into one contiguous registered buffer owned by the
+    // returned SliceBuffer, so Python can view the data without any copy
+    bool use_allocator_free = true;
+    void *buffer = allocateBuffer(total_length, use_allocator_free);
+    if (!buffer) {
+        LOG(ERROR) << "Failed to allocate buffer of size " << total_length
+                   << " for key: " << key;
+        return nullptr;
+    }
+    result = std::make_shared<SliceBuffer>(*this, buffer, total_length,
+                                           use_allocator_free);
+
+    std::vector<Slice> slices;
+    uint64_t offset = 0;
+    for (auto chunk_size : object_info.replica_list[0].data_slice_sizes()) {
+        slices.emplace_back(
+            Slice{static_cast<char *>(buffer) + offset, chunk_size});
+        offset += chunk_size;
+    }
 
     // Get the object data
-    error_code = client_->Get(key, object_info, guard.slices());
+    error_code = client_->Get(key, object_info, slices);
     if (error_code != ErrorCode::OK) {
         LOG(ERROR) << "Get failed for key: " << key
                    << " with error: " << toString(error_code);
         return nullptr;
     }
 
-    if (guard.slices().size() == 1) {
-        auto ptr = guard.slices()[0].ptr;
-        guard.slices().clear();
-        // Use SimpleAllocator for deallocation (default behavior)
-        result = std::make_shared<SliceBuffer>(*this, ptr, total_length, true);
-    } else {
-        auto contiguous_buffer = exportSlices(guard.slices(), total_length);
-        // Use delete[] for deallocation since exportSlices uses new char[]
-        result = std::make_shared<SliceBuffer>(*this, contiguous_buffer,
-                                               total_length, false);
-    }
-
     return result;
 }
 
@@ -649,9 +821,7 @@ int DistributedObjectStore::get_into(const std::string &key, void *buffer,
     }
 
     auto &replica = object_info.replica_list[0];
-    for (auto &handle : replica.buffer_descriptors) {
-        total_size += handle.size_;
-    }
+    total_size = replica.data_size();
 
     // Check if user buffer is large enough
     if (size < total_size) {
@@ -664,8 +834,7 @@ int DistributedObjectStore::get_into(const std::string &key, void *buffer,
     std::vector<mooncake::Slice> slices;
     uint64_t offset = 0;
 
-    for (auto &handle : replica.buffer_descriptors) {
-        auto chunk_size = handle.size_;
+    for (auto chunk_size : replica.data_slice_sizes()) {
         void *chunk_ptr = static_cast<char *>(buffer) + offset;
         slices.emplace_back(Slice{chunk_ptr, chunk_size});
         offset += chunk_size;
@@ -721,6 +890,181 @@ int DistributedObjectStore::put_from(const std::string &key, void *buffer,
     return 0;
 }
 
+std::vector<int> DistributedObjectStore::batch_get_into(
+    const std::vector<std::string> &keys, const std::vector<void *> &buffers,
+    const std::vector<size_t> &sizes) {
+    // NOTE: The buffer addresses must be previously registered with
+    // register_buffer() for zero-copy RDMA operations to work correctly
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return std::vector<int>(keys.size(), -1);
+    }
+    if (keys.size() != buffers.size() || keys.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched batch sizes, keys: " << keys.size()
+                   << ", buffers: " << buffers.size()
+                   << ", sizes: " << sizes.size();
+        return std::vector<int>(keys.size(), -1);
+    }
+    if (keys.empty()) {
+        return {};
+    }
+    if (hasDuplicateKeys(keys)) {
+        return std::vector<int>(keys.size(), -1);
+    }
+
+    // Step 1: Get object info of all keys in one request
+    mooncake::Client::BatchObjectInfo batched_object_info;
+    ErrorCode error_code = client_->BatchQuery(keys, batched_object_info);
+    if (error_code != ErrorCode::OK) {
+        LOG(ERROR) << "BatchQuery failed with error: " << toString(error_code);
+        return std::vector<int>(keys.size(), toInt(error_code));
+    }
+
+    // Step 2: Split each user buffer according to its object info
+    std::vector<int> results(keys.size(), -1);
+    std::vector<std::string> valid_keys;
+    std::vector<size_t> valid_indices;
+    std::unordered_map<std::string, std::vector<Slice>> batched_slices;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const auto &replica_list =
+            batched_object_info.batch_replica_list[keys[i]];
+        if (replica_list.empty()) {
+            LOG(ERROR) << "Internal error: replica_list is empty for key: "
+                       << keys[i];
+            continue;
+        }
+
+        uint64_t total_size = 0;
+        std::vector<Slice> slices;
+        for (auto chunk_size : replica_list[0].data_slice_sizes()) {
+            void *chunk_ptr = static_cast<char *>(buffers[i]) + total_size;
+            slices.emplace_back(Slice{chunk_ptr, chunk_size});
+            total_size += chunk_size;
+        }
+        if (sizes[i] < total_size) {
+            LOG(ERROR) << "User buffer too small for key: " << keys[i]
+                       << ". Required: " << total_size
+                       << ", provided: " << sizes[i];
+            continue;
+        }
+
+        results[i] = static_cast<int>(total_size);
+        valid_keys.push_back(keys[i]);
+        valid_indices.push_back(i);
+        batched_slices.emplace(keys[i], std::move(slices));
+    }
+
+    // Step 3: Read all objects directly into the user buffers
+    if (!valid_keys.empty()) {
+        error_code =
+            client_->BatchGet(valid_keys, batched_object_info, batched_slices);
+        if (error_code != ErrorCode::OK) {
+            LOG(ERROR) << "BatchGet failed with error: "
+                       << toString(error_code);
+            for (size_t i : valid_indices) {
+                results[i] = toInt(error_code);
+            }
+        }
+    }
+    return results;
+}
+
+int DistributedObjectStore::batch_put_from(const std::vector<std::string> &keys,
+                                           const std::vector<void *> &buffers,
+                                           const std::vector<size_t> &sizes) {
+    // NOTE: The buffer addresses must be previously registered with
+    // register_buffer() for zero-copy RDMA operations to work correctly
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return -1;
+    }
+    if (keys.size() != buffers.size() || keys.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched batch sizes, keys: " << keys.size()
+                   << ", buffers: " << buffers.size()
+                   << ", sizes: " << sizes.size();
+        return -1;
+    }
+    if (hasDuplicateKeys(keys)) {
+        return -1;
+    }
+
+    // Create slices directly from the user buffers
+    std::vector<std::string> put_keys;
+    std::unordered_map<std::string, std::vector<Slice>> batched_slices;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (sizes[i] == 0) {
+            LOG(WARNING) << "Attempting to put empty data for key: "
+                         << keys[i];
+            continue;
+        }
+        put_keys.push_back(keys[i]);
+        batched_slices.emplace(keys[i], splitIntoSlices(buffers[i], sizes[i]));
+    }
+    if (put_keys.empty()) {
+        return 0;
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 1;  // Make configurable
+    config.preferred_segment = this->local_hostname;
+
+    ErrorCode error_code = client_->BatchPut(put_keys, batched_slices, config);
+    if (error_code != ErrorCode::OK) {
+        LOG(ERROR) << "BatchPut operation failed with error: "
+                   << toString(error_code);
+        return toInt(error_code);
+    }
+    return 0;
+}
+
+int DistributedObjectStore::batch_put(
+    const std::vector<std::string> &keys,
+    const std::vector<std::span<const char>> &values) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return -1;
+    }
+    if (keys.size() != values.size()) {
+        LOG(ERROR) << "Mismatched batch sizes, keys: " << keys.size()
+                   << ", values: " << values.size();
+        return -1;
+    }
+    if (keys.empty()) {
+        return 0;
+    }
+    if (hasDuplicateKeys(keys)) {
+        return -1;
+    }
+
+    // The guards free the staging slices once the batch is done
+    std::vector<std::unique_ptr<SliceGuard>> guards;
+    guards.reserve(keys.size());
+    std::unordered_map<std::string, std::vector<Slice>> batched_slices;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        guards.emplace_back(std::make_unique<SliceGuard>(*this));
+        int ret = allocateSlices(guards.back()->slices(), values[i]);
+        if (ret) {
+            LOG(ERROR) << "Failed to allocate slices for batch put operation, "
+                          "key: "
+                       << keys[i] << ", value size: " << values[i].size();
+            return -1;
+        }
+        batched_slices.emplace(keys[i], guards.back()->slices());
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 1;  // Make configurable
+    config.preferred_segment = this->local_hostname;
+
+    ErrorCode error_code = client_->BatchPut(keys, batched_slices, config);
+    if (error_code != ErrorCode::OK) {
+        LOG(ERROR) << "BatchPut operation failed with error: "
+                   << toString(error_code);
+        return toInt(error_code);
+    }
+    return 0;
+}
+
 PYBIND11_MODULE(store, m) {
     // Define the SliceBuffer class
     py::class_<SliceBuffer, std::shared_ptr<SliceBuffer>>(m, "SliceBuffer",
@@ -771,13 +1115,24 @@ PYBIND11_MODULE(store, m) {
              py::return_value_policy::take_ownership)
         .def("remove", &DistributedObjectStore::remove,
              py::call_guard<py::gil_scoped_release>())
+        .def("batch_remove", &DistributedObjectStore::batchRemove,
+             py::call_guard<py::gil_scoped_release>(), py::arg("keys"))
         .def("remove_all", &DistributedObjectStore::removeAll,
              py::call_guard<py::gil_scoped_release>())
         .def("is_exist", &DistributedObjectStore::isExist,
              py::call_guard<py::gil_scoped_release>())
+        .def("batch_is_exist", &DistributedObjectStore::batchIsExist,
+             py::call_guard<py::gil_scoped_release>(), py::arg("keys"))
+        .def("longest_cached_prefix",
+             &DistributedObjectStore::longestCachedPrefix,
+             py::call_guard<py::gil_scoped_release>(), py::arg("keys"))
         .def("close", &DistributedObjectStore::tearDownAll)
         .def("get_size", &DistributedObjectStore::getSize,
              py::call_guard<py::gil_scoped_release>())
+        .def("get_metrics", &DistributedObjectStore::getMetrics,
+             py::call_guard<py::gil_scoped_release>())
+        .def("dump_trace", &DistributedObjectStore::dumpTrace,
+             py::arg("path"), py::call_guard<py::gil_scoped_release>())
         .def(
             "register_buffer",
             [](DistributedObjectStore &self, uintptr_t buffer_ptr,
@@ -811,6 +1166,61 @@ PYBIND11_MODULE(store, m) {
             },
             py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
             "Put object data directly from a pre-allocated buffer")
+        .def(
+            "batch_get_into",
+            [](DistributedObjectStore &self,
+               const std::vector<std::string> &keys,
+               const std::vector<uintptr_t> &buffer_ptrs,
+               const std::vector<size_t> &sizes) {
+                // Get data of all keys directly into user-provided buffers
+                std::vector<void *> buffers;
+                buffers.reserve(buffer_ptrs.size());
+                for (uintptr_t ptr : buffer_ptrs) {
+                    buffers.push_back(reinterpret_cast<void *>(ptr));
+                }
+                py::gil_scoped_release release;
+                return self.batch_get_into(keys, buffers, sizes);
+            },
+            py::arg("keys"), py::arg("buffer_ptrs"), py::arg("sizes"),
+            "Get a batch of objects directly into pre-allocated buffers")
+        .def(
+            "batch_put_from",
+            [](DistributedObjectStore &self,
+               const std::vector<std::string> &keys,
+               const std::vector<uintptr_t> &buffer_ptrs,
+               const std::vector<size_t> &sizes) {
+                // Put data of all keys directly from user-provided buffers
+                std::vector<void *> buffers;
+                buffers.reserve(buffer_ptrs.size());
+                for (uintptr_t ptr : buffer_ptrs) {
+                    buffers.push_back(reinterpret_cast<void *>(ptr));
+                }
+                py::gil_scoped_release release;
+                return self.batch_put_from(keys, buffers, sizes);
+            },
+            py::arg("keys"), py::arg("buffer_ptrs"), py::arg("sizes"),
+            "Put a batch of objects directly from pre-allocated buffers")
+        .def(
+            "batch_put",
+            [](DistributedObjectStore &self,
+               const std::vector<std::string> &keys, py::list values) {
+                // Hold the buffer views until the put is done
+                std::vector<py::buffer_info> infos;
+                std::vector<std::span<const char>> spans;
+                infos.reserve(values.size());
+                spans.reserve(values.size());
+                for (auto &obj : values) {
+                    py::buffer buf = py::reinterpret_borrow<py::buffer>(obj);
+                    infos.emplace_back(buf.request(/*writable=*/false));
+                    spans.emplace_back(
+                        static_cast<const char *>(infos.back().ptr),
+                        static_cast<size_t>(infos.back().size));
+                }
+                py::gil_scoped_release release;
+                return self.batch_put(keys, spans);
+            },
+            py::arg("keys"), py::arg("values"),
+            "Put a batch of bytes-like objects in one request")
         .def("put",
              [](DistributedObjectStore &self, const std::string &key,
                 py::buffer buf) {
@@ -5,7 +5,9 @@
 #include <csignal>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "allocator.h"
 #include "client.h"
@@ -50,6 +52,55 @@ class ResourceTracker {
     std::unordered_set<DistributedObjectStore *> instances_;
 };
 
+/**
+ * @brief Cache of registered buffers for values larger than one slice
+ *
+ * SimpleAllocator hands out at most kMaxSliceSize contiguous bytes. Larger
+ * get_buffer() results are read into buffers from this pool instead. Buffers
+ * are rounded up to a power of two and kept registered with the transfer
+ * engine while cached, so registration is paid once per size class rather
+ * than once per get.
+ */
+class LargeBufferPool {
+   public:
+    /**
+     * @param client Client the buffers are registered with
+     * @param max_cached_bytes Upper bound on the total size of idle buffers
+     */
+    LargeBufferPool(std::shared_ptr<mooncake::Client> client,
+                    size_t max_cached_bytes);
+    ~LargeBufferPool();
+
+    LargeBufferPool(const LargeBufferPool &) = delete;
+    LargeBufferPool &operator=(const LargeBufferPool &) = delete;
+
+    /**
+     * @brief Get a registered buffer of at least size bytes
+     * @return Pointer to the buffer, or nullptr on failure
+     */
+    void *allocate(size_t size);
+
+    /**
+     * @brief Return a buffer obtained from allocate() with the same size
+     */
+    void deallocate(void *ptr, size_t size);
+
+   private:
+    static constexpr size_t kBufferAlignment = 4096;
+
+    static size_t capacityOf(size_t size);
+
+    // Unregister and free a buffer
+    void releaseBuffer(void *ptr);
+
+    std::shared_ptr<mooncake::Client> client_;
+    const size_t max_cached_bytes_;
+
+    std::mutex mutex_;
+    std::unordered_map<size_t, std::vector<void *>> free_buffers_;
+    size_t cached_bytes_ = 0;
+};
+
 /**
  * @brief A class that holds a contiguous buffer of data
  * This class is responsible for freeing the buffer when it's destroyed (RAII)
@@ -63,7 +114,7 @@ class SliceBuffer {
      * @param buffer Pointer to the contiguous buffer
      * @param size Size of the buffer in bytes
      * @param use_allocator_free If true, use SimpleAllocator to free the
-     * buffer, otherwise use delete[]
+     * buffer, otherwise return it to the LargeBufferPool
      */
     SliceBuffer(DistributedObjectStore &store, void *buffer, uint64_t size,
                 bool use_allocator_free = true);
@@ -141,6 +192,41 @@ class DistributedObjectStore {
     int put_parts(const std::string &key,
                   std::vector<std::span<const char>> values);
 
+    /**
+     * @brief Get a batch of objects directly into pre-allocated buffers
+     * @param keys Keys of the objects to get, without duplicates
+     * @param buffers Pointers to the pre-allocated buffers, one per key (must
+     * be registered with register_buffer)
+     * @param sizes Sizes of the buffers
+     * @return Per-key number of bytes read on success, negative value on error
+     * @note All transfers are submitted before waiting for any of them
+     */
+    std::vector<int> batch_get_into(const std::vector<std::string> &keys,
+                                    const std::vector<void *> &buffers,
+                                    const std::vector<size_t> &sizes);
+
+    /**
+     * @brief Put a batch of objects directly from pre-allocated buffers
+     * @param keys Keys of the objects to put, without duplicates
+     * @param buffers Pointers to the buffers containing data, one per key
+     * (must be registered with register_buffer)
+     * @param sizes Sizes of the data to put
+     * @return 0 on success, negative value on error
+     */
+    int batch_put_from(const std::vector<std::string> &keys,
+                       const std::vector<void *> &buffers,
+                       const std::vector<size_t> &sizes);
+
+    /**
+     * @brief Put a batch of objects in one request
+     * @param keys Keys of the objects to put, without duplicates
+     * @param values Values of the objects, one per key. They are staged in
+     * the registered client buffer like in put().
+     * @return 0 on success, negative value on error
+     */
+    int batch_put(const std::vector<std::string> &keys,
+                  const std::vector<std::span<const char>> &values);
+
     pybind11::bytes get(const std::string &key);
 
     /**
@@ -148,11 +234,20 @@ class DistributedObjectStore {
      * @param key Key to get data for
      * @return std::shared_ptr<SliceBuffer> Buffer containing the data, or
      * nullptr if error
+     * @note The data is read directly into the returned registered buffer and
+     * is exposed through the buffer protocol without further copies
      */
     std::shared_ptr<SliceBuffer> get_buffer(const std::string &key);
 
     int remove(const std::string &key);
 
+    /**
+     * @brief Remove a batch of objects in one request
+     * @param keys Keys to remove
+     * @return Per-key result, 0 if removed, error code otherwise
+     */
+    std::vector<int> batchRemove(const std::vector<std::string> &keys);
+
     long removeAll();
 
     int tearDownAll();
@@ -164,6 +259,22 @@ class DistributedObjectStore {
      */
     int isExist(const std::string &key);
 
+    /**
+     * @brief Check if a batch of objects exist in one request
+     * @param keys Keys to check
+     * @return Per-key result, 1 if exists, 0 if not exists, error code
+     * otherwise
+     */
+    std::vector<int> batchIsExist(const std::vector<std::string> &keys);
+
+    /**
+     * @brief Find how many leading blocks of a KV cache chain are stored, in
+     * one request
+     * @param keys Block keys, first block first
+     * @return Length of the cached prefix, error code (negative) if error
+     */
+    int64_t longestCachedPrefix(const std::vector<std::string> &keys);
+
     /**
      * @brief Get the size of an object
      * @param key Key of the object
@@ -172,6 +283,21 @@ class DistributedObjectStore {
      */
     int64_t getSize(const std::string &key);
 
+    /**
+     * @brief Get the metrics of the client
+     * @return Metrics in Prometheus text format, empty if the client is not
+     * initialized
+     */
+    std::string getMetrics();
+
+    /**
+     * @brief Write the spans of sampled requests of this process to a file
+     * in Chrome trace format
+     * @param path File to write
+     * @return 0 on success, -1 on error
+     */
+    int dumpTrace(const std::string &path);
+
    private:
     int allocateSlices(std::vector<mooncake::Slice> &slices,
                        const std::string &value);
@@ -186,8 +312,13 @@ class DistributedObjectStore {
     int allocateSlicesPacked(std::vector<mooncake::Slice> &slices,
                              const std::vector<std::span<const char>> &parts);
 
-    char *exportSlices(const std::vector<mooncake::Slice> &slices,
-                       uint64_t length);
+    /**
+     * @brief Allocate one contiguous registered buffer
+     * @param size Size of the buffer
+     * @param use_allocator_free Set to true if the buffer came from
+     * client_buffer_allocator_, false if from large_buffer_pool_
+     */
+    void *allocateBuffer(uint64_t size, bool &use_allocator_free);
 
     int freeSlices(const std::vector<mooncake::Slice> &slices);
 
@@ -195,6 +326,7 @@ class DistributedObjectStore {
     std::shared_ptr<mooncake::Client> client_ = nullptr;
     std::unique_ptr<mooncake::SimpleAllocator> client_buffer_allocator_ =
         nullptr;
+    std::unique_ptr<LargeBufferPool> large_buffer_pool_ = nullptr;
     struct SegmentDeleter {
         void operator()(void *ptr) {
             if (ptr) {
@@ -0,0 +1,122 @@
+// Measures the latency of spilling objects to and reading them back from the
+// disk tier, and compares a disk hit with recomputing the KV cache it holds.
+//
+//   ./disk_tier_bench --path=/mnt/nvme/bench --sizes=1048576,16777216
+//
+// The recompute cost is modelled from the prefill throughput: an object of
+// size bytes holds size / kv_bytes_per_token tokens. The defaults correspond
+// to Llama-70B in fp16 (80 layers, 8 KV heads of dim 128).
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "disk_tier.h"
+
+DEFINE_string(path, "/tmp/disk_tier_bench", "Backing file of the disk tier");
+DEFINE_uint64(capacity_mb, 4096, "Size of the backing file in MB");
+DEFINE_string(sizes, "262144,1048576,4194304,16777216,67108864",
+              "Comma separated object sizes");
+DEFINE_int32(iterations, 50, "Objects written and read per size");
+DEFINE_uint64(kv_bytes_per_token, 327680, "KV cache bytes per token");
+DEFINE_double(prefill_tokens_per_sec, 10000,
+              "Prefill throughput used to model the recompute latency");
+
+namespace mooncake {
+namespace {
+
+std::vector<size_t> ParseList(const std::string& value) {
+    std::vector<size_t> list;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            list.push_back(std::stoul(item));
+        }
+    }
+    return list;
+}
+
+double ElapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+double Percentile(std::vector<double> samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    return samples[idx];
+}
+
+int Run() {
+    auto tier =
+        DiskTier::Create(FLAGS_path, FLAGS_capacity_mb * 1024 * 1024);
+    if (!tier) {
+        return 1;
+    }
+    if (!tier->direct_io()) {
+        LOG(WARNING) << "O_DIRECT is not supported on " << FLAGS_path
+                     << ", reads may be served from the page cache";
+    }
+
+    printf("%-10s %-12s %-12s %-12s %-12s %-14s %-8s\n", "size", "write_p50",
+           "read_p50", "read_p99", "read_GB/s", "recompute_us", "speedup");
+    for (size_t size : ParseList(FLAGS_sizes)) {
+        std::vector<char> data(size, 'x');
+        std::vector<Slice> slices = {{data.data(), data.size()}};
+        std::vector<uint64_t> offsets;
+        std::vector<double> writes;
+        std::vector<double> reads;
+        for (int i = 0; i < FLAGS_iterations; ++i) {
+            uint64_t offset = 0;
+            auto start = std::chrono::steady_clock::now();
+            if (tier->Write(slices, offset) != ErrorCode::OK) {
+                LOG(WARNING) << "Disk tier full after " << i << " objects of "
+                             << size << " bytes";
+                break;
+            }
+            writes.push_back(ElapsedUs(start));
+            offsets.push_back(offset);
+        }
+        // Read in write order, so that no object is hot in a device cache
+        for (uint64_t offset : offsets) {
+            auto start = std::chrono::steady_clock::now();
+            if (tier->Read(offset, slices) != ErrorCode::OK) {
+                LOG(ERROR) << "Read failed at offset " << offset;
+                return 1;
+            }
+            reads.push_back(ElapsedUs(start));
+        }
+        for (uint64_t offset : offsets) {
+            tier->Free(offset);
+        }
+        if (reads.empty()) {
+            continue;
+        }
+
+        double read_p50 = Percentile(reads, 0.5);
+        double tokens = static_cast<double>(size) / FLAGS_kv_bytes_per_token;
+        double recompute_us = tokens / FLAGS_prefill_tokens_per_sec * 1e6;
+        printf("%-10zu %-12.1f %-12.1f %-12.1f %-12.2f %-14.1f %-8.2f\n", size,
+               Percentile(writes, 0.5), read_p50, Percentile(reads, 0.99),
+               size / read_p50 / 1e3, recompute_us, recompute_us / read_p50);
+    }
+    return 0;
+}
+
+}  // namespace
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    return mooncake::Run();
+}
@@ -0,0 +1,310 @@
+// Measures the CPU cost of MasterService operations without the RPC layer,
+// at 1 to --max_threads threads, so that lock contention and scaling
+// regressions show up in isolation. Built if Google Benchmark is installed.
+//
+// Every benchmark runs against a service holding --num_keys objects spread
+// over --num_segments segments. The segments are fake address ranges, the
+// master never touches the memory it hands out. E.g.
+//   ./master_service_bench --num_keys=100000,1000000 --max_threads=64 \
+//       --benchmark_filter=GetReplicaList
+// Google Benchmark flags (--benchmark_*) are accepted as well.
+
+#include <benchmark/benchmark.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "master_service.h"
+#include "types.h"
+
+DEFINE_string(num_keys, "100000,1000000",
+              "Comma separated numbers of objects held by the service");
+DEFINE_int32(num_segments, 64, "Number of mounted segments");
+DEFINE_uint64(segment_size_gb, 16, "Size of each segment in GB");
+DEFINE_uint64(value_size, 4096, "Size of each object");
+DEFINE_int32(max_threads, 64, "Run with 1, 2, 4, ... up to this many threads");
+DEFINE_int32(batch_size, 16, "Keys per BatchGetReplicaList");
+DEFINE_double(evict_ratio, 0.01, "Ratio evicted by each BatchEvict");
+
+namespace mooncake {
+
+// Reaches the background tasks of MasterService, which are private
+class MasterServiceBench {
+   public:
+    static void BatchEvict(MasterService& service, double ratio) {
+        service.BatchEvict(ratio);
+    }
+    static void ClearInvalidHandles(MasterService& service) {
+        service.ClearInvalidHandles();
+    }
+};
+
+namespace {
+
+// Far away from anything mapped, nothing is ever accessed there
+constexpr uintptr_t kSegmentBase = 0x100000000000;
+
+std::string KeyName(uint64_t index) { return "key_" + std::to_string(index); }
+
+ErrorCode PutObject(MasterService& service, const std::string& key) {
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+    ErrorCode err = service.PutStart(key, FLAGS_value_size, {FLAGS_value_size},
+                                     config, replica_list);
+    if (err != ErrorCode::OK) return err;
+    return service.PutEnd(key);
+}
+
+// A service holding num_keys objects. It is kept between the runs of the
+// benchmarks, which leave the objects in place unless they mark it dirty.
+struct Fixture {
+    uint64_t num_keys = 0;
+    bool dirty = true;
+    std::unique_ptr<MasterService> service;
+    UUID client_id;
+    uint64_t next_segment = 0;  // Index of the next segment to mount
+
+    // Called by thread 0 before the other threads start measuring
+    MasterService& Prepare(uint64_t keys) {
+        if (service && !dirty && num_keys == keys) {
+            return *service;
+        }
+        service.reset();
+        // Leases expire at once, so that objects can be removed and evicted
+        service = std::make_unique<MasterService>(
+            /*enable_gc=*/false, /*default_kv_lease_ttl=*/0,
+            /*eviction_ratio=*/FLAGS_evict_ratio);
+        client_id = generate_uuid();
+        next_segment = 0;
+        for (int i = 0; i < FLAGS_num_segments; ++i) {
+            CHECK_EQ(MountNext(), ErrorCode::OK) << "Failed to mount segment";
+        }
+        for (uint64_t i = 0; i < keys; ++i) {
+            CHECK_EQ(PutObject(*service, KeyName(i)), ErrorCode::OK)
+                << "Failed to put " << KeyName(i);
+        }
+        num_keys = keys;
+        dirty = false;
+        return *service;
+    }
+
+    Segment NextSegment() {
+        const size_t size = FLAGS_segment_size_gb << 30;
+        uint64_t index = next_segment++;
+        return Segment(generate_uuid(), "segment_" + std::to_string(index),
+                       kSegmentBase + index * size, size);
+    }
+
+    ErrorCode MountNext() {
+        return service->MountSegment(NextSegment(), client_id);
+    }
+};
+
+Fixture g_fixture;
+
+// Per-thread random key choice
+class KeyPicker {
+   public:
+    KeyPicker(const benchmark::State& state)
+        : rng_(state.thread_index()), keys_(0, state.range(0) - 1) {}
+    std::string Next() { return KeyName(keys_(rng_)); }
+
+   private:
+    std::mt19937_64 rng_;
+    std::uniform_int_distribution<uint64_t> keys_;
+};
+
+void BM_PutStartEnd(benchmark::State& state) {
+    static std::atomic<uint64_t> next_writer{0};
+    static MasterService* service;
+    if (state.thread_index() == 0) {
+        service = &g_fixture.Prepare(state.range(0));
+    }
+    // Keys are new for every thread of every run, the objects written are
+    // left behind
+    const std::string prefix = "put_" + std::to_string(next_writer++) + "_";
+    uint64_t i = 0;
+    for (auto _ : state) {
+        if (PutObject(*service, prefix + std::to_string(i++)) !=
+            ErrorCode::OK) {
+            state.SkipWithError("PutStart/PutEnd failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetReplicaList(benchmark::State& state) {
+    static MasterService* service;
+    if (state.thread_index() == 0) {
+        service = &g_fixture.Prepare(state.range(0));
+    }
+    KeyPicker keys(state);
+    std::vector<Replica::Descriptor> replica_list;
+    for (auto _ : state) {
+        replica_list.clear();
+        benchmark::DoNotOptimize(
+            service->GetReplicaList(keys.Next(), replica_list));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BatchGetReplicaList(benchmark::State& state) {
+    static MasterService* service;
+    if (state.thread_index() == 0) {
+        service = &g_fixture.Prepare(state.range(0));
+    }
+    KeyPicker keys(state);
+    std::vector<std::string> batch(FLAGS_batch_size);
+    std::unordered_map<std::string, std::vector<Replica::Descriptor>>
+        batch_replica_list;
+    for (auto _ : state) {
+        for (auto& key : batch) key = keys.Next();
+        batch_replica_list.clear();
+        benchmark::DoNotOptimize(
+            service->BatchGetReplicaList(batch, batch_replica_list));
+    }
+    state.SetItemsProcessed(state.iterations() * FLAGS_batch_size);
+}
+
+void BM_Remove(benchmark::State& state) {
+    static std::atomic<uint64_t> run{0};
+    static MasterService* service;
+    if (state.thread_index() == 0) {
+        service = &g_fixture.Prepare(state.range(0));
+        ++run;
+        // Objects to remove, written before any thread starts measuring
+        for (int t = 0; t < state.threads(); ++t) {
+            for (benchmark::IterationCount i = 0; i < state.max_iterations;
+                 ++i) {
+                std::string key = "remove_" + std::to_string(run.load()) +
+                                  "_" + std::to_string(t) + "_" +
+                                  std::to_string(i);
+                CHECK_EQ(PutObject(*service, key), ErrorCode::OK);
+            }
+        }
+    }
+    std::string prefix;
+    uint64_t i = 0;
+    for (auto _ : state) {
+        if (i == 0) {
+            // Past the start barrier, run is the one thread 0 wrote for
+            prefix = "remove_" + std::to_string(run.load()) + "_" +
+                     std::to_string(state.thread_index()) + "_";
+        }
+        if (service->Remove(prefix + std::to_string(i++)) != ErrorCode::OK) {
+            state.SkipWithError("Remove failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MountUnmount(benchmark::State& state) {
+    static MasterService* service;
+    if (state.thread_index() == 0) {
+        service = &g_fixture.Prepare(state.range(0));
+    }
+    for (auto _ : state) {
+        Segment segment;
+        {
+            // Segment names and bases are handed out by the fixture
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
+            segment = g_fixture.NextSegment();
+        }
+        if (service->MountSegment(segment, g_fixture.client_id) !=
+                ErrorCode::OK ||
+            service->UnmountSegment(segment.id, g_fixture.client_id) !=
+                ErrorCode::OK) {
+            state.SkipWithError("MountSegment/UnmountSegment failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Background tasks of the GC thread, which runs them alone
+
+void BM_BatchEvict(benchmark::State& state) {
+    MasterService& service = g_fixture.Prepare(state.range(0));
+    for (auto _ : state) {
+        MasterServiceBench::BatchEvict(service, FLAGS_evict_ratio);
+    }
+    // The evicted objects are gone
+    g_fixture.dirty = true;
+}
+
+void BM_ClearInvalidHandles(benchmark::State& state) {
+    MasterService& service = g_fixture.Prepare(state.range(0));
+    for (auto _ : state) {
+        MasterServiceBench::ClearInvalidHandles(service);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+std::vector<int64_t> ParseNumKeys() {
+    std::vector<int64_t> num_keys;
+    std::stringstream ss(FLAGS_num_keys);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        num_keys.push_back(std::stoll(item));
+        CHECK_GT(num_keys.back(), 0) << "Invalid --num_keys " << item;
+    }
+    return num_keys;
+}
+
+void RegisterBenchmarks() {
+    using Function = void (*)(benchmark::State&);
+    const std::vector<std::pair<const char*, Function>> concurrent = {
+        {"PutStartEnd", BM_PutStartEnd},
+        {"GetReplicaList", BM_GetReplicaList},
+        {"BatchGetReplicaList", BM_BatchGetReplicaList},
+        {"Remove", BM_Remove},
+        {"MountUnmount", BM_MountUnmount},
+    };
+    const std::vector<std::pair<const char*, Function>> background = {
+        {"BatchEvict", BM_BatchEvict},
+        {"ClearInvalidHandles", BM_ClearInvalidHandles},
+    };
+    auto num_keys = ParseNumKeys();
+    for (const auto& [name, function] : concurrent) {
+        auto* bench = benchmark::RegisterBenchmark(name, function);
+        for (int64_t keys : num_keys) bench->Arg(keys);
+        bench->ArgName("keys")
+            ->ThreadRange(1, FLAGS_max_threads)
+            ->UseRealTime();
+    }
+    for (const auto& [name, function] : background) {
+        auto* bench = benchmark::RegisterBenchmark(name, function);
+        for (int64_t keys : num_keys) bench->Arg(keys);
+        bench->ArgName("keys")->Unit(benchmark::kMillisecond);
+        if (function == BM_BatchEvict) {
+            // Each iteration evicts --evict_ratio of the objects, keep it to a few
+            bench->Iterations(10);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_minloglevel = google::WARNING;
+    mooncake::RegisterBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
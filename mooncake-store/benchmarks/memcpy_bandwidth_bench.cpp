@@ -0,0 +1,103 @@
+// Measures the bandwidth of the LOCAL_MEMCPY path.
+//
+//   ./memcpy_bandwidth_bench --copy_size_mb=256 --threads=1,2,4,8
+//
+// The baselines are a single std::memcpy, which is what a single-worker
+// MemcpyWorkerPool did before, and a single fast_memcpy. They are followed by
+// MemcpyWorkerPool with each of the given worker counts.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fast_memcpy.h"
+#include "transfer_task.h"
+
+DEFINE_uint64(copy_size_mb, 256, "Size of each copy in MB");
+DEFINE_int32(iterations, 20, "Number of copies per configuration");
+DEFINE_string(threads, "1,2,4,8",
+              "Comma separated MemcpyWorkerPool worker counts");
+
+namespace mooncake {
+namespace {
+
+std::vector<size_t> ParseThreads(const std::string& value) {
+    std::vector<size_t> threads;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            threads.push_back(std::stoul(item));
+        }
+    }
+    return threads;
+}
+
+void Report(const std::string& name, size_t bytes,
+            const std::function<void()>& copy) {
+    copy();  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+        copy();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%-24s %-12.2f\n", name.c_str(),
+           bytes * FLAGS_iterations / seconds / (1024.0 * 1024 * 1024));
+}
+
+int Run() {
+    const size_t size = FLAGS_copy_size_mb * 1024 * 1024;
+    std::unique_ptr<char, decltype(&free)> src(
+        static_cast<char*>(aligned_alloc(4096, size)), &free);
+    std::unique_ptr<char, decltype(&free)> dest(
+        static_cast<char*>(aligned_alloc(4096, size)), &free);
+    if (!src || !dest) {
+        LOG(ERROR) << "Failed to allocate " << size << " bytes";
+        return 1;
+    }
+    // Fault the pages in before measuring
+    memset(src.get(), 'x', size);
+    memset(dest.get(), 0, size);
+
+    printf("%-24s %-12s\n", "config", "GB/s");
+    Report("std::memcpy", size,
+           [&] { std::memcpy(dest.get(), src.get(), size); });
+    Report("fast_memcpy", size,
+           [&] { fast_memcpy(dest.get(), src.get(), size); });
+
+    for (size_t threads : ParseThreads(FLAGS_threads)) {
+        MemcpyWorkerPool pool(threads);
+        Report("pool_" + std::to_string(threads) + "_workers", size, [&] {
+            auto state = std::make_shared<MemcpyOperationState>();
+            std::vector<MemcpyOperation> operations;
+            operations.emplace_back(dest.get(), src.get(), size);
+            pool.submitTask(MemcpyTask(std::move(operations), state));
+            state->wait_for_completion();
+        });
+    }
+
+    if (memcmp(src.get(), dest.get(), size) != 0) {
+        LOG(ERROR) << "Destination does not match source";
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    return mooncake::Run();
+}
@@ -0,0 +1,594 @@
+// Load generator for the store: N clients with mounted segments run a mix of
+// Put, Get and BatchGet against one master, and the throughput and latency
+// percentiles of every operation are reported.
+//
+// Everything runs on one machine over TCP by default: the master is started
+// in-process and the transfer engines exchange their metadata by P2P
+// handshake, so neither mooncake_master nor a metadata server is needed, e.g.
+//   ./mooncake_store_bench --num_clients=4 --key_distribution=zipfian \
+//       --get_ratio=0.8 --put_ratio=0.1 --batch_get_ratio=0.1
+// Pass --start_master=false to run against an existing master instead.
+//
+// Keys 0..num_keys-1 are written before the measurement starts, and Gets and
+// BatchGets read them with the chosen popularity. Every key has a fixed size
+// drawn from the size distribution. Keys written by an earlier run or by
+// another process with the same --key_prefix are kept as they are, so that
+// several processes can load one master; they must use the same --seed and
+// size distribution to agree on the sizes. Puts write new keys, unique per
+// process, so that they are not reduced to an OBJECT_ALREADY_EXISTS check; the
+// master evicts old objects once the segments fill up, which shows up as Get
+// errors.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
+#include "client.h"
+#include "rpc_service.h"
+#include "types.h"
+#include "utils.h"
+
+DEFINE_bool(start_master, true,
+            "Start a master in this process on the port of master_address");
+DEFINE_string(master_address, "localhost:50051", "Address of master server");
+DEFINE_int32(master_http_port, 9003,
+             "Metrics port of the master, if started in this process");
+DEFINE_string(protocol, "tcp", "Transfer protocol: rdma|tcp");
+DEFINE_string(device_name, "ibp6s0",
+              "Device name to use, valid if protocol=rdma");
+DEFINE_string(metadata_url, "P2PHANDSHAKE",
+              "Metadata connection string for transfer engine");
+DEFINE_string(local_ip, "localhost", "Hostname or IP of the local clients");
+DEFINE_int32(base_port, 17800, "First port used by the local clients");
+DEFINE_int32(num_clients, 2, "Number of clients, each mounting a segment");
+DEFINE_int32(threads_per_client, 1, "Worker threads per client");
+DEFINE_uint64(segment_size_mb, 1024, "Size of each mounted segment in MB");
+DEFINE_int32(replica_num, 1, "Replicas per put");
+
+DEFINE_uint64(num_keys, 10000, "Number of keys read by Get and BatchGet");
+DEFINE_string(key_prefix, "bench",
+              "Prefix of the keys, processes sharing a master read the same "
+              "keys if they use the same prefix");
+DEFINE_string(key_distribution, "uniform",
+              "Popularity of the keys read: fixed|uniform|zipfian. fixed "
+              "reads the keys round robin");
+DEFINE_double(zipf_theta, 0.99,
+              "Skew of the zipfian distributions, in (0, 1)");
+DEFINE_string(size_distribution, "fixed",
+              "Distribution of the value sizes: fixed|uniform|zipfian. "
+              "zipfian makes small values the most frequent");
+DEFINE_uint64(value_size, 64 * 1024, "Value size of the fixed distribution");
+DEFINE_uint64(min_value_size, 4 * 1024,
+              "Smallest value of the uniform and zipfian distributions");
+DEFINE_uint64(max_value_size, 1024 * 1024,
+              "Largest value of the uniform and zipfian distributions");
+
+DEFINE_double(put_ratio, 0.1, "Weight of Put in the operation mix");
+DEFINE_double(get_ratio, 0.8, "Weight of Get in the operation mix");
+DEFINE_double(batch_get_ratio, 0.1, "Weight of BatchGet in the operation mix");
+DEFINE_int32(batch_size, 16, "Keys per BatchGet");
+
+DEFINE_int32(duration_sec, 10, "Duration of the measurement");
+DEFINE_uint64(ops_per_thread, 0,
+              "Stop each worker after this many operations instead of after "
+              "duration_sec, if not 0");
+DEFINE_uint64(seed, 42, "Seed of the key sizes and of the workers");
+DEFINE_string(json_output, "",
+              "Also write the results as JSON to this file, if set");
+
+namespace mooncake {
+namespace {
+
+enum BenchOp { OP_PUT, OP_GET, OP_BATCH_GET, NUM_OPS };
+constexpr const char* kOpNames[NUM_OPS] = {"put", "get", "batch_get"};
+
+enum class Distribution { FIXED, UNIFORM, ZIPFIAN };
+
+bool ParseDistribution(const std::string& name, Distribution& distribution) {
+    if (name == "fixed") {
+        distribution = Distribution::FIXED;
+    } else if (name == "uniform") {
+        distribution = Distribution::UNIFORM;
+    } else if (name == "zipfian") {
+        distribution = Distribution::ZIPFIAN;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Draws ranks in [0, n) with P(rank) proportional to 1 / (rank + 1)^theta, as
+// in YCSB (Gray et al., "Quickly Generating Billion-Record Synthetic
+// Databases"). Rank 0 is the most popular.
+class ZipfianGenerator {
+   public:
+    ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+        double zeta2 = 0;
+        for (uint64_t i = 1; i <= n; ++i) {
+            zetan_ += 1.0 / std::pow(static_cast<double>(i), theta);
+            if (i == 2) zeta2 = zetan_;
+        }
+        alpha_ = 1.0 / (1.0 - theta);
+        eta_ = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetan_);
+    }
+
+    uint64_t Next(std::mt19937_64& rng) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) {
+            return std::min<uint64_t>(1, n_ - 1);
+        }
+        auto rank = static_cast<uint64_t>(
+            n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+        return std::min(rank, n_ - 1);
+    }
+
+   private:
+    uint64_t n_;
+    double theta_;
+    double zetan_ = 0;
+    double alpha_;
+    double eta_;
+};
+
+// Value sizes. The zipfian distribution picks one of kSizeBuckets sizes
+// evenly spaced between the smallest and the largest one.
+class SizeDistribution {
+   public:
+    static constexpr uint64_t kSizeBuckets = 64;
+
+    explicit SizeDistribution(Distribution distribution)
+        : distribution_(distribution),
+          zipfian_(kSizeBuckets, FLAGS_zipf_theta) {}
+
+    uint64_t Next(std::mt19937_64& rng) const {
+        switch (distribution_) {
+            case Distribution::FIXED:
+                return FLAGS_value_size;
+            case Distribution::UNIFORM:
+                return std::uniform_int_distribution<uint64_t>(
+                    FLAGS_min_value_size, FLAGS_max_value_size)(rng);
+            case Distribution::ZIPFIAN:
+                return FLAGS_min_value_size +
+                       (FLAGS_max_value_size - FLAGS_min_value_size) *
+                           zipfian_.Next(rng) / (kSizeBuckets - 1);
+        }
+        return FLAGS_value_size;
+    }
+
+    uint64_t Max() const {
+        return distribution_ == Distribution::FIXED ? FLAGS_value_size
+                                                    : FLAGS_max_value_size;
+    }
+
+    // The size of a key only depends on the key and the seed, so that every
+    // worker knows how much to read
+    uint64_t OfKey(uint64_t key_index) const {
+        std::mt19937_64 rng(FLAGS_seed ^ (key_index * 0x9e3779b97f4a7c15ULL));
+        return Next(rng);
+    }
+
+   private:
+    Distribution distribution_;
+    ZipfianGenerator zipfian_;
+};
+
+class KeyDistribution {
+   public:
+    KeyDistribution(Distribution distribution, uint64_t num_keys)
+        : distribution_(distribution),
+          num_keys_(num_keys),
+          zipfian_(distribution == Distribution::ZIPFIAN
+                       ? std::make_unique<ZipfianGenerator>(num_keys,
+                                                            FLAGS_zipf_theta)
+                       : nullptr) {}
+
+    // cursor is the per-worker position of the round robin
+    uint64_t Next(std::mt19937_64& rng, uint64_t& cursor) const {
+        switch (distribution_) {
+            case Distribution::FIXED:
+                return cursor++ % num_keys_;
+            case Distribution::UNIFORM:
+                return std::uniform_int_distribution<uint64_t>(
+                    0, num_keys_ - 1)(rng);
+            case Distribution::ZIPFIAN:
+                return zipfian_->Next(rng);
+        }
+        return 0;
+    }
+
+   private:
+    Distribution distribution_;
+    uint64_t num_keys_;
+    std::unique_ptr<ZipfianGenerator> zipfian_;
+};
+
+std::string KeyName(uint64_t key_index) {
+    return FLAGS_key_prefix + "_key_" + std::to_string(key_index);
+}
+
+// Splits size bytes at buffer into slices of at most kMaxSliceSize, the same
+// way for the put and the get of a key so that they match its replicas
+std::vector<Slice> MakeSlices(char* buffer, uint64_t size) {
+    std::vector<Slice> slices;
+    for (uint64_t offset = 0; offset < size; offset += kMaxSliceSize) {
+        slices.emplace_back(
+            Slice{buffer + offset, std::min(kMaxSliceSize, size - offset)});
+    }
+    return slices;
+}
+
+struct OpStats {
+    std::vector<double> latencies_us;  // Of successful operations
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+};
+
+struct OpResult {
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    double ops_per_sec = 0;
+    double mb_per_sec = 0;
+    double avg_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+};
+
+double Percentile(const std::vector<double>& sorted_us, double p) {
+    if (sorted_us.empty()) return 0;
+    size_t idx = static_cast<size_t>(p * (sorted_us.size() - 1));
+    return sorted_us[idx];
+}
+
+class Worker {
+   public:
+    Worker(int id, std::shared_ptr<Client> client, char* buffer,
+           const KeyDistribution& keys, const SizeDistribution& sizes)
+        : id_(id),
+          client_(std::move(client)),
+          buffer_(buffer),
+          keys_(keys),
+          sizes_(sizes),
+          rng_(FLAGS_seed + id) {
+        config_.replica_num = FLAGS_replica_num;
+    }
+
+    // Writes the keys assigned to this worker, unless they exist already
+    bool Prefill(int num_workers) {
+        for (uint64_t key = id_; key < FLAGS_num_keys; key += num_workers) {
+            auto slices = MakeSlices(buffer_, sizes_.OfKey(key));
+            ErrorCode err = client_->Put(KeyName(key), slices, config_);
+            if (err != ErrorCode::OK &&
+                err != ErrorCode::OBJECT_ALREADY_EXISTS) {
+                LOG(ERROR) << "Failed to prefill key " << key << ": " << err;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Run(std::chrono::steady_clock::time_point deadline) {
+        std::discrete_distribution<int> op_distribution(
+            {FLAGS_put_ratio, FLAGS_get_ratio, FLAGS_batch_get_ratio});
+        for (uint64_t i = 0; FLAGS_ops_per_thread == 0 ||
+                             i < FLAGS_ops_per_thread;
+             ++i) {
+            if (FLAGS_ops_per_thread == 0 &&
+                std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            auto op = static_cast<BenchOp>(op_distribution(rng_));
+            uint64_t bytes = 0;
+            auto start = std::chrono::steady_clock::now();
+            ErrorCode err = RunOp(op, bytes);
+            auto end = std::chrono::steady_clock::now();
+            auto& stats = stats_[op];
+            if (err != ErrorCode::OK) {
+                ++stats.errors;
+                continue;
+            }
+            stats.latencies_us.push_back(
+                std::chrono::duration<double, std::micro>(end - start)
+                    .count());
+            stats.bytes += bytes;
+        }
+    }
+
+    const OpStats& stats(BenchOp op) const { return stats_[op]; }
+
+   private:
+    ErrorCode RunOp(BenchOp op, uint64_t& bytes) {
+        switch (op) {
+            case OP_PUT: {
+                bytes = sizes_.Next(rng_);
+                auto slices = MakeSlices(buffer_, bytes);
+                std::string key = FLAGS_key_prefix + "_put_" +
+                                  std::to_string(getpid()) + "_" +
+                                  std::to_string(id_) + "_" +
+                                  std::to_string(put_seq_++);
+                return client_->Put(key, slices, config_);
+            }
+            case OP_GET: {
+                uint64_t key = keys_.Next(rng_, cursor_);
+                bytes = sizes_.OfKey(key);
+                auto slices = MakeSlices(buffer_, bytes);
+                return client_->Get(KeyName(key), slices);
+            }
+            case OP_BATCH_GET: {
+                // BatchGet rejects duplicate keys
+                std::unordered_set<uint64_t> picked;
+                const size_t batch_size = std::min<uint64_t>(
+                    FLAGS_batch_size, FLAGS_num_keys);
+                while (picked.size() < batch_size) {
+                    picked.insert(keys_.Next(rng_, cursor_));
+                }
+                std::vector<std::string> keys;
+                std::unordered_map<std::string, std::vector<Slice>> slices;
+                char* buffer = buffer_;
+                for (uint64_t key : picked) {
+                    uint64_t size = sizes_.OfKey(key);
+                    keys.push_back(KeyName(key));
+                    slices.emplace(keys.back(), MakeSlices(buffer, size));
+                    buffer += size;
+                    bytes += size;
+                }
+                return client_->BatchGet(keys, slices);
+            }
+            default:
+                return ErrorCode::INVALID_PARAMS;
+        }
+    }
+
+    int id_;
+    std::shared_ptr<Client> client_;
+    char* buffer_;  // Room for a BatchGet of the largest values
+    const KeyDistribution& keys_;
+    const SizeDistribution& sizes_;
+    std::mt19937_64 rng_;
+    uint64_t cursor_ = 0;
+    uint64_t put_seq_ = 0;
+    ReplicateConfig config_;
+    OpStats stats_[NUM_OPS];
+};
+
+std::shared_ptr<Client> CreateClient(const std::string& host_name) {
+    void** args =
+        (FLAGS_protocol == "rdma") ? rdma_args(FLAGS_device_name) : nullptr;
+    auto client_opt = Client::Create(host_name, FLAGS_metadata_url,
+                                     FLAGS_protocol, args,
+                                     FLAGS_master_address);
+    if (!client_opt.has_value()) {
+        LOG(ERROR) << "Failed to create client with host_name: " << host_name;
+        return nullptr;
+    }
+    return *client_opt;
+}
+
+// Allocations of the buffer allocator must be a multiple of its slab size
+size_t RoundUpToSlab(size_t size) {
+    constexpr size_t kSlabSize = 4 * 1024 * 1024;
+    return (size + kSlabSize - 1) / kSlabSize * kSlabSize;
+}
+
+void WriteJson(const std::string& path, const OpResult (&results)[NUM_OPS],
+               double elapsed_sec) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        PLOG(ERROR) << "Failed to open " << path;
+        return;
+    }
+    fprintf(file,
+            "{\n  \"config\": {\"num_clients\": %d, \"threads_per_client\": "
+            "%d, \"protocol\": \"%s\", \"num_keys\": %lu, "
+            "\"key_distribution\": \"%s\", \"size_distribution\": \"%s\", "
+            "\"value_size\": %lu, \"min_value_size\": %lu, "
+            "\"max_value_size\": %lu, \"zipf_theta\": %g, \"put_ratio\": %g, "
+            "\"get_ratio\": %g, \"batch_get_ratio\": %g, \"batch_size\": %d, "
+            "\"replica_num\": %d},\n",
+            FLAGS_num_clients, FLAGS_threads_per_client,
+            FLAGS_protocol.c_str(), FLAGS_num_keys,
+            FLAGS_key_distribution.c_str(), FLAGS_size_distribution.c_str(),
+            FLAGS_value_size, FLAGS_min_value_size, FLAGS_max_value_size,
+            FLAGS_zipf_theta, FLAGS_put_ratio, FLAGS_get_ratio,
+            FLAGS_batch_get_ratio, FLAGS_batch_size, FLAGS_replica_num);
+    fprintf(file, "  \"elapsed_sec\": %.3f,\n  \"results\": {", elapsed_sec);
+    for (int op = 0; op < NUM_OPS; ++op) {
+        const auto& result = results[op];
+        fprintf(file,
+                "%s\n    \"%s\": {\"ops\": %lu, \"errors\": %lu, "
+                "\"ops_per_sec\": %.1f, \"mb_per_sec\": %.1f, \"avg_us\": "
+                "%.1f, \"p50_us\": %.1f, \"p99_us\": %.1f, \"p999_us\": %.1f}",
+                op ? "," : "", kOpNames[op], result.ops, result.errors,
+                result.ops_per_sec, result.mb_per_sec, result.avg_us,
+                result.p50_us, result.p99_us, result.p999_us);
+    }
+    fprintf(file, "\n  }\n}\n");
+    fclose(file);
+}
+
+int Run() {
+    Distribution key_distribution, size_distribution;
+    if (!ParseDistribution(FLAGS_key_distribution, key_distribution) ||
+        !ParseDistribution(FLAGS_size_distribution, size_distribution)) {
+        LOG(ERROR) << "Distributions must be fixed, uniform or zipfian";
+        return 1;
+    }
+    if (FLAGS_num_keys == 0 || FLAGS_num_clients <= 0 ||
+        FLAGS_threads_per_client <= 0 || FLAGS_batch_size <= 0 ||
+        FLAGS_min_value_size == 0 ||
+        FLAGS_min_value_size > FLAGS_max_value_size ||
+        FLAGS_zipf_theta <= 0 || FLAGS_zipf_theta >= 1 ||
+        FLAGS_put_ratio + FLAGS_get_ratio + FLAGS_batch_get_ratio <= 0) {
+        LOG(ERROR) << "Invalid workload parameters";
+        return 1;
+    }
+
+    // Master in this process, if requested
+    // The server goes first, it calls into the service
+    std::unique_ptr<WrappedMasterService> master_service;
+    std::unique_ptr<coro_rpc::coro_rpc_server> master_server;
+    if (FLAGS_start_master) {
+        auto port_pos = FLAGS_master_address.rfind(':');
+        if (port_pos == std::string::npos) {
+            LOG(ERROR) << "Invalid master_address " << FLAGS_master_address;
+            return 1;
+        }
+        int port = std::stoi(FLAGS_master_address.substr(port_pos + 1));
+        master_server = std::make_unique<coro_rpc::coro_rpc_server>(
+            std::thread::hardware_concurrency(), port);
+        master_service = std::make_unique<WrappedMasterService>(
+            false, DEFAULT_DEFAULT_KV_LEASE_TTL, false,
+            FLAGS_master_http_port);
+        RegisterRpcService(*master_server, *master_service);
+        auto started = master_server->async_start();
+        if (started.hasResult()) {
+            LOG(ERROR) << "Failed to start master on port " << port << ": "
+                       << started.result().value();
+            return 1;
+        }
+    }
+
+    // Clients with their segments and a registered buffer per worker
+    const size_t segment_size = RoundUpToSlab(FLAGS_segment_size_mb << 20);
+    KeyDistribution keys(key_distribution, FLAGS_num_keys);
+    SizeDistribution sizes(size_distribution);
+    const size_t worker_buffer_size =
+        sizes.Max() * std::min<uint64_t>(FLAGS_batch_size, FLAGS_num_keys);
+    const size_t client_buffer_size =
+        RoundUpToSlab(worker_buffer_size * FLAGS_threads_per_client);
+
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<void*> segments;
+    std::vector<void*> buffers;
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < FLAGS_num_clients; ++i) {
+        auto client = CreateClient(FLAGS_local_ip + ":" +
+                                   std::to_string(FLAGS_base_port + i));
+        if (!client) return 1;
+        void* segment = allocate_buffer_allocator_memory(segment_size);
+        if (!segment ||
+            client->MountSegment(segment, segment_size) != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to mount segment of client " << i;
+            return 1;
+        }
+        void* buffer = allocate_buffer_allocator_memory(client_buffer_size);
+        if (!buffer || client->RegisterLocalMemory(
+                           buffer, client_buffer_size, "cpu:0", false,
+                           false) != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to register buffer of client " << i;
+            return 1;
+        }
+        memset(buffer, 'x', client_buffer_size);
+        for (int t = 0; t < FLAGS_threads_per_client; ++t) {
+            workers.push_back(std::make_unique<Worker>(
+                static_cast<int>(workers.size()), client,
+                static_cast<char*>(buffer) + t * worker_buffer_size, keys,
+                sizes));
+        }
+        clients.push_back(client);
+        segments.push_back(segment);
+        buffers.push_back(buffer);
+    }
+
+    LOG(INFO) << "Writing " << FLAGS_num_keys << " keys";
+    std::atomic<bool> prefill_ok{true};
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&, w = worker.get()] {
+            if (!w->Prefill(workers.size())) prefill_ok = false;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+    if (!prefill_ok) return 1;
+
+    LOG(INFO) << "Running " << workers.size() << " workers";
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(FLAGS_duration_sec);
+    for (auto& worker : workers) {
+        threads.emplace_back(
+            [deadline, w = worker.get()] { w->Run(deadline); });
+    }
+    for (auto& thread : threads) thread.join();
+    double elapsed_sec =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    OpResult results[NUM_OPS];
+    printf("%-10s %-10s %-8s %-12s %-10s %-10s %-10s %-10s %-10s\n", "op",
+           "ops", "errors", "ops/s", "MB/s", "avg_us", "p50_us", "p99_us",
+           "p999_us");
+    for (int op = 0; op < NUM_OPS; ++op) {
+        std::vector<double> latencies_us;
+        uint64_t bytes = 0;
+        auto& result = results[op];
+        for (const auto& worker : workers) {
+            const auto& stats = worker->stats(static_cast<BenchOp>(op));
+            latencies_us.insert(latencies_us.end(),
+                                stats.latencies_us.begin(),
+                                stats.latencies_us.end());
+            bytes += stats.bytes;
+            result.errors += stats.errors;
+        }
+        std::sort(latencies_us.begin(), latencies_us.end());
+        result.ops = latencies_us.size();
+        result.ops_per_sec = result.ops / elapsed_sec;
+        result.mb_per_sec = bytes / elapsed_sec / (1 << 20);
+        double total_us = 0;
+        for (double latency : latencies_us) total_us += latency;
+        result.avg_us = result.ops ? total_us / result.ops : 0;
+        result.p50_us = Percentile(latencies_us, 0.5);
+        result.p99_us = Percentile(latencies_us, 0.99);
+        result.p999_us = Percentile(latencies_us, 0.999);
+        printf("%-10s %-10lu %-8lu %-12.1f %-10.1f %-10.1f %-10.1f %-10.1f "
+               "%-10.1f\n",
+               kOpNames[op], result.ops, result.errors, result.ops_per_sec,
+               result.mb_per_sec, result.avg_us, result.p50_us, result.p99_us,
+               result.p999_us);
+    }
+    if (!FLAGS_json_output.empty()) {
+        WriteJson(FLAGS_json_output, results, elapsed_sec);
+    }
+
+    workers.clear();
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if (clients[i]->UnmountSegment(segments[i], segment_size) !=
+            ErrorCode::OK) {
+            LOG(ERROR) << "Failed to unmount segment of client " << i;
+        }
+    }
+    clients.clear();
+    for (void* buffer : buffers) free(buffer);
+    for (void* segment : segments) free(segment);
+    if (master_server) {
+        master_server->stop();
+    }
+    return 0;
+}
+
+}  // namespace
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    return mooncake::Run();
+}
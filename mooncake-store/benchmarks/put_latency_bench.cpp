@@ -0,0 +1,163 @@
+// Measures Client::Put latency for different replica counts.
+//
+// Start a master first (mooncake_master), then run e.g.
+//   ./put_latency_bench --protocol=tcp --max_replica_num=3
+// The writer client does not mount a segment, so every replica is written
+// through the transfer engine to one of the segment provider clients.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocator.h"
+#include "client.h"
+#include "types.h"
+#include "utils.h"
+
+DEFINE_string(protocol, "tcp", "Transfer protocol: rdma|tcp");
+DEFINE_string(device_name, "ibp6s0",
+              "Device name to use, valid if protocol=rdma");
+DEFINE_string(metadata_url, "localhost:2379",
+              "Metadata connection string for transfer engine");
+DEFINE_string(master_address, "localhost:50051", "Address of master server");
+DEFINE_string(local_ip, "localhost", "Hostname or IP of the local clients");
+DEFINE_int32(base_port, 17900, "First port used by the local clients");
+DEFINE_int32(num_segments, 3, "Number of segment provider clients");
+DEFINE_uint64(segment_size_mb, 512, "Size of each mounted segment in MB");
+DEFINE_uint64(value_size, 1024 * 1024, "Size of each value in bytes");
+DEFINE_int32(max_replica_num, 3, "Benchmark replica_num from 1 to this");
+DEFINE_int32(iterations, 200, "Number of puts per replica_num");
+DEFINE_uint64(kv_lease_ttl_ms, mooncake::DEFAULT_DEFAULT_KV_LEASE_TTL,
+              "Lease TTL of the master, used to wait before cleanup");
+
+namespace mooncake {
+namespace {
+
+std::shared_ptr<Client> CreateClient(const std::string& host_name) {
+    void** args =
+        (FLAGS_protocol == "rdma") ? rdma_args(FLAGS_device_name) : nullptr;
+    auto client_opt = Client::Create(host_name, FLAGS_metadata_url,
+                                     FLAGS_protocol, args,
+                                     FLAGS_master_address);
+    if (!client_opt.has_value()) {
+        LOG(ERROR) << "Failed to create client with host_name: " << host_name;
+        return nullptr;
+    }
+    return *client_opt;
+}
+
+double Percentile(std::vector<double>& sorted_us, double p) {
+    if (sorted_us.empty()) return 0;
+    size_t idx = static_cast<size_t>(p * (sorted_us.size() - 1));
+    return sorted_us[idx];
+}
+
+int Run() {
+    const size_t segment_size = FLAGS_segment_size_mb * 1024 * 1024;
+
+    // Segment provider clients
+    std::vector<std::shared_ptr<Client>> providers;
+    std::vector<void*> segments;
+    for (int i = 0; i < FLAGS_num_segments; ++i) {
+        auto client = CreateClient(FLAGS_local_ip + ":" +
+                                   std::to_string(FLAGS_base_port + 1 + i));
+        if (!client) return 1;
+        void* segment = allocate_buffer_allocator_memory(segment_size);
+        if (!segment ||
+            client->MountSegment(segment, segment_size) != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to mount segment " << i;
+            return 1;
+        }
+        providers.push_back(client);
+        segments.push_back(segment);
+    }
+
+    // Writer client with a registered source buffer
+    auto writer =
+        CreateClient(FLAGS_local_ip + ":" + std::to_string(FLAGS_base_port));
+    if (!writer) return 1;
+    auto buffer_allocator =
+        std::make_unique<SimpleAllocator>(FLAGS_value_size * 2);
+    if (writer->RegisterLocalMemory(buffer_allocator->getBase(),
+                                    FLAGS_value_size * 2, "cpu:0", false,
+                                    false) != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to register local memory";
+        return 1;
+    }
+    void* value = buffer_allocator->allocate(FLAGS_value_size);
+    memset(value, 'x', FLAGS_value_size);
+
+    std::vector<Slice> slices;
+    for (size_t offset = 0; offset < FLAGS_value_size;
+         offset += kMaxSliceSize) {
+        size_t size = std::min(kMaxSliceSize, FLAGS_value_size - offset);
+        slices.emplace_back(Slice{static_cast<char*>(value) + offset, size});
+    }
+
+    printf("%-12s %-10s %-12s %-12s %-12s %-12s\n", "replica_num", "puts",
+           "avg_us", "p50_us", "p99_us", "MB/s");
+    for (int replica_num = 1; replica_num <= FLAGS_max_replica_num;
+         ++replica_num) {
+        ReplicateConfig config;
+        config.replica_num = replica_num;
+
+        std::vector<double> latencies_us;
+        latencies_us.reserve(FLAGS_iterations);
+        for (int i = 0; i < FLAGS_iterations; ++i) {
+            std::string key = "put_latency_bench_r" +
+                              std::to_string(replica_num) + "_" +
+                              std::to_string(i);
+            auto start = std::chrono::steady_clock::now();
+            ErrorCode err = writer->Put(key, slices, config);
+            auto end = std::chrono::steady_clock::now();
+            if (err != ErrorCode::OK) {
+                LOG(ERROR) << "Put failed for key " << key << ": " << err;
+                return 1;
+            }
+            latencies_us.push_back(
+                std::chrono::duration<double, std::micro>(end - start)
+                    .count());
+        }
+
+        std::sort(latencies_us.begin(), latencies_us.end());
+        double total_us = 0;
+        for (double latency : latencies_us) total_us += latency;
+        double avg_us = total_us / latencies_us.size();
+        double mb_per_sec = FLAGS_value_size * latencies_us.size() /
+                            total_us;  // bytes/us == MB/s
+        printf("%-12d %-10zu %-12.1f %-12.1f %-12.1f %-12.1f\n", replica_num,
+               latencies_us.size(), avg_us, Percentile(latencies_us, 0.5),
+               Percentile(latencies_us, 0.99), mb_per_sec);
+
+        // Free the space for the next round
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(FLAGS_kv_lease_ttl_ms));
+        writer->RemoveAll();
+    }
+
+    buffer_allocator->deallocate(value, FLAGS_value_size);
+    for (int i = 0; i < FLAGS_num_segments; ++i) {
+        if (providers[i]->UnmountSegment(segments[i], segment_size) !=
+            ErrorCode::OK) {
+            LOG(ERROR) << "Failed to unmount segment " << i;
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = 1;
+    return mooncake::Run();
+}
@@ -4,6 +4,7 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "cachelib_memory_allocator/MemoryAllocator.h"
 #include "master_metric_manager.h"
@@ -68,22 +69,52 @@ class BufferAllocator : public std::enable_shared_from_this<BufferAllocator> {
 
 // The main difference is that it allocates real memory and returns it, while
 // BufferAllocator allocates an address
+//
+// Small allocations go through a per-thread cache in front of the shared
+// CacheLib pool, so that threads do not contend on the allocation class locks
+// for every slice. Each thread keeps a bounded magazine of free blocks per
+// size class and periodically returns blocks it has not reused to the pool.
+// The caches of all threads share a byte budget, and an allocation that finds
+// the pool empty reclaims the blocks cached by every thread, idle ones too.
+// deallocate() must be called with the size passed to allocate().
 class SimpleAllocator {
    public:
-    SimpleAllocator(size_t size);
+    // Upper bound on the memory cached by one thread
+    static constexpr size_t kMaxThreadCacheBytes = 8 * 1024 * 1024;
+    // Upper bound on the memory cached by all threads together
+    static constexpr size_t kMaxTotalCacheBytes = 64 * 1024 * 1024;
+    // Maximum number of free blocks cached per size class and thread
+    static constexpr size_t kMagazineCapacity = 32;
+    // Number of cache operations between two scavenges of a thread cache
+    static constexpr uint32_t kScavengeInterval = 1024;
+
+    explicit SimpleAllocator(size_t size, bool enable_thread_cache = true);
     ~SimpleAllocator();
     void* allocate(size_t size);
     void deallocate(void* ptr, size_t size);
     void* getBase() const { return base_; }
 
    private:
+    struct Core;
+    struct ThreadCache;
+
+    // Index of the cached size class serving size, or -1 if not cached
+    int cachedClassIndex(size_t size) const;
+    ThreadCache* getThreadCache();
+    void* allocateFromPool(size_t size);
+
     void* base_{nullptr};
 
-    std::unique_ptr<char[]> header_region_start_;
-    size_t header_region_size_;
+    // Owns the memory and the CacheLib allocator. Thread caches hold weak
+    // references so that they can return blocks on thread exit as long as the
+    // memory is still alive.
+    std::shared_ptr<Core> core_;
+    const uint64_t id_;
 
-    std::unique_ptr<facebook::cachelib::MemoryAllocator> memory_allocator_;
-    facebook::cachelib::PoolId pool_id_;
+    // CacheLib allocation sizes of the cached classes, in ascending order
+    std::vector<uint32_t> cached_class_sizes_;
+    size_t thread_cache_bytes_{0};
+    size_t total_cache_bytes_{0};
 };
 
 }  // namespace mooncake
@@ -3,11 +3,17 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 #include <boost/functional/hash.hpp>
 
+#include "allocator.h"
+#include "client_metric.h"
+#include "compression.h"
+#include "disk_tier.h"
 #include "master_client.h"
+#include "replica_selector.h"
 #include "rpc_service.h"
 #include "transfer_engine.h"
 #include "transfer_task.h"
@@ -16,6 +22,49 @@
 
 namespace mooncake {
 
+/**
+ * @brief Read-only view of an object stored in the client's own segment
+ *
+ * Returned by Client::GetView. The spans point straight into the mounted
+ * segment, in the order of the object's slices, so no data is copied. The
+ * object is pinned on the master and is neither removed, evicted nor garbage
+ * collected until the view is released or destroyed. A view must not outlive
+ * the Client that created it.
+ */
+class ObjectView {
+   public:
+    ~ObjectView() { Release(); }
+
+    ObjectView(const ObjectView&) = delete;
+    ObjectView& operator=(const ObjectView&) = delete;
+
+    const std::vector<std::span<const char>>& spans() const { return spans_; }
+
+    /**
+     * @brief Total size of the object in bytes
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Unpin the object. The spans must not be accessed afterwards.
+     * Calling it more than once has no effect.
+     * @return ErrorCode indicating success/failure of the unpin
+     */
+    ErrorCode Release();
+
+   private:
+    friend class Client;
+
+    ObjectView(MasterClient* master_client, const UUID& client_id,
+               std::string key, std::vector<std::span<const char>> spans);
+
+    MasterClient* master_client_;
+    UUID client_id_;
+    std::string key_;
+    std::vector<std::span<const char>> spans_;
+    size_t size_;
+};
+
 /**
  * @brief Client for interacting with the mooncake distributed object store
  */
@@ -74,6 +123,10 @@ class Client {
 
     /**
      * @brief Gets object metadata without transferring data
+     *
+     * If the object was evicted to the disk tier of another client, waits a
+     * bounded time for the master to promote it back to memory.
+     *
      * @param object_key Key to query
      * @param object_info Output parameter for object metadata
      * @return ErrorCode indicating success/failure
@@ -98,6 +151,41 @@ class Client {
     ErrorCode Get(const std::string& object_key, const ObjectInfo& object_info,
                   std::vector<Slice>& slices);
 
+    /**
+     * @brief Retrieves a byte range of an object
+     *
+     * Only the parts of the replica's slices that overlap the range are
+     * transferred. The range is written contiguously into slices. Objects in
+     * the local disk tier are read from disk; objects in the disk tier of
+     * another client return ErrorCode::REPLICA_IS_NOT_READY if they are not
+     * promoted in time, like Get.
+     *
+     * @param object_key Key to retrieve
+     * @param offset Byte offset of the range within the object
+     * @param length Number of bytes to read
+     * @param slices Vector of slices to store the range, at least length
+     * bytes in total
+     * @return ErrorCode indicating success/failure
+     */
+    ErrorCode Get(const std::string& object_key, size_t offset, size_t length,
+                  std::vector<Slice>& slices);
+
+    /**
+     * @brief Returns a zero-copy view of an object in the local segment
+     *
+     * Only works if a complete replica of the object lives entirely in a
+     * segment mounted by this client. The object stays pinned until the view
+     * is released, so keep views short-lived to not block eviction. Without
+     * HA the master drops the pin after the client TTL (--client_ttl).
+     *
+     * @param object_key Key to retrieve
+     * @param view Output view of the object
+     * @return ErrorCode::OK on success, ErrorCode::INVALID_REPLICA if no
+     * complete replica is local (use Get instead), other ErrorCode for errors
+     */
+    ErrorCode GetView(const std::string& object_key,
+                      std::unique_ptr<ObjectView>& view);
+
     /**
      * @brief Transfers data using pre-queried object information
      * @param object_keys Keys of the objects
@@ -125,6 +213,8 @@ class Client {
      * @param keys Object keys
      * @param batched_slices Vector of data slices to store
      * @param config Replication configuration
+     * @return ErrorCode::INVALID_PARAMS if config sets a codec or dedup,
+     * batch puts store every value uncompressed
      */
     ErrorCode BatchPut(
         const std::vector<ObjectKey>& keys,
@@ -138,6 +228,43 @@ class Client {
      */
     ErrorCode Remove(const ObjectKey& key);
 
+    /**
+     * @brief Asynchronous versions of Get, Put, BatchGet and BatchPut
+     *
+     * Each returns a lazy coroutine covering the whole pipeline: the master
+     * RPC, the data transfer and, for puts, PutEnd or PutRevoke. It suspends
+     * instead of blocking while waiting, so a single thread can keep many
+     * operations in flight. Nothing runs until the coroutine is awaited or
+     * started, e.g. with co_await, collectAll, start() or syncAwait(). The
+     * arguments are referenced, not copied, and must outlive the coroutine.
+     *
+     * Like the synchronous gets, the gets wait up to 2 seconds for objects
+     * being promoted from the disk tier of another client, and return
+     * ErrorCode::REPLICA_IS_NOT_READY if they are still not back in memory.
+     */
+    async_simple::coro::Lazy<ErrorCode> AsyncGet(const std::string& object_key,
+                                                 std::vector<Slice>& slices);
+
+    async_simple::coro::Lazy<ErrorCode> AsyncPut(const ObjectKey& key,
+                                                 std::vector<Slice>& slices,
+                                                 const ReplicateConfig& config);
+
+    async_simple::coro::Lazy<ErrorCode> AsyncBatchGet(
+        const std::vector<std::string>& object_keys,
+        std::unordered_map<std::string, std::vector<Slice>>& slices);
+
+    async_simple::coro::Lazy<ErrorCode> AsyncBatchPut(
+        const std::vector<ObjectKey>& keys,
+        std::unordered_map<std::string, std::vector<Slice>>& batched_slices,
+        const ReplicateConfig& config);
+
+    /**
+     * @brief Removes a batch of objects and all their replicas in one request
+     * @param keys Keys to remove
+     * @return Per-key ErrorCode in the order of keys, see Remove
+     */
+    std::vector<ErrorCode> BatchRemove(const std::vector<ObjectKey>& keys);
+
     /**
      * @brief Removes all objects and all its replicas
      * @return The number of objects removed, negative on error
@@ -190,7 +317,65 @@ class Client {
      */
     ErrorCode IsExist(const std::string& key);
 
+    /**
+     * @brief Checks if a batch of objects exist in one request
+     * @param keys Keys to check
+     * @return Per-key ErrorCode in the order of keys, see IsExist
+     */
+    std::vector<ErrorCode> BatchIsExist(const std::vector<std::string>& keys);
+
+    /**
+     * @brief Finds how many leading blocks of a KV cache chain are stored,
+     * in one request. The blocks found are leased like with IsExist.
+     * @param keys Block keys, first block first. See PrefixIndex for the key
+     * format the master indexes.
+     * @param[out] prefix_length Number of leading keys that exist
+     * @return ErrorCode::OK on success, other ErrorCode for errors
+     */
+    ErrorCode LongestCachedPrefix(const std::vector<std::string>& keys,
+                                  size_t& prefix_length);
+
+    /**
+     * @brief Statistics of the compression stage of Put and Get
+     * @return Cumulative counters since the client was created
+     */
+    CompressionStats GetCompressionStats() const;
+
+    /**
+     * @brief Metrics of the client in Prometheus text format, as served on
+     * /metrics when MC_STORE_METRICS_PORT is set
+     */
+    std::string GetMetrics() const;
+
    private:
+    /**
+     * @brief Buffers taken from the compression staging allocator, released
+     * when the owner goes out of scope
+     */
+    class StagingBuffers {
+       public:
+        StagingBuffers(Client* client, SimpleAllocator* allocator)
+            : client_(client), allocator_(allocator) {}
+        ~StagingBuffers();
+        StagingBuffers(const StagingBuffers&) = delete;
+        StagingBuffers& operator=(const StagingBuffers&) = delete;
+
+        // Returns nullptr if the staging memory is exhausted
+        void* Allocate(size_t size);
+
+        // Heap memory outside the staging allocator, registered with the
+        // transfer engine if register_memory is set. Returns nullptr on
+        // failure.
+        void* AllocateTemporary(size_t size, bool register_memory);
+
+       private:
+        Client* client_;
+        SimpleAllocator* allocator_;
+        std::vector<std::pair<void*, size_t>> buffers_;
+        // Temporary buffers and whether they are registered
+        std::vector<std::pair<std::unique_ptr<char[]>, bool>> temporary_;
+    };
+
     /**
      * @brief Private constructor to enforce creation through Create() method
      */
@@ -208,24 +393,157 @@ class Client {
     ErrorCode TransferData(
         const std::vector<AllocatedBuffer::Descriptor>& handles,
         std::vector<Slice>& slices, TransferRequest::OpCode op_code);
-    ErrorCode TransferWrite(
-        const std::vector<AllocatedBuffer::Descriptor>& handles,
-        std::vector<Slice>& slices);
-    ErrorCode TransferRead(
+
+    /**
+     * @brief Submit the reads of one object without waiting for them
+     *
+     * Reads from the replica chosen by SelectReplica. When striped reads are
+     * enabled and the chosen replica is not local, the slices are instead
+     * split across all complete replicas with the same layout so that each
+     * replica serves a disjoint subset of them in parallel.
+     *
+     * @param replica_list Replicas of the object
+     * @param slices Destination slices
+     * @param futures Output futures, one per replica read from
+     * @param load_guards Output guards to keep alive until the futures finish
+     * @return ErrorCode::OK if all reads were submitted
+     */
+    ErrorCode SubmitRead(const std::vector<Replica::Descriptor>& replica_list,
+                         std::vector<Slice>& slices,
+                         std::vector<TransferFuture>& futures,
+                         std::vector<ReplicaSelector::LoadGuard>& load_guards);
+
+    /**
+     * @brief Submit writes of slices to every replica without waiting for them
+     * @param replica_list Replicas allocated by PutStart
+     * @param slices Source slices
+     * @param futures Output futures, one per submitted replica write. On
+     * failure it still holds the writes submitted so far, which must be
+     * waited for before revoking the put.
+     * @return ErrorCode::OK if all writes were submitted
+     */
+    ErrorCode SubmitWrite(const std::vector<Replica::Descriptor>& replica_list,
+                          std::vector<Slice>& slices,
+                          std::vector<TransferFuture>& futures);
+
+    /**
+     * @brief Compress the slices of a value according to config
+     *
+     * Slices that do not shrink keep pointing at the caller's memory. If no
+     * slice shrinks, or the value is too small, encoded equals slices and
+     * compression is left empty.
+     *
+     * @param slices Raw slices of the value
+     * @param config Replication configuration carrying the codec
+     * @param staging Owner of the compressed slices
+     * @param encoded Output slices to write
+     * @param compression Output description of the encoding for PutStart
+     * @return ErrorCode::INVALID_PARAMS if the codec is not built in
+     */
+    ErrorCode EncodeValue(const std::vector<Slice>& slices,
+                          const ReplicateConfig& config,
+                          StagingBuffers& staging, std::vector<Slice>& encoded,
+                          CompressionInfo& compression);
+
+    /**
+     * @brief Read a compressed replica and decompress it into slices
+     *
+     * Submits the read and returns a future that decodes the data when it is
+     * waited for. Compressed slices are read into the staging memory, or into
+     * a temporary buffer once that is exhausted.
+     *
+     * @param disk If set, the stored slices are read from this extent of the
+     * local disk tier instead of handles, which then only give their sizes
+     */
+    ErrorCode ReadCompressed(
         const std::vector<AllocatedBuffer::Descriptor>& handles,
+        const CompressionInfo& compression, std::vector<Slice>& slices,
+        std::vector<TransferFuture>& futures,
+        const DiskLocation* disk = nullptr);
+
+    /**
+     * @brief Read a replica held by the local disk tier
+     *
+     * Blocks until the data is read and returns an already completed future.
+     *
+     * @return ErrorCode::REPLICA_IS_NOT_READY if the replica is in the disk
+     * tier of another client and has to be promoted first
+     */
+    ErrorCode ReadFromDisk(const Replica::Descriptor& replica,
+                           std::vector<Slice>& slices,
+                           std::vector<TransferFuture>& futures);
+
+    /**
+     * @brief Read length bytes from offset of an object held by the local
+     * disk tier, for the ranged Get
+     * @return ErrorCode::REPLICA_IS_NOT_READY if the replica is in the disk
+     * tier of another client
+     */
+    ErrorCode GetRangeFromDisk(const std::string& object_key,
+                               const Replica::Descriptor& replica,
+                               size_t offset, size_t length,
+                               std::vector<Slice>& slices);
+
+    /**
+     * @brief Whether reading the object needs its promotion from the disk
+     * tier of another client
+     */
+    bool NeedsPromotion(
+        const std::vector<Replica::Descriptor>& replica_list) const;
+    bool NeedsPromotion(const BatchGetReplicaListResponse& response) const;
+
+    /**
+     * @brief Open the disk tier configured by MC_STORE_DISK_TIER_DIR and
+     * start polling the master for disk tasks. Does nothing if unset.
+     */
+    ErrorCode InitDiskTier();
+
+    /**
+     * @brief Map buffers of a segment mounted by this client to local slices
+     * @return false if any buffer lies outside the mounted segments
+     */
+    bool MapLocalBuffers(
+        const std::vector<AllocatedBuffer::Descriptor>& buffers,
         std::vector<Slice>& slices);
 
+    void DiskTierThreadFunc();
+    void RunDiskTask(const DiskTask& task);
+
+    /**
+     * @brief Serve the metrics on the port given by MC_STORE_METRICS_PORT.
+     * Does nothing if unset.
+     */
+    ErrorCode InitMetricsServer();
+
+    /**
+     * @brief Lazily create the codec workers and the registered staging
+     * memory holding compressed slices in flight
+     * @return The staging allocator, or nullptr if it could not be registered
+     */
+    SimpleAllocator* InitCompression();
+
     /**
-     * @brief Find the first complete replica from a replica list
-     * @param replica_list List of replicas to search through
-     * @param handles Output vector to store the buffer handles of the found
+     * @brief Select the complete replica to read from, preferring local and
+     * lightly loaded replicas
+     * @param replica_list List of replicas to choose from
+     * @param handles Output vector to store the buffer handles of the selected
      * replica
+     * @param load_guard Output guard that accounts the read as in flight until
+     * it is destroyed; keep it alive until the transfer completes
+     * @param selected Output, set to the selected replica if not null
      * @return ErrorCode::OK if found, ErrorCode::INVALID_REPLICA if no complete
      * replica
      */
-    ErrorCode FindFirstCompleteReplica(
+    ErrorCode SelectReplica(
         const std::vector<Replica::Descriptor>& replica_list,
-        std::vector<AllocatedBuffer::Descriptor>& handles);
+        std::vector<AllocatedBuffer::Descriptor>& handles,
+        ReplicaSelector::LoadGuard& load_guard,
+        const Replica::Descriptor** selected = nullptr);
+
+    // Recorded into by master_client_ and transfer_submitter_, so it is
+    // declared before them
+    ClientMetric metric_;
+    std::unique_ptr<coro_http::coro_http_server> metrics_server_;
 
     // Core components
     TransferEngine transfer_engine_;
@@ -240,6 +558,22 @@ class Client {
     const std::string local_hostname_;
     const std::string metadata_connstring_;
 
+    // Picks the replica to read from and tracks in-flight reads per segment
+    ReplicaSelector replica_selector_;
+    // Split reads of large objects across replicas (MC_STORE_STRIPED_READ)
+    bool striped_read_enabled_;
+
+    // Compression, set up on first use by InitCompression
+    std::once_flag compression_once_;
+    std::unique_ptr<CompressionStage> compression_stage_;
+    // Registered memory for compressed slices (MC_STORE_COMPRESSION_BUFFER_MB)
+    std::unique_ptr<SimpleAllocator> staging_allocator_;
+
+    // Evicted objects of the local segments, if enabled
+    std::unique_ptr<DiskTier> disk_tier_;
+    std::thread disk_tier_thread_;
+    std::atomic<bool> disk_tier_running_{false};
+
     // For high availability
     MasterViewHelper master_view_helper_;
     std::thread ping_thread_;
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "compression.h"
+#include "master_metric_manager.h"
+#include "transfer_task.h"
+#include "utils/latency_histogram.h"
+
+namespace mooncake {
+
+// Reasons for the client to repeat a request to the master
+enum class ClientRetry : uint8_t {
+    // Get polled the master while an object was promoted from a disk tier
+    PROMOTION_WAIT,
+    // The ping thread reconnected to a new master
+    MASTER_RECONNECT,
+    NUM_RETRIES,
+};
+
+/**
+ * @brief Metrics of one Client
+ *
+ * Covers the latency of master RPCs per method, the latency and bytes of
+ * transfers per strategy and direction, the bytes moved per peer segment,
+ * retries, revoked puts, the codec and the RPCs and transfers in flight.
+ * Recording only
+ * touches atomics, apart from the first transfer to a new peer. Thread safe.
+ */
+class ClientMetric {
+   public:
+    using OpCode = Transport::TransferRequest::OpCode;
+
+    ClientMetric() = default;
+    ClientMetric(const ClientMetric&) = delete;
+    ClientMetric& operator=(const ClientMetric&) = delete;
+
+    /**
+     * @brief Times one master RPC and counts it as in flight meanwhile
+     */
+    class RpcScope {
+       public:
+        RpcScope(ClientMetric& metric, MasterRpc rpc);
+        ~RpcScope();
+
+        RpcScope(const RpcScope&) = delete;
+        RpcScope& operator=(const RpcScope&) = delete;
+
+       private:
+        ClientMetric& metric_;
+        ScopedLatencyRecorder latency_;
+    };
+
+    LatencyHistogram& rpc_latency(MasterRpc rpc) {
+        return rpc_latencies_[static_cast<size_t>(rpc)];
+    }
+
+    const LatencyHistogram& transfer_latency(TransferStrategy strategy,
+                                             OpCode op_code) const {
+        return transfers_[TransferIndex(strategy, op_code)].latency;
+    }
+
+    /**
+     * @brief Account a submitted transfer as in flight until it is recorded
+     * by RecordTransfer or dropped by AbandonTransfer
+     */
+    void StartTransfer() {
+        transfers_in_flight_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Account a finished transfer. Bytes only count on success.
+     */
+    void RecordTransfer(TransferStrategy strategy, OpCode op_code,
+                        uint64_t bytes,
+                        std::chrono::steady_clock::duration latency,
+                        bool success);
+
+    // A transfer whose result was never observed
+    void AbandonTransfer() {
+        transfers_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Add bytes moved from or to the segment of a peer
+     */
+    void RecordPeerBytes(const std::string& peer, OpCode op_code,
+                         uint64_t bytes);
+
+    void IncRetry(ClientRetry reason, uint64_t count = 1) {
+        retries_[static_cast<size_t>(reason)].fetch_add(
+            count, std::memory_order_relaxed);
+    }
+
+    // Objects whose put was revoked
+    void IncRevokedPuts(uint64_t count = 1) {
+        revoked_puts_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Account one slice run through the compressor. stored_bytes is
+     * what was written for it, raw_bytes if it did not shrink.
+     */
+    void RecordCompress(uint64_t raw_bytes, uint64_t stored_bytes,
+                        uint64_t ns);
+    void RecordDecompress(uint64_t raw_bytes, uint64_t ns);
+    CompressionStats compression_stats() const;
+
+    uint64_t transfer_bytes(TransferStrategy strategy, OpCode op_code) const {
+        return transfers_[TransferIndex(strategy, op_code)].bytes.load(
+            std::memory_order_relaxed);
+    }
+    uint64_t transfer_failures(TransferStrategy strategy,
+                               OpCode op_code) const {
+        return transfers_[TransferIndex(strategy, op_code)].failures.load(
+            std::memory_order_relaxed);
+    }
+    uint64_t peer_bytes(const std::string& peer, OpCode op_code) const;
+    uint64_t retries(ClientRetry reason) const {
+        return retries_[static_cast<size_t>(reason)].load(
+            std::memory_order_relaxed);
+    }
+    uint64_t revoked_puts() const {
+        return revoked_puts_.load(std::memory_order_relaxed);
+    }
+    int64_t rpcs_in_flight() const {
+        return rpcs_in_flight_.load(std::memory_order_relaxed);
+    }
+    int64_t transfers_in_flight() const {
+        return transfers_in_flight_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Serializes all metrics into Prometheus text format. Latency
+     * summaries and peers without samples are left out.
+     */
+    std::string Serialize() const;
+
+   private:
+    static constexpr size_t kNumStrategies = 2;
+    static constexpr size_t kNumOpCodes = 2;
+
+    struct TransferStats {
+        LatencyHistogram latency;
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> failures{0};
+    };
+
+    struct PeerStats {
+        std::array<std::atomic<uint64_t>, kNumOpCodes> bytes{};
+    };
+
+    static size_t OpIndex(OpCode op_code) {
+        return op_code == Transport::TransferRequest::READ ? 0 : 1;
+    }
+
+    static size_t TransferIndex(TransferStrategy strategy, OpCode op_code) {
+        return static_cast<size_t>(strategy) * kNumOpCodes + OpIndex(op_code);
+    }
+
+    std::array<LatencyHistogram, static_cast<size_t>(MasterRpc::NUM_RPCS)>
+        rpc_latencies_;
+    std::array<TransferStats, kNumStrategies * kNumOpCodes> transfers_;
+
+    mutable std::shared_mutex peers_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<PeerStats>> peers_;
+
+    std::array<std::atomic<uint64_t>,
+               static_cast<size_t>(ClientRetry::NUM_RETRIES)>
+        retries_{};
+    std::atomic<uint64_t> revoked_puts_{0};
+
+    std::atomic<uint64_t> compressed_slices_{0};
+    std::atomic<uint64_t> compress_raw_bytes_{0};
+    std::atomic<uint64_t> compress_stored_bytes_{0};
+    std::atomic<uint64_t> compress_ns_{0};
+    std::atomic<uint64_t> decompressed_bytes_{0};
+    std::atomic<uint64_t> decompress_ns_{0};
+    std::atomic<int64_t> rpcs_in_flight_{0};
+    std::atomic<int64_t> transfers_in_flight_{0};
+};
+
+}  // namespace mooncake
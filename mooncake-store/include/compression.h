@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+// Objects smaller than this are not worth compressing
+static constexpr uint64_t kMinCompressSize = 4096;
+
+/**
+ * @brief Whether the codec is compiled into this build
+ */
+bool IsCodecSupported(CompressionCodec codec);
+
+/**
+ * @brief Encode one slice
+ *
+ * The data is first byte-shuffled if shuffle_bytes > 1, grouping the n-th
+ * byte of every element together, which makes fp16/bf16 tensors much more
+ * compressible. The result is then compressed with the codec.
+ *
+ * @return Encoded size, or 0 if the encoded data does not fit in dst_capacity.
+ * Callers pass the raw size as capacity, so 0 means the slice does not
+ * compress and should be stored as is.
+ */
+size_t CompressSlice(CompressionCodec codec, uint8_t shuffle_bytes,
+                     const void* src, size_t src_size, void* dst,
+                     size_t dst_capacity);
+
+/**
+ * @brief Decode one slice encoded by CompressSlice
+ * @return true if exactly raw_size bytes were decoded into dst
+ */
+bool DecompressSlice(CompressionCodec codec, uint8_t shuffle_bytes,
+                     const void* src, size_t src_size, void* dst,
+                     size_t raw_size);
+
+/**
+ * @brief Cumulative codec statistics of a client
+ */
+struct CompressionStats {
+    uint64_t compressed_slices{0};
+    uint64_t raw_bytes{0};      // Input of the compressor
+    uint64_t stored_bytes{0};   // What was written for that input
+    uint64_t compress_ns{0};    // Time spent compressing
+    uint64_t decompressed_bytes{0};
+    uint64_t decompress_ns{0};  // Time spent decompressing
+
+    double ratio() const {
+        return stored_bytes ? static_cast<double>(raw_bytes) / stored_bytes
+                            : 0;
+    }
+    // Throughput in MB/s of raw data
+    double compress_mbps() const {
+        return compress_ns ? raw_bytes * 1000.0 / compress_ns : 0;
+    }
+    double decompress_mbps() const {
+        return decompress_ns ? decompressed_bytes * 1000.0 / decompress_ns
+                             : 0;
+    }
+};
+
+/**
+ * @brief Runs the codec over the slices of a value in parallel
+ *
+ * The number of worker threads can be set via MC_STORE_COMPRESSION_THREADS
+ * and defaults to min(hardware threads, 4). The calling thread always takes
+ * part in the work.
+ */
+class CompressionStage {
+   public:
+    explicit CompressionStage(size_t num_workers = 0);
+    ~CompressionStage();
+
+    CompressionStage(const CompressionStage&) = delete;
+    CompressionStage& operator=(const CompressionStage&) = delete;
+
+    /**
+     * @brief Run task(i) for every i in [0, count) and wait for all of them
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+   private:
+    struct Job {
+        const std::function<void(size_t)>* task{nullptr};
+        size_t count{0};
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    static size_t get_worker_count();
+    static void RunJob(Job& job);
+    void WorkerThread();
+
+    std::vector<std::thread> workers_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    bool shutdown_{false};
+};
+
+}  // namespace mooncake
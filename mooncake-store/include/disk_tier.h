@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief File backed store for objects evicted from the local segment
+ *
+ * Objects are written as extents of one preallocated file. The file is opened
+ * with O_DIRECT so that spilled data does not fill the page cache, falling
+ * back to buffered I/O on file systems without O_DIRECT support. All I/O goes
+ * through an aligned bounce buffer, so the slices need no alignment.
+ *
+ * Thread safe. The file is removed when the store is destroyed, a disk tier
+ * does not survive its client.
+ */
+class DiskTier {
+   public:
+    // Offsets and sizes of extents are multiples of this
+    static constexpr size_t kAlignment = 4096;
+
+    /**
+     * @brief Create the backing file
+     * @param path File to create, an existing file is overwritten
+     * @param capacity Size of the file in bytes
+     * @return nullptr if the file cannot be created
+     */
+    static std::unique_ptr<DiskTier> Create(const std::string& path,
+                                            size_t capacity);
+
+    ~DiskTier();
+
+    DiskTier(const DiskTier&) = delete;
+    DiskTier& operator=(const DiskTier&) = delete;
+
+    /**
+     * @brief Write the slices back to back into a new extent
+     * @param[out] offset Offset of the extent
+     * @return ErrorCode::BUFFER_OVERFLOW if there is no room left,
+     * ErrorCode::WRITE_FAIL on I/O errors
+     */
+    ErrorCode Write(const std::vector<Slice>& slices, uint64_t& offset);
+
+    /**
+     * @brief Read the extent at offset into slices, which must have the sizes
+     * the extent was written with
+     * @param start Position in the extent to read from, for ranged reads
+     * @return ErrorCode::INVALID_PARAMS if there is no such extent or it is
+     * smaller than start plus the slices, ErrorCode::INVALID_READ on I/O
+     * errors
+     */
+    ErrorCode Read(uint64_t offset, const std::vector<Slice>& slices,
+                   uint64_t start = 0);
+
+    /**
+     * @brief Release the extent at offset. Reads in progress keep the extent
+     * until they finish, so its space is not handed out meanwhile.
+     */
+    void Free(uint64_t offset);
+
+    size_t capacity() const { return capacity_; }
+    size_t used() const;
+    bool direct_io() const { return direct_io_; }
+
+   private:
+    DiskTier(int fd, std::string path, size_t capacity, bool direct_io);
+
+    struct Extent {
+        uint64_t size;  // aligned
+        uint32_t readers{0};
+        bool freed{false};  // released once the last reader is done
+    };
+
+    // First fit allocation of an aligned extent
+    bool AllocateExtent(size_t size, uint64_t& offset);
+
+    // Scatter size bytes from position start of the extent at offset over
+    // the slices
+    ErrorCode ReadExtent(uint64_t offset, uint64_t start, size_t size,
+                         const std::vector<Slice>& slices);
+
+    // Return the extent to the free list, mutex_ must be held
+    void ReleaseExtentLocked(
+        std::unordered_map<uint64_t, Extent>::iterator it);
+
+    const int fd_;
+    const std::string path_;
+    const size_t capacity_;
+    const bool direct_io_;
+
+    mutable std::mutex mutex_;
+    std::map<uint64_t, uint64_t> free_extents_;  // offset -> size
+    std::unordered_map<uint64_t, Extent> used_extents_;  // offset -> extent
+    size_t used_{0};
+};
+
+}  // namespace mooncake
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mooncake {
+
+// Copies at least this large bypass the cache with non-temporal stores
+constexpr size_t kNonTemporalCopyThreshold = 1024 * 1024;
+
+/**
+ * @brief memcpy for large, non-overlapping buffers
+ *
+ * Copies of at least kNonTemporalCopyThreshold bytes use an AVX-512 or AVX2
+ * kernel with non-temporal stores when the CPU supports it, so that the
+ * destination does not evict the working set from the cache and no read for
+ * ownership is issued for it. Everything else falls back to std::memcpy.
+ */
+void fast_memcpy(void* dest, const void* src, size_t size);
+
+}  // namespace mooncake
@@ -82,7 +82,8 @@ class MasterServiceSupervisor {
         double eviction_high_watermark_ratio,
         int64_t client_live_ttl_sec,
         const std::string& etcd_endpoints = "0.0.0.0:2379",
-        const std::string& local_hostname = "0.0.0.0:50051");
+        const std::string& local_hostname = "0.0.0.0:50051",
+        bool enable_prefix_index = false);
     int Start();
     ~MasterServiceSupervisor();
 
@@ -97,6 +98,7 @@ class MasterServiceSupervisor {
     double eviction_ratio_;
     double eviction_high_watermark_ratio_;
     int64_t client_live_ttl_sec_;
+    bool enable_prefix_index_;
 
     // coro_rpc server thread
     std::thread server_thread_;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <ylt/coro_rpc/coro_rpc_client.hpp>
 
+#include "client_metric.h"
 #include "rpc_service.h"
 #include "types.h"
 
@@ -16,10 +19,17 @@ static const std::string kDefaultMasterAddress = "localhost:50051";
 
 /**
  * @brief Client for interacting with the mooncake master service
+ *
+ * The synchronous RPCs on the Get/Put path pass the trace id of the calling
+ * thread (Tracer::currentTraceId) to the master, which traces them under it.
  */
 class MasterClient {
    public:
-    MasterClient();
+    /**
+     * @param metric Receives the latency of every RPC, must outlive the
+     * MasterClient
+     */
+    explicit MasterClient(ClientMetric& metric);
     ~MasterClient();
 
     MasterClient(const MasterClient&) = delete;
@@ -41,6 +51,22 @@ class MasterClient {
     [[nodiscard]] ExistKeyResponse ExistKey(
         const std::string& object_key);
 
+    /**
+     * @brief Checks if a batch of objects exist
+     * @param object_keys Keys to query
+     * @return Per-key ErrorCode indicating exist or not
+     */
+    [[nodiscard]] BatchExistKeyResponse BatchExistKey(
+        const std::vector<std::string>& object_keys);
+
+    /**
+     * @brief Finds how many leading keys of a block chain are cached
+     * @param object_keys Keys of the chain, first block first
+     * @return Length of the cached prefix, leased on the master
+     */
+    [[nodiscard]] LongestCachedPrefixResponse LongestCachedPrefix(
+        const std::vector<std::string>& object_keys);
+
     /**
      * @brief Gets object metadata without transferring data
      * @param object_key Key to query
@@ -59,18 +85,43 @@ class MasterClient {
     [[nodiscard]] BatchGetReplicaListResponse BatchGetReplicaList(
         const std::vector<std::string>& object_keys);
 
+    /**
+     * @brief Gets object metadata and pins the object so that it is not
+     * removed or evicted until UnpinKey is called
+     * @param object_key Key to pin
+     * @param client_id Client owning the pin, its pins are dropped when it
+     * expires
+     * @return Replica list and ErrorCode indicating success/failure
+     */
+    [[nodiscard]] GetReplicaListResponse PinKey(const std::string& object_key,
+                                                const UUID& client_id);
+
+    /**
+     * @brief Releases a pin taken by PinKey
+     * @param object_key Key to unpin
+     * @param client_id Client that took the pin
+     * @return ErrorCode indicating success/failure
+     */
+    [[nodiscard]] UnpinKeyResponse UnpinKey(const std::string& object_key,
+                                            const UUID& client_id);
+
     /**
      * @brief Starts a put operation
      * @param key Object key
      * @param slice_lengths Vector of slice lengths
      * @param value_length Total value length
      * @param config Replication configuration
+     * @param compression How the slices were encoded, if at all
+     * @param content_hash Hash of the raw value for deduplication, empty to
+     * disable it
      * @param start_response Output parameter for put start response
      * @return ErrorCode indicating success/failure
      */
     [[nodiscard]] PutStartResponse PutStart(
         const std::string& key, const std::vector<size_t>& slice_lengths,
-        size_t value_length, const ReplicateConfig& config);
+        size_t value_length, const ReplicateConfig& config,
+        const CompressionInfo& compression = {},
+        const ContentHash& content_hash = {});
 
     /**
      * @brief Starts a batch of put operations for N objects
@@ -124,6 +175,14 @@ class MasterClient {
      */
     [[nodiscard]] RemoveResponse Remove(const std::string& key);
 
+    /**
+     * @brief Removes a batch of objects and all their replicas
+     * @param keys Keys to remove
+     * @return Per-key ErrorCode indicating success/failure
+     */
+    [[nodiscard]] BatchRemoveResponse BatchRemove(
+        const std::vector<std::string>& keys);
+
     /**
      * @brief Removes all objects and all its replicas
      * @return ErrorCode indicating success/failure
@@ -169,8 +228,86 @@ class MasterClient {
      */
     [[nodiscard]] PingResponse Ping(const UUID& client_id);
 
+    /**
+     * @brief Polls the work for the disk tier of this client
+     * @param client_id The uuid of the client
+     * @return Tasks to run and ErrorCode indicating success/failure
+     */
+    [[nodiscard]] FetchDiskTasksResponse FetchDiskTasks(const UUID& client_id);
+
+    /**
+     * @brief Reports the outcome of a SPILL task
+     * @param key Object key
+     * @param location Where the object was written
+     * @param success Whether the write succeeded
+     * @return ErrorCode::OK if the master now references location
+     */
+    [[nodiscard]] SpillEndResponse SpillEnd(const std::string& key,
+                                            const DiskLocation& location,
+                                            bool success);
+
+    /**
+     * @brief Reports the outcome of a PROMOTE task
+     * @param key Object key
+     * @param location Where the object was read from
+     * @param success Whether the buffers were filled
+     * @return ErrorCode indicating success/failure
+     */
+    [[nodiscard]] PromoteEndResponse PromoteEnd(const std::string& key,
+                                                const DiskLocation& location,
+                                                bool success);
+
+    /**
+     * @brief Asynchronous variants of the RPCs on the Get/Put path. They
+     * suspend the calling coroutine instead of blocking the thread while the
+     * master handles the request. Arguments are copied into the coroutine.
+     * The trace id of a sampled request is passed explicitly, as the
+     * coroutine may resume on another thread than its caller.
+     */
+    [[nodiscard]] async_simple::coro::Lazy<GetReplicaListResponse>
+    AsyncGetReplicaList(std::string object_key, uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<BatchGetReplicaListResponse>
+    AsyncBatchGetReplicaList(std::vector<std::string> object_keys,
+                             uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<PutStartResponse> AsyncPutStart(
+        std::string key, std::vector<uint64_t> slice_lengths,
+        uint64_t value_length, ReplicateConfig config,
+        CompressionInfo compression = {}, ContentHash content_hash = {},
+        uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<BatchPutStartResponse>
+    AsyncBatchPutStart(
+        std::vector<std::string> keys,
+        std::unordered_map<std::string, uint64_t> value_lengths,
+        std::unordered_map<std::string, std::vector<uint64_t>> slice_lengths,
+        ReplicateConfig config, uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<PutEndResponse> AsyncPutEnd(
+        std::string key, uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<BatchPutEndResponse>
+    AsyncBatchPutEnd(std::vector<std::string> keys, uint64_t trace_id = 0);
+
+    [[nodiscard]] async_simple::coro::Lazy<PutRevokeResponse> AsyncPutRevoke(
+        std::string key);
+
+    [[nodiscard]] async_simple::coro::Lazy<BatchPutRevokeResponse>
+    AsyncBatchPutRevoke(std::vector<std::string> keys);
+
    private:
+    /**
+     * @brief Send a request to the master and await the response, returning
+     * fail_response if the RPC itself fails
+     */
+    template <auto ServiceMethod, typename ResponseType, typename... Args>
+    async_simple::coro::Lazy<ResponseType> InvokeAsync(
+        std::string_view rpc_name, MasterRpc rpc, ResponseType fail_response,
+        Args... args);
+
     coro_rpc_client client_;
+    ClientMetric& metric_;
 };
 
 }  // namespace mooncake
@@ -1,14 +1,54 @@
 #pragma once
 
+#include <array>
 #include <mutex>
 #include <string>
 
+#include "utils/latency_histogram.h"
 #include "ylt/metric/counter.hpp"
 #include "ylt/metric/gauge.hpp"
 #include "ylt/metric/histogram.hpp"
 
 namespace mooncake {
 
+// Master RPCs whose latency is tracked
+enum class MasterRpc : uint8_t {
+    EXIST_KEY,
+    BATCH_EXIST_KEY,
+    LONGEST_CACHED_PREFIX,
+    GET_REPLICA_LIST,
+    BATCH_GET_REPLICA_LIST,
+    PIN_KEY,
+    UNPIN_KEY,
+    PUT_START,
+    PUT_END,
+    PUT_REVOKE,
+    BATCH_PUT_START,
+    BATCH_PUT_END,
+    BATCH_PUT_REVOKE,
+    REMOVE,
+    BATCH_REMOVE,
+    REMOVE_ALL,
+    MOUNT_SEGMENT,
+    REMOUNT_SEGMENT,
+    UNMOUNT_SEGMENT,
+    PING,
+    FETCH_DISK_TASKS,
+    SPILL_END,
+    PROMOTE_END,
+    NUM_RPCS,
+};
+
+// Method name of rpc, as used in metric labels
+const char* MasterRpcName(MasterRpc rpc);
+
+// Master locks whose contention is tracked
+enum class MasterLock : uint8_t {
+    METADATA_SHARD,
+    SEGMENT,
+    NUM_LOCKS,
+};
+
 class MasterMetricManager {
    public:
     // --- Singleton Access ---
@@ -98,6 +138,27 @@ class MasterMetricManager {
     int64_t get_evicted_key_count();
     int64_t get_evicted_size();
 
+    // Deduplication Metrics
+    void inc_dedup_hit(int64_t saved_size);
+    int64_t get_dedup_hits();
+    int64_t get_dedup_saved_size();
+
+    // Disk Tier Metrics
+    void inc_disk_spill(int64_t size);
+    void inc_disk_promotion();
+    int64_t get_disk_spills();
+    int64_t get_disk_spilled_size();
+    int64_t get_disk_promotions();
+
+    // Latency Metrics
+    LatencyHistogram& rpc_latency(MasterRpc rpc) {
+        return rpc_latencies_[static_cast<size_t>(rpc)];
+    }
+    // Time spent waiting for a contended lock
+    LatencyHistogram& lock_wait(MasterLock lock) {
+        return lock_waits_[static_cast<size_t>(lock)];
+    }
+
     // --- Serialization ---
     /**
      * @brief Serializes all managed metrics into Prometheus text format.
@@ -162,6 +223,21 @@ class MasterMetricManager {
     ylt::metric::counter_t evicted_key_count_;
     ylt::metric::counter_t evicted_size_;
 
+    // Deduplication Metrics
+    ylt::metric::counter_t dedup_hits_;
+    ylt::metric::counter_t dedup_saved_size_;
+
+    // Disk Tier Metrics
+    ylt::metric::counter_t disk_spills_;
+    ylt::metric::counter_t disk_spilled_size_;
+    ylt::metric::counter_t disk_promotions_;
+
+    // Latency Metrics
+    std::array<LatencyHistogram, static_cast<size_t>(MasterRpc::NUM_RPCS)>
+        rpc_latencies_;
+    std::array<LatencyHistogram, static_cast<size_t>(MasterLock::NUM_LOCKS)>
+        lock_waits_;
+
     // Some metrics are used only in HA mode. Use a flag to control the output
     // content.
     bool enable_ha_{false};
@@ -16,9 +16,12 @@
 
 #include "allocation_strategy.h"
 #include "eviction_strategy.h"
+#include "master_metric_manager.h"
 #include "allocator.h"
+#include "prefix_index.h"
 #include "types.h"
 #include "segment.h"
+#include "trace.h"
 
 
 namespace mooncake {
@@ -46,7 +49,9 @@ struct GCTask {
  * Lock order: To avoid deadlocks, the following lock order should be followed:
  * 1. client_mutex_
  * 2. metadata_shards_[shard_idx_].mutex
- * 3. segment_mutex_
+ * 3. content_shards_[shard_idx_].mutex
+ * 4. segment_mutex_
+ * 5. disk_tier_mutex_
 */
 class MasterService {
    private:
@@ -64,7 +69,7 @@ class MasterService {
                   double eviction_high_watermark_ratio = DEFAULT_EVICTION_HIGH_WATERMARK_RATIO,
                   ViewVersionId view_version = 0,
                   int64_t client_live_ttl_sec = DEFAULT_CLIENT_LIVE_TTL_SEC,
-                  bool enable_ha = false);
+                  bool enable_ha = false, bool enable_prefix_index = false);
     ~MasterService();
 
     /**
@@ -106,6 +111,24 @@ class MasterService {
      */
     ErrorCode ExistKey(const std::string& key);
 
+    /**
+     * @brief Check if a batch of objects exist. Keys are grouped by metadata
+     * shard so that each shard is locked only once.
+     * @return Per-key result in the order of keys, with the same meaning as
+     * ExistKey
+     */
+    std::vector<ErrorCode> BatchExistKey(const std::vector<std::string>& keys);
+
+    /**
+     * @brief Find how many leading keys of a chain of KV cache blocks are
+     * cached, granting each of them a lease as ExistKey does. With the prefix
+     * index enabled, keys must have the "<parent_hash>/<block_hash>" format
+     * of PrefixIndex and chains are matched in the index before the object
+     * metadata is checked.
+     * @return Number of leading keys that exist
+     */
+    size_t LongestCachedPrefix(const std::vector<std::string>& keys);
+
     /**
      * @brief Fetch all keys
      * @return ErrorCode::OK if exists
@@ -145,6 +168,28 @@ class MasterService {
         std::unordered_map<std::string, std::vector<Replica::Descriptor>>&
             batch_replica_list);
 
+    /**
+     * @brief Get list of replicas for an object and pin it. A pinned object
+     * is not removed, evicted or garbage collected until every pin on it has
+     * been released with UnpinKey, so its buffers can be read in place.
+     * Pins are owned by client_id and dropped when that client expires. Without
+     * HA the master cannot tell whether a client is alive, so a pin is
+     * dropped once it has been held for client_live_ttl_sec; pinning the key
+     * again renews the pins of the client.
+     * @param[out] replica_list Vector to store replica information
+     * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND if not
+     * found, ErrorCode::REPLICA_IS_NOT_READY if not ready
+     */
+    ErrorCode PinKey(const std::string& key, const UUID& client_id,
+                     std::vector<Replica::Descriptor>& replica_list);
+
+    /**
+     * @brief Release a pin taken by PinKey from the same client
+     * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND if not
+     * found, ErrorCode::INVALID_PARAMS if the client holds no pin on it
+     */
+    ErrorCode UnpinKey(const std::string& key, const UUID& client_id);
+
     /**
      * @brief Mark a key for garbage collection after specified delay
      * @param key The key to be garbage collected
@@ -156,6 +201,13 @@ class MasterService {
     /**
      * @brief Start a put operation for an object
      * @param[out] replica_list Vector to store replica information for slices
+     * @param compression How the client encoded the slices; value_length and
+     * slice_lengths are the stored, i.e. encoded, sizes
+     * @param content_hash Hash of the raw value, empty if the client did not
+     * ask for deduplication. If a complete object with the same hash and raw
+     * size exists, the key is mapped onto its buffers and replica_list is
+     * returned already COMPLETE: nothing has to be written and no PutEnd is
+     * expected.
      * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND if exists,
      *         ErrorCode::NO_AVAILABLE_HANDLE if allocation fails,
      *         ErrorCode::INVALID_PARAMS if slice size is invalid
@@ -163,7 +215,9 @@ class MasterService {
     ErrorCode PutStart(const std::string& key, uint64_t value_length,
                        const std::vector<uint64_t>& slice_lengths,
                        const ReplicateConfig& config,
-                       std::vector<Replica::Descriptor>& replica_list);
+                       std::vector<Replica::Descriptor>& replica_list,
+                       const CompressionInfo& compression = {},
+                       const ContentHash& content_hash = {});
 
     /**
      * @brief Complete a put operation
@@ -216,6 +270,14 @@ class MasterService {
      */
     ErrorCode Remove(const std::string& key);
 
+    /**
+     * @brief Remove a batch of objects and their replicas. Keys are grouped by
+     * metadata shard so that each shard is locked only once.
+     * @return Per-key result in the order of keys, with the same meaning as
+     * Remove
+     */
+    std::vector<ErrorCode> BatchRemove(const std::vector<std::string>& keys);
+
     /**
      * @brief Remove all objects and their replicas
      * @return return the number of objects removed
@@ -240,6 +302,42 @@ class MasterService {
     ErrorCode Ping(const UUID& client_id, ViewVersionId& view_version,
               ClientStatus& client_status);
 
+    /**
+     * @brief Poll the work for the disk tier of a client. Calling it also
+     * registers the segments of the client as backed by a disk tier, so that
+     * eviction moves their objects to disk instead of dropping them, for as
+     * long as the client keeps polling.
+     * @param[out] tasks Tasks to run, each SPILL and PROMOTE task must be
+     * answered with SpillEnd or PromoteEnd
+     * @return ErrorCode::OK on success
+     */
+    ErrorCode FetchDiskTasks(const UUID& client_id,
+                             std::vector<DiskTask>& tasks);
+
+    /**
+     * @brief Complete a SPILL task. On success the memory replicas are
+     * replaced by a DISK replica at location and their buffers are freed.
+     * @param success Whether the data was written to location
+     * @return ErrorCode::OK if the object now lives at location. Any other
+     * code means the master does not reference location and the client has to
+     * free it: ErrorCode::OBJECT_NOT_FOUND if the object is gone,
+     * ErrorCode::INVALID_WRITE if it is no longer being spilled,
+     * ErrorCode::OBJECT_HAS_LEASE if it was read in the meantime.
+     */
+    ErrorCode SpillEnd(const std::string& key, const DiskLocation& location,
+                       bool success);
+
+    /**
+     * @brief Complete a PROMOTE task. On success the memory replica becomes
+     * COMPLETE and the DISK replica at location is dropped, so the client
+     * frees location. On failure the object stays on disk.
+     * @param success Whether the buffers were filled from location
+     * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND or
+     * ErrorCode::INVALID_WRITE if there is no such promotion
+     */
+    ErrorCode PromoteEnd(const std::string& key, const DiskLocation& location,
+                         bool success);
+
    private:
     // GC thread function
     void GCThreadFunc();
@@ -250,6 +348,19 @@ class MasterService {
     // Clear invalid handles in all shards
     void ClearInvalidHandles();
 
+    // Drop the pins held by expired clients and the pins past their deadline
+    void ReleaseStalePins(const std::vector<UUID>& expired_clients);
+
+    // Drop content index entries whose buffers have all been freed
+    void SweepContentIndex();
+
+    // Drop prefix index entries of objects that have been removed or evicted
+    void SweepPrefixIndex();
+
+    // Abandon timed out promotions and drop the least recently used disk
+    // objects of disk tiers that rejected a spill
+    void SweepDiskTier();
+
     // Internal data structures
     struct ObjectMetadata {
         std::vector<Replica> replicas;
@@ -257,6 +368,42 @@ class MasterService {
         // Default constructor, creates a time_point representing
         // the Clock's epoch (i.e., time_since_epoch() is zero).
         std::chrono::steady_clock::time_point lease_timeout;
+        // Outstanding PinKey calls per client. A pinned object holds a lease
+        // that does not expire.
+        struct Pin {
+            uint32_t count{0};
+            // Only set without HA, where clients are not monitored
+            std::chrono::steady_clock::time_point deadline;
+        };
+        std::unordered_map<UUID, Pin, boost::hash<UUID>> pins;
+        // Hash to publish in the content index once the put completes
+        ContentHash content_hash;
+        // Set while a SPILL or PROMOTE task of the object is outstanding. If
+        // the owner does not answer in time the task is abandoned.
+        std::chrono::steady_clock::time_point disk_task_deadline;
+
+        // Bytes freed by dropping the object. Buffers shared with
+        // deduplicated objects stay allocated, and disk replicas hold none.
+        uint64_t FreeableSize() const {
+            uint64_t freeable = 0;
+            for (const auto& replica : replicas) {
+                for (const auto& buffer : replica.buffers()) {
+                    if (buffer.use_count() == 1) {
+                        freeable += buffer->size();
+                    }
+                }
+            }
+            return freeable;
+        }
+
+        bool IsOnDisk() const {
+            return !replicas.empty() &&
+                   replicas.front().status() == ReplicaStatus::DISK;
+        }
+
+        bool IsSpilling(std::chrono::steady_clock::time_point& now) const {
+            return !IsOnDisk() && now < disk_task_deadline;
+        }
 
         // Check if there is some replica with a different status than the given value.
         // If there is, return the status of the first replica that is not equal to
@@ -278,12 +425,13 @@ class MasterService {
 
         // Check if the lease has expired
         bool IsLeaseExpired() const {
-            return std::chrono::steady_clock::now() >= lease_timeout;
+            return pins.empty() &&
+                   std::chrono::steady_clock::now() >= lease_timeout;
         }
 
         // Check if the lease has expired
         bool IsLeaseExpired(std::chrono::steady_clock::time_point &now) const {
-            return now >= lease_timeout;
+            return pins.empty() && now >= lease_timeout;
         }
     };
 
@@ -300,14 +448,109 @@ class MasterService {
     };
     std::array<MetadataShard, kNumShards> metadata_shards_;
 
+    // Lock a metadata shard, recording the wait if the lock is contended and
+    // tracing it for sampled requests
+    static std::unique_lock<std::mutex> LockShard(const MetadataShard& shard) {
+        TraceSpan span("master.shard_lock");
+        return AcquireMeasured<std::unique_lock<std::mutex>>(
+            shard.mutex, MasterMetricManager::instance().lock_wait(
+                             MasterLock::METADATA_SHARD));
+    }
+
     // Helper to get shard index from key
     size_t getShardIndex(const std::string& key) const {
         return std::hash<std::string>{}(key) % kNumShards;
     }
 
+    // Content index of complete deduplicated objects. Entries only hold weak
+    // references to the buffers, which are owned by the replicas of the
+    // objects sharing them, so the memory is freed with the last of them.
+    struct ContentEntry {
+        std::vector<std::vector<std::weak_ptr<AllocatedBuffer>>> replicas;
+        CompressionInfo compression;
+        uint64_t size{0};  // Stored size
+        // Slice sizes before compression, which the slices of readers follow
+        std::vector<uint64_t> raw_slice_lengths;
+    };
+    static constexpr size_t kNumContentShards = 64;
+    struct ContentShard {
+        std::mutex mutex;
+        std::unordered_map<ContentHash, ContentEntry, ContentHashHasher>
+            entries;
+    };
+    std::array<ContentShard, kNumContentShards> content_shards_;
+    // Number of GC thread iterations between two sweeps of the content and
+    // prefix indexes
+    static constexpr uint64_t kContentSweepInterval = 1000;
+
+    ContentShard& getContentShard(const ContentHash& hash) {
+        return content_shards_[ContentHashHasher{}(hash) % kNumContentShards];
+    }
+
+    // Build replicas sharing the buffers of the object indexed under hash.
+    // Returns false if there is no live object with that hash and raw slice
+    // layout.
+    bool LookupContent(const ContentHash& hash,
+                       const std::vector<uint64_t>& raw_slice_lengths,
+                       size_t max_replicas, std::vector<Replica>& replicas,
+                       uint64_t& size);
+
+    // Index the complete object's buffers under its content hash
+    void PublishContent(const ObjectMetadata& metadata);
+
+    // Disk tier related members. A SPILL task is handed to the client owning
+    // the segment of the object's first replica, if that client polls for
+    // disk tasks. The data stays in memory until the client confirms the
+    // write, so eviction counts objects being spilled as already evicted.
+    static constexpr uint64_t kDiskTaskTimeoutMs = 10 * 1000;
+    // A client not polling for this long no longer accepts spills
+    static constexpr uint64_t kDiskTierOwnerTtlMs = 5 * 1000;
+    // Number of GC thread iterations between two sweeps of the disk tier
+    static constexpr uint64_t kDiskSweepInterval = 100;
+    struct DiskTierOwner {
+        UUID client_id;
+        std::chrono::steady_clock::time_point last_poll;
+        // Disk space to free after a failed spill
+        uint64_t reclaim_bytes{0};
+    };
+    std::mutex disk_tier_mutex_;
+    std::unordered_map<std::string, DiskTierOwner>
+        disk_tier_owners_;  // segment name -> owner
+    std::unordered_map<UUID, std::vector<DiskTask>, boost::hash<UUID>>
+        disk_tasks_;  // client id -> pending tasks
+
+    // Queue a SPILL task for the object if its segment has a disk tier
+    bool TrySpill(const std::string& key, ObjectMetadata& metadata,
+                  std::chrono::steady_clock::time_point& now);
+
+    // Allocate memory in the owner's segment and queue a PROMOTE task
+    void TryPromote(const std::string& key, ObjectMetadata& metadata);
+
+    // Free the memory replica of a promotion the owner did not finish in
+    // time. Returns true if there was one.
+    bool DropStalePromotion(const std::string& key, ObjectMetadata& metadata,
+                            std::chrono::steady_clock::time_point& now);
+
+    // Queue DROP tasks for the disk replicas of an object being erased
+    void DropDiskReplicas(const std::string& key,
+                          const ObjectMetadata& metadata);
+
+    // Queue a task for the disk tier of client_id. Fails if the client no
+    // longer polls for tasks.
+    bool PushDiskTask(const UUID& client_id, const std::string& segment_name,
+                      DiskTask task);
+
     // Helper to clean up stale handles pointing to unmounted segments
     bool CleanupStaleHandles(ObjectMetadata& metadata);
 
+    // Group key indices by shard index, preserving order within each shard
+    std::unordered_map<size_t, std::vector<size_t>> GroupKeysByShard(
+        const std::vector<std::string>& keys) const;
+
+    // ExistKey and Remove on a shard whose mutex is already held
+    ErrorCode ExistKeyInShard(MetadataShard& shard, const std::string& key);
+    ErrorCode RemoveInShard(MetadataShard& shard, const std::string& key);
+
     // GC related members
     static constexpr size_t kGCQueueSize = 10 * 1024;  // Size of the GC queue
     boost::lockfree::queue<GCTask*> gc_queue_{kGCQueueSize};
@@ -316,6 +559,8 @@ class MasterService {
     bool enable_gc_{true};  // Flag to enable/disable garbage collection
     static constexpr uint64_t kGCThreadSleepMs =
         10;  // 10 ms sleep between GC and eviction checks
+    // Number of GC thread iterations between two checks of the pin deadlines
+    static constexpr uint64_t kPinSweepInterval = 100;
 
     // Lease related members
     const uint64_t default_kv_lease_ttl_; // in milliseconds
@@ -332,7 +577,7 @@ class MasterService {
             : service_(service),
               key_(key),
               shard_idx_(service_->getShardIndex(key)),
-              lock_(service_->metadata_shards_[shard_idx_].mutex),
+              lock_(LockShard(service_->metadata_shards_[shard_idx_])),
               it_(service_->metadata_shards_[shard_idx_].metadata.find(key)) {
             // Automatically clean up invalid handles
             if (it_ != service_->metadata_shards_[shard_idx_].metadata.end()) {
@@ -375,6 +620,8 @@ class MasterService {
     };
 
     friend class MetadataAccessor;
+    // Drives BatchEvict and ClearInvalidHandles in benchmarks
+    friend class MasterServiceBench;
 
     ViewVersionId view_version_;
 
@@ -398,6 +645,12 @@ class MasterService {
 
     // if high availability features enabled
     const bool enable_ha_;
+
+    // Blocks of complete objects with block keys. Entries are added by PutEnd
+    // and dropped lazily, by LongestCachedPrefix when it finds an entry without
+    // an object and by the periodic sweep of the GC thread.
+    const bool enable_prefix_index_;
+    PrefixIndex prefix_index_;
 };
 
 }  // namespace mooncake
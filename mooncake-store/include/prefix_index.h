@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Tree of the cached blocks of KV cache chains
+ *
+ * Keys that take part in the index have the form "<parent_hash>/<block_hash>",
+ * where parent_hash is the block hash of the previous block of the chain and
+ * is empty for the first block. Block hashes identify a node of the tree, so
+ * a chain of keys is cached as long as each block is indexed under the block
+ * before it. Other keys are ignored.
+ *
+ * The index only records which blocks have been put, callers verify the
+ * matched keys against the object metadata. Thread safe.
+ */
+class PrefixIndex {
+   public:
+    static constexpr char kSeparator = '/';
+
+    /**
+     * @brief Split a key into its parent and block hash
+     * @return false if the key does not have the block key format
+     */
+    static bool ParseKey(std::string_view key, std::string_view& parent,
+                         std::string_view& block);
+
+    /**
+     * @brief Index a block, replacing a node of the same block hash under
+     * another parent
+     */
+    void Insert(const std::string& key);
+
+    /**
+     * @brief Remove a block. Its descendants stay indexed but no chain
+     * through it matches until it is inserted again.
+     */
+    void Erase(const std::string& key);
+
+    /**
+     * @brief Number of leading keys that form a chain of indexed blocks, i.e.
+     * each key is indexed and is the child of the key before it
+     */
+    size_t Match(const std::vector<std::string>& keys) const;
+
+    /**
+     * @brief Keys of all indexed blocks
+     */
+    std::vector<std::string> Keys() const;
+
+    // Number of indexed blocks
+    size_t size() const;
+
+   private:
+    struct Node {
+        std::string parent;
+        uint32_t children = 0;
+        // False for nodes only kept as ancestors of indexed blocks
+        bool cached = false;
+    };
+
+    // Drop nodes from block upwards as long as they are neither cached nor
+    // have children
+    void PruneLocked(std::string block);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Node> nodes_;  // block hash -> node
+    size_t cached_{0};
+};
+
+}  // namespace mooncake
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Chooses which complete replica a client reads an object from.
+ *
+ * Replicas are ranked by locality first: a replica whose buffers all live on
+ * the client's own segment is served by the local memcpy path, a replica on
+ * another segment of the same host avoids the network, and everything else is
+ * a remote peer. Among replicas of the best locality, the one whose segments
+ * have the fewest reads in flight from this client wins. Remaining ties are
+ * broken randomly so that concurrent readers spread over equivalent replicas
+ * instead of all hitting the first one.
+ *
+ * The selector is thread-safe and is meant to be shared by all operations of
+ * one client.
+ */
+class ReplicaSelector {
+   public:
+    enum class Locality {
+        LOCAL = 0,      // All buffers are on the client's own segment
+        SAME_HOST = 1,  // All buffers are on segments of the same host
+        REMOTE = 2,     // At least one buffer is on another host
+    };
+
+    /**
+     * @brief RAII handle that keeps the in-flight counters of a replica's
+     * segments raised for the duration of a transfer
+     */
+    class LoadGuard {
+       public:
+        LoadGuard() = default;
+        LoadGuard(ReplicaSelector* selector, std::vector<std::string> segments)
+            : selector_(selector), segments_(std::move(segments)) {}
+
+        ~LoadGuard() { reset(); }
+
+        LoadGuard(const LoadGuard&) = delete;
+        LoadGuard& operator=(const LoadGuard&) = delete;
+
+        LoadGuard(LoadGuard&& other) noexcept
+            : selector_(other.selector_), segments_(std::move(other.segments_)) {
+            other.selector_ = nullptr;
+        }
+
+        LoadGuard& operator=(LoadGuard&& other) noexcept {
+            if (this != &other) {
+                reset();
+                selector_ = other.selector_;
+                segments_ = std::move(other.segments_);
+                other.selector_ = nullptr;
+            }
+            return *this;
+        }
+
+        void reset() {
+            if (selector_) {
+                selector_->Release(segments_);
+                selector_ = nullptr;
+            }
+            segments_.clear();
+        }
+
+       private:
+        ReplicaSelector* selector_{nullptr};
+        std::vector<std::string> segments_;
+    };
+
+    explicit ReplicaSelector(const std::string& local_hostname)
+        : local_hostname_(local_hostname),
+          local_host_(HostOf(local_hostname)) {}
+
+    ReplicaSelector(const ReplicaSelector&) = delete;
+    ReplicaSelector& operator=(const ReplicaSelector&) = delete;
+
+    /**
+     * @brief Pick the best complete replica
+     * @param replica_list Replicas returned by the master
+     * @return Index into replica_list, or std::nullopt if no replica is
+     * complete
+     */
+    std::optional<size_t> Select(
+        const std::vector<Replica::Descriptor>& replica_list) {
+        thread_local std::mt19937 rng(std::random_device{}());
+
+        std::optional<size_t> best;
+        Locality best_locality = Locality::REMOTE;
+        int64_t best_load = 0;
+        size_t tie_count = 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < replica_list.size(); ++i) {
+            const auto& replica = replica_list[i];
+            if (replica.status != ReplicaStatus::COMPLETE ||
+                replica.buffer_descriptors.empty()) {
+                continue;
+            }
+
+            const Locality locality = GetLocality(replica);
+            const int64_t load = GetLoadLocked(replica);
+            if (!best || locality < best_locality ||
+                (locality == best_locality && load < best_load)) {
+                best = i;
+                best_locality = locality;
+                best_load = load;
+                tie_count = 1;
+            } else if (locality == best_locality && load == best_load) {
+                // Reservoir sampling keeps each tied replica equally likely
+                ++tie_count;
+                if (std::uniform_int_distribution<size_t>(0, tie_count - 1)(
+                        rng) == 0) {
+                    best = i;
+                }
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Mark a read from the given replica as in flight
+     * @return Guard that releases the load when destroyed
+     */
+    LoadGuard Acquire(const Replica::Descriptor& replica) {
+        std::vector<std::string> segments;
+        segments.reserve(replica.buffer_descriptors.size());
+        for (const auto& desc : replica.buffer_descriptors) {
+            if (std::find(segments.begin(), segments.end(),
+                          desc.segment_name_) == segments.end()) {
+                segments.push_back(desc.segment_name_);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& segment : segments) {
+            ++inflight_[segment];
+        }
+        return LoadGuard(this, std::move(segments));
+    }
+
+    /**
+     * @brief Classify a replica relative to the local client
+     */
+    Locality GetLocality(const Replica::Descriptor& replica) const {
+        Locality locality = Locality::LOCAL;
+        for (const auto& desc : replica.buffer_descriptors) {
+            if (desc.segment_name_ == local_hostname_) {
+                continue;
+            }
+            if (HostOf(desc.segment_name_) == local_host_) {
+                locality = Locality::SAME_HOST;
+            } else {
+                return Locality::REMOTE;
+            }
+        }
+        return locality;
+    }
+
+    /**
+     * @brief Number of reads from this client currently in flight to a segment
+     */
+    int64_t GetInflight(const std::string& segment_name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = inflight_.find(segment_name);
+        return it == inflight_.end() ? 0 : it->second;
+    }
+
+   private:
+    // Segment names are "host:port"; strip the port to compare hosts
+    static std::string_view HostOf(std::string_view segment_name) {
+        auto pos = segment_name.rfind(':');
+        return pos == std::string_view::npos ? segment_name
+                                             : segment_name.substr(0, pos);
+    }
+
+    // The load of a replica is that of its busiest segment. Must hold mutex_.
+    int64_t GetLoadLocked(const Replica::Descriptor& replica) const {
+        int64_t load = 0;
+        for (const auto& desc : replica.buffer_descriptors) {
+            auto it = inflight_.find(desc.segment_name_);
+            if (it != inflight_.end()) {
+                load = std::max(load, it->second);
+            }
+        }
+        return load;
+    }
+
+    void Release(const std::vector<std::string>& segments) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& segment : segments) {
+            auto it = inflight_.find(segment);
+            if (it == inflight_.end()) {
+                continue;
+            }
+            if (--it->second <= 0) {
+                inflight_.erase(it);
+            }
+        }
+    }
+
+    const std::string local_hostname_;
+    const std::string local_host_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, int64_t> inflight_;
+};
+
+}  // namespace mooncake
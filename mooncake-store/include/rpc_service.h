@@ -2,6 +2,7 @@
 #include <ylt/struct_json/json_reader.h>
 #include <ylt/struct_json/json_writer.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -13,7 +14,9 @@
 
 #include "master_metric_manager.h"
 #include "master_service.h"
+#include "trace.h"
 #include "types.h"
+#include "utils/latency_histogram.h"
 #include "utils/scoped_vlog_timer.h"
 
 namespace mooncake {
@@ -23,6 +26,18 @@ struct ExistKeyResponse {
 };
 YLT_REFL(ExistKeyResponse, error_code)
 
+struct BatchExistKeyResponse {
+    std::vector<ErrorCode> exist_results;
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(BatchExistKeyResponse, exist_results, error_code)
+
+struct LongestCachedPrefixResponse {
+    uint64_t prefix_length = 0;
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(LongestCachedPrefixResponse, prefix_length, error_code)
+
 struct GetReplicaListResponse {
     std::vector<Replica::Descriptor> replica_list;
     ErrorCode error_code = ErrorCode::OK;
@@ -39,8 +54,11 @@ YLT_REFL(BatchGetReplicaListResponse, batch_replica_list, error_code)
 struct PutStartResponse {
     std::vector<Replica::Descriptor> replica_list;
     ErrorCode error_code = ErrorCode::OK;
+    // The object was mapped onto the buffers of an identical object; there
+    // is nothing to write and no PutEnd to send
+    bool deduplicated = false;
 };
-YLT_REFL(PutStartResponse, replica_list, error_code)
+YLT_REFL(PutStartResponse, replica_list, error_code, deduplicated)
 
 struct PutEndResponse {
     ErrorCode error_code = ErrorCode::OK;
@@ -67,10 +85,19 @@ struct BatchPutRevokeResponse {
 };
 YLT_REFL(BatchPutRevokeResponse, error_code)
 
+struct UnpinKeyResponse {
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(UnpinKeyResponse, error_code)
 struct RemoveResponse {
     ErrorCode error_code = ErrorCode::OK;
 };
 YLT_REFL(RemoveResponse, error_code)
+struct BatchRemoveResponse {
+    std::vector<ErrorCode> remove_results;
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(BatchRemoveResponse, remove_results, error_code)
 struct RemoveAllResponse {
     long removed_count = 0;
 };
@@ -97,6 +124,22 @@ struct PingResponse {
 };
 YLT_REFL(PingResponse, view_version, error_code)
 
+struct FetchDiskTasksResponse {
+    std::vector<DiskTask> tasks;
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(FetchDiskTasksResponse, tasks, error_code)
+
+struct SpillEndResponse {
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(SpillEndResponse, error_code)
+
+struct PromoteEndResponse {
+    ErrorCode error_code = ErrorCode::OK;
+};
+YLT_REFL(PromoteEndResponse, error_code)
+
 constexpr uint64_t kMetricReportIntervalSeconds = 10;
 
 class WrappedMasterService {
@@ -109,10 +152,11 @@ class WrappedMasterService {
             DEFAULT_EVICTION_HIGH_WATERMARK_RATIO,
         ViewVersionId view_version = 0,
         int64_t client_live_ttl_sec = DEFAULT_CLIENT_LIVE_TTL_SEC,
-        bool enable_ha = false)
+        bool enable_ha = false, bool enable_prefix_index = false)
         : master_service_(enable_gc, default_kv_lease_ttl, eviction_ratio,
                           eviction_high_watermark_ratio, view_version,
-                          client_live_ttl_sec, enable_ha),
+                          client_live_ttl_sec, enable_ha,
+                          enable_prefix_index),
           http_server_(4, http_port),
           metric_report_running_(enable_metric_reporting),
           view_version_(view_version) {
@@ -168,6 +212,14 @@ class WrappedMasterService {
                 resp.set_status_and_content(status_type::ok, summary);
             });
 
+        // Spans of sampled requests in Chrome trace format
+        http_server_.set_http_handler<GET>(
+            "/trace", [](coro_http_request& req, coro_http_response& resp) {
+                resp.add_header("Content-Type", "application/json");
+                resp.set_status_and_content(
+                    status_type::ok, Tracer::instance().dumpChromeTrace());
+            });
+
         // Endpoint for query a key's location
         http_server_.set_http_handler<GET>(
             "/query_key",
@@ -257,6 +309,7 @@ class WrappedMasterService {
 
     ExistKeyResponse ExistKey(const std::string& key) {
         ScopedVLogTimer timer(1, "ExistKey");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::EXIST_KEY));
         timer.LogRequest("key=", key);
 
         // Increment request metric
@@ -274,8 +327,53 @@ class WrappedMasterService {
         return response;
     }
 
-    GetReplicaListResponse GetReplicaList(const std::string& key) {
+    BatchExistKeyResponse BatchExistKey(const std::vector<std::string>& keys) {
+        ScopedVLogTimer timer(1, "BatchExistKey");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::BATCH_EXIST_KEY));
+        timer.LogRequest("keys_count=", keys.size());
+
+        // Increment request metric
+        MasterMetricManager::instance().inc_exist_key_requests(keys.size());
+
+        BatchExistKeyResponse response;
+        response.exist_results = master_service_.BatchExistKey(keys);
+
+        // Track failures if needed
+        int64_t failures = std::count_if(
+            response.exist_results.begin(), response.exist_results.end(),
+            [](ErrorCode err) { return err != ErrorCode::OK; });
+        if (failures > 0) {
+            MasterMetricManager::instance().inc_exist_key_failures(failures);
+        }
+
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    LongestCachedPrefixResponse LongestCachedPrefix(
+        const std::vector<std::string>& keys) {
+        ScopedVLogTimer timer(1, "LongestCachedPrefix");
+        ScopedLatencyRecorder latency(
+            RpcLatency(MasterRpc::LONGEST_CACHED_PREFIX));
+        timer.LogRequest("keys_count=", keys.size());
+
+        LongestCachedPrefixResponse response;
+        response.prefix_length = master_service_.LongestCachedPrefix(keys);
+
+        // Count the probes as the IsExist calls they replace
+        MasterMetricManager::instance().inc_exist_key_requests(
+            std::min<uint64_t>(response.prefix_length + 1, keys.size()));
+
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    GetReplicaListResponse GetReplicaList(const std::string& key,
+                                          uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "GetReplicaList");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::GET_REPLICA_LIST));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.GetReplicaList");
         timer.LogRequest("key=", key);
 
         // Increment request metric
@@ -294,9 +392,46 @@ class WrappedMasterService {
         return response;
     }
 
+    GetReplicaListResponse PinKey(const std::string& key,
+                                  const UUID& client_id) {
+        ScopedVLogTimer timer(1, "PinKey");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PIN_KEY));
+        timer.LogRequest("key=", key, ", client_id=", client_id);
+
+        // A pin is taken by a read, count it as one
+        MasterMetricManager::instance().inc_get_replica_list_requests();
+
+        GetReplicaListResponse response;
+        response.error_code =
+            master_service_.PinKey(key, client_id, response.replica_list);
+
+        // Track failures if needed
+        if (response.error_code != ErrorCode::OK) {
+            MasterMetricManager::instance().inc_get_replica_list_failures();
+        }
+
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    UnpinKeyResponse UnpinKey(const std::string& key, const UUID& client_id) {
+        ScopedVLogTimer timer(1, "UnpinKey");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::UNPIN_KEY));
+        timer.LogRequest("key=", key, ", client_id=", client_id);
+
+        UnpinKeyResponse response;
+        response.error_code = master_service_.UnpinKey(key, client_id);
+        timer.LogResponseJson(response);
+        return response;
+    }
+
     BatchGetReplicaListResponse BatchGetReplicaList(
-        const std::vector<std::string>& keys) {
+        const std::vector<std::string>& keys, uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "BatchGetReplicaList");
+        ScopedLatencyRecorder latency(
+            RpcLatency(MasterRpc::BATCH_GET_REPLICA_LIST));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.BatchGetReplicaList");
         timer.LogRequest("action=get_batch_replica_list");
 
         BatchGetReplicaListResponse response;
@@ -309,8 +444,14 @@ class WrappedMasterService {
 
     PutStartResponse PutStart(const std::string& key, uint64_t value_length,
                               const std::vector<uint64_t>& slice_lengths,
-                              const ReplicateConfig& config) {
+                              const ReplicateConfig& config,
+                              const CompressionInfo& compression = {},
+                              const ContentHash& content_hash = {},
+                              uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "PutStart");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PUT_START));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.PutStart");
         timer.LogRequest("key=", key, ", value_length=", value_length,
                          ", slice_lengths=", slice_lengths.size());
 
@@ -321,8 +462,14 @@ class WrappedMasterService {
         MasterMetricManager::instance().observe_value_size(value_length);
 
         PutStartResponse response;
-        response.error_code = master_service_.PutStart(
-            key, value_length, slice_lengths, config, response.replica_list);
+        response.error_code =
+            master_service_.PutStart(key, value_length, slice_lengths, config,
+                                     response.replica_list, compression,
+                                     content_hash);
+        response.deduplicated =
+            response.error_code == ErrorCode::OK &&
+            !response.replica_list.empty() &&
+            response.replica_list[0].status == ReplicaStatus::COMPLETE;
 
         // Track failures if needed
         if (response.error_code != ErrorCode::OK) {
@@ -336,8 +483,11 @@ class WrappedMasterService {
         return response;
     }
 
-    PutEndResponse PutEnd(const std::string& key) {
+    PutEndResponse PutEnd(const std::string& key, uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "PutEnd");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PUT_END));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.PutEnd");
         timer.LogRequest("key=", key);
 
         // Increment request metric
@@ -357,6 +507,7 @@ class WrappedMasterService {
 
     PutRevokeResponse PutRevoke(const std::string& key) {
         ScopedVLogTimer timer(1, "PutRevoke");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PUT_REVOKE));
         timer.LogRequest("key=", key);
 
         // Increment request metric
@@ -382,8 +533,11 @@ class WrappedMasterService {
         const std::unordered_map<std::string, uint64_t>& value_lengths,
         const std::unordered_map<std::string, std::vector<uint64_t>>&
             slice_lengths,
-        const ReplicateConfig& config) {
+        const ReplicateConfig& config, uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "BatchPutStart");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::BATCH_PUT_START));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.BatchPutStart");
         timer.LogRequest("xrrkeys_count=", keys.size());
 
         BatchPutStartResponse response;
@@ -399,8 +553,12 @@ class WrappedMasterService {
         return response;
     }
 
-    BatchPutEndResponse BatchPutEnd(const std::vector<std::string>& keys) {
+    BatchPutEndResponse BatchPutEnd(const std::vector<std::string>& keys,
+                                    uint64_t trace_id = 0) {
         ScopedVLogTimer timer(1, "BatchPutEnd");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::BATCH_PUT_END));
+        TraceScope trace(trace_id);
+        TraceSpan span("master.BatchPutEnd");
         timer.LogRequest("keys_count=", keys.size());
 
         BatchPutEndResponse response;
@@ -412,6 +570,7 @@ class WrappedMasterService {
     BatchPutRevokeResponse BatchPutRevoke(
         const std::vector<std::string>& keys) {
         ScopedVLogTimer timer(1, "BatchPutRevoke");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::BATCH_PUT_REVOKE));
         timer.LogRequest("keys_count=", keys.size());
 
         BatchPutRevokeResponse response;
@@ -426,6 +585,7 @@ class WrappedMasterService {
 
     RemoveResponse Remove(const std::string& key) {
         ScopedVLogTimer timer(1, "Remove");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::REMOVE));
         timer.LogRequest("key=", key);
 
         // Increment request metric
@@ -446,8 +606,36 @@ class WrappedMasterService {
         return response;
     }
 
+    BatchRemoveResponse BatchRemove(const std::vector<std::string>& keys) {
+        ScopedVLogTimer timer(1, "BatchRemove");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::BATCH_REMOVE));
+        timer.LogRequest("keys_count=", keys.size());
+
+        // Increment request metric
+        MasterMetricManager::instance().inc_remove_requests(keys.size());
+
+        BatchRemoveResponse response;
+        response.remove_results = master_service_.BatchRemove(keys);
+
+        // Track failures and decrement key count on successful removes
+        int64_t failures = std::count_if(
+            response.remove_results.begin(), response.remove_results.end(),
+            [](ErrorCode err) { return err != ErrorCode::OK; });
+        if (failures > 0) {
+            MasterMetricManager::instance().inc_remove_failures(failures);
+        }
+        int64_t removed = static_cast<int64_t>(keys.size()) - failures;
+        if (removed > 0) {
+            MasterMetricManager::instance().dec_key_count(removed);
+        }
+
+        timer.LogResponseJson(response);
+        return response;
+    }
+
     RemoveAllResponse RemoveAll() {
         ScopedVLogTimer timer(1, "RemoveAll");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::REMOVE_ALL));
         timer.LogRequest("action=remove_all_objects");
 
         // Increment request metric
@@ -464,6 +652,7 @@ class WrappedMasterService {
 
     MountSegmentResponse MountSegment(const Segment& segment, const UUID& client_id) {
         ScopedVLogTimer timer(1, "MountSegment");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::MOUNT_SEGMENT));
         timer.LogRequest("base=", segment.base, ", size=", segment.size,
                          ", segment_name=", segment.name, ", id=", segment.id);
 
@@ -485,6 +674,7 @@ class WrappedMasterService {
     ReMountSegmentResponse ReMountSegment(const std::vector<Segment>& segments,
                                           const UUID& client_id) {
         ScopedVLogTimer timer(1, "ReMountSegment");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::REMOUNT_SEGMENT));
         timer.LogRequest("segments_count=", segments.size(),
                          ", client_id=", client_id);
 
@@ -506,6 +696,7 @@ class WrappedMasterService {
 
     UnmountSegmentResponse UnmountSegment(const UUID& segment_id, const UUID& client_id) {
         ScopedVLogTimer timer(1, "UnmountSegment");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::UNMOUNT_SEGMENT));
         timer.LogRequest("segment_id=", segment_id);
 
         // Increment request metric
@@ -525,6 +716,7 @@ class WrappedMasterService {
 
     PingResponse Ping(const UUID& client_id) {
         ScopedVLogTimer timer(1, "Ping");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PING));
         timer.LogRequest("client_id=", client_id);
 
         MasterMetricManager::instance().inc_ping_requests();
@@ -541,7 +733,50 @@ class WrappedMasterService {
         return response;
     }
 
+    FetchDiskTasksResponse FetchDiskTasks(const UUID& client_id) {
+        ScopedVLogTimer timer(1, "FetchDiskTasks");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::FETCH_DISK_TASKS));
+        timer.LogRequest("client_id=", client_id);
+
+        FetchDiskTasksResponse response;
+        response.error_code =
+            master_service_.FetchDiskTasks(client_id, response.tasks);
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    SpillEndResponse SpillEnd(const std::string& key,
+                              const DiskLocation& location, bool success) {
+        ScopedVLogTimer timer(1, "SpillEnd");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::SPILL_END));
+        timer.LogRequest("key=", key, ", offset=", location.offset,
+                         ", success=", success);
+
+        SpillEndResponse response;
+        response.error_code = master_service_.SpillEnd(key, location, success);
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    PromoteEndResponse PromoteEnd(const std::string& key,
+                                  const DiskLocation& location, bool success) {
+        ScopedVLogTimer timer(1, "PromoteEnd");
+        ScopedLatencyRecorder latency(RpcLatency(MasterRpc::PROMOTE_END));
+        timer.LogRequest("key=", key, ", offset=", location.offset,
+                         ", success=", success);
+
+        PromoteEndResponse response;
+        response.error_code =
+            master_service_.PromoteEnd(key, location, success);
+        timer.LogResponseJson(response);
+        return response;
+    }
+
    private:
+    static LatencyHistogram& RpcLatency(MasterRpc rpc) {
+        return MasterMetricManager::instance().rpc_latency(rpc);
+    }
+
     MasterService master_service_;
     std::thread metric_report_thread_;
     coro_http::coro_http_server http_server_;
@@ -554,11 +789,20 @@ inline void RegisterRpcService(
     mooncake::WrappedMasterService& wrapped_master_service) {
     server.register_handler<&mooncake::WrappedMasterService::ExistKey>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::BatchExistKey>(
+        &wrapped_master_service);
+    server
+        .register_handler<&mooncake::WrappedMasterService::LongestCachedPrefix>(
+            &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::GetReplicaList>(
         &wrapped_master_service);
     server
         .register_handler<&mooncake::WrappedMasterService::BatchGetReplicaList>(
             &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::PinKey>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::UnpinKey>(
+        &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::PutStart>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::PutEnd>(
@@ -573,6 +817,8 @@ inline void RegisterRpcService(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::Remove>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::BatchRemove>(
+        &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::RemoveAll>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::MountSegment>(
@@ -581,6 +827,12 @@ inline void RegisterRpcService(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::Ping>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::FetchDiskTasks>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::SpillEnd>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::PromoteEnd>(
+        &wrapped_master_service);
 }
 
 }  // namespace mooncake
\ No newline at end of file
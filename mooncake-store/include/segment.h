@@ -10,6 +10,7 @@
 
 #include "allocation_strategy.h"
 #include "allocator.h"
+#include "master_metric_manager.h"
 #include "types.h"
 
 namespace mooncake {
@@ -57,7 +58,10 @@ class ScopedSegmentAccess {
      */
     explicit ScopedSegmentAccess(SegmentManager* segment_manager,
                                  std::shared_mutex& mutex)
-        : segment_manager_(segment_manager), lock_(mutex) {}
+        : segment_manager_(segment_manager),
+          lock_(AcquireMeasured<std::unique_lock<std::shared_mutex>>(
+              mutex, MasterMetricManager::instance().lock_wait(
+                         MasterLock::SEGMENT))) {}
 
     /**
      * @brief Mount a segment
@@ -122,7 +126,9 @@ class ScopedAllocatorAccess {
         std::shared_mutex& mutex)
         : allocators_by_name_(allocators_by_name),
           allocators_(allocators),
-          lock_(mutex) {}
+          lock_(AcquireMeasured<std::shared_lock<std::shared_mutex>>(
+              mutex, MasterMetricManager::instance().lock_wait(
+                         MasterLock::SEGMENT))) {}
 
     const std::unordered_map<std::string,
                        std::vector<std::shared_ptr<BufferAllocator>>>&
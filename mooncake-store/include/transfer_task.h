@@ -1,8 +1,12 @@
 #pragma once
 
+#include <async_simple/coro/Lazy.h>
+
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -18,6 +22,8 @@
 
 namespace mooncake {
 
+class ClientMetric;
+
 /**
  * @brief Transfer strategy enumeration
  */
@@ -50,7 +56,7 @@ inline std::ostream& operator<<(std::ostream& os,
 class OperationState {
    public:
     OperationState() = default;
-    virtual ~OperationState() = default;
+    virtual ~OperationState();
 
     // Non-copyable, non-movable
     OperationState(const OperationState&) = delete;
@@ -85,10 +91,57 @@ class OperationState {
      */
     virtual void wait_for_completion() = 0;
 
+    /**
+     * @brief Call callback once the operation made progress and may have
+     * completed, right away if it has completed already. The callback may
+     * run on a worker or transport thread holding locks, so it must only
+     * hand the work off, e.g. schedule a coroutine on an executor.
+     */
+    virtual void notify_progress(std::function<void()> callback);
+
+    /**
+     * @brief Fail the operation unless it has completed already, e.g. when
+     * waiting for it timed out
+     */
+    void fail_if_incomplete(ErrorCode error_code);
+
+    /**
+     * @brief Record the operation into metric once it completes. Must be
+     * called before the operation can complete.
+     * @param handles Buffers of the transfer, giving its size and peers
+     * @param start When the transfer was submitted
+     */
+    void track(ClientMetric* metric,
+               Transport::TransferRequest::OpCode op_code,
+               const std::vector<AllocatedBuffer::Descriptor>& handles,
+               std::chrono::steady_clock::time_point start);
+
    protected:
+    /**
+     * @brief Report the result to the tracking metric, if any. Make sure to
+     * lock the mutex and set result_ first.
+     */
+    void record_completion();
+
+    /**
+     * @brief Run the callbacks registered through notify_progress(). Make
+     * sure to lock the mutex and set result_ first.
+     */
+    void run_progress_callbacks();
+
     std::optional<ErrorCode> result_ = std::nullopt;
     mutable std::mutex mutex_;
     std::condition_variable cv_;
+
+   private:
+    std::vector<std::function<void()>> progress_callbacks_;
+    ClientMetric* metric_ = nullptr;
+    Transport::TransferRequest::OpCode op_code_ =
+        Transport::TransferRequest::READ;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t bytes_ = 0;
+    // Bytes per peer segment
+    std::vector<std::pair<std::string, uint64_t>> peers_;
 };
 
 /**
@@ -104,8 +157,11 @@ class MemcpyOperationState : public OperationState {
     void set_completed(ErrorCode error_code) {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            assert(!result_.has_value());
+            // Failed by a waiter that timed out
+            if (result_.has_value()) return;
             result_.emplace(error_code);
+            record_completion();
+            run_progress_callbacks();
         }
         cv_.notify_all();
     }
@@ -138,6 +194,8 @@ class TransferEngineOperationState : public OperationState {
 
     void wait_for_completion() override;
 
+    void notify_progress(std::function<void()> callback) override;
+
     TransferStrategy get_strategy() const override {
         return TransferStrategy::TRANSFER_ENGINE;
     }
@@ -192,6 +250,18 @@ class TransferFuture {
      */
     ErrorCode get();
 
+    /**
+     * @brief Wait for the operation to complete without blocking the thread
+     *
+     * Suspends the calling coroutine until the operation signals progress,
+     * so that a single thread can keep many operations in flight. The
+     * coroutine resumes on the coro_io executor. Like wait(), it fails the
+     * operation with TRANSFER_FAIL after 60 seconds.
+     *
+     * @return ErrorCode indicating success or failure
+     */
+    async_simple::coro::Lazy<ErrorCode> asyncWait();
+
     /**
      * @brief Get the transfer strategy used by this operation
      * @return TransferStrategy enum value
@@ -199,9 +269,44 @@ class TransferFuture {
     TransferStrategy strategy() const;
 
    private:
+    friend class ContinuationOperationState;
+
     std::shared_ptr<OperationState> state_;
 };
 
+/**
+ * @brief Operation state that runs a completion step once an inner operation
+ * has succeeded, e.g. to decode the data the inner transfer read
+ *
+ * The step runs on the first thread that finds the inner operation completed
+ * through is_completed() or wait_for_completion(), so submitting never blocks
+ * on it. It is skipped if the inner operation fails.
+ */
+class ContinuationOperationState : public OperationState {
+   public:
+    ContinuationOperationState(TransferFuture inner,
+                               std::function<ErrorCode()> continuation)
+        : inner_(std::move(inner)), continuation_(std::move(continuation)) {}
+
+    bool is_completed() override;
+
+    void wait_for_completion() override;
+
+    void notify_progress(std::function<void()> callback) override;
+
+    TransferStrategy get_strategy() const override {
+        return inner_.strategy();
+    }
+
+   private:
+    void finish(ErrorCode inner_result);
+
+    TransferFuture inner_;
+    // Serializes runs of the continuation
+    std::mutex continuation_mutex_;
+    std::function<ErrorCode()> continuation_;
+};
+
 /**
  * @brief Memory copy operation descriptor
  */
@@ -229,12 +334,23 @@ struct MemcpyTask {
 /**
  * @brief Thread pool for asynchronous memcpy operations
  *
- * This class manages a single worker thread that executes memcpy operations
- * asynchronously.
+ * Tasks smaller than kInlineMemcpyThreshold are copied by the submitting
+ * thread right away. Larger tasks are split into chunks of up to
+ * kMemcpyChunkSize bytes that the workers copy in parallel, so a single large
+ * get or put is not limited to the bandwidth of one core. Workers are grouped
+ * by NUMA node and pinned to it, and each chunk is queued on the node that
+ * holds its destination buffer.
  */
 class MemcpyWorkerPool {
    public:
-    explicit MemcpyWorkerPool();
+    static constexpr size_t kInlineMemcpyThreshold = 64 * 1024;
+    static constexpr size_t kMemcpyChunkSize = 2 * 1024 * 1024;
+
+    /**
+     * @param num_workers Number of worker threads, 0 to read it from
+     * MC_STORE_MEMCPY_THREADS or use the default
+     */
+    explicit MemcpyWorkerPool(size_t num_workers = 0);
     ~MemcpyWorkerPool();
 
     // Non-copyable, non-movable
@@ -249,13 +365,40 @@ class MemcpyWorkerPool {
      */
     void submitTask(MemcpyTask task);
 
+    size_t numWorkers() const { return workers_.size(); }
+
    private:
-    void workerThread();
+    // Completion tracking shared by the chunks of one task
+    struct PendingTask {
+        std::shared_ptr<MemcpyOperationState> state;
+        std::atomic<size_t> remaining_chunks;
+        std::atomic<bool> failed{false};
+
+        PendingTask(std::shared_ptr<MemcpyOperationState> s, size_t chunks)
+            : state(std::move(s)), remaining_chunks(chunks) {}
+    };
+
+    struct MemcpyChunk {
+        std::vector<MemcpyOperation> operations;
+        std::shared_ptr<PendingTask> pending;
+    };
+
+    // Chunks waiting for the workers of one NUMA node, or of all nodes when
+    // there are fewer workers than nodes
+    struct NodeQueue {
+        std::queue<MemcpyChunk> chunks;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    void workerThread(size_t queue_index);
+
+    // Queue of the workers closest to the given destination address
+    size_t selectQueue(const void* dest);
 
     std::vector<std::thread> workers_;
-    std::queue<MemcpyTask> task_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    std::vector<std::unique_ptr<NodeQueue>> queues_;
+    std::atomic<size_t> next_queue_{0};
     std::atomic<bool> shutdown_;
 };
 
@@ -268,8 +411,12 @@ class MemcpyWorkerPool {
  */
 class TransferSubmitter {
    public:
+    /**
+     * @param metric If set, every submitted operation is recorded into it
+     */
     explicit TransferSubmitter(TransferEngine& engine,
-                               const std::string& local_hostname);
+                               const std::string& local_hostname,
+                               ClientMetric* metric = nullptr);
 
     /**
      * @brief Submit an asynchronous transfer operation
@@ -293,6 +440,7 @@ class TransferSubmitter {
     const std::string local_hostname_;
     std::unique_ptr<MemcpyWorkerPool> memcpy_pool_;
     bool memcpy_enabled_;
+    ClientMetric* metric_;
 
     /**
      * @brief Select the optimal transfer strategy
@@ -3,6 +3,7 @@
 #include <glog/logging.h>
 
 #include <cstdint>
+#include <iomanip>
 #include <map>
 #include <memory>
 #include <string>
@@ -170,6 +171,7 @@ enum class ReplicaStatus {
     COMPLETE,       // Write complete, replica is available
     REMOVED,        // Replica has been removed
     FAILED,         // Failed state (can be used for reassignment)
+    DISK,           // Evicted to the disk tier of its owner, holds no memory
 };
 
 /**
@@ -183,13 +185,103 @@ inline std::ostream& operator<<(std::ostream& os,
                        {ReplicaStatus::PROCESSING, "PROCESSING"},
                        {ReplicaStatus::COMPLETE, "COMPLETE"},
                        {ReplicaStatus::REMOVED, "REMOVED"},
-                       {ReplicaStatus::FAILED, "FAILED"}};
+                       {ReplicaStatus::FAILED, "FAILED"},
+                       {ReplicaStatus::DISK, "DISK"}};
 
     os << (status_strings.count(status) ? status_strings.at(status)
                                         : "UNKNOWN");
     return os;
 }
 
+/**
+ * @brief Codec the client applies to the slices of an object
+ */
+enum class CompressionCodec : uint8_t {
+    NONE = 0,  // Stored as is
+    ZLIB = 1,  // Deflate, always available
+    ZSTD = 2,  // Zstandard, requires building with STORE_USE_ZSTD
+};
+
+/**
+ * @brief Stream operator for CompressionCodec
+ */
+inline std::ostream& operator<<(std::ostream& os,
+                                const CompressionCodec& codec) noexcept {
+    static const std::unordered_map<CompressionCodec, std::string_view>
+        codec_strings{{CompressionCodec::NONE, "NONE"},
+                      {CompressionCodec::ZLIB, "ZLIB"},
+                      {CompressionCodec::ZSTD, "ZSTD"}};
+
+    os << (codec_strings.count(codec) ? codec_strings.at(codec) : "UNKNOWN");
+    return os;
+}
+
+/**
+ * @brief How the slices of an object were encoded by the client
+ *
+ * raw_sizes holds the decoded size of every slice. A slice whose stored size
+ * equals its raw size did not compress and is stored as is.
+ */
+struct CompressionInfo {
+    CompressionCodec codec{CompressionCodec::NONE};
+    uint8_t shuffle_bytes{0};  // Element width of the byte-shuffle, 0 if none
+    std::vector<uint64_t> raw_sizes;
+    YLT_REFL(CompressionInfo, codec, shuffle_bytes, raw_sizes);
+};
+
+/**
+ * @brief 128-bit hash of the raw content of an object, computed by the client
+ * for deduplicated puts. All zero means the object has no hash.
+ */
+struct ContentHash {
+    uint64_t high{0};
+    uint64_t low{0};
+    YLT_REFL(ContentHash, high, low);
+
+    bool empty() const { return high == 0 && low == 0; }
+    bool operator==(const ContentHash& other) const {
+        return high == other.high && low == other.low;
+    }
+};
+
+struct ContentHashHasher {
+    size_t operator()(const ContentHash& hash) const {
+        // The bits are already uniformly distributed
+        return static_cast<size_t>(hash.low ^ hash.high);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const ContentHash& hash) noexcept {
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::hex << std::setfill('0') << std::setw(16) << hash.high
+       << std::setw(16) << hash.low;
+    os.flags(flags);
+    return os;
+}
+
+/**
+ * @brief Where the disk tier of a client keeps an evicted object
+ *
+ * The object is stored as its slices back to back, with the same stored, i.e.
+ * possibly compressed, sizes it had in memory.
+ */
+struct DiskLocation {
+    UUID owner{0, 0};          // Client whose disk tier holds the data
+    std::string segment_name;  // Segment of the owner the data came from
+    uint64_t offset{0};        // Offset of the extent in the disk tier file
+    std::vector<uint64_t> slice_sizes;
+    YLT_REFL(DiskLocation, owner, segment_name, offset, slice_sizes);
+
+    uint64_t size() const {
+        uint64_t size = 0;
+        for (uint64_t slice_size : slice_sizes) {
+            size += slice_size;
+        }
+        return size;
+    }
+};
+
 /**
  * @brief Configuration for replica management
  */
@@ -197,12 +289,23 @@ struct ReplicateConfig {
     size_t replica_num{0};
     std::string preferred_segment{};  // Preferred segment for allocation,
                                       // defaults to client's local hostname
+    // Codec for the object data, applied by the client before writing
+    CompressionCodec codec{CompressionCodec::NONE};
+    // Element width to byte-shuffle before compressing, e.g. 2 for fp16/bf16
+    // tensors. 0 or 1 disables shuffling.
+    uint8_t shuffle_bytes{0};
+    // Hash the content so that objects identical to an existing one share its
+    // buffers instead of being written again
+    bool dedup{false};
 
     friend std::ostream& operator<<(std::ostream& os,
                                     const ReplicateConfig& config) noexcept {
         return os << "ReplicateConfig: { replica_num: " << config.replica_num
                   << ", preferred_segment: " << config.preferred_segment
-                  << " }";
+                  << ", codec: " << config.codec
+                  << ", shuffle_bytes: "
+                  << static_cast<int>(config.shuffle_bytes)
+                  << ", dedup: " << config.dedup << " }";
     }
 };
 
@@ -235,6 +338,14 @@ class AllocatedBuffer {
         return !allocator_.expired();
     }
 
+    [[nodiscard]] std::weak_ptr<BufferAllocator> allocator() const {
+        return allocator_;
+    }
+
+    [[nodiscard]] const std::string& segment_name() const {
+        return segment_name_;
+    }
+
     // Serialize the buffer into a descriptor for transfer
     [[nodiscard]] Descriptor get_descriptor() const;
 
@@ -283,8 +394,30 @@ class Replica {
 
     Replica() = default;
     Replica(std::vector<std::unique_ptr<AllocatedBuffer>> buffers,
-            ReplicaStatus status)
-        : buffers_(std::move(buffers)), status_(status) {}
+            ReplicaStatus status, CompressionInfo compression = {})
+        : status_(status), compression_(std::move(compression)) {
+        buffers_.reserve(buffers.size());
+        for (auto& buf_ptr : buffers) {
+            buffers_.emplace_back(std::move(buf_ptr));
+        }
+    }
+
+    // Replica backed by buffers that may be shared with other objects of the
+    // same content; a buffer is freed when its last replica goes away
+    Replica(std::vector<std::shared_ptr<AllocatedBuffer>> buffers,
+            ReplicaStatus status, CompressionInfo compression = {})
+        : buffers_(std::move(buffers)),
+          status_(status),
+          compression_(std::move(compression)) {}
+
+    // Replica whose data was moved to the disk tier of the segment owner. It
+    // becomes invalid together with the owner's segment.
+    Replica(DiskLocation disk_location, std::weak_ptr<BufferAllocator> owner,
+            CompressionInfo compression = {})
+        : status_(ReplicaStatus::DISK),
+          compression_(std::move(compression)),
+          disk_location_(std::move(disk_location)),
+          disk_owner_(std::move(owner)) {}
 
     void reset() noexcept {
         buffers_.clear();
@@ -295,9 +428,25 @@ class Replica {
 
     [[nodiscard]] ReplicaStatus status() const { return status_; }
 
+    [[nodiscard]] const std::vector<std::shared_ptr<AllocatedBuffer>>&
+    buffers() const {
+        return buffers_;
+    }
+
+    [[nodiscard]] const CompressionInfo& compression() const {
+        return compression_;
+    }
+
+    [[nodiscard]] const DiskLocation& disk_location() const {
+        return disk_location_;
+    }
+
     [[nodiscard]] bool has_invalid_handle() const {
+        if (status_ == ReplicaStatus::DISK) {
+            return disk_owner_.expired();
+        }
         return std::any_of(buffers_.begin(), buffers_.end(),
-                           [](const std::unique_ptr<AllocatedBuffer>& buf_ptr) {
+                           [](const std::shared_ptr<AllocatedBuffer>& buf_ptr) {
                                return !buf_ptr->isAllocatorValid();
                            });
     }
@@ -316,17 +465,61 @@ class Replica {
     struct Descriptor {
         std::vector<AllocatedBuffer::Descriptor> buffer_descriptors;
         ReplicaStatus status;
-        YLT_REFL(Descriptor, buffer_descriptors, status);
+        CompressionInfo compression;
+        DiskLocation disk_location;  // Only set for DISK replicas
+        YLT_REFL(Descriptor, buffer_descriptors, status, compression,
+                 disk_location);
+
+        bool is_compressed() const {
+            return compression.codec != CompressionCodec::NONE;
+        }
+
+        bool is_on_disk() const { return status == ReplicaStatus::DISK; }
+
+        /**
+         * @brief Decoded size of each slice, i.e. the sizes of the slices
+         * the object has to be read into
+         */
+        std::vector<uint64_t> data_slice_sizes() const {
+            if (is_compressed()) {
+                return compression.raw_sizes;
+            }
+            if (is_on_disk()) {
+                return disk_location.slice_sizes;
+            }
+            std::vector<uint64_t> sizes;
+            sizes.reserve(buffer_descriptors.size());
+            for (const auto& desc : buffer_descriptors) {
+                sizes.push_back(desc.size_);
+            }
+            return sizes;
+        }
+
+        /**
+         * @brief Decoded size of the object
+         */
+        uint64_t data_size() const {
+            uint64_t size = 0;
+            for (uint64_t slice_size : data_slice_sizes()) {
+                size += slice_size;
+            }
+            return size;
+        }
     };
 
    private:
-    std::vector<std::unique_ptr<AllocatedBuffer>> buffers_;
+    std::vector<std::shared_ptr<AllocatedBuffer>> buffers_;
     ReplicaStatus status_{ReplicaStatus::UNDEFINED};
+    CompressionInfo compression_;
+    DiskLocation disk_location_;
+    std::weak_ptr<BufferAllocator> disk_owner_;
 };
 
 inline Replica::Descriptor Replica::get_descriptor() const {
     Replica::Descriptor desc;
     desc.status = status_;
+    desc.compression = compression_;
+    desc.disk_location = disk_location_;
     desc.buffer_descriptors.reserve(buffers_.size());
     for (const auto& buf_ptr : buffers_) {
         if (buf_ptr) {
@@ -344,10 +537,45 @@ inline std::ostream& operator<<(std::ostream& os, const Replica& replica) {
             os << *buf_ptr;
         }
     }
-    os << "] }";
+    os << "]";
+    if (replica.status_ == ReplicaStatus::DISK) {
+        os << ", disk_offset: " << replica.disk_location_.offset
+           << ", disk_size: " << replica.disk_location_.size();
+    }
+    os << " }";
+    return os;
+}
+
+/**
+ * @brief Work the master hands to the disk tier of a client
+ */
+enum class DiskTaskType : uint8_t {
+    SPILL = 0,    // Write buffers of the client's segment to disk
+    PROMOTE = 1,  // Read an object from disk back into buffers
+    DROP = 2,     // Free the disk space of an object that is gone
+};
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const DiskTaskType& type) noexcept {
+    static const std::unordered_map<DiskTaskType, std::string_view>
+        type_strings{{DiskTaskType::SPILL, "SPILL"},
+                     {DiskTaskType::PROMOTE, "PROMOTE"},
+                     {DiskTaskType::DROP, "DROP"}};
+
+    os << (type_strings.count(type) ? type_strings.at(type) : "UNKNOWN");
     return os;
 }
 
+struct DiskTask {
+    DiskTaskType type{DiskTaskType::SPILL};
+    std::string key;
+    // SPILL: the buffers to write. PROMOTE: the buffers to fill.
+    std::vector<AllocatedBuffer::Descriptor> buffers;
+    // PROMOTE and DROP: the extent holding the object
+    DiskLocation location;
+    YLT_REFL(DiskTask, type, key, buffers, location);
+};
+
 /**
  * @brief Represents a contiguous memory region
  */
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Log-bucketed latency histogram for hot paths
+ *
+ * Latencies are recorded in nanoseconds into 4 buckets per power of two, so
+ * quantiles are reported with at most 25% relative error. Every thread
+ * records into one of kShards cache line aligned shards, which keeps a
+ * recording down to two relaxed increments on a line other threads rarely
+ * touch. The shards are merged when a snapshot is taken.
+ */
+class LatencyHistogram {
+   public:
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kSubBucketBits = 2;
+    // Values of 2^kMaxExponent ns (~18 minutes) and above share the last
+    // bucket
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kNumBuckets = kMaxExponent * kSubBuckets;
+    static constexpr size_t kShards = 16;
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+
+        // Upper bound of the bucket holding the q-quantile, 0 if empty
+        uint64_t QuantileNs(double q) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return BucketUpperBound(i);
+                }
+            }
+            return BucketUpperBound(counts.size() - 1);
+        }
+    };
+
+    void Record(uint64_t ns) {
+        Shard& shard = shards_[ThreadShard()];
+        shard.counts[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void Record(std::chrono::steady_clock::duration duration) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+                      .count();
+        Record(static_cast<uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    Snapshot GetSnapshot() const {
+        Snapshot snapshot;
+        snapshot.counts.assign(kNumBuckets, 0);
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < kNumBuckets; ++i) {
+                uint64_t n = shard.counts[i].load(std::memory_order_relaxed);
+                snapshot.counts[i] += n;
+                snapshot.count += n;
+            }
+            snapshot.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    /**
+     * @brief Write the histogram as the samples of a Prometheus summary in
+     * microseconds: the 0.5, 0.9, 0.99 and 0.999 quantiles, _sum and _count.
+     * The HELP and TYPE lines of the family are left to the caller.
+     * @param labels Label pairs without braces, e.g. method="Get"
+     */
+    void WritePrometheus(std::ostream& os, std::string_view name,
+                         std::string_view labels) const {
+        Snapshot snapshot = GetSnapshot();
+        for (double q : {0.5, 0.9, 0.99, 0.999}) {
+            os << name << "{" << labels << ",quantile=\"" << q << "\"} "
+               << snapshot.QuantileNs(q) / 1000.0 << "\n";
+        }
+        os << name << "_sum{" << labels << "} " << snapshot.sum_ns / 1000.0
+           << "\n";
+        os << name << "_count{" << labels << "} " << snapshot.count << "\n";
+    }
+
+    static size_t BucketIndex(uint64_t ns) {
+        if (ns < kSubBuckets) {
+            return ns;
+        }
+        size_t exponent = 63 - __builtin_clzll(ns);
+        if (exponent >= kMaxExponent) {
+            return kNumBuckets - 1;
+        }
+        size_t sub = (ns >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return (exponent - 1) * kSubBuckets + sub;
+    }
+
+    // Exclusive upper bound of the values in bucket index
+    static uint64_t BucketUpperBound(size_t index) {
+        if (index < kSubBuckets) {
+            return index + 1;
+        }
+        size_t exponent = index / kSubBuckets + 1;
+        uint64_t sub = index % kSubBuckets;
+        return (kSubBuckets + sub + 1) << (exponent - kSubBucketBits);
+    }
+
+   private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kNumBuckets> counts{};
+        std::atomic<uint64_t> sum_ns{0};
+    };
+
+    static size_t ThreadShard() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    std::array<Shard, kShards> shards_;
+};
+
+/**
+ * @brief Records the lifetime of the scope into a LatencyHistogram
+ */
+class ScopedLatencyRecorder {
+   public:
+    explicit ScopedLatencyRecorder(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatencyRecorder() {
+        histogram_.Record(std::chrono::steady_clock::now() - start_);
+    }
+
+    ScopedLatencyRecorder(const ScopedLatencyRecorder&) = delete;
+    ScopedLatencyRecorder& operator=(const ScopedLatencyRecorder&) = delete;
+
+   private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Lock mutex with a Lock such as std::unique_lock or std::shared_lock,
+ * recording the time spent waiting into wait. Uncontended acquisitions are
+ * not timed and not recorded, so the histogram counts contended ones only.
+ */
+template <typename Lock, typename Mutex>
+Lock AcquireMeasured(Mutex& mutex, LatencyHistogram& wait) {
+    Lock lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        wait.Record(std::chrono::steady_clock::now() - start);
+    }
+    return lock;
+}
+
+}  // namespace mooncake
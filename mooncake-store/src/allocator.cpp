@@ -4,6 +4,8 @@
 #include <glog/logging.h>
 
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "master_metric_manager.h"
 
@@ -105,90 +107,225 @@ void BufferAllocator::deallocate(AllocatedBuffer* handle) {
     }
 }
 
-SimpleAllocator::SimpleAllocator(size_t size) {
-    LOG(INFO) << "initializing_simple_allocator size=" << size;
+struct SimpleAllocator::Core {
+    void* base{nullptr};
+    std::unique_ptr<char[]> header_region_start;
+    size_t header_region_size{0};
+    std::unique_ptr<facebook::cachelib::MemoryAllocator> memory_allocator;
+    facebook::cachelib::PoolId pool_id;
 
-    try {
-        // Allocate the base memory region
-        base_ = std::aligned_alloc(facebook::cachelib::Slab::kSize, size);
-        if (!base_) {
-            LOG(ERROR) << "base_memory_allocation_failed size=" << size;
-            throw std::bad_alloc();
+    // Live thread caches, so that any thread can reclaim their blocks
+    std::mutex caches_mutex;
+    std::unordered_set<ThreadCache*> caches;
+    // Bytes held by all thread caches together
+    std::atomic<size_t> cached_bytes{0};
+
+    ~Core() {
+        memory_allocator.reset();
+        if (base) {
+            std::free(base);
         }
+    }
 
-        // Calculate header region size similar to BufferAllocator
-        header_region_size_ = sizeof(facebook::cachelib::SlabHeader) *
-                                  static_cast<unsigned int>(
-                                      size / sizeof(facebook::cachelib::Slab)) +
-                              1;
-
-        header_region_start_ = std::make_unique<char[]>(header_region_size_);
-        if (!header_region_start_) {
-            std::free(base_);
-            LOG(ERROR) << "header_region_allocation_failed size="
-                       << header_region_size_;
-            throw std::bad_alloc();
+    // Return a block to the shared pool
+    void free(void* ptr) {
+        try {
+            memory_allocator->free(ptr);
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "deallocation_exception error=" << e.what();
+        } catch (...) {
+            LOG(ERROR) << "deallocation_unknown_exception";
+        }
+    }
+
+    // Return the blocks of every thread cache to the pool
+    void reclaimAll();
+};
+
+struct SimpleAllocator::ThreadCache {
+    std::weak_ptr<Core> core;
+    // Guards the magazines against a reclaim from another thread. Only the
+    // owning thread and reclaimAll take it, so it is almost never contended.
+    std::mutex mutex;
+    // Free blocks per cached size class, the most recently freed last
+    std::vector<std::vector<void*>> magazines;
+    // Fewest blocks each magazine held since the last scavenge. That many
+    // blocks were not needed during the interval and can be given back.
+    std::vector<size_t> low_water;
+    size_t cached_bytes{0};
+    uint32_t ops_since_scavenge{0};
+
+    ThreadCache(std::weak_ptr<Core> core, size_t num_classes)
+        : core(std::move(core)),
+          magazines(num_classes),
+          low_water(num_classes, 0) {}
+
+    // Return all blocks to the pool on thread exit
+    ~ThreadCache() {
+        auto alive = core.lock();
+        if (!alive) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(alive->caches_mutex);
+            alive->caches.erase(this);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        releaseLocked(*alive);
+    }
+
+    // Give back every cached block. Requires mutex.
+    void releaseLocked(Core& alive) {
+        for (size_t i = 0; i < magazines.size(); ++i) {
+            for (void* ptr : magazines[i]) {
+                alive.free(ptr);
+            }
+            magazines[i].clear();
+            low_water[i] = 0;
+        }
+        alive.cached_bytes -= cached_bytes;
+        cached_bytes = 0;
+    }
+
+    // Requires mutex
+    void scavenge(Core& alive, const std::vector<uint32_t>& class_sizes) {
+        ops_since_scavenge = 0;
+        for (size_t i = 0; i < magazines.size(); ++i) {
+            auto& magazine = magazines[i];
+            // The oldest blocks are at the front
+            size_t idle = std::min(low_water[i], magazine.size());
+            for (size_t j = 0; j < idle; ++j) {
+                alive.free(magazine[j]);
+            }
+            magazine.erase(magazine.begin(), magazine.begin() + idle);
+            cached_bytes -= idle * class_sizes[i];
+            alive.cached_bytes -= idle * class_sizes[i];
+            low_water[i] = magazine.size();
         }
+    }
+};
+
+void SimpleAllocator::Core::reclaimAll() {
+    std::lock_guard<std::mutex> caches_lock(caches_mutex);
+    for (ThreadCache* cache : caches) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->releaseLocked(*this);
+    }
+}
+
+namespace {
+std::atomic<uint64_t> next_simple_allocator_id{1};
+}  // namespace
+
+SimpleAllocator::SimpleAllocator(size_t size, bool enable_thread_cache)
+    : core_(std::make_shared<Core>()), id_(next_simple_allocator_id++) {
+    LOG(INFO) << "initializing_simple_allocator size=" << size;
+
+    // Allocate the base memory region
+    base_ = std::aligned_alloc(facebook::cachelib::Slab::kSize, size);
+    if (!base_) {
+        LOG(ERROR) << "base_memory_allocation_failed size=" << size;
+        throw std::bad_alloc();
+    }
+    core_->base = base_;
+
+    try {
+        // Calculate header region size similar to BufferAllocator
+        core_->header_region_size =
+            sizeof(facebook::cachelib::SlabHeader) *
+                static_cast<unsigned int>(size /
+                                          sizeof(facebook::cachelib::Slab)) +
+            1;
+
+        core_->header_region_start =
+            std::make_unique<char[]>(core_->header_region_size);
 
         // Initialize CacheLib memory allocator
-        memory_allocator_ =
+        auto alloc_sizes =
+            facebook::cachelib::MemoryAllocator::generateAllocSizes();
+        core_->memory_allocator =
             std::make_unique<facebook::cachelib::MemoryAllocator>(
-                facebook::cachelib::MemoryAllocator::Config(
-                    facebook::cachelib::MemoryAllocator::generateAllocSizes()),
-                header_region_start_.get(), header_region_size_, base_, size);
-
-        if (!memory_allocator_) {
-            std::free(base_);
-            LOG(ERROR) << "cachelib_memory_allocator_init_failed";
-            throw std::runtime_error("Failed to initialize memory allocator");
-        }
+                facebook::cachelib::MemoryAllocator::Config(alloc_sizes),
+                core_->header_region_start.get(), core_->header_region_size,
+                base_, size);
 
         // Add main memory pool
-        pool_id_ = memory_allocator_->addPool("main", size);
+        core_->pool_id = core_->memory_allocator->addPool("main", size);
         LOG(INFO) << "simple_allocator_initialized pool_id="
-                  << static_cast<int>(pool_id_);
+                  << static_cast<int>(core_->pool_id);
 
-    } catch (const std::exception& e) {
-        if (base_) {
-            std::free(base_);
-            base_ = nullptr;
+        // Cache the size classes small enough for several blocks to fit in
+        // the per-thread budget
+        if (enable_thread_cache) {
+            thread_cache_bytes_ = std::min(kMaxThreadCacheBytes, size / 16);
+            total_cache_bytes_ = std::min(kMaxTotalCacheBytes, size / 8);
+            for (uint32_t alloc_size : alloc_sizes) {
+                if (alloc_size * 4 > thread_cache_bytes_) {
+                    break;
+                }
+                cached_class_sizes_.push_back(alloc_size);
+            }
         }
+    } catch (const std::exception& e) {
+        // The core frees the base region
+        base_ = nullptr;
+        core_.reset();
         LOG(ERROR) << "simple_allocator_init_exception error=" << e.what();
         throw;
     }
 }
 
 SimpleAllocator::~SimpleAllocator() {
-    try {
-        if (memory_allocator_) {
-            memory_allocator_.reset();
-        }
-        if (base_) {
-            std::free(base_);
-            base_ = nullptr;
-        }
-        LOG(INFO) << "simple_allocator_destroyed status=success";
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "simple_allocator_destruction_exception error="
-                   << e.what();
+    // Blocks still cached by other threads are released along with the core
+    core_.reset();
+    base_ = nullptr;
+    LOG(INFO) << "simple_allocator_destroyed status=success";
+}
+
+int SimpleAllocator::cachedClassIndex(size_t size) const {
+    if (cached_class_sizes_.empty() || size > cached_class_sizes_.back()) {
+        return -1;
     }
+    // Same class lookup as CacheLib, so a cached block fits the request
+    auto it = std::lower_bound(cached_class_sizes_.begin(),
+                               cached_class_sizes_.end(), size);
+    return static_cast<int>(it - cached_class_sizes_.begin());
 }
 
-void* SimpleAllocator::allocate(size_t size) {
-    if (!memory_allocator_) {
-        LOG(ERROR) << "allocator_status=not_initialized";
-        return nullptr;
+SimpleAllocator::ThreadCache* SimpleAllocator::getThreadCache() {
+    thread_local std::unordered_map<uint64_t, std::unique_ptr<ThreadCache>>
+        caches;
+    thread_local uint64_t last_id = 0;
+    thread_local ThreadCache* last_cache = nullptr;
+    if (last_id == id_) {
+        return last_cache;
     }
 
-    try {
-        size_t padding_size = std::max(size, kMinSliceSize);
-        void* ptr = memory_allocator_->allocate(pool_id_, padding_size);
-        if (!ptr) {
-            LOG(WARNING) << "allocation_failed size=" << size;
-            return nullptr;
+    auto it = caches.find(id_);
+    if (it == caches.end()) {
+        // Drop the caches of destroyed allocators, their memory is gone
+        for (auto stale = caches.begin(); stale != caches.end();) {
+            if (stale->second->core.expired()) {
+                stale = caches.erase(stale);
+            } else {
+                ++stale;
+            }
         }
-        VLOG(1) << "allocation_succeeded size=" << size << " address=" << ptr;
-        return ptr;
+        it = caches
+                 .emplace(id_, std::make_unique<ThreadCache>(
+                                   core_, cached_class_sizes_.size()))
+                 .first;
+        std::lock_guard<std::mutex> lock(core_->caches_mutex);
+        core_->caches.insert(it->second.get());
+    }
+    last_id = id_;
+    last_cache = it->second.get();
+    return last_cache;
+}
+
+void* SimpleAllocator::allocateFromPool(size_t size) {
+    try {
+        return core_->memory_allocator->allocate(core_->pool_id, size);
     } catch (const std::exception& e) {
         LOG(ERROR) << "allocation_exception error=" << e.what();
         return nullptr;
@@ -198,22 +335,86 @@ void* SimpleAllocator::allocate(size_t size) {
     }
 }
 
+void* SimpleAllocator::allocate(size_t size) {
+    if (!core_) {
+        LOG(ERROR) << "allocator_status=not_initialized";
+        return nullptr;
+    }
+
+    size_t padding_size = std::max(size, kMinSliceSize);
+    int class_index = cachedClassIndex(padding_size);
+    if (class_index >= 0) {
+        ThreadCache* cache = getThreadCache();
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        auto& magazine = cache->magazines[class_index];
+        if (!magazine.empty()) {
+            void* ptr = magazine.back();
+            magazine.pop_back();
+            const size_t class_size = cached_class_sizes_[class_index];
+            cache->cached_bytes -= class_size;
+            core_->cached_bytes -= class_size;
+            cache->low_water[class_index] =
+                std::min(cache->low_water[class_index], magazine.size());
+            if (++cache->ops_since_scavenge >= kScavengeInterval) {
+                cache->scavenge(*core_, cached_class_sizes_);
+            }
+            VLOG(1) << "allocation_succeeded size=" << size
+                    << " address=" << ptr << " source=thread_cache";
+            return ptr;
+        }
+    }
+
+    void* ptr = allocateFromPool(padding_size);
+    if (!ptr && core_->cached_bytes.load(std::memory_order_relaxed) > 0) {
+        // The missing memory may sit idle in any thread's cache, including
+        // threads that no longer allocate
+        core_->reclaimAll();
+        ptr = allocateFromPool(padding_size);
+    }
+    if (!ptr) {
+        LOG(WARNING) << "allocation_failed size=" << size;
+        return nullptr;
+    }
+    VLOG(1) << "allocation_succeeded size=" << size << " address=" << ptr;
+    return ptr;
+}
+
 void SimpleAllocator::deallocate(void* ptr, size_t size) {
-    if (!memory_allocator_ || !ptr) {
+    if (!core_ || !ptr) {
         LOG(WARNING) << "invalid_deallocation_request allocator="
-                     << (memory_allocator_ ? "valid" : "null")
+                     << (core_ ? "valid" : "null")
                      << " ptr=" << (ptr ? "valid" : "null");
         return;
     }
 
-    try {
-        memory_allocator_->free(ptr);
-        VLOG(1) << "deallocation_succeeded size=" << size << " address=" << ptr;
-    } catch (const std::exception& e) {
-        LOG(ERROR) << "deallocation_exception error=" << e.what();
-    } catch (...) {
-        LOG(ERROR) << "deallocation_unknown_exception";
+    int class_index = cachedClassIndex(std::max(size, kMinSliceSize));
+    if (class_index >= 0) {
+        ThreadCache* cache = getThreadCache();
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        auto& magazine = cache->magazines[class_index];
+        const size_t class_size = cached_class_sizes_[class_index];
+        bool fits = magazine.size() < kMagazineCapacity &&
+                    cache->cached_bytes + class_size <= thread_cache_bytes_;
+        // Reserve room in the budget shared by all threads
+        if (fits && core_->cached_bytes.fetch_add(class_size) + class_size >
+                        total_cache_bytes_) {
+            core_->cached_bytes -= class_size;
+            fits = false;
+        }
+        if (fits) {
+            magazine.push_back(ptr);
+            cache->cached_bytes += class_size;
+            if (++cache->ops_since_scavenge >= kScavengeInterval) {
+                cache->scavenge(*core_, cached_class_sizes_);
+            }
+            VLOG(1) << "deallocation_succeeded size=" << size
+                    << " address=" << ptr << " target=thread_cache";
+            return;
+        }
     }
+
+    core_->free(ptr);
+    VLOG(1) << "deallocation_succeeded size=" << size << " address=" << ptr;
 }
 
 }  // namespace mooncake
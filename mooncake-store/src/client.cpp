@@ -4,9 +4,17 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
+#include <sstream>
 #include <unordered_set>
 
+// Header-only use of xxHash, no library to link
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#include <ylt/coro_io/coro_io.hpp>
+
 #include "rpc_service.h"
 #include "transfer_engine.h"
 #include "transfer_task.h"
@@ -23,15 +31,181 @@ namespace mooncake {
     return slice_size;
 }
 
+// Trace id of a request entering the client. Requests made on behalf of an
+// already traced one stay in its trace.
+static uint64_t SampleTrace() {
+    const uint64_t trace_id = Tracer::currentTraceId();
+    return trace_id ? trace_id : Tracer::instance().sample();
+}
+
+// Map the byte range [offset, offset + length) of an object stored in handles
+// onto slices. Produces pairs of equally sized handle and slice pieces, cutting
+// handles and slices wherever either of them ends.
+static ErrorCode MapRangeToTransfer(
+    const std::vector<AllocatedBuffer::Descriptor>& handles, size_t offset,
+    size_t length, const std::vector<Slice>& slices,
+    std::vector<AllocatedBuffer::Descriptor>& range_handles,
+    std::vector<Slice>& range_slices) {
+    range_handles.clear();
+    range_slices.clear();
+
+    size_t handle_idx = 0;
+    size_t handle_pos = offset;
+    // Skip the handles that end before the range starts
+    while (handle_idx < handles.size() &&
+           handle_pos >= handles[handle_idx].size_) {
+        handle_pos -= handles[handle_idx].size_;
+        ++handle_idx;
+    }
+
+    size_t slice_idx = 0;
+    size_t slice_pos = 0;
+    size_t remaining = length;
+    while (remaining > 0) {
+        while (slice_idx < slices.size() &&
+               slice_pos == slices[slice_idx].size) {
+            ++slice_idx;
+            slice_pos = 0;
+        }
+        if (handle_idx >= handles.size() || slice_idx >= slices.size()) {
+            return ErrorCode::INVALID_PARAMS;
+        }
+
+        const auto& handle = handles[handle_idx];
+        const auto& slice = slices[slice_idx];
+        size_t piece = std::min({remaining, handle.size_ - handle_pos,
+                                 slice.size - slice_pos});
+
+        AllocatedBuffer::Descriptor range_handle = handle;
+        range_handle.buffer_address_ += handle_pos;
+        range_handle.size_ = piece;
+        range_handles.push_back(std::move(range_handle));
+        range_slices.push_back(
+            Slice{static_cast<char*>(slice.ptr) + slice_pos, piece});
+
+        remaining -= piece;
+        slice_pos += piece;
+        handle_pos += piece;
+        if (handle_pos == handle.size_) {
+            ++handle_idx;
+            handle_pos = 0;
+        }
+    }
+    return ErrorCode::OK;
+}
+
+// Objects smaller than this are always read from a single replica, since
+// the extra transfer setup would outweigh the gained bandwidth
+static constexpr size_t kMinStripedReadSize = 4 * 1024 * 1024;
+
+static bool get_striped_read() {
+    const char* env_value = std::getenv("MC_STORE_STRIPED_READ");
+    if (env_value == nullptr) {
+        return false;
+    }
+    std::string env_str(env_value);
+    std::transform(env_str.begin(), env_str.end(), env_str.begin(),
+                   ::tolower);
+    if (env_str == "true" || env_str == "1" || env_str == "yes" ||
+        env_str == "on") {
+        LOG(INFO) << "striped read set by env MC_STORE_STRIPED_READ";
+        return true;
+    }
+    return false;
+}
+
+// Size of the registered staging memory for compressed slices
+static constexpr size_t kDefaultCompressionBufferSize = 64 * 1024 * 1024;
+
+static size_t get_compression_buffer_size() {
+    const char* env_value = std::getenv("MC_STORE_COMPRESSION_BUFFER_MB");
+    if (env_value) {
+        try {
+            long mb = std::stol(env_value);
+            if (mb > 0) {
+                return static_cast<size_t>(mb) * 1024 * 1024;
+            }
+        } catch (const std::exception&) {
+        }
+        LOG(WARNING) << "Ignoring invalid MC_STORE_COMPRESSION_BUFFER_MB="
+                     << env_value;
+    }
+    return kDefaultCompressionBufferSize;
+}
+
+// Size of the disk tier file (MC_STORE_DISK_TIER_SIZE_MB)
+static constexpr size_t kDefaultDiskTierSize = 16ULL * 1024 * 1024 * 1024;
+// How often an idle disk tier polls the master for tasks
+static constexpr int kDiskTaskPollIntervalMs = 20;
+// How long the gets wait for an object to be promoted from the disk tier of
+// another client. After that they return REPLICA_IS_NOT_READY.
+static constexpr int kDiskPromotionWaitMs = 2000;
+static constexpr int kDiskPromotionPollMs = 5;
+
+static size_t get_disk_tier_size() {
+    const char* env_value = std::getenv("MC_STORE_DISK_TIER_SIZE_MB");
+    if (env_value) {
+        try {
+            long mb = std::stol(env_value);
+            if (mb > 0) {
+                return static_cast<size_t>(mb) * 1024 * 1024;
+            }
+        } catch (const std::exception&) {
+        }
+        LOG(WARNING) << "Ignoring invalid MC_STORE_DISK_TIER_SIZE_MB="
+                     << env_value;
+    }
+    return kDefaultDiskTierSize;
+}
+
+// XXH3 128-bit hash of the concatenated slices
+static ContentHash ComputeContentHash(const std::vector<Slice>& slices) {
+    XXH3_state_t* state = XXH3_createState();
+    CHECK(state) << "Failed to create hash state";
+    XXH3_128bits_reset(state);
+    for (const auto& slice : slices) {
+        XXH3_128bits_update(state, slice.ptr, slice.size);
+    }
+    XXH128_hash_t digest = XXH3_128bits_digest(state);
+    XXH3_freeState(state);
+
+    ContentHash hash{digest.high64, digest.low64};
+    if (hash.empty()) {
+        hash.low = 1;  // All zero means no hash
+    }
+    return hash;
+}
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
 Client::Client(const std::string& local_hostname,
                const std::string& metadata_connstring)
-    : local_hostname_(local_hostname),
-      metadata_connstring_(metadata_connstring) {
+    : master_client_(metric_),
+      local_hostname_(local_hostname),
+      metadata_connstring_(metadata_connstring),
+      replica_selector_(local_hostname),
+      striped_read_enabled_(get_striped_read()) {
     client_id_ = generate_uuid();
     LOG(INFO) << "client_id=" << client_id_;
 }
 
 Client::~Client() {
+    if (metrics_server_) {
+        metrics_server_->stop();
+    }
+
+    // The disk tier copies from and into the mounted segments
+    if (disk_tier_running_) {
+        disk_tier_running_ = false;
+        if (disk_tier_thread_.joinable()) {
+            disk_tier_thread_.join();
+        }
+    }
+
     // Make a copy of mounted_segments_ to avoid modifying while iterating
     std::vector<Segment> segments_to_unmount;
     {
@@ -56,6 +230,10 @@ Client::~Client() {
         mounted_segments_.clear();
     }
 
+    if (staging_allocator_) {
+        unregisterLocalMemory(staging_allocator_->getBase(), false);
+    }
+
     // Stop ping thread only after no need to contact master anymore
     if (ping_running_) {
         ping_running_ = false;
@@ -192,8 +370,8 @@ ErrorCode Client::InitTransferEngine(const std::string& local_hostname,
     CHECK(transport) << "Failed to install transport";
 
     // Initialize TransferSubmitter after transfer engine is ready
-    transfer_submitter_ =
-        std::make_unique<TransferSubmitter>(transfer_engine_, local_hostname);
+    transfer_submitter_ = std::make_unique<TransferSubmitter>(
+        transfer_engine_, local_hostname, &metric_);
 
     return ErrorCode::OK;
 }
@@ -218,11 +396,25 @@ std::optional<std::shared_ptr<Client>> Client::Create(
         return std::nullopt;
     }
 
+    err = client->InitDiskTier();
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to initialize disk tier";
+        return std::nullopt;
+    }
+
+    err = client->InitMetricsServer();
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to start metrics server";
+        return std::nullopt;
+    }
+
     return client;
 }
 
 ErrorCode Client::Get(const std::string& object_key,
                       std::vector<Slice>& slices) {
+    TraceScope trace(SampleTrace());
+    TraceSpan span("client.Get");
     ObjectInfo object_info;
     auto err = Query(object_key, object_info);
     if (err != ErrorCode::OK) return err;
@@ -232,6 +424,8 @@ ErrorCode Client::Get(const std::string& object_key,
 ErrorCode Client::BatchGet(
     const std::vector<std::string>& object_keys,
     std::unordered_map<std::string, std::vector<Slice>>& slices) {
+    TraceScope trace(SampleTrace());
+    TraceSpan span("client.BatchGet");
     std::unordered_set<std::string> seen;
     for (const auto& key : object_keys) {
         if (!seen.insert(key).second) {
@@ -245,12 +439,93 @@ ErrorCode Client::BatchGet(
     if (err == ErrorCode::OK) {
         return BatchGet(object_keys, batched_object_info, slices);
     }
-    return ErrorCode::OBJECT_NOT_FOUND;
+    return err;
+}
+
+ObjectView::ObjectView(MasterClient* master_client, const UUID& client_id,
+                       std::string key,
+                       std::vector<std::span<const char>> spans)
+    : master_client_(master_client),
+      client_id_(client_id),
+      key_(std::move(key)),
+      spans_(std::move(spans)),
+      size_(0) {
+    for (const auto& span : spans_) {
+        size_ += span.size();
+    }
+}
+
+ErrorCode ObjectView::Release() {
+    if (!master_client_) {
+        return ErrorCode::OK;
+    }
+    auto response = master_client_->UnpinKey(key_, client_id_);
+    if (response.error_code != ErrorCode::OK) {
+        LOG(ERROR) << "unpin_failed key=" << key_
+                   << " error=" << response.error_code;
+    }
+    master_client_ = nullptr;
+    spans_.clear();
+    size_ = 0;
+    return response.error_code;
+}
+
+ErrorCode Client::GetView(const std::string& object_key,
+                          std::unique_ptr<ObjectView>& view) {
+    auto response = master_client_.PinKey(object_key, client_id_);
+    if (response.error_code != ErrorCode::OK) {
+        return response.error_code;
+    }
+
+    const Replica::Descriptor* local_replica = nullptr;
+    for (const auto& replica : response.replica_list) {
+        if (replica.status == ReplicaStatus::COMPLETE &&
+            !replica.buffer_descriptors.empty() &&
+            replica_selector_.GetLocality(replica) ==
+                ReplicaSelector::Locality::LOCAL) {
+            local_replica = &replica;
+            break;
+        }
+    }
+    // A compressed object has no contiguous raw bytes to expose
+    if (!local_replica || local_replica->is_compressed()) {
+        VLOG(1) << "no_local_raw_replica key=" << object_key;
+        auto unpin_response = master_client_.UnpinKey(object_key, client_id_);
+        if (unpin_response.error_code != ErrorCode::OK) {
+            LOG(ERROR) << "unpin_failed key=" << object_key
+                       << " error=" << unpin_response.error_code;
+        }
+        return local_replica ? ErrorCode::INVALID_PARAMS
+                             : ErrorCode::INVALID_REPLICA;
+    }
+
+    std::vector<std::span<const char>> spans;
+    spans.reserve(local_replica->buffer_descriptors.size());
+    for (const auto& handle : local_replica->buffer_descriptors) {
+        spans.emplace_back(
+            reinterpret_cast<const char*>(handle.buffer_address_),
+            handle.size_);
+    }
+    view.reset(new ObjectView(&master_client_, client_id_, object_key,
+                              std::move(spans)));
+    return ErrorCode::OK;
 }
 
 ErrorCode Client::Query(const std::string& object_key,
                         ObjectInfo& object_info) {
     auto response = master_client_.GetReplicaList(object_key);
+    // The master promotes the object on this request, wait until it is back
+    // in memory
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(kDiskPromotionWaitMs);
+    while (response.error_code == ErrorCode::OK &&
+           NeedsPromotion(response.replica_list) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(kDiskPromotionPollMs));
+        metric_.IncRetry(ClientRetry::PROMOTION_WAIT);
+        response = master_client_.GetReplicaList(object_key);
+    }
     // copy vec
     object_info.replica_list.resize(response.replica_list.size());
     for (size_t i = 0; i < response.replica_list.size(); ++i) {
@@ -262,6 +537,16 @@ ErrorCode Client::Query(const std::string& object_key,
 ErrorCode Client::BatchQuery(const std::vector<std::string>& object_keys,
                              BatchObjectInfo& batched_object_info) {
     auto response = master_client_.BatchGetReplicaList(object_keys);
+    // Same as Query, for every object being promoted
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(kDiskPromotionWaitMs);
+    while (response.error_code == ErrorCode::OK && NeedsPromotion(response) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(kDiskPromotionPollMs));
+        metric_.IncRetry(ClientRetry::PROMOTION_WAIT);
+        response = master_client_.BatchGetReplicaList(object_keys);
+    }
     // copy vec
     if (response.batch_replica_list.size() != object_keys.size()) {
         LOG(ERROR) << "QueryBatch failed, response size is not equal to "
@@ -286,23 +571,148 @@ ErrorCode Client::BatchQuery(const std::vector<std::string>& object_keys,
 ErrorCode Client::Get(const std::string& object_key,
                       const ObjectInfo& object_info,
                       std::vector<Slice>& slices) {
-    // Find the first complete replica
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+
+    std::vector<TransferFuture> futures;
+    std::vector<ReplicaSelector::LoadGuard> load_guards;
+    ErrorCode err =
+        SubmitRead(object_info.replica_list, slices, futures, load_guards);
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::INVALID_REPLICA) {
+            LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
+        } else {
+            LOG(ERROR) << "transfer_read_failed key=" << object_key
+                       << " error=" << err;
+        }
+        return err;
+    }
+
+    // Every stripe writes into the caller's slices, so all of them are
+    // waited for even after one fails
+    ErrorCode result = ErrorCode::OK;
+    for (auto& future : futures) {
+        ErrorCode future_err = future.get();
+        if (future_err != ErrorCode::OK && result == ErrorCode::OK) {
+            LOG(ERROR) << "transfer_read_failed key=" << object_key
+                       << " error=" << future_err;
+            result = future_err;
+        }
+    }
+    return result;
+}
+
+ErrorCode Client::Get(const std::string& object_key, size_t offset,
+                      size_t length, std::vector<Slice>& slices) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+    TraceScope trace(SampleTrace());
+    TraceSpan span("client.Get");
+
+    if (length == 0) {
+        LOG(ERROR) << "empty_range key=" << object_key;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    size_t slices_size = CalculateSliceSize(slices);
+    if (slices_size < length) {
+        LOG(ERROR) << "Slice size " << slices_size << " is smaller than range "
+                   << "length " << length;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    ObjectInfo object_info;
+    auto err = Query(object_key, object_info);
+    if (err != ErrorCode::OK) return err;
+
+    // Same as SubmitRead, a DISK replica comes first while it exists
+    const auto& replica_list = object_info.replica_list;
+    if (!replica_list.empty() && replica_list.front().is_on_disk()) {
+        return GetRangeFromDisk(object_key, replica_list.front(), offset,
+                                length, slices);
+    }
+
     std::vector<AllocatedBuffer::Descriptor> handles;
-    ErrorCode err = FindFirstCompleteReplica(object_info.replica_list, handles);
+    ReplicaSelector::LoadGuard load_guard;
+    const Replica::Descriptor* replica = nullptr;
+    err = SelectReplica(replica_list, handles, load_guard, &replica);
     if (err != ErrorCode::OK) {
         if (err == ErrorCode::INVALID_REPLICA) {
             LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
         }
         return err;
     }
+    if (replica->is_compressed()) {
+        LOG(ERROR) << "ranged_get_on_compressed_object key=" << object_key;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    size_t object_size = 0;
+    for (const auto& handle : handles) {
+        object_size += handle.size_;
+    }
+    if (offset > object_size || length > object_size - offset) {
+        LOG(ERROR) << "range_out_of_bounds key=" << object_key
+                   << " offset=" << offset << " length=" << length
+                   << " object_size=" << object_size;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    std::vector<AllocatedBuffer::Descriptor> range_handles;
+    std::vector<Slice> range_slices;
+    err = MapRangeToTransfer(handles, offset, length, slices, range_handles,
+                             range_slices);
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "failed_to_map_range key=" << object_key
+                   << " offset=" << offset << " length=" << length;
+        return err;
+    }
 
-    if (TransferRead(handles, slices) != ErrorCode::OK) {
+    VLOG(1) << "ranged_get key=" << object_key << " offset=" << offset
+            << " length=" << length << " pieces=" << range_handles.size();
+    if (TransferData(range_handles, range_slices, TransferRequest::READ) !=
+        ErrorCode::OK) {
         LOG(ERROR) << "transfer_read_failed key=" << object_key;
         return ErrorCode::INVALID_PARAMS;
     }
     return ErrorCode::OK;
 }
 
+ErrorCode Client::GetRangeFromDisk(const std::string& object_key,
+                                   const Replica::Descriptor& replica,
+                                   size_t offset, size_t length,
+                                   std::vector<Slice>& slices) {
+    if (NeedsPromotion({replica})) {
+        LOG(ERROR) << "replica_in_remote_disk_tier key=" << object_key
+                   << " owner=" << replica.disk_location.owner;
+        return ErrorCode::REPLICA_IS_NOT_READY;
+    }
+    if (replica.is_compressed()) {
+        LOG(ERROR) << "ranged_get_on_compressed_object key=" << object_key;
+        return ErrorCode::INVALID_PARAMS;
+    }
+    const uint64_t object_size = replica.disk_location.size();
+    if (offset > object_size || length > object_size - offset) {
+        LOG(ERROR) << "range_out_of_bounds key=" << object_key
+                   << " offset=" << offset << " length=" << length
+                   << " object_size=" << object_size;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    // The range is read back to back into the first length bytes of slices
+    std::vector<Slice> read_slices;
+    uint64_t remaining = length;
+    for (const auto& slice : slices) {
+        if (remaining == 0) {
+            break;
+        }
+        size_t piece = std::min<uint64_t>(slice.size, remaining);
+        read_slices.push_back(Slice{slice.ptr, piece});
+        remaining -= piece;
+    }
+    VLOG(1) << "ranged_get_from_disk key=" << object_key
+            << " offset=" << offset << " length=" << length;
+    return disk_tier_->Read(replica.disk_location.offset, read_slices, offset);
+}
+
 ErrorCode Client::BatchGet(
     const std::vector<std::string>& object_keys,
     BatchObjectInfo& batched_object_info,
@@ -312,44 +722,45 @@ ErrorCode Client::BatchGet(
     // Collect all transfer operations for parallel execution
     std::vector<std::pair<std::string, TransferFuture>> pending_transfers;
     pending_transfers.reserve(object_keys.size());
-
-    // Submit all transfers in parallel
+    // Keep the selected replicas accounted as busy until all reads finish
+    std::vector<ReplicaSelector::LoadGuard> load_guards;
+    load_guards.reserve(object_keys.size());
+
+    // Submit all transfers in parallel. On an error nothing more is
+    // submitted, but the transfers already submitted are still waited for,
+    // they write into the caller's buffers.
+    ErrorCode batch_err = ErrorCode::OK;
     for (const auto& key : object_keys) {
         auto object_info_it = batched_object_info.batch_replica_list.find(key);
         auto slices_it = slices.find(key);
         if (object_info_it == batched_object_info.batch_replica_list.end() ||
             slices_it == slices.end()) {
             LOG(ERROR) << "Key not found: " << key;
-            slices.clear();
-            return ErrorCode::INVALID_PARAMS;
+            batch_err = ErrorCode::INVALID_PARAMS;
+            break;
         }
 
-        // Find the first complete replica for this key
-        const auto& replica_list = object_info_it->second;
-        std::vector<AllocatedBuffer::Descriptor> handles;
-        ErrorCode err = FindFirstCompleteReplica(replica_list, handles);
+        // Submit transfer operations for this key asynchronously
+        std::vector<TransferFuture> futures;
+        ErrorCode err = SubmitRead(object_info_it->second, slices_it->second,
+                                   futures, load_guards);
         if (err != ErrorCode::OK) {
             if (err == ErrorCode::INVALID_REPLICA) {
                 LOG(ERROR) << "no_complete_replicas_found key=" << key;
+            } else {
+                LOG(ERROR) << "Failed to submit transfer operation for key: "
+                           << key;
             }
-            slices.clear();
-            return err;
+            batch_err = err;
+            break;
         }
 
-        // Submit transfer operation asynchronously
-        auto future = transfer_submitter_->submit(handles, slices_it->second,
-                                                  TransferRequest::READ);
-        if (!future) {
-            LOG(ERROR) << "Failed to submit transfer operation for key: "
-                       << key;
-            slices.clear();
-            return ErrorCode::TRANSFER_FAIL;
+        for (auto& future : futures) {
+            VLOG(1) << "Submitted transfer for key " << key
+                    << " using strategy: "
+                    << static_cast<int>(future.strategy());
+            pending_transfers.emplace_back(key, std::move(future));
         }
-
-        VLOG(1) << "Submitted transfer for key " << key
-                << " using strategy: " << static_cast<int>(future->strategy());
-
-        pending_transfers.emplace_back(key, std::move(*future));
     }
 
     // Wait for all transfers to complete
@@ -358,11 +769,17 @@ ErrorCode Client::BatchGet(
         if (result != ErrorCode::OK) {
             LOG(ERROR) << "Transfer failed for key: " << key
                        << " with error: " << static_cast<int>(result);
-            slices.clear();
-            return result;
+            if (batch_err == ErrorCode::OK) {
+                batch_err = result;
+            }
+            continue;
         }
         VLOG(1) << "Transfer completed successfully for key: " << key;
     }
+    if (batch_err != ErrorCode::OK) {
+        slices.clear();
+        return batch_err;
+    }
 
     VLOG(1) << "BatchGet completed successfully for " << object_keys.size()
             << " keys";
@@ -371,18 +788,36 @@ ErrorCode Client::BatchGet(
 
 ErrorCode Client::Put(const ObjectKey& key, std::vector<Slice>& slices,
                       const ReplicateConfig& config) {
+    TraceScope trace(SampleTrace());
+    TraceSpan span("client.Put");
+    ContentHash content_hash;
+    if (config.dedup) {
+        content_hash = ComputeContentHash(slices);
+    }
+
+    // Compressed slices must stay alive until the writes complete
+    StagingBuffers staging(
+        this,
+        config.codec != CompressionCodec::NONE ? InitCompression() : nullptr);
+    std::vector<Slice> encoded;
+    CompressionInfo compression;
+    ErrorCode err = EncodeValue(slices, config, staging, encoded, compression);
+    if (err != ErrorCode::OK) {
+        return err;
+    }
+
     // Prepare slice lengths
     std::vector<size_t> slice_lengths;
     size_t slice_size = 0;
-    for (size_t i = 0; i < slices.size(); ++i) {
-        slice_lengths.push_back(slices[i].size);
-        slice_size += slices[i].size;
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        slice_lengths.push_back(encoded[i].size);
+        slice_size += encoded[i].size;
     }
 
     // Start put operation
-    PutStartResponse start_response =
-        master_client_.PutStart(key, slice_lengths, slice_size, config);
-    ErrorCode err = start_response.error_code;
+    PutStartResponse start_response = master_client_.PutStart(
+        key, slice_lengths, slice_size, config, compression, content_hash);
+    err = start_response.error_code;
     if (err != ErrorCode::OK) {
         if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
             VLOG(1) << "object_already_exists key=" << key;
@@ -391,25 +826,33 @@ ErrorCode Client::Put(const ObjectKey& key, std::vector<Slice>& slices,
         LOG(ERROR) << "Failed to start put operation: " << err;
         return err;
     }
+    if (start_response.deduplicated) {
+        VLOG(1) << "put_deduplicated key=" << key;
+        return ErrorCode::OK;
+    }
 
-    // Transfer data using allocated handles from all replicas
-    for (const auto& replica : start_response.replica_list) {
-        std::vector<AllocatedBuffer::Descriptor> handles;
-        for (const auto& handle : replica.buffer_descriptors) {
-            CHECK(handle.buffer_address_ != 0) << "buffer_address_ is nullptr";
-            handles.push_back(handle);
+    // Write all replicas in parallel. Every submitted write is waited for,
+    // even after a failure, so that no transfer still targets the buffers
+    // once the put is revoked.
+    std::vector<TransferFuture> futures;
+    ErrorCode transfer_err =
+        SubmitWrite(start_response.replica_list, encoded, futures);
+    for (auto& future : futures) {
+        ErrorCode result = future.get();
+        if (transfer_err == ErrorCode::OK && result != ErrorCode::OK) {
+            transfer_err = result;
         }
+    }
 
-        ErrorCode transfer_err = TransferWrite(handles, slices);
-        if (transfer_err != ErrorCode::OK) {
-            // Revoke put operation
-            auto revoke_err = master_client_.PutRevoke(key);
-            if (revoke_err.error_code != ErrorCode::OK) {
-                LOG(ERROR) << "Failed to revoke put operation";
-                return revoke_err.error_code;
-            }
-            return transfer_err;
+    if (transfer_err != ErrorCode::OK) {
+        // Revoke put operation
+        metric_.IncRevokedPuts();
+        auto revoke_err = master_client_.PutRevoke(key);
+        if (revoke_err.error_code != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to revoke put operation";
+            return revoke_err.error_code;
         }
+        return transfer_err;
     }
 
     // End put operation
@@ -426,6 +869,17 @@ ErrorCode Client::BatchPut(
     std::unordered_map<std::string, std::vector<Slice>>& batched_slices,
     ReplicateConfig& config) {
     CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+    TraceScope trace(SampleTrace());
+    TraceSpan span("client.BatchPut");
+    if (config.codec != CompressionCodec::NONE) {
+        LOG(ERROR) << "codec_not_supported_by_batch_put codec="
+                   << static_cast<int>(config.codec);
+        return ErrorCode::INVALID_PARAMS;
+    }
+    if (config.dedup) {
+        LOG(ERROR) << "dedup_not_supported_by_batch_put";
+        return ErrorCode::INVALID_PARAMS;
+    }
 
     std::unordered_map<std::string, std::vector<size_t>> batched_slice_lengths;
     std::unordered_map<std::string, size_t> batched_value_lengths;
@@ -490,6 +944,7 @@ ErrorCode Client::BatchPut(
                 LOG(ERROR) << "Failed to submit transfer operation for key: "
                            << key << " replica: " << replica_idx;
                 // Revoke put operation
+                metric_.IncRevokedPuts(keys.size());
                 auto revoke_err = master_client_.BatchPutRevoke(keys);
                 if (revoke_err.error_code != ErrorCode::OK) {
                     LOG(ERROR) << "Failed to revoke put operation";
@@ -515,6 +970,7 @@ ErrorCode Client::BatchPut(
                        << " replica: " << replica_idx
                        << " with error: " << result;
             // Revoke put operation
+            metric_.IncRevokedPuts(keys.size());
             auto revoke_err = master_client_.BatchPutRevoke(keys);
             if (revoke_err.error_code != ErrorCode::OK) {
                 LOG(ERROR) << "Failed to revoke put operation";
@@ -538,88 +994,431 @@ ErrorCode Client::BatchPut(
     return ErrorCode::OK;
 }
 
-ErrorCode Client::Remove(const ObjectKey& key) {
-    return master_client_.Remove(key).error_code;
-}
-
-long Client::RemoveAll() { return master_client_.RemoveAll().removed_count; }
-
-ErrorCode Client::MountSegment(const void* buffer, size_t size) {
-    if (buffer == nullptr || size == 0 ||
-        reinterpret_cast<uintptr_t>(buffer) % facebook::cachelib::Slab::kSize ||
-        size % facebook::cachelib::Slab::kSize) {
-        LOG(ERROR) << "buffer=" << buffer << " or size=" << size
-                   << " is not aligned to " << facebook::cachelib::Slab::kSize;
-        return ErrorCode::INVALID_PARAMS;
+async_simple::coro::Lazy<ErrorCode> Client::AsyncGet(
+    const std::string& object_key, std::vector<Slice>& slices) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+    // The coroutine may resume on another thread, so the trace id is only
+    // made current around the synchronous steps
+    const uint64_t trace_id = SampleTrace();
+    TraceSpan span("client.AsyncGet", trace_id);
+
+    auto response =
+        co_await master_client_.AsyncGetReplicaList(object_key, trace_id);
+    // Same as Query, without blocking the thread
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(kDiskPromotionWaitMs);
+    while (response.error_code == ErrorCode::OK &&
+           NeedsPromotion(response.replica_list) &&
+           std::chrono::steady_clock::now() < deadline) {
+        co_await coro_io::sleep_for(
+            std::chrono::milliseconds(kDiskPromotionPollMs));
+        metric_.IncRetry(ClientRetry::PROMOTION_WAIT);
+        response =
+            co_await master_client_.AsyncGetReplicaList(object_key, trace_id);
+    }
+    if (response.error_code != ErrorCode::OK) {
+        co_return response.error_code;
     }
 
-    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
-
-    // Check if the segment overlaps with any existing segment
-    for (auto& it : mounted_segments_) {
-        auto& mtseg = it.second;
-        uintptr_t l1 = reinterpret_cast<uintptr_t>(mtseg.base);
-        uintptr_t r1 = reinterpret_cast<uintptr_t>(mtseg.size) + l1;
-        uintptr_t l2 = reinterpret_cast<uintptr_t>(buffer);
-        uintptr_t r2 = reinterpret_cast<uintptr_t>(size) + l2;
-        if (std::max(l1, l2) < std::min(r1, r2)) {
-            LOG(ERROR) << "segment_overlaps base1=" << mtseg.base
-                       << " size1=" << mtseg.size << " base2=" << buffer
-                       << " size2=" << size;
-            return ErrorCode::INVALID_PARAMS;
+    std::vector<TransferFuture> futures;
+    std::vector<ReplicaSelector::LoadGuard> load_guards;
+    ErrorCode err;
+    {
+        TraceScope trace(trace_id);
+        err = SubmitRead(response.replica_list, slices, futures, load_guards);
+    }
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::INVALID_REPLICA) {
+            LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
+        } else {
+            LOG(ERROR) << "transfer_read_failed key=" << object_key
+                       << " error=" << err;
         }
+        co_return err;
     }
 
-    int rc = transfer_engine_.registerLocalMemory(
-        (void*)buffer, size, kWildcardLocation, true, true);
-    if (rc != 0) {
-        LOG(ERROR) << "register_local_memory_failed base=" << buffer
-                   << " size=" << size << ", error=" << rc;
-        return ErrorCode::INVALID_PARAMS;
+    // Drain every stripe before returning, they write into the caller's
+    // slices
+    ErrorCode result = ErrorCode::OK;
+    for (auto& future : futures) {
+        ErrorCode future_err = co_await future.asyncWait();
+        if (future_err != ErrorCode::OK && result == ErrorCode::OK) {
+            LOG(ERROR) << "transfer_read_failed key=" << object_key
+                       << " error=" << future_err;
+            result = future_err;
+        }
     }
+    co_return result;
+}
 
-    Segment segment(generate_uuid(), local_hostname_,
-                    reinterpret_cast<uintptr_t>(buffer), size);
+async_simple::coro::Lazy<ErrorCode> Client::AsyncPut(
+    const ObjectKey& key, std::vector<Slice>& slices,
+    const ReplicateConfig& config) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+    const uint64_t trace_id = SampleTrace();
+    TraceSpan span("client.AsyncPut", trace_id);
 
-    ErrorCode err =
-        master_client_.MountSegment(segment, client_id_).error_code;
-    if (err != ErrorCode::OK) {
-        LOG(ERROR) << "mount_segment_to_master_failed base=" << buffer
-                   << " size=" << size << ", error=" << err;
-        return err;
+    ContentHash content_hash;
+    if (config.dedup) {
+        content_hash = ComputeContentHash(slices);
     }
 
-    mounted_segments_[segment.id] = segment;
-    return ErrorCode::OK;
-}
+    StagingBuffers staging(
+        this,
+        config.codec != CompressionCodec::NONE ? InitCompression() : nullptr);
+    std::vector<Slice> encoded;
+    CompressionInfo compression;
+    ErrorCode err = EncodeValue(slices, config, staging, encoded, compression);
+    if (err != ErrorCode::OK) {
+        co_return err;
+    }
 
-ErrorCode Client::UnmountSegment(const void* buffer, size_t size) {
-    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
-    auto segment = mounted_segments_.end();
+    std::vector<uint64_t> slice_lengths;
+    uint64_t slice_size = 0;
+    for (const auto& slice : encoded) {
+        slice_lengths.push_back(slice.size);
+        slice_size += slice.size;
+    }
 
-    for (auto it = mounted_segments_.begin(); it != mounted_segments_.end();
-         ++it) {
-        if (it->second.base == reinterpret_cast<uintptr_t>(buffer) &&
-            it->second.size == size) {
-            segment = it;
-            break;
+    PutStartResponse start_response = co_await master_client_.AsyncPutStart(
+        key, std::move(slice_lengths), slice_size, config,
+        std::move(compression), content_hash, trace_id);
+    err = start_response.error_code;
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
+            VLOG(1) << "object_already_exists key=" << key;
+            co_return ErrorCode::OK;
         }
+        LOG(ERROR) << "Failed to start put operation: " << err;
+        co_return err;
     }
-    if (segment == mounted_segments_.end()) {
-        LOG(ERROR) << "segment_not_found base=" << buffer << " size=" << size;
-        return ErrorCode::INVALID_PARAMS;
+    if (start_response.deduplicated) {
+        VLOG(1) << "put_deduplicated key=" << key;
+        co_return ErrorCode::OK;
     }
 
-    ErrorCode err =
-        master_client_.UnmountSegment(segment->second.id, client_id_)
-            .error_code;
-    if (err != ErrorCode::OK) {
-        LOG(ERROR) << "Failed to unmount segment from master: "
-                   << toString(err);
-        return err;
+    // Write all replicas in parallel and wait for every submitted write
+    // before deciding between PutEnd and PutRevoke
+    std::vector<TransferFuture> futures;
+    ErrorCode transfer_err;
+    {
+        TraceScope trace(trace_id);
+        transfer_err =
+            SubmitWrite(start_response.replica_list, encoded, futures);
+    }
+    for (auto& future : futures) {
+        ErrorCode result = co_await future.asyncWait();
+        if (transfer_err == ErrorCode::OK && result != ErrorCode::OK) {
+            transfer_err = result;
+        }
     }
 
-    int rc = transfer_engine_.unregisterLocalMemory(
+    if (transfer_err != ErrorCode::OK) {
+        metric_.IncRevokedPuts();
+        auto revoke_response = co_await master_client_.AsyncPutRevoke(key);
+        if (revoke_response.error_code != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to revoke put operation";
+            co_return revoke_response.error_code;
+        }
+        co_return transfer_err;
+    }
+
+    err = (co_await master_client_.AsyncPutEnd(key, trace_id)).error_code;
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to end put operation: " << err;
+        co_return err;
+    }
+    co_return ErrorCode::OK;
+}
+
+async_simple::coro::Lazy<ErrorCode> Client::AsyncBatchGet(
+    const std::vector<std::string>& object_keys,
+    std::unordered_map<std::string, std::vector<Slice>>& slices) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+
+    std::unordered_set<std::string> seen;
+    for (const auto& key : object_keys) {
+        if (!seen.insert(key).second) {
+            LOG(ERROR) << "Duplicate key not supported for Batch API, key: "
+                       << key;
+            co_return ErrorCode::INVALID_PARAMS;
+        }
+    }
+    const uint64_t trace_id = SampleTrace();
+    TraceSpan span("client.AsyncBatchGet", trace_id);
+
+    auto response =
+        co_await master_client_.AsyncBatchGetReplicaList(object_keys, trace_id);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(kDiskPromotionWaitMs);
+    while (response.error_code == ErrorCode::OK && NeedsPromotion(response) &&
+           std::chrono::steady_clock::now() < deadline) {
+        co_await coro_io::sleep_for(
+            std::chrono::milliseconds(kDiskPromotionPollMs));
+        metric_.IncRetry(ClientRetry::PROMOTION_WAIT);
+        response = co_await master_client_.AsyncBatchGetReplicaList(
+            object_keys, trace_id);
+    }
+    if (response.error_code != ErrorCode::OK) {
+        co_return response.error_code;
+    }
+
+    std::vector<std::pair<std::string, TransferFuture>> pending_transfers;
+    pending_transfers.reserve(object_keys.size());
+    std::vector<ReplicaSelector::LoadGuard> load_guards;
+    load_guards.reserve(object_keys.size());
+
+    // On an error nothing more is submitted, but the transfers already
+    // submitted are still awaited, they write into the caller's buffers
+    ErrorCode batch_err = ErrorCode::OK;
+    for (const auto& key : object_keys) {
+        auto replica_list_it = response.batch_replica_list.find(key);
+        auto slices_it = slices.find(key);
+        if (replica_list_it == response.batch_replica_list.end() ||
+            slices_it == slices.end()) {
+            LOG(ERROR) << "Key not found: " << key;
+            batch_err = ErrorCode::INVALID_PARAMS;
+            break;
+        }
+
+        std::vector<TransferFuture> futures;
+        ErrorCode err;
+        {
+            TraceScope trace(trace_id);
+            err = SubmitRead(replica_list_it->second, slices_it->second,
+                             futures, load_guards);
+        }
+        if (err != ErrorCode::OK) {
+            if (err == ErrorCode::INVALID_REPLICA) {
+                LOG(ERROR) << "no_complete_replicas_found key=" << key;
+            } else {
+                LOG(ERROR) << "Failed to submit transfer operation for key: "
+                           << key;
+            }
+            batch_err = err;
+            break;
+        }
+        for (auto& future : futures) {
+            pending_transfers.emplace_back(key, std::move(future));
+        }
+    }
+
+    for (auto& [key, future] : pending_transfers) {
+        ErrorCode result = co_await future.asyncWait();
+        if (result != ErrorCode::OK) {
+            LOG(ERROR) << "Transfer failed for key: " << key
+                       << " with error: " << result;
+            if (batch_err == ErrorCode::OK) {
+                batch_err = result;
+            }
+        }
+    }
+    co_return batch_err;
+}
+
+async_simple::coro::Lazy<ErrorCode> Client::AsyncBatchPut(
+    const std::vector<ObjectKey>& keys,
+    std::unordered_map<std::string, std::vector<Slice>>& batched_slices,
+    const ReplicateConfig& config) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+    const uint64_t trace_id = SampleTrace();
+    TraceSpan span("client.AsyncBatchPut", trace_id);
+    if (config.codec != CompressionCodec::NONE) {
+        LOG(ERROR) << "codec_not_supported_by_batch_put codec="
+                   << static_cast<int>(config.codec);
+        co_return ErrorCode::INVALID_PARAMS;
+    }
+    if (config.dedup) {
+        LOG(ERROR) << "dedup_not_supported_by_batch_put";
+        co_return ErrorCode::INVALID_PARAMS;
+    }
+
+    std::unordered_map<std::string, std::vector<uint64_t>> batched_slice_lengths;
+    std::unordered_map<std::string, uint64_t> batched_value_lengths;
+    for (const auto& key : keys) {
+        auto slices = batched_slices.find(key);
+        if (slices == batched_slices.end()) {
+            LOG(ERROR) << "Cannot find slices for key: " << key;
+            co_return ErrorCode::INVALID_PARAMS;
+        }
+        uint64_t slice_size = 0;
+        std::vector<uint64_t> slice_lengths;
+        for (const auto& slice : slices->second) {
+            slice_lengths.push_back(slice.size);
+            slice_size += slice.size;
+        }
+        batched_slice_lengths.emplace(key, std::move(slice_lengths));
+        batched_value_lengths.emplace(key, slice_size);
+    }
+
+    BatchPutStartResponse start_response =
+        co_await master_client_.AsyncBatchPutStart(
+            keys, std::move(batched_value_lengths),
+            std::move(batched_slice_lengths), config, trace_id);
+    ErrorCode err = start_response.error_code;
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
+            LOG(INFO) << "object_already_exists key count " << keys.size();
+            co_return ErrorCode::OK;
+        }
+        LOG(ERROR) << "Failed to start batch put operation: " << err;
+        co_return err;
+    }
+
+    // Submit the writes of all keys, then wait for every submitted write
+    std::vector<std::pair<std::string, TransferFuture>> pending_transfers;
+    ErrorCode transfer_err = ErrorCode::OK;
+    for (const auto& key : keys) {
+        auto replica_list_it = start_response.batch_replica_list.find(key);
+        if (replica_list_it == start_response.batch_replica_list.end()) {
+            LOG(ERROR) << "Cannot find replica_list for key: " << key;
+            transfer_err = ErrorCode::INVALID_PARAMS;
+            break;
+        }
+        std::vector<TransferFuture> futures;
+        {
+            TraceScope trace(trace_id);
+            transfer_err =
+                SubmitWrite(replica_list_it->second,
+                            batched_slices.find(key)->second, futures);
+        }
+        for (auto& future : futures) {
+            pending_transfers.emplace_back(key, std::move(future));
+        }
+        if (transfer_err != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to submit transfer operation for key: "
+                       << key;
+            break;
+        }
+    }
+
+    for (auto& [key, future] : pending_transfers) {
+        ErrorCode result = co_await future.asyncWait();
+        if (result != ErrorCode::OK) {
+            LOG(ERROR) << "Transfer failed for key: " << key
+                       << " with error: " << result;
+            if (transfer_err == ErrorCode::OK) {
+                transfer_err = result;
+            }
+        }
+    }
+
+    if (transfer_err != ErrorCode::OK) {
+        metric_.IncRevokedPuts(keys.size());
+        auto revoke_response =
+            co_await master_client_.AsyncBatchPutRevoke(keys);
+        if (revoke_response.error_code != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to revoke put operation";
+            co_return revoke_response.error_code;
+        }
+        co_return transfer_err;
+    }
+
+    err =
+        (co_await master_client_.AsyncBatchPutEnd(keys, trace_id)).error_code;
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to end put operation: " << err;
+        co_return err;
+    }
+    co_return ErrorCode::OK;
+}
+
+ErrorCode Client::Remove(const ObjectKey& key) {
+    return master_client_.Remove(key).error_code;
+}
+
+std::vector<ErrorCode> Client::BatchRemove(
+    const std::vector<ObjectKey>& keys) {
+    auto response = master_client_.BatchRemove(keys);
+    if (response.remove_results.size() != keys.size()) {
+        LOG(ERROR) << "BatchRemove failed, response size is not equal to "
+                      "request size";
+        return std::vector<ErrorCode>(
+            keys.size(), response.error_code != ErrorCode::OK
+                             ? response.error_code
+                             : ErrorCode::INTERNAL_ERROR);
+    }
+    return response.remove_results;
+}
+
+long Client::RemoveAll() { return master_client_.RemoveAll().removed_count; }
+
+ErrorCode Client::MountSegment(const void* buffer, size_t size) {
+    if (buffer == nullptr || size == 0 ||
+        reinterpret_cast<uintptr_t>(buffer) % facebook::cachelib::Slab::kSize ||
+        size % facebook::cachelib::Slab::kSize) {
+        LOG(ERROR) << "buffer=" << buffer << " or size=" << size
+                   << " is not aligned to " << facebook::cachelib::Slab::kSize;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+
+    // Check if the segment overlaps with any existing segment
+    for (auto& it : mounted_segments_) {
+        auto& mtseg = it.second;
+        uintptr_t l1 = reinterpret_cast<uintptr_t>(mtseg.base);
+        uintptr_t r1 = reinterpret_cast<uintptr_t>(mtseg.size) + l1;
+        uintptr_t l2 = reinterpret_cast<uintptr_t>(buffer);
+        uintptr_t r2 = reinterpret_cast<uintptr_t>(size) + l2;
+        if (std::max(l1, l2) < std::min(r1, r2)) {
+            LOG(ERROR) << "segment_overlaps base1=" << mtseg.base
+                       << " size1=" << mtseg.size << " base2=" << buffer
+                       << " size2=" << size;
+            return ErrorCode::INVALID_PARAMS;
+        }
+    }
+
+    int rc = transfer_engine_.registerLocalMemory(
+        (void*)buffer, size, kWildcardLocation, true, true);
+    if (rc != 0) {
+        LOG(ERROR) << "register_local_memory_failed base=" << buffer
+                   << " size=" << size << ", error=" << rc;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    Segment segment(generate_uuid(), local_hostname_,
+                    reinterpret_cast<uintptr_t>(buffer), size);
+
+    ErrorCode err =
+        master_client_.MountSegment(segment, client_id_).error_code;
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "mount_segment_to_master_failed base=" << buffer
+                   << " size=" << size << ", error=" << err;
+        return err;
+    }
+
+    mounted_segments_[segment.id] = segment;
+    return ErrorCode::OK;
+}
+
+ErrorCode Client::UnmountSegment(const void* buffer, size_t size) {
+    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+    auto segment = mounted_segments_.end();
+
+    for (auto it = mounted_segments_.begin(); it != mounted_segments_.end();
+         ++it) {
+        if (it->second.base == reinterpret_cast<uintptr_t>(buffer) &&
+            it->second.size == size) {
+            segment = it;
+            break;
+        }
+    }
+    if (segment == mounted_segments_.end()) {
+        LOG(ERROR) << "segment_not_found base=" << buffer << " size=" << size;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    ErrorCode err =
+        master_client_.UnmountSegment(segment->second.id, client_id_)
+            .error_code;
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to unmount segment from master: "
+                   << toString(err);
+        return err;
+    }
+
+    int rc = transfer_engine_.unregisterLocalMemory(
         reinterpret_cast<void*>(segment->second.base));
     if (rc != 0) {
         LOG(ERROR) << "Failed to unregister transfer buffer with transfer "
@@ -660,6 +1459,71 @@ ErrorCode Client::IsExist(const std::string& key) {
     return response.error_code;
 }
 
+std::vector<ErrorCode> Client::BatchIsExist(
+    const std::vector<std::string>& keys) {
+    auto response = master_client_.BatchExistKey(keys);
+    if (response.exist_results.size() != keys.size()) {
+        LOG(ERROR) << "BatchIsExist failed, response size is not equal to "
+                      "request size";
+        return std::vector<ErrorCode>(
+            keys.size(), response.error_code != ErrorCode::OK
+                             ? response.error_code
+                             : ErrorCode::INTERNAL_ERROR);
+    }
+    return response.exist_results;
+}
+
+ErrorCode Client::LongestCachedPrefix(const std::vector<std::string>& keys,
+                                      size_t& prefix_length) {
+    auto response = master_client_.LongestCachedPrefix(keys);
+    prefix_length = response.prefix_length;
+    return response.error_code;
+}
+
+CompressionStats Client::GetCompressionStats() const {
+    return metric_.compression_stats();
+}
+
+std::string Client::GetMetrics() const { return metric_.Serialize(); }
+
+ErrorCode Client::InitMetricsServer() {
+    const char* env_value = std::getenv("MC_STORE_METRICS_PORT");
+    if (!env_value) {
+        return ErrorCode::OK;
+    }
+    int port = 0;
+    try {
+        port = std::stoi(env_value);
+    } catch (const std::exception&) {
+    }
+    if (port <= 0 || port > 65535) {
+        LOG(ERROR) << "Invalid MC_STORE_METRICS_PORT=" << env_value;
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    using namespace coro_http;
+    metrics_server_ = std::make_unique<coro_http_server>(1, port);
+    metrics_server_->set_http_handler<GET>(
+        "/metrics", [this](coro_http_request& req, coro_http_response& resp) {
+            resp.add_header("Content-Type", "text/plain; version=0.0.4");
+            resp.set_status_and_content(status_type::ok, GetMetrics());
+        });
+    metrics_server_->set_http_handler<GET>(
+        "/trace", [](coro_http_request& req, coro_http_response& resp) {
+            resp.add_header("Content-Type", "application/json");
+            resp.set_status_and_content(status_type::ok,
+                                        Tracer::instance().dumpChromeTrace());
+        });
+    auto started = metrics_server_->async_start();
+    if (started.hasResult()) {
+        LOG(ERROR) << "Failed to start metrics server on port " << port;
+        metrics_server_.reset();
+        return ErrorCode::INTERNAL_ERROR;
+    }
+    LOG(INFO) << "Client metrics served on port " << port;
+    return ErrorCode::OK;
+}
+
 ErrorCode Client::TransferData(
     const std::vector<AllocatedBuffer::Descriptor>& handles,
     std::vector<Slice>& slices, TransferRequest::OpCode op_code) {
@@ -676,15 +1540,270 @@ ErrorCode Client::TransferData(
     return future->get();
 }
 
-ErrorCode Client::TransferWrite(
-    const std::vector<AllocatedBuffer::Descriptor>& handles,
-    std::vector<Slice>& slices) {
-    return TransferData(handles, slices, TransferRequest::WRITE);
+ErrorCode Client::SubmitWrite(
+    const std::vector<Replica::Descriptor>& replica_list,
+    std::vector<Slice>& slices, std::vector<TransferFuture>& futures) {
+    CHECK(transfer_submitter_) << "TransferSubmitter not initialized";
+
+    for (size_t replica_idx = 0; replica_idx < replica_list.size();
+         ++replica_idx) {
+        const auto& handles = replica_list[replica_idx].buffer_descriptors;
+        for (const auto& handle : handles) {
+            CHECK(handle.buffer_address_ != 0) << "buffer_address_ is nullptr";
+        }
+
+        auto future =
+            transfer_submitter_->submit(handles, slices, TransferRequest::WRITE);
+        if (!future) {
+            LOG(ERROR) << "Failed to submit transfer operation for replica: "
+                       << replica_idx;
+            return ErrorCode::TRANSFER_FAIL;
+        }
+        VLOG(1) << "Submitted write for replica " << replica_idx
+                << " using strategy: " << future->strategy();
+        futures.push_back(std::move(*future));
+    }
+    return ErrorCode::OK;
+}
+
+Client::StagingBuffers::~StagingBuffers() {
+    for (auto& [ptr, size] : buffers_) {
+        allocator_->deallocate(ptr, size);
+    }
+    for (auto& [buffer, registered] : temporary_) {
+        if (registered) {
+            client_->unregisterLocalMemory(buffer.get(), false);
+        }
+    }
+}
+
+void* Client::StagingBuffers::Allocate(size_t size) {
+    if (!allocator_) {
+        return nullptr;
+    }
+    void* ptr = allocator_->allocate(size);
+    if (ptr) {
+        buffers_.emplace_back(ptr, size);
+    }
+    return ptr;
+}
+
+void* Client::StagingBuffers::AllocateTemporary(size_t size,
+                                                bool register_memory) {
+    std::unique_ptr<char[]> buffer(new (std::nothrow) char[size]);
+    if (!buffer) {
+        LOG(ERROR) << "Failed to allocate temporary staging memory size="
+                   << size;
+        return nullptr;
+    }
+    if (register_memory &&
+        client_->RegisterLocalMemory(buffer.get(), size, kWildcardLocation,
+                                     false, false) != ErrorCode::OK) {
+        LOG(ERROR) << "Failed to register temporary staging memory size="
+                   << size;
+        return nullptr;
+    }
+    void* ptr = buffer.get();
+    temporary_.emplace_back(std::move(buffer), register_memory);
+    return ptr;
+}
+
+SimpleAllocator* Client::InitCompression() {
+    std::call_once(compression_once_, [this] {
+        compression_stage_ = std::make_unique<CompressionStage>();
+        size_t size = get_compression_buffer_size();
+        auto allocator = std::make_unique<SimpleAllocator>(size);
+        // Only ever a local source or destination of transfers
+        ErrorCode err = RegisterLocalMemory(allocator->getBase(), size,
+                                            kWildcardLocation, false, false);
+        if (err != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to register compression staging memory: "
+                       << err;
+        } else {
+            staging_allocator_ = std::move(allocator);
+        }
+    });
+    return staging_allocator_.get();
 }
 
-ErrorCode Client::TransferRead(
+ErrorCode Client::EncodeValue(const std::vector<Slice>& slices,
+                              const ReplicateConfig& config,
+                              StagingBuffers& staging,
+                              std::vector<Slice>& encoded,
+                              CompressionInfo& compression) {
+    encoded = slices;
+    compression = CompressionInfo{};
+    if (config.codec == CompressionCodec::NONE) {
+        return ErrorCode::OK;
+    }
+    if (!IsCodecSupported(config.codec)) {
+        LOG(ERROR) << "codec_not_supported codec=" << config.codec;
+        return ErrorCode::INVALID_PARAMS;
+    }
+    if (CalculateSliceSize(slices) < kMinCompressSize) {
+        return ErrorCode::OK;
+    }
+
+    // A slice without staging space is simply stored as is
+    std::vector<void*> outputs(slices.size(), nullptr);
+    for (size_t i = 0; i < slices.size(); ++i) {
+        outputs[i] = staging.Allocate(slices[i].size);
+    }
+
+    std::vector<size_t> stored_sizes(slices.size(), 0);
+    compression_stage_->ParallelFor(slices.size(), [&](size_t i) {
+        if (!outputs[i]) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        stored_sizes[i] =
+            CompressSlice(config.codec, config.shuffle_bytes, slices[i].ptr,
+                          slices[i].size, outputs[i], slices[i].size);
+        metric_.RecordCompress(
+            slices[i].size, stored_sizes[i] ? stored_sizes[i] : slices[i].size,
+            elapsed_ns(start));
+    });
+
+    bool shrunk = false;
+    compression.raw_sizes.resize(slices.size());
+    for (size_t i = 0; i < slices.size(); ++i) {
+        compression.raw_sizes[i] = slices[i].size;
+        if (stored_sizes[i] > 0) {
+            encoded[i] = Slice{outputs[i], stored_sizes[i]};
+            shrunk = true;
+        }
+    }
+    if (!shrunk) {
+        compression = CompressionInfo{};
+        return ErrorCode::OK;
+    }
+    compression.codec = config.codec;
+    compression.shuffle_bytes = config.shuffle_bytes;
+    return ErrorCode::OK;
+}
+
+ErrorCode Client::ReadCompressed(
     const std::vector<AllocatedBuffer::Descriptor>& handles,
-    std::vector<Slice>& slices) {
+    const CompressionInfo& compression, std::vector<Slice>& slices,
+    std::vector<TransferFuture>& futures, const DiskLocation* disk) {
+    if (!IsCodecSupported(compression.codec)) {
+        LOG(ERROR) << "codec_not_supported codec=" << compression.codec;
+        return ErrorCode::INVALID_PARAMS;
+    }
+    if (slices.size() != handles.size() ||
+        compression.raw_sizes.size() != handles.size()) {
+        LOG(ERROR) << "Compressed object needs one slice per stored slice, "
+                   << "got " << slices.size() << " for " << handles.size();
+        return ErrorCode::INVALID_PARAMS;
+    }
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (slices[i].size < compression.raw_sizes[i]) {
+            LOG(ERROR) << "Slice " << i << " size " << slices[i].size
+                       << " is smaller than raw size "
+                       << compression.raw_sizes[i];
+            return ErrorCode::INVALID_PARAMS;
+        }
+    }
+
+    // Compressed slices land in staging memory, raw ones go straight to the
+    // destination. The staging memory lives until the data is decoded.
+    auto staging = std::make_shared<StagingBuffers>(this, InitCompression());
+    std::vector<Slice> read_slices(handles.size());
+    std::vector<size_t> overflow;
+    size_t overflow_size = 0;
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (handles[i].size_ == compression.raw_sizes[i]) {
+            read_slices[i] = Slice{slices[i].ptr, handles[i].size_};
+            continue;
+        }
+        void* ptr = staging->Allocate(handles[i].size_);
+        if (!ptr) {
+            overflow.push_back(i);
+            overflow_size += handles[i].size_;
+            continue;
+        }
+        read_slices[i] = Slice{ptr, handles[i].size_};
+    }
+
+    // Slices that find the staging memory exhausted share a temporary buffer
+    // instead of failing the read. The disk tier reads with pread, so only
+    // transfers need it registered.
+    if (!overflow.empty()) {
+        VLOG(1) << "compression_staging_exhausted temporary_size="
+                << overflow_size;
+        auto* temporary = static_cast<char*>(
+            staging->AllocateTemporary(overflow_size, disk == nullptr));
+        if (!temporary) {
+            return ErrorCode::BUFFER_OVERFLOW;
+        }
+        for (size_t i : overflow) {
+            read_slices[i] = Slice{temporary, handles[i].size_};
+            temporary += handles[i].size_;
+        }
+    }
+
+    std::optional<TransferFuture> read;
+    if (disk) {
+        auto state = std::make_shared<MemcpyOperationState>();
+        state->set_completed(disk_tier_->Read(disk->offset, read_slices));
+        read.emplace(state);
+    } else {
+        read = transfer_submitter_->submit(handles, read_slices,
+                                           TransferRequest::READ);
+        if (!read) {
+            return ErrorCode::TRANSFER_FAIL;
+        }
+    }
+
+    // Decoding runs when the read is waited for, so the reads of a batch
+    // are all in flight before the first one is decoded
+    auto decode = [this, staging, compression, read_slices,
+                   slices]() -> ErrorCode {
+        std::atomic<bool> decode_failed{false};
+        compression_stage_->ParallelFor(read_slices.size(), [&](size_t i) {
+            if (read_slices[i].size == compression.raw_sizes[i]) {
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            if (!DecompressSlice(compression.codec, compression.shuffle_bytes,
+                                 read_slices[i].ptr, read_slices[i].size,
+                                 slices[i].ptr, compression.raw_sizes[i])) {
+                decode_failed = true;
+                return;
+            }
+            metric_.RecordDecompress(compression.raw_sizes[i],
+                                     elapsed_ns(start));
+        });
+        return decode_failed ? ErrorCode::INVALID_READ : ErrorCode::OK;
+    };
+    futures.emplace_back(std::make_shared<ContinuationOperationState>(
+        std::move(*read), std::move(decode)));
+    return ErrorCode::OK;
+}
+
+ErrorCode Client::SubmitRead(
+    const std::vector<Replica::Descriptor>& replica_list,
+    std::vector<Slice>& slices, std::vector<TransferFuture>& futures,
+    std::vector<ReplicaSelector::LoadGuard>& load_guards) {
+    // An object in the disk tier has no complete replica in memory. While it
+    // is being promoted the DISK replica stays first in the list.
+    if (!replica_list.empty() && replica_list.front().is_on_disk()) {
+        return ReadFromDisk(replica_list.front(), slices, futures);
+    }
+
+    std::vector<AllocatedBuffer::Descriptor> handles;
+    ReplicaSelector::LoadGuard load_guard;
+    ErrorCode err = SelectReplica(replica_list, handles, load_guard);
+    if (err != ErrorCode::OK) {
+        return err;
+    }
+
+    // All replicas of an object are written with the same encoding
+    const auto& compression = replica_list.front().compression;
+    if (compression.codec != CompressionCodec::NONE) {
+        return ReadCompressed(handles, compression, slices, futures);
+    }
+
     size_t total_size = 0;
     for (const auto& handle : handles) {
         total_size += handle.size_;
@@ -697,7 +1816,258 @@ ErrorCode Client::TransferRead(
         return ErrorCode::INVALID_PARAMS;
     }
 
-    return TransferData(handles, slices, TransferRequest::READ);
+    // Stripes are cut at buffer boundaries, so each destination slice must
+    // match one buffer of the replica. Other layouts are read as a whole.
+    bool slices_match_handles = slices.size() == handles.size();
+    for (size_t i = 0; slices_match_handles && i < handles.size(); ++i) {
+        slices_match_handles = slices[i].size == handles[i].size_;
+    }
+
+    // Collect the other complete replicas that share the selected replica's
+    // slice layout; only those can serve an arbitrary subset of the slices
+    std::vector<const Replica::Descriptor*> stripe_replicas;
+    if (striped_read_enabled_ && slices_match_handles && handles.size() > 1 &&
+        total_size >= kMinStripedReadSize) {
+        for (const auto& replica : replica_list) {
+            if (replica.status != ReplicaStatus::COMPLETE ||
+                replica.buffer_descriptors.size() != handles.size()) {
+                continue;
+            }
+            // A local replica is already the fastest source on its own
+            if (replica_selector_.GetLocality(replica) ==
+                ReplicaSelector::Locality::LOCAL) {
+                stripe_replicas.clear();
+                break;
+            }
+            bool same_layout = true;
+            for (size_t i = 0; i < handles.size(); ++i) {
+                if (replica.buffer_descriptors[i].size_ != handles[i].size_) {
+                    same_layout = false;
+                    break;
+                }
+            }
+            if (same_layout) {
+                stripe_replicas.push_back(&replica);
+            }
+        }
+    }
+
+    if (stripe_replicas.size() < 2) {
+        auto future =
+            transfer_submitter_->submit(handles, slices, TransferRequest::READ);
+        if (!future) {
+            return ErrorCode::TRANSFER_FAIL;
+        }
+        futures.push_back(std::move(*future));
+        load_guards.push_back(std::move(load_guard));
+        return ErrorCode::OK;
+    }
+
+    // Assign each slice to the replica with the fewest bytes assigned so far
+    const size_t stripe_count =
+        std::min(stripe_replicas.size(), handles.size());
+    std::vector<std::vector<AllocatedBuffer::Descriptor>> stripe_handles(
+        stripe_count);
+    std::vector<std::vector<Slice>> stripe_slices(stripe_count);
+    std::vector<size_t> stripe_bytes(stripe_count, 0);
+    for (size_t i = 0; i < handles.size(); ++i) {
+        size_t target = std::min_element(stripe_bytes.begin(),
+                                         stripe_bytes.end()) -
+                        stripe_bytes.begin();
+        stripe_handles[target].push_back(
+            stripe_replicas[target]->buffer_descriptors[i]);
+        stripe_slices[target].push_back(slices[i]);
+        stripe_bytes[target] += handles[i].size_;
+    }
+
+    load_guard.reset();
+    const size_t first_future = futures.size();
+    for (size_t r = 0; r < stripe_count; ++r) {
+        auto future = transfer_submitter_->submit(
+            stripe_handles[r], stripe_slices[r], TransferRequest::READ);
+        if (!future) {
+            // Don't leave earlier stripes writing into the caller's buffers
+            for (size_t i = first_future; i < futures.size(); ++i) {
+                futures[i].wait();
+            }
+            futures.erase(futures.begin() + first_future, futures.end());
+            return ErrorCode::TRANSFER_FAIL;
+        }
+        VLOG(1) << "striped_read stripe=" << r
+                << " slices=" << stripe_slices[r].size()
+                << " bytes=" << stripe_bytes[r];
+        futures.push_back(std::move(*future));
+        load_guards.push_back(replica_selector_.Acquire(*stripe_replicas[r]));
+    }
+    return ErrorCode::OK;
+}
+
+bool Client::NeedsPromotion(
+    const std::vector<Replica::Descriptor>& replica_list) const {
+    if (replica_list.empty() || !replica_list.front().is_on_disk()) {
+        return false;
+    }
+    return !disk_tier_ ||
+           replica_list.front().disk_location.owner != client_id_;
+}
+
+bool Client::NeedsPromotion(
+    const BatchGetReplicaListResponse& response) const {
+    for (const auto& [key, replica_list] : response.batch_replica_list) {
+        if (NeedsPromotion(replica_list)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ErrorCode Client::ReadFromDisk(const Replica::Descriptor& replica,
+                               std::vector<Slice>& slices,
+                               std::vector<TransferFuture>& futures) {
+    if (NeedsPromotion({replica})) {
+        VLOG(1) << "replica_in_remote_disk_tier owner="
+                << replica.disk_location.owner;
+        return ErrorCode::REPLICA_IS_NOT_READY;
+    }
+
+    const DiskLocation& location = replica.disk_location;
+    if (replica.is_compressed()) {
+        std::vector<AllocatedBuffer::Descriptor> handles(
+            location.slice_sizes.size());
+        for (size_t i = 0; i < handles.size(); ++i) {
+            handles[i].size_ = location.slice_sizes[i];
+        }
+        return ReadCompressed(handles, replica.compression, slices, futures,
+                              &location);
+    }
+
+    // The extent is read back to back into the first size bytes of slices
+    const uint64_t size = location.size();
+    if (CalculateSliceSize(slices) < size) {
+        LOG(ERROR) << "Slice size " << CalculateSliceSize(slices)
+                   << " is smaller than total size " << size;
+        return ErrorCode::INVALID_PARAMS;
+    }
+    std::vector<Slice> read_slices;
+    uint64_t remaining = size;
+    for (const auto& slice : slices) {
+        if (remaining == 0) {
+            break;
+        }
+        size_t piece = std::min<uint64_t>(slice.size, remaining);
+        read_slices.push_back(Slice{slice.ptr, piece});
+        remaining -= piece;
+    }
+
+    auto state = std::make_shared<MemcpyOperationState>();
+    state->set_completed(disk_tier_->Read(location.offset, read_slices));
+    futures.emplace_back(state);
+    return ErrorCode::OK;
+}
+
+ErrorCode Client::InitDiskTier() {
+    const char* dir = std::getenv("MC_STORE_DISK_TIER_DIR");
+    if (!dir) {
+        return ErrorCode::OK;
+    }
+    std::ostringstream name;
+    name << "mooncake_disk_tier_" << client_id_.first << "_"
+         << client_id_.second;
+    auto path = std::filesystem::path(dir) / name.str();
+    disk_tier_ = DiskTier::Create(path.string(), get_disk_tier_size());
+    if (!disk_tier_) {
+        return ErrorCode::INVALID_PARAMS;
+    }
+    disk_tier_running_ = true;
+    disk_tier_thread_ = std::thread(&Client::DiskTierThreadFunc, this);
+    return ErrorCode::OK;
+}
+
+bool Client::MapLocalBuffers(
+    const std::vector<AllocatedBuffer::Descriptor>& buffers,
+    std::vector<Slice>& slices) {
+    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+    slices.clear();
+    for (const auto& buffer : buffers) {
+        bool local = false;
+        for (const auto& [id, segment] : mounted_segments_) {
+            if (buffer.buffer_address_ >= segment.base &&
+                buffer.buffer_address_ + buffer.size_ <=
+                    segment.base + segment.size) {
+                local = true;
+                break;
+            }
+        }
+        if (!local) {
+            LOG(ERROR) << "buffer_not_in_local_segment address="
+                       << buffer.buffer_address_ << " size=" << buffer.size_;
+            return false;
+        }
+        slices.push_back(
+            Slice{reinterpret_cast<void*>(buffer.buffer_address_),
+                  buffer.size_});
+    }
+    return true;
+}
+
+void Client::RunDiskTask(const DiskTask& task) {
+    switch (task.type) {
+        case DiskTaskType::SPILL: {
+            DiskLocation location;
+            location.owner = client_id_;
+            location.segment_name = task.buffers.empty()
+                                        ? local_hostname_
+                                        : task.buffers.front().segment_name_;
+            std::vector<Slice> slices;
+            ErrorCode err = ErrorCode::INVALID_PARAMS;
+            if (MapLocalBuffers(task.buffers, slices)) {
+                err = disk_tier_->Write(slices, location.offset);
+            }
+            for (const auto& slice : slices) {
+                location.slice_sizes.push_back(slice.size);
+            }
+            auto response =
+                master_client_.SpillEnd(task.key, location, err == ErrorCode::OK);
+            // The master did not take the extent
+            if (err == ErrorCode::OK &&
+                response.error_code != ErrorCode::OK) {
+                disk_tier_->Free(location.offset);
+            }
+            VLOG(1) << "spill key=" << task.key << " result=" << err
+                    << " master_result=" << response.error_code;
+            break;
+        }
+        case DiskTaskType::PROMOTE: {
+            std::vector<Slice> slices;
+            bool success = MapLocalBuffers(task.buffers, slices) &&
+                           disk_tier_->Read(task.location.offset, slices) ==
+                               ErrorCode::OK;
+            auto response =
+                master_client_.PromoteEnd(task.key, task.location, success);
+            if (success && response.error_code == ErrorCode::OK) {
+                disk_tier_->Free(task.location.offset);
+            }
+            VLOG(1) << "promote key=" << task.key << " success=" << success
+                    << " master_result=" << response.error_code;
+            break;
+        }
+        case DiskTaskType::DROP:
+            disk_tier_->Free(task.location.offset);
+            break;
+    }
+}
+
+void Client::DiskTierThreadFunc() {
+    while (disk_tier_running_) {
+        auto response = master_client_.FetchDiskTasks(client_id_);
+        for (const auto& task : response.tasks) {
+            RunDiskTask(task);
+        }
+        if (response.tasks.empty()) {
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(kDiskTaskPollIntervalMs));
+        }
+    }
 }
 
 void Client::PingThreadFunc() {
@@ -776,6 +2146,7 @@ void Client::PingThreadFunc() {
             continue;
         }
 
+        metric_.IncRetry(ClientRetry::MASTER_RECONNECT);
         err = master_client_.Connect(master_address);
         if (err != ErrorCode::OK) {
             LOG(ERROR) << "Failed to connect to master " << master_address
@@ -794,21 +2165,28 @@ void Client::PingThreadFunc() {
     }
 }
 
-ErrorCode Client::FindFirstCompleteReplica(
+ErrorCode Client::SelectReplica(
     const std::vector<Replica::Descriptor>& replica_list,
-    std::vector<AllocatedBuffer::Descriptor>& handles) {
+    std::vector<AllocatedBuffer::Descriptor>& handles,
+    ReplicaSelector::LoadGuard& load_guard,
+    const Replica::Descriptor** selected) {
     handles.clear();
 
-    // Find the first complete replica
-    for (size_t i = 0; i < replica_list.size(); ++i) {
-        if (replica_list[i].status == ReplicaStatus::COMPLETE) {
-            handles = replica_list[i].buffer_descriptors;
-            return ErrorCode::OK;
-        }
+    auto replica_idx = replica_selector_.Select(replica_list);
+    if (!replica_idx) {
+        // No complete replica found
+        return ErrorCode::INVALID_REPLICA;
     }
 
-    // No complete replica found
-    return ErrorCode::INVALID_REPLICA;
+    const auto& replica = replica_list[*replica_idx];
+    VLOG(1) << "selected_replica index=" << *replica_idx << " locality="
+            << static_cast<int>(replica_selector_.GetLocality(replica));
+    handles = replica.buffer_descriptors;
+    load_guard = replica_selector_.Acquire(replica);
+    if (selected) {
+        *selected = &replica;
+    }
+    return ErrorCode::OK;
 }
 
 }  // namespace mooncake
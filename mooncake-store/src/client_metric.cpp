@@ -0,0 +1,243 @@
+#include "client_metric.h"
+
+#include <iterator>
+#include <mutex>
+#include <sstream>
+
+namespace mooncake {
+
+namespace {
+
+// Label values of ClientRetry
+constexpr const char* kClientRetryNames[] = {"promotion_wait",
+                                             "master_reconnect"};
+static_assert(std::size(kClientRetryNames) ==
+              static_cast<size_t>(ClientRetry::NUM_RETRIES));
+
+constexpr TransferStrategy kStrategies[] = {TransferStrategy::LOCAL_MEMCPY,
+                                            TransferStrategy::TRANSFER_ENGINE};
+constexpr Transport::TransferRequest::OpCode kOpCodes[] = {
+    Transport::TransferRequest::READ, Transport::TransferRequest::WRITE};
+
+const char* StrategyName(TransferStrategy strategy) {
+    return strategy == TransferStrategy::LOCAL_MEMCPY ? "local_memcpy"
+                                                      : "transfer_engine";
+}
+
+const char* OpName(Transport::TransferRequest::OpCode op_code) {
+    return op_code == Transport::TransferRequest::READ ? "read" : "write";
+}
+
+void WriteHeader(std::ostream& os, const char* name, const char* type,
+                 const char* help) {
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+}
+
+}  // namespace
+
+ClientMetric::RpcScope::RpcScope(ClientMetric& metric, MasterRpc rpc)
+    : metric_(metric), latency_(metric.rpc_latency(rpc)) {
+    metric_.rpcs_in_flight_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ClientMetric::RpcScope::~RpcScope() {
+    metric_.rpcs_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ClientMetric::RecordTransfer(TransferStrategy strategy, OpCode op_code,
+                                  uint64_t bytes,
+                                  std::chrono::steady_clock::duration latency,
+                                  bool success) {
+    auto& stats = transfers_[TransferIndex(strategy, op_code)];
+    stats.latency.Record(latency);
+    if (success) {
+        stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+        stats.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    transfers_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ClientMetric::RecordPeerBytes(const std::string& peer, OpCode op_code,
+                                   uint64_t bytes) {
+    const size_t op = OpIndex(op_code);
+    {
+        std::shared_lock lock(peers_mutex_);
+        auto it = peers_.find(peer);
+        if (it != peers_.end()) {
+            it->second->bytes[op].fetch_add(bytes, std::memory_order_relaxed);
+            return;
+        }
+    }
+    std::unique_lock lock(peers_mutex_);
+    auto& stats = peers_[peer];
+    if (!stats) {
+        stats = std::make_unique<PeerStats>();
+    }
+    stats->bytes[op].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ClientMetric::RecordCompress(uint64_t raw_bytes, uint64_t stored_bytes,
+                                  uint64_t ns) {
+    compressed_slices_.fetch_add(1, std::memory_order_relaxed);
+    compress_raw_bytes_.fetch_add(raw_bytes, std::memory_order_relaxed);
+    compress_stored_bytes_.fetch_add(stored_bytes, std::memory_order_relaxed);
+    compress_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void ClientMetric::RecordDecompress(uint64_t raw_bytes, uint64_t ns) {
+    decompressed_bytes_.fetch_add(raw_bytes, std::memory_order_relaxed);
+    decompress_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+CompressionStats ClientMetric::compression_stats() const {
+    CompressionStats stats;
+    stats.compressed_slices =
+        compressed_slices_.load(std::memory_order_relaxed);
+    stats.raw_bytes = compress_raw_bytes_.load(std::memory_order_relaxed);
+    stats.stored_bytes =
+        compress_stored_bytes_.load(std::memory_order_relaxed);
+    stats.compress_ns = compress_ns_.load(std::memory_order_relaxed);
+    stats.decompressed_bytes =
+        decompressed_bytes_.load(std::memory_order_relaxed);
+    stats.decompress_ns = decompress_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t ClientMetric::peer_bytes(const std::string& peer,
+                                  OpCode op_code) const {
+    const size_t op = OpIndex(op_code);
+    std::shared_lock lock(peers_mutex_);
+    auto it = peers_.find(peer);
+    if (it == peers_.end()) {
+        return 0;
+    }
+    return it->second->bytes[op].load(std::memory_order_relaxed);
+}
+
+std::string ClientMetric::Serialize() const {
+    std::stringstream ss;
+
+    bool header_written = false;
+    for (size_t i = 0; i < rpc_latencies_.size(); ++i) {
+        if (rpc_latencies_[i].GetSnapshot().count == 0) {
+            continue;
+        }
+        if (!header_written) {
+            WriteHeader(ss, "client_rpc_latency_microseconds", "summary",
+                        "Latency of master RPCs seen by the client");
+            header_written = true;
+        }
+        std::string labels = std::string("method=\"") +
+                             MasterRpcName(static_cast<MasterRpc>(i)) + "\"";
+        rpc_latencies_[i].WritePrometheus(
+            ss, "client_rpc_latency_microseconds", labels);
+    }
+
+    header_written = false;
+    for (auto strategy : kStrategies) {
+        for (auto op_code : kOpCodes) {
+            const auto& latency = transfer_latency(strategy, op_code);
+            if (latency.GetSnapshot().count == 0) {
+                continue;
+            }
+            if (!header_written) {
+                WriteHeader(ss, "client_transfer_latency_microseconds",
+                            "summary",
+                            "Latency of transfers from submission to "
+                            "completion");
+                header_written = true;
+            }
+            std::string labels = std::string("strategy=\"") +
+                                 StrategyName(strategy) + "\",op=\"" +
+                                 OpName(op_code) + "\"";
+            latency.WritePrometheus(ss, "client_transfer_latency_microseconds",
+                                    labels);
+        }
+    }
+
+    WriteHeader(ss, "client_transfer_bytes_total", "counter",
+                "Bytes moved by successful transfers");
+    for (auto strategy : kStrategies) {
+        for (auto op_code : kOpCodes) {
+            ss << "client_transfer_bytes_total{strategy=\""
+               << StrategyName(strategy) << "\",op=\"" << OpName(op_code)
+               << "\"} " << transfer_bytes(strategy, op_code) << "\n";
+        }
+    }
+    WriteHeader(ss, "client_transfer_failures_total", "counter",
+                "Transfers that completed with an error");
+    for (auto strategy : kStrategies) {
+        for (auto op_code : kOpCodes) {
+            ss << "client_transfer_failures_total{strategy=\""
+               << StrategyName(strategy) << "\",op=\"" << OpName(op_code)
+               << "\"} " << transfer_failures(strategy, op_code) << "\n";
+        }
+    }
+
+    {
+        std::shared_lock lock(peers_mutex_);
+        if (!peers_.empty()) {
+            WriteHeader(ss, "client_peer_bytes_total", "counter",
+                        "Bytes moved from or to the segments of each peer");
+        }
+        for (const auto& [peer, stats] : peers_) {
+            for (auto op_code : kOpCodes) {
+                ss << "client_peer_bytes_total{peer=\"" << peer << "\",op=\""
+                   << OpName(op_code) << "\"} "
+                   << stats->bytes[OpIndex(op_code)].load(
+                          std::memory_order_relaxed)
+                   << "\n";
+            }
+        }
+    }
+
+    WriteHeader(ss, "client_retries_total", "counter",
+                "Requests repeated to the master");
+    for (size_t i = 0; i < retries_.size(); ++i) {
+        ss << "client_retries_total{reason=\"" << kClientRetryNames[i]
+           << "\"} " << retries_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    WriteHeader(ss, "client_revoked_puts_total", "counter",
+                "Objects whose put was revoked after a failed write");
+    ss << "client_revoked_puts_total " << revoked_puts() << "\n";
+
+    const CompressionStats compression = compression_stats();
+    WriteHeader(ss, "client_compressed_slices_total", "counter",
+                "Slices run through the compressor");
+    ss << "client_compressed_slices_total " << compression.compressed_slices
+       << "\n";
+    WriteHeader(ss, "client_compression_raw_bytes_total", "counter",
+                "Bytes fed to the compressor");
+    ss << "client_compression_raw_bytes_total " << compression.raw_bytes
+       << "\n";
+    WriteHeader(ss, "client_compression_stored_bytes_total", "counter",
+                "Bytes written for the input of the compressor");
+    ss << "client_compression_stored_bytes_total "
+       << compression.stored_bytes << "\n";
+    WriteHeader(ss, "client_compression_ratio", "gauge",
+                "Raw bytes per stored byte of compressed puts, 0 before any");
+    ss << "client_compression_ratio " << compression.ratio() << "\n";
+    WriteHeader(ss, "client_decompressed_bytes_total", "counter",
+                "Bytes produced by the decompressor");
+    ss << "client_decompressed_bytes_total "
+       << compression.decompressed_bytes << "\n";
+    WriteHeader(ss, "client_codec_throughput_mbps", "gauge",
+                "Average codec throughput in MB/s of raw data");
+    ss << "client_codec_throughput_mbps{op=\"compress\"} "
+       << compression.compress_mbps() << "\n";
+    ss << "client_codec_throughput_mbps{op=\"decompress\"} "
+       << compression.decompress_mbps() << "\n";
+
+    WriteHeader(ss, "client_rpcs_in_flight", "gauge",
+                "Master RPCs waiting for a response");
+    ss << "client_rpcs_in_flight " << rpcs_in_flight() << "\n";
+    WriteHeader(ss, "client_transfers_in_flight", "gauge",
+                "Submitted transfers that have not completed");
+    ss << "client_transfers_in_flight " << transfers_in_flight() << "\n";
+
+    return ss.str();
+}
+
+}  // namespace mooncake
@@ -0,0 +1,239 @@
+#include "compression.h"
+
+#include <glog/logging.h>
+#include <zlib.h>
+
+#ifdef STORE_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace mooncake {
+
+namespace {
+
+// Transpose elements of width bytes so that byte j of every element ends up
+// in plane j. A tail shorter than one element is copied as is.
+void Shuffle(const char* src, char* dst, size_t size, size_t width) {
+    const size_t count = size / width;
+    for (size_t j = 0; j < width; ++j) {
+        char* plane = dst + j * count;
+        for (size_t i = 0; i < count; ++i) {
+            plane[i] = src[i * width + j];
+        }
+    }
+    std::memcpy(dst + count * width, src + count * width, size - count * width);
+}
+
+void Unshuffle(const char* src, char* dst, size_t size, size_t width) {
+    const size_t count = size / width;
+    for (size_t j = 0; j < width; ++j) {
+        const char* plane = src + j * count;
+        for (size_t i = 0; i < count; ++i) {
+            dst[i * width + j] = plane[i];
+        }
+    }
+    std::memcpy(dst + count * width, src + count * width, size - count * width);
+}
+
+// Per-thread scratch space for the shuffled form of a slice
+char* ScratchBuffer(size_t size) {
+    thread_local std::vector<char> scratch;
+    if (scratch.size() < size) {
+        scratch.resize(size);
+    }
+    return scratch.data();
+}
+
+}  // namespace
+
+bool IsCodecSupported(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+        case CompressionCodec::ZLIB:
+            return true;
+        case CompressionCodec::ZSTD:
+#ifdef STORE_USE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+size_t CompressSlice(CompressionCodec codec, uint8_t shuffle_bytes,
+                     const void* src, size_t src_size, void* dst,
+                     size_t dst_capacity) {
+    // Anything not strictly smaller than the input is stored as is
+    dst_capacity = std::min(dst_capacity, src_size - (src_size > 0 ? 1 : 0));
+    if (src_size == 0 || dst_capacity == 0) {
+        return 0;
+    }
+
+    const char* input = static_cast<const char*>(src);
+    if (shuffle_bytes > 1) {
+        char* shuffled = ScratchBuffer(src_size);
+        Shuffle(input, shuffled, src_size, shuffle_bytes);
+        input = shuffled;
+    }
+
+    switch (codec) {
+        case CompressionCodec::ZLIB: {
+            uLongf dst_size = dst_capacity;
+            int ret = compress2(static_cast<Bytef*>(dst), &dst_size,
+                                reinterpret_cast<const Bytef*>(input),
+                                src_size, Z_BEST_SPEED);
+            // Z_BUF_ERROR means the data does not compress below capacity
+            return ret == Z_OK ? dst_size : 0;
+        }
+#ifdef STORE_USE_ZSTD
+        case CompressionCodec::ZSTD: {
+            size_t ret = ZSTD_compress(dst, dst_capacity, input, src_size, 1);
+            return ZSTD_isError(ret) ? 0 : ret;
+        }
+#endif
+        default:
+            return 0;
+    }
+}
+
+bool DecompressSlice(CompressionCodec codec, uint8_t shuffle_bytes,
+                     const void* src, size_t src_size, void* dst,
+                     size_t raw_size) {
+    char* output = static_cast<char*>(dst);
+    if (shuffle_bytes > 1) {
+        output = ScratchBuffer(raw_size);
+    }
+
+    bool ok = false;
+    switch (codec) {
+        case CompressionCodec::ZLIB: {
+            uLongf dst_size = raw_size;
+            int ret = uncompress(reinterpret_cast<Bytef*>(output), &dst_size,
+                                 static_cast<const Bytef*>(src), src_size);
+            ok = ret == Z_OK && dst_size == raw_size;
+            break;
+        }
+#ifdef STORE_USE_ZSTD
+        case CompressionCodec::ZSTD: {
+            size_t ret = ZSTD_decompress(output, raw_size, src, src_size);
+            ok = !ZSTD_isError(ret) && ret == raw_size;
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+    if (!ok) {
+        LOG(ERROR) << "decompress_failed codec=" << codec
+                   << " stored_size=" << src_size << " raw_size=" << raw_size;
+        return false;
+    }
+
+    if (shuffle_bytes > 1) {
+        Unshuffle(output, static_cast<char*>(dst), raw_size, shuffle_bytes);
+    }
+    return true;
+}
+
+size_t CompressionStage::get_worker_count() {
+    const char* env = std::getenv("MC_STORE_COMPRESSION_THREADS");
+    if (env) {
+        try {
+            long value = std::stol(env);
+            if (value >= 0) {
+                return static_cast<size_t>(value);
+            }
+        } catch (const std::exception&) {
+        }
+        LOG(WARNING) << "Ignoring invalid MC_STORE_COMPRESSION_THREADS=" << env;
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return std::clamp<size_t>(hw, 1, 4);
+}
+
+CompressionStage::CompressionStage(size_t num_workers) {
+    if (num_workers == 0) {
+        num_workers = get_worker_count();
+    }
+    // The calling thread works too, so one worker fewer keeps the
+    // parallelism at num_workers
+    for (size_t i = 1; i < num_workers; ++i) {
+        workers_.emplace_back(&CompressionStage::WorkerThread, this);
+    }
+}
+
+CompressionStage::~CompressionStage() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        shutdown_ = true;
+    }
+    queue_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void CompressionStage::RunJob(Job& job) {
+    size_t i;
+    while ((i = job.next.fetch_add(1)) < job.count) {
+        (*job.task)(i);
+        if (job.done.fetch_add(1) + 1 == job.count) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.cv.notify_all();
+        }
+    }
+}
+
+void CompressionStage::WorkerThread() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+            if (shutdown_) {
+                return;
+            }
+            job = queue_.front();
+            // Every index has been claimed, nothing left to help with
+            if (job->next.load() >= job->count) {
+                queue_.pop_front();
+                continue;
+            }
+        }
+        RunJob(*job);
+    }
+}
+
+void CompressionStage::ParallelFor(size_t count,
+                                   const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers_.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        queue_.push_back(job);
+    }
+    queue_cv_.notify_all();
+
+    RunJob(*job);
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cv.wait(lock, [&job] { return job->done.load() == job->count; });
+}
+
+}  // namespace mooncake
@@ -0,0 +1,310 @@
+#include "disk_tier.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace mooncake {
+
+namespace {
+
+// Unit of the I/O requests issued by the store
+constexpr size_t kIoChunkSize = 4 * 1024 * 1024;
+
+size_t AlignUp(size_t size) {
+    return (size + DiskTier::kAlignment - 1) / DiskTier::kAlignment *
+           DiskTier::kAlignment;
+}
+
+// Per-thread aligned bounce buffer of kIoChunkSize bytes
+char* IoBuffer() {
+    struct Deleter {
+        void operator()(char* ptr) const { std::free(ptr); }
+    };
+    thread_local std::unique_ptr<char, Deleter> buffer;
+    if (!buffer) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, DiskTier::kAlignment, kIoChunkSize) != 0) {
+            return nullptr;
+        }
+        buffer.reset(static_cast<char*>(ptr));
+    }
+    return buffer.get();
+}
+
+bool PwriteAll(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t ret = pwrite(fd, data, size, offset);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        size -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+bool PreadAll(int fd, char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t ret = pread(fd, data, size, offset);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (ret == 0) {
+            return false;
+        }
+        data += ret;
+        size -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::unique_ptr<DiskTier> DiskTier::Create(const std::string& path,
+                                           size_t capacity) {
+    capacity = capacity / kAlignment * kAlignment;
+    if (capacity == 0) {
+        LOG(ERROR) << "disk_tier_too_small path=" << path;
+        return nullptr;
+    }
+
+    bool direct_io = true;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0600);
+    if (fd < 0 && errno == EINVAL) {
+        // e.g. tmpfs
+        direct_io = false;
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+    if (fd < 0) {
+        LOG(ERROR) << "disk_tier_open_failed path=" << path
+                   << " error=" << strerror(errno);
+        return nullptr;
+    }
+
+    int rc = posix_fallocate(fd, 0, capacity);
+    if (rc != 0) {
+        LOG(ERROR) << "disk_tier_fallocate_failed path=" << path
+                   << " capacity=" << capacity << " error=" << strerror(rc);
+        close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+
+    LOG(INFO) << "disk_tier_created path=" << path << " capacity=" << capacity
+              << " direct_io=" << direct_io;
+    return std::unique_ptr<DiskTier>(
+        new DiskTier(fd, path, capacity, direct_io));
+}
+
+DiskTier::DiskTier(int fd, std::string path, size_t capacity, bool direct_io)
+    : fd_(fd),
+      path_(std::move(path)),
+      capacity_(capacity),
+      direct_io_(direct_io) {
+    free_extents_[0] = capacity_;
+}
+
+DiskTier::~DiskTier() {
+    close(fd_);
+    unlink(path_.c_str());
+}
+
+size_t DiskTier::used() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_;
+}
+
+bool DiskTier::AllocateExtent(size_t size, uint64_t& offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = free_extents_.begin(); it != free_extents_.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+        offset = it->first;
+        uint64_t remaining = it->second - size;
+        free_extents_.erase(it);
+        if (remaining > 0) {
+            free_extents_[offset + size] = remaining;
+        }
+        used_extents_[offset] = Extent{size};
+        used_ += size;
+        return true;
+    }
+    return false;
+}
+
+void DiskTier::Free(uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto used_it = used_extents_.find(offset);
+    if (used_it == used_extents_.end() || used_it->second.freed) {
+        LOG(ERROR) << "disk_tier_free_unknown_extent offset=" << offset;
+        return;
+    }
+    if (used_it->second.readers > 0) {
+        // The last reader releases it
+        used_it->second.freed = true;
+        return;
+    }
+    ReleaseExtentLocked(used_it);
+}
+
+void DiskTier::ReleaseExtentLocked(
+    std::unordered_map<uint64_t, Extent>::iterator it) {
+    uint64_t offset = it->first;
+    uint64_t size = it->second.size;
+    used_extents_.erase(it);
+    used_ -= size;
+
+    // Merge with the free neighbours
+    auto next = free_extents_.lower_bound(offset);
+    if (next != free_extents_.end() && offset + size == next->first) {
+        size += next->second;
+        next = free_extents_.erase(next);
+    }
+    if (next != free_extents_.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    free_extents_[offset] = size;
+}
+
+ErrorCode DiskTier::Write(const std::vector<Slice>& slices,
+                          uint64_t& offset) {
+    size_t size = 0;
+    for (const auto& slice : slices) {
+        size += slice.size;
+    }
+    if (size == 0) {
+        return ErrorCode::INVALID_PARAMS;
+    }
+    char* chunk = IoBuffer();
+    if (!chunk) {
+        return ErrorCode::INTERNAL_ERROR;
+    }
+    if (!AllocateExtent(AlignUp(size), offset)) {
+        VLOG(1) << "disk_tier_full size=" << size << " used=" << used();
+        return ErrorCode::BUFFER_OVERFLOW;
+    }
+
+    uint64_t pos = 0;
+    size_t fill = 0;
+    for (const auto& slice : slices) {
+        const char* src = static_cast<const char*>(slice.ptr);
+        size_t left = slice.size;
+        while (left > 0) {
+            size_t piece = std::min(left, kIoChunkSize - fill);
+            std::memcpy(chunk + fill, src, piece);
+            fill += piece;
+            src += piece;
+            left -= piece;
+            if (fill == kIoChunkSize) {
+                if (!PwriteAll(fd_, chunk, fill, offset + pos)) {
+                    LOG(ERROR) << "disk_tier_write_failed offset="
+                               << offset + pos << " error=" << strerror(errno);
+                    Free(offset);
+                    return ErrorCode::WRITE_FAIL;
+                }
+                pos += fill;
+                fill = 0;
+            }
+        }
+    }
+    if (fill > 0) {
+        size_t padded = AlignUp(fill);
+        std::memset(chunk + fill, 0, padded - fill);
+        if (!PwriteAll(fd_, chunk, padded, offset + pos)) {
+            LOG(ERROR) << "disk_tier_write_failed offset=" << offset + pos
+                       << " error=" << strerror(errno);
+            Free(offset);
+            return ErrorCode::WRITE_FAIL;
+        }
+    }
+    return ErrorCode::OK;
+}
+
+ErrorCode DiskTier::Read(uint64_t offset, const std::vector<Slice>& slices,
+                         uint64_t start) {
+    size_t size = 0;
+    for (const auto& slice : slices) {
+        size += slice.size;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = used_extents_.find(offset);
+        if (it == used_extents_.end() || it->second.freed ||
+            it->second.size < start + size) {
+            LOG(ERROR) << "disk_tier_bad_extent offset=" << offset
+                       << " start=" << start << " size=" << size;
+            return ErrorCode::INVALID_PARAMS;
+        }
+        // Keep the extent from being reused while reading it
+        ++it->second.readers;
+    }
+
+    ErrorCode err = ReadExtent(offset, start, size, slices);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = used_extents_.find(offset);
+    if (--it->second.readers == 0 && it->second.freed) {
+        ReleaseExtentLocked(it);
+    }
+    return err;
+}
+
+ErrorCode DiskTier::ReadExtent(uint64_t offset, uint64_t start, size_t size,
+                               const std::vector<Slice>& slices) {
+    char* chunk = IoBuffer();
+    if (!chunk) {
+        return ErrorCode::INTERNAL_ERROR;
+    }
+
+    // Reads start at an aligned position, the bytes before start are skipped
+    const uint64_t end = start + size;
+    size_t skip = start % kAlignment;
+    size_t slice_idx = 0;
+    size_t slice_pos = 0;
+    for (uint64_t pos = start - skip; pos < end; pos += kIoChunkSize) {
+        size_t length = std::min<uint64_t>(kIoChunkSize, end - pos);
+        if (!PreadAll(fd_, chunk, AlignUp(length), offset + pos)) {
+            LOG(ERROR) << "disk_tier_read_failed offset=" << offset + pos
+                       << " error=" << strerror(errno);
+            return ErrorCode::INVALID_READ;
+        }
+        // Scatter the chunk over the slices
+        size_t chunk_pos = skip;
+        skip = 0;
+        while (chunk_pos < length) {
+            while (slices[slice_idx].size == slice_pos) {
+                ++slice_idx;
+                slice_pos = 0;
+            }
+            const auto& slice = slices[slice_idx];
+            size_t piece = std::min(length - chunk_pos, slice.size - slice_pos);
+            std::memcpy(static_cast<char*>(slice.ptr) + slice_pos,
+                        chunk + chunk_pos, piece);
+            chunk_pos += piece;
+            slice_pos += piece;
+        }
+    }
+    return ErrorCode::OK;
+}
+
+}  // namespace mooncake
@@ -0,0 +1,102 @@
+#include "fast_memcpy.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace mooncake {
+
+#if defined(__x86_64__)
+namespace {
+
+constexpr size_t kStreamAlignment = 64;
+// Bytes moved per loop iteration by every kernel
+constexpr size_t kStreamBlock = 256;
+
+using CopyKernel = void (*)(char*, const char*, size_t);
+
+// dest must be 64-byte aligned and size a multiple of kStreamBlock
+__attribute__((target("avx512f"))) void stream_copy_avx512(char* dest,
+                                                          const char* src,
+                                                          size_t size) {
+    for (size_t i = 0; i < size; i += kStreamBlock) {
+        __m512i v0 = _mm512_loadu_si512(src + i);
+        __m512i v1 = _mm512_loadu_si512(src + i + 64);
+        __m512i v2 = _mm512_loadu_si512(src + i + 128);
+        __m512i v3 = _mm512_loadu_si512(src + i + 192);
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dest + i), v0);
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dest + i + 64), v1);
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dest + i + 128), v2);
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dest + i + 192), v3);
+    }
+    _mm_sfence();
+}
+
+__attribute__((target("avx2"))) void stream_copy_avx2(char* dest,
+                                                      const char* src,
+                                                      size_t size) {
+    for (size_t i = 0; i < size; i += kStreamBlock) {
+        for (size_t j = 0; j < kStreamBlock; j += 128) {
+            const char* s = src + i + j;
+            char* d = dest + i + j;
+            __m256i v0 =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+            __m256i v1 =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32));
+            __m256i v2 =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 64));
+            __m256i v3 =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 96));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d), v0);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 32), v1);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 64), v2);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 96), v3);
+        }
+    }
+    _mm_sfence();
+}
+
+CopyKernel select_stream_kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return stream_copy_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return stream_copy_avx2;
+    }
+    return nullptr;
+}
+
+}  // namespace
+#endif
+
+void fast_memcpy(void* dest, const void* src, size_t size) {
+#if defined(__x86_64__)
+    static const CopyKernel kernel = select_stream_kernel();
+    if (kernel && size >= kNonTemporalCopyThreshold) {
+        char* d = static_cast<char*>(dest);
+        const char* s = static_cast<const char*>(src);
+
+        // Align the destination for the streaming stores
+        const size_t misalignment =
+            reinterpret_cast<uintptr_t>(d) % kStreamAlignment;
+        const size_t head =
+            misalignment ? kStreamAlignment - misalignment : 0;
+        std::memcpy(d, s, head);
+        d += head;
+        s += head;
+        size -= head;
+
+        const size_t body = size - size % kStreamBlock;
+        kernel(d, s, body);
+        std::memcpy(d + body, s + body, size - body);
+        return;
+    }
+#endif
+    std::memcpy(dest, src, size);
+}
+
+}  // namespace mooncake
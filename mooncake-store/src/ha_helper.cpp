@@ -94,7 +94,8 @@ MasterServiceSupervisor::MasterServiceSupervisor(
     bool enable_metric_reporting, int metrics_port,
     int64_t default_kv_lease_ttl, double eviction_ratio,
     double eviction_high_watermark_ratio, int64_t client_live_ttl_sec,
-    const std::string& etcd_endpoints, const std::string& local_hostname)
+    const std::string& etcd_endpoints, const std::string& local_hostname,
+    bool enable_prefix_index)
     : port_(port),
       server_thread_num_(server_thread_num),
       enable_gc_(enable_gc),
@@ -104,6 +105,7 @@ MasterServiceSupervisor::MasterServiceSupervisor(
       eviction_ratio_(eviction_ratio),
       eviction_high_watermark_ratio_(eviction_high_watermark_ratio),
       client_live_ttl_sec_(client_live_ttl_sec),
+      enable_prefix_index_(enable_prefix_index),
       etcd_endpoints_(etcd_endpoints),
       local_hostname_(local_hostname) {}
 
@@ -141,7 +143,7 @@ int MasterServiceSupervisor::Start() {
         mooncake::WrappedMasterService wrapped_master_service(
             enable_gc_, default_kv_lease_ttl_, enable_metric_reporting_,
             metrics_port_, eviction_ratio_, eviction_high_watermark_ratio_,
-            version, client_live_ttl_sec_, enable_ha);
+            version, client_live_ttl_sec_, enable_ha, enable_prefix_index_);
         mooncake::RegisterRpcService(server, wrapped_master_service);
         // Metric reporting is now handled by WrappedMasterService.
 
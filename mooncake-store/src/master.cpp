@@ -42,6 +42,9 @@ DEFINE_string(local_hostname, "",
 DEFINE_int64(client_ttl, mooncake::DEFAULT_CLIENT_LIVE_TTL_SEC,
              "How long a client is considered alive after the last ping, only "
              "used in HA mode");
+DEFINE_bool(enable_prefix_index, false,
+            "Index keys of the form <parent_hash>/<block_hash> to answer "
+            "LongestCachedPrefix requests without probing every block");
 
 int main(int argc, char* argv[]) {
     easylog::set_min_severity(easylog::Severity::WARN);
@@ -60,7 +63,8 @@ int main(int argc, char* argv[]) {
               << ", enable_ha=" << FLAGS_enable_ha
               << ", etcd_endpoints=" << FLAGS_etcd_endpoints
               << ", local_hostname=" << FLAGS_local_hostname
-              << ", client_ttl=" << FLAGS_client_ttl;
+              << ", client_ttl=" << FLAGS_client_ttl
+              << ", enable_prefix_index=" << FLAGS_enable_prefix_index;
 
     int server_thread_num =
         std::min(FLAGS_max_threads,
@@ -90,7 +94,8 @@ int main(int argc, char* argv[]) {
             FLAGS_enable_metric_reporting, FLAGS_metrics_port,
             FLAGS_default_kv_lease_ttl, FLAGS_eviction_ratio,
             FLAGS_eviction_high_watermark_ratio, FLAGS_client_ttl,
-            FLAGS_etcd_endpoints, FLAGS_local_hostname);
+            FLAGS_etcd_endpoints, FLAGS_local_hostname,
+            FLAGS_enable_prefix_index);
 
         return supervisor.Start();
     } else {
@@ -101,7 +106,7 @@ int main(int argc, char* argv[]) {
             FLAGS_enable_gc, FLAGS_default_kv_lease_ttl,
             FLAGS_enable_metric_reporting, FLAGS_metrics_port,
             FLAGS_eviction_ratio, FLAGS_eviction_high_watermark_ratio, version,
-            FLAGS_client_ttl, FLAGS_enable_ha);
+            FLAGS_client_ttl, FLAGS_enable_ha, FLAGS_enable_prefix_index);
 
         mooncake::RegisterRpcService(server, wrapped_master_service);
         return server.start();
@@ -17,7 +17,7 @@ namespace mooncake {
 using namespace coro_rpc;
 using namespace async_simple::coro;
 
-MasterClient::MasterClient() = default;
+MasterClient::MasterClient(ClientMetric& metric) : metric_(metric) {}
 MasterClient::~MasterClient() = default;
 
 ErrorCode MasterClient::Connect(const std::string& master_addr) {
@@ -35,6 +35,7 @@ ErrorCode MasterClient::Connect(const std::string& master_addr) {
 
 ExistKeyResponse MasterClient::ExistKey(const std::string& object_key) {
     ScopedVLogTimer timer(1, "MasterClient::ExistKey");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::EXIST_KEY);
     timer.LogRequest("object_key=", object_key);
 
     auto request_result =
@@ -60,13 +61,78 @@ ExistKeyResponse MasterClient::ExistKey(const std::string& object_key) {
     return result.value();
 }
 
+BatchExistKeyResponse MasterClient::BatchExistKey(
+    const std::vector<std::string>& object_keys) {
+    ScopedVLogTimer timer(1, "MasterClient::BatchExistKey");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::BATCH_EXIST_KEY);
+    timer.LogRequest("keys_count=", object_keys.size());
+
+    auto request_result =
+        client_.send_request<&WrappedMasterService::BatchExistKey>(
+            object_keys);
+    std::optional<BatchExistKeyResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<BatchExistKeyResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to check batch key existence: "
+                           << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+
+    if (!result) {
+        auto response = BatchExistKeyResponse{
+            std::vector<ErrorCode>(object_keys.size(), ErrorCode::RPC_FAIL),
+            ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
+LongestCachedPrefixResponse MasterClient::LongestCachedPrefix(
+    const std::vector<std::string>& object_keys) {
+    ScopedVLogTimer timer(1, "MasterClient::LongestCachedPrefix");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::LONGEST_CACHED_PREFIX);
+    timer.LogRequest("keys_count=", object_keys.size());
+
+    auto request_result =
+        client_.send_request<&WrappedMasterService::LongestCachedPrefix>(
+            object_keys);
+    std::optional<LongestCachedPrefixResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<LongestCachedPrefixResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to query longest cached prefix: "
+                           << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+
+    if (!result) {
+        auto response = LongestCachedPrefixResponse{0, ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
 GetReplicaListResponse MasterClient::GetReplicaList(
     const std::string& object_key) {
     ScopedVLogTimer timer(1, "MasterClient::GetReplicaList");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::GET_REPLICA_LIST);
+    TraceSpan span("rpc.GetReplicaList");
     timer.LogRequest("object_key=", object_key);
 
     auto request_result =
-        client_.send_request<&WrappedMasterService::GetReplicaList>(object_key);
+        client_.send_request<&WrappedMasterService::GetReplicaList>(
+            object_key, Tracer::currentTraceId());
     std::optional<GetReplicaListResponse> result = coro::syncAwait(
         [&]() -> coro::Lazy<std::optional<GetReplicaListResponse>> {
             auto result = co_await co_await request_result;
@@ -86,14 +152,69 @@ GetReplicaListResponse MasterClient::GetReplicaList(
     return result.value();
 }
 
+GetReplicaListResponse MasterClient::PinKey(const std::string& object_key,
+                                            const UUID& client_id) {
+    ScopedVLogTimer timer(1, "MasterClient::PinKey");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PIN_KEY);
+    timer.LogRequest("object_key=", object_key, ", client_id=", client_id);
+
+    auto request_result = client_.send_request<&WrappedMasterService::PinKey>(
+        object_key, client_id);
+    std::optional<GetReplicaListResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<GetReplicaListResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to pin key: " << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = GetReplicaListResponse{{}, ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
+UnpinKeyResponse MasterClient::UnpinKey(const std::string& object_key,
+                                        const UUID& client_id) {
+    ScopedVLogTimer timer(1, "MasterClient::UnpinKey");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::UNPIN_KEY);
+    timer.LogRequest("object_key=", object_key, ", client_id=", client_id);
+
+    auto request_result = client_.send_request<&WrappedMasterService::UnpinKey>(
+        object_key, client_id);
+    std::optional<UnpinKeyResponse> result =
+        coro::syncAwait([&]() -> coro::Lazy<std::optional<UnpinKeyResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to unpin key: " << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = UnpinKeyResponse{ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
 BatchGetReplicaListResponse MasterClient::BatchGetReplicaList(
     const std::vector<std::string>& object_keys) {
     ScopedVLogTimer timer(1, "MasterClient::BatchGetReplicaList");
+    ClientMetric::RpcScope rpc_scope(metric_,
+                                     MasterRpc::BATCH_GET_REPLICA_LIST);
+    TraceSpan span("rpc.BatchGetReplicaList");
     timer.LogRequest("action=get_batch_replica_list");
 
     auto request_result =
         client_.send_request<&WrappedMasterService::BatchGetReplicaList>(
-            object_keys);
+            object_keys, Tracer::currentTraceId());
     std::optional<BatchGetReplicaListResponse> result = coro::syncAwait(
         [&]() -> coro::Lazy<std::optional<BatchGetReplicaListResponse>> {
             auto result = co_await co_await request_result;
@@ -115,8 +236,11 @@ BatchGetReplicaListResponse MasterClient::BatchGetReplicaList(
 
 PutStartResponse MasterClient::PutStart(
     const std::string& key, const std::vector<size_t>& slice_lengths,
-    size_t value_length, const ReplicateConfig& config) {
+    size_t value_length, const ReplicateConfig& config,
+    const CompressionInfo& compression, const ContentHash& content_hash) {
     ScopedVLogTimer timer(1, "MasterClient::PutStart");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PUT_START);
+    TraceSpan span("rpc.PutStart");
     timer.LogRequest("key=", key, ", value_length=", value_length,
                      ", slice_count=", slice_lengths.size());
 
@@ -128,7 +252,8 @@ PutStartResponse MasterClient::PutStart(
     }
 
     auto request_result = client_.send_request<&WrappedMasterService::PutStart>(
-        key, value_length, rpc_slice_lengths, config);
+        key, value_length, rpc_slice_lengths, config, compression,
+        content_hash, Tracer::currentTraceId());
     std::optional<PutStartResponse> result =
         coro::syncAwait([&]() -> coro::Lazy<std::optional<PutStartResponse>> {
             auto result = co_await co_await request_result;
@@ -154,11 +279,14 @@ BatchPutStartResponse MasterClient::BatchPutStart(
     const std::unordered_map<std::string, std::vector<uint64_t>>& slice_lengths,
     const ReplicateConfig& config) {
     ScopedVLogTimer timer(1, "MasterClient::BatchPutStart");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::BATCH_PUT_START);
+    TraceSpan span("rpc.BatchPutStart");
     timer.LogRequest("keys_count=", keys.size());
 
     auto request_result =
         client_.send_request<&WrappedMasterService::BatchPutStart>(
-            keys, value_lengths, slice_lengths, config);
+            keys, value_lengths, slice_lengths, config,
+            Tracer::currentTraceId());
     std::optional<BatchPutStartResponse> result = coro::syncAwait(
         [&]() -> coro::Lazy<std::optional<BatchPutStartResponse>> {
             auto result = co_await co_await request_result;
@@ -180,10 +308,12 @@ BatchPutStartResponse MasterClient::BatchPutStart(
 
 PutEndResponse MasterClient::PutEnd(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::PutEnd");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PUT_END);
+    TraceSpan span("rpc.PutEnd");
     timer.LogRequest("key=", key);
 
-    auto request_result =
-        client_.send_request<&WrappedMasterService::PutEnd>(key);
+    auto request_result = client_.send_request<&WrappedMasterService::PutEnd>(
+        key, Tracer::currentTraceId());
     std::optional<PutEndResponse> result =
         coro::syncAwait([&]() -> coro::Lazy<std::optional<PutEndResponse>> {
             auto result = co_await co_await request_result;
@@ -206,10 +336,13 @@ PutEndResponse MasterClient::PutEnd(const std::string& key) {
 BatchPutEndResponse MasterClient::BatchPutEnd(
     const std::vector<std::string>& keys) {
     ScopedVLogTimer timer(1, "MasterClient::BatchPutEnd");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::BATCH_PUT_END);
+    TraceSpan span("rpc.BatchPutEnd");
     timer.LogRequest("keys_count=", keys.size());
 
     auto request_result =
-        client_.send_request<&WrappedMasterService::BatchPutEnd>(keys);
+        client_.send_request<&WrappedMasterService::BatchPutEnd>(
+            keys, Tracer::currentTraceId());
     std::optional<BatchPutEndResponse> result = coro::syncAwait(
         [&]() -> coro::Lazy<std::optional<BatchPutEndResponse>> {
             auto result = co_await co_await request_result;
@@ -231,6 +364,7 @@ BatchPutEndResponse MasterClient::BatchPutEnd(
 
 PutRevokeResponse MasterClient::PutRevoke(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::PutRevoke");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PUT_REVOKE);
     timer.LogRequest("key=", key);
 
     auto request_result =
@@ -257,6 +391,7 @@ PutRevokeResponse MasterClient::PutRevoke(const std::string& key) {
 BatchPutRevokeResponse MasterClient::BatchPutRevoke(
     const std::vector<std::string>& keys) {
     ScopedVLogTimer timer(1, "MasterClient::BatchPutRevoke");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::BATCH_PUT_REVOKE);
     timer.LogRequest("keys_count=", keys.size());
 
     auto request_result =
@@ -282,6 +417,7 @@ BatchPutRevokeResponse MasterClient::BatchPutRevoke(
 
 RemoveResponse MasterClient::Remove(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::Remove");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::REMOVE);
     timer.LogRequest("key=", key);
 
     auto request_result =
@@ -304,8 +440,38 @@ RemoveResponse MasterClient::Remove(const std::string& key) {
     return result.value();
 }
 
+BatchRemoveResponse MasterClient::BatchRemove(
+    const std::vector<std::string>& keys) {
+    ScopedVLogTimer timer(1, "MasterClient::BatchRemove");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::BATCH_REMOVE);
+    timer.LogRequest("keys_count=", keys.size());
+
+    auto request_result =
+        client_.send_request<&WrappedMasterService::BatchRemove>(keys);
+    std::optional<BatchRemoveResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<BatchRemoveResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to remove batch objects: "
+                           << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = BatchRemoveResponse{
+            std::vector<ErrorCode>(keys.size(), ErrorCode::RPC_FAIL),
+            ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
 RemoveAllResponse MasterClient::RemoveAll() {
     ScopedVLogTimer timer(1, "MasterClient::RemoveAll");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::REMOVE_ALL);
     timer.LogRequest("action=remove_all_objects");
 
     auto request_result =
@@ -334,6 +500,7 @@ RemoveAllResponse MasterClient::RemoveAll() {
 MountSegmentResponse MasterClient::MountSegment(const Segment& segment,
                                                 const UUID& client_id) {
     ScopedVLogTimer timer(1, "MasterClient::MountSegment");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::MOUNT_SEGMENT);
     timer.LogRequest("base=", segment.base, ", size=", segment.size,
                      ", name=", segment.name, ", id=", segment.id,
                      ", client_id=", client_id);
@@ -363,6 +530,7 @@ MountSegmentResponse MasterClient::MountSegment(const Segment& segment,
 ReMountSegmentResponse MasterClient::ReMountSegment(
     const std::vector<Segment>& segments, const UUID& client_id) {
     ScopedVLogTimer timer(1, "MasterClient::ReMountSegment");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::REMOUNT_SEGMENT);
     timer.LogRequest("segments_num=", segments.size(), ", client_id=", client_id);
 
     std::optional<ReMountSegmentResponse> result =
@@ -390,6 +558,7 @@ ReMountSegmentResponse MasterClient::ReMountSegment(
 UnmountSegmentResponse MasterClient::UnmountSegment(const UUID& segment_id,
                                                     const UUID& client_id) {
     ScopedVLogTimer timer(1, "MasterClient::UnmountSegment");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::UNMOUNT_SEGMENT);
     timer.LogRequest("segment_id=", segment_id, ", client_id=", client_id);
 
     auto request_result =
@@ -416,6 +585,7 @@ UnmountSegmentResponse MasterClient::UnmountSegment(const UUID& segment_id,
 
 PingResponse MasterClient::Ping(const UUID& client_id) {
     ScopedVLogTimer timer(1, "MasterClient::Ping");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PING);
     timer.LogRequest("client_id=", client_id);
 
     auto request_result =
@@ -440,4 +610,181 @@ PingResponse MasterClient::Ping(const UUID& client_id) {
     return result.value();
 }
 
+FetchDiskTasksResponse MasterClient::FetchDiskTasks(const UUID& client_id) {
+    ScopedVLogTimer timer(1, "MasterClient::FetchDiskTasks");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::FETCH_DISK_TASKS);
+    timer.LogRequest("client_id=", client_id);
+
+    auto request_result =
+        client_.send_request<&WrappedMasterService::FetchDiskTasks>(client_id);
+    std::optional<FetchDiskTasksResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<FetchDiskTasksResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to fetch disk tasks: "
+                           << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = FetchDiskTasksResponse{{}, ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
+SpillEndResponse MasterClient::SpillEnd(const std::string& key,
+                                        const DiskLocation& location,
+                                        bool success) {
+    ScopedVLogTimer timer(1, "MasterClient::SpillEnd");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::SPILL_END);
+    timer.LogRequest("key=", key, ", offset=", location.offset,
+                     ", success=", success);
+
+    auto request_result = client_.send_request<&WrappedMasterService::SpillEnd>(
+        key, location, success);
+    std::optional<SpillEndResponse> result =
+        coro::syncAwait([&]() -> coro::Lazy<std::optional<SpillEndResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to end spill: " << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = SpillEndResponse{ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
+PromoteEndResponse MasterClient::PromoteEnd(const std::string& key,
+                                            const DiskLocation& location,
+                                            bool success) {
+    ScopedVLogTimer timer(1, "MasterClient::PromoteEnd");
+    ClientMetric::RpcScope rpc_scope(metric_, MasterRpc::PROMOTE_END);
+    timer.LogRequest("key=", key, ", offset=", location.offset,
+                     ", success=", success);
+
+    auto request_result =
+        client_.send_request<&WrappedMasterService::PromoteEnd>(key, location,
+                                                                success);
+    std::optional<PromoteEndResponse> result = coro::syncAwait(
+        [&]() -> coro::Lazy<std::optional<PromoteEndResponse>> {
+            auto result = co_await co_await request_result;
+            if (!result) {
+                LOG(ERROR) << "Failed to end promotion: " << result.error().msg;
+                co_return std::nullopt;
+            }
+            co_return result->result();
+        }());
+    if (!result) {
+        auto response = PromoteEndResponse{ErrorCode::RPC_FAIL};
+        timer.LogResponseJson(response);
+        return response;
+    }
+    timer.LogResponseJson(result.value());
+    return result.value();
+}
+
+template <auto ServiceMethod, typename ResponseType, typename... Args>
+coro::Lazy<ResponseType> MasterClient::InvokeAsync(std::string_view rpc_name,
+                                                   MasterRpc rpc,
+                                                   ResponseType fail_response,
+                                                   Args... args) {
+    ScopedVLogTimer timer(1, rpc_name);
+    ClientMetric::RpcScope rpc_scope(metric_, rpc);
+    timer.LogRequest("async=true");
+
+    auto result =
+        co_await co_await client_.send_request<ServiceMethod>(args...);
+    if (!result) {
+        LOG(ERROR) << rpc_name << " failed: " << result.error().msg;
+        timer.LogResponseJson(fail_response);
+        co_return fail_response;
+    }
+    timer.LogResponseJson(result->result());
+    co_return result->result();
+}
+
+coro::Lazy<GetReplicaListResponse> MasterClient::AsyncGetReplicaList(
+    std::string object_key, uint64_t trace_id) {
+    TraceSpan span("rpc.GetReplicaList", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::GetReplicaList>(
+        "MasterClient::AsyncGetReplicaList", MasterRpc::GET_REPLICA_LIST,
+        GetReplicaListResponse{{}, ErrorCode::RPC_FAIL}, std::move(object_key),
+        trace_id);
+}
+
+coro::Lazy<BatchGetReplicaListResponse> MasterClient::AsyncBatchGetReplicaList(
+    std::vector<std::string> object_keys, uint64_t trace_id) {
+    TraceSpan span("rpc.BatchGetReplicaList", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::BatchGetReplicaList>(
+        "MasterClient::AsyncBatchGetReplicaList",
+        MasterRpc::BATCH_GET_REPLICA_LIST,
+        BatchGetReplicaListResponse{{}, ErrorCode::RPC_FAIL},
+        std::move(object_keys), trace_id);
+}
+
+coro::Lazy<PutStartResponse> MasterClient::AsyncPutStart(
+    std::string key, std::vector<uint64_t> slice_lengths,
+    uint64_t value_length, ReplicateConfig config,
+    CompressionInfo compression, ContentHash content_hash,
+    uint64_t trace_id) {
+    TraceSpan span("rpc.PutStart", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::PutStart>(
+        "MasterClient::AsyncPutStart", MasterRpc::PUT_START,
+        PutStartResponse{{}, ErrorCode::RPC_FAIL}, std::move(key),
+        value_length, std::move(slice_lengths), std::move(config),
+        std::move(compression), content_hash, trace_id);
+}
+
+coro::Lazy<BatchPutStartResponse> MasterClient::AsyncBatchPutStart(
+    std::vector<std::string> keys,
+    std::unordered_map<std::string, uint64_t> value_lengths,
+    std::unordered_map<std::string, std::vector<uint64_t>> slice_lengths,
+    ReplicateConfig config, uint64_t trace_id) {
+    TraceSpan span("rpc.BatchPutStart", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::BatchPutStart>(
+        "MasterClient::AsyncBatchPutStart", MasterRpc::BATCH_PUT_START,
+        BatchPutStartResponse{{}, ErrorCode::RPC_FAIL}, std::move(keys),
+        std::move(value_lengths), std::move(slice_lengths), std::move(config),
+        trace_id);
+}
+
+coro::Lazy<PutEndResponse> MasterClient::AsyncPutEnd(std::string key,
+                                                     uint64_t trace_id) {
+    TraceSpan span("rpc.PutEnd", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::PutEnd>(
+        "MasterClient::AsyncPutEnd", MasterRpc::PUT_END,
+        PutEndResponse{ErrorCode::RPC_FAIL}, std::move(key), trace_id);
+}
+
+coro::Lazy<BatchPutEndResponse> MasterClient::AsyncBatchPutEnd(
+    std::vector<std::string> keys, uint64_t trace_id) {
+    TraceSpan span("rpc.BatchPutEnd", trace_id);
+    co_return co_await InvokeAsync<&WrappedMasterService::BatchPutEnd>(
+        "MasterClient::AsyncBatchPutEnd", MasterRpc::BATCH_PUT_END,
+        BatchPutEndResponse{ErrorCode::RPC_FAIL}, std::move(keys), trace_id);
+}
+
+coro::Lazy<PutRevokeResponse> MasterClient::AsyncPutRevoke(std::string key) {
+    co_return co_await InvokeAsync<&WrappedMasterService::PutRevoke>(
+        "MasterClient::AsyncPutRevoke", MasterRpc::PUT_REVOKE,
+        PutRevokeResponse{ErrorCode::RPC_FAIL}, std::move(key));
+}
+
+coro::Lazy<BatchPutRevokeResponse> MasterClient::AsyncBatchPutRevoke(
+    std::vector<std::string> keys) {
+    co_return co_await InvokeAsync<&WrappedMasterService::BatchPutRevoke>(
+        "MasterClient::AsyncBatchPutRevoke", MasterRpc::BATCH_PUT_REVOKE,
+        BatchPutRevokeResponse{ErrorCode::RPC_FAIL}, std::move(keys));
+}
+
 }  // namespace mooncake
@@ -1,11 +1,54 @@
 #include "master_metric_manager.h"
 
 #include <iomanip>  // For std::fixed, std::setprecision
+#include <iterator>  // For std::size
 #include <sstream>  // For string building during serialization
 #include <vector>   // Required by histogram serialization
 
 namespace mooncake {
 
+namespace {
+
+// Names of MasterRpc, as in the RPC handlers
+constexpr const char* kMasterRpcNames[] = {
+    "ExistKey",
+    "BatchExistKey",
+    "LongestCachedPrefix",
+    "GetReplicaList",
+    "BatchGetReplicaList",
+    "PinKey",
+    "UnpinKey",
+    "PutStart",
+    "PutEnd",
+    "PutRevoke",
+    "BatchPutStart",
+    "BatchPutEnd",
+    "BatchPutRevoke",
+    "Remove",
+    "BatchRemove",
+    "RemoveAll",
+    "MountSegment",
+    "ReMountSegment",
+    "UnmountSegment",
+    "Ping",
+    "FetchDiskTasks",
+    "SpillEnd",
+    "PromoteEnd",
+};
+static_assert(std::size(kMasterRpcNames) ==
+              static_cast<size_t>(MasterRpc::NUM_RPCS));
+
+// Names of MasterLock
+constexpr const char* kMasterLockNames[] = {"metadata_shard", "segment"};
+static_assert(std::size(kMasterLockNames) ==
+              static_cast<size_t>(MasterLock::NUM_LOCKS));
+
+}  // namespace
+
+const char* MasterRpcName(MasterRpc rpc) {
+    return kMasterRpcNames[static_cast<size_t>(rpc)];
+}
+
 // --- Singleton Instance ---
 MasterMetricManager& MasterMetricManager::instance() {
     // Guaranteed to be lazy initialized and thread-safe in C++11+
@@ -94,7 +137,21 @@ MasterMetricManager::MasterMetricManager()
       evicted_key_count_("master_evicted_key_count",
                         "Total number of keys evicted"),
       evicted_size_("master_evicted_size_bytes",
-                    "Total bytes of evicted objects") {}
+                    "Total bytes of evicted objects"),
+
+      // Initialize Deduplication Counters
+      dedup_hits_("master_dedup_hits_total",
+                  "Total number of puts mapped onto an identical object"),
+      dedup_saved_size_("master_dedup_saved_size_bytes",
+                        "Total bytes not allocated thanks to deduplication"),
+
+      // Initialize Disk Tier Counters
+      disk_spills_("master_disk_spills_total",
+                   "Total number of evicted objects moved to a disk tier"),
+      disk_spilled_size_("master_disk_spilled_size_bytes",
+                         "Total bytes of objects moved to a disk tier"),
+      disk_promotions_("master_disk_promotions_total",
+                       "Total number of objects read back from a disk tier") {}
 
 // --- Metric Interface Methods ---
 
@@ -339,6 +396,38 @@ int64_t MasterMetricManager::get_evicted_size() {
     return evicted_size_.value();
 }
 
+// Deduplication Metrics
+void MasterMetricManager::inc_dedup_hit(int64_t saved_size) {
+    dedup_hits_.inc();
+    dedup_saved_size_.inc(saved_size);
+}
+
+int64_t MasterMetricManager::get_dedup_hits() { return dedup_hits_.value(); }
+
+int64_t MasterMetricManager::get_dedup_saved_size() {
+    return dedup_saved_size_.value();
+}
+
+// Disk Tier Metrics
+void MasterMetricManager::inc_disk_spill(int64_t size) {
+    disk_spills_.inc();
+    disk_spilled_size_.inc(size);
+}
+
+void MasterMetricManager::inc_disk_promotion() {
+    disk_promotions_.inc();
+}
+
+int64_t MasterMetricManager::get_disk_spills() { return disk_spills_.value(); }
+
+int64_t MasterMetricManager::get_disk_spilled_size() {
+    return disk_spilled_size_.value();
+}
+
+int64_t MasterMetricManager::get_disk_promotions() {
+    return disk_promotions_.value();
+}
+
 // --- Setters ---
 void MasterMetricManager::set_enable_ha(bool enable_ha) {
     enable_ha_ = enable_ha;
@@ -401,6 +490,42 @@ std::string MasterMetricManager::serialize_metrics() {
     serialize_metric(evicted_key_count_);
     serialize_metric(evicted_size_);
 
+    // Serialize Deduplication Counters
+    serialize_metric(dedup_hits_);
+    serialize_metric(dedup_saved_size_);
+
+    // Serialize Disk Tier Counters
+    serialize_metric(disk_spills_);
+    serialize_metric(disk_spilled_size_);
+    serialize_metric(disk_promotions_);
+
+    // Serialize Latency Summaries, leaving out the ones never recorded
+    auto serialize_latencies = [&ss](auto& histograms, const auto& names,
+                                     const char* metric_name,
+                                     const char* label_name,
+                                     const char* help) {
+        bool header_written = false;
+        for (size_t i = 0; i < histograms.size(); ++i) {
+            if (histograms[i].GetSnapshot().count == 0) {
+                continue;
+            }
+            if (!header_written) {
+                ss << "# HELP " << metric_name << " " << help << "\n";
+                ss << "# TYPE " << metric_name << " summary\n";
+                header_written = true;
+            }
+            std::string labels =
+                std::string(label_name) + "=\"" + names[i] + "\"";
+            histograms[i].WritePrometheus(ss, metric_name, labels);
+        }
+    };
+    serialize_latencies(rpc_latencies_, kMasterRpcNames,
+                        "master_rpc_latency_microseconds", "method",
+                        "Latency of master RPC handlers");
+    serialize_latencies(lock_waits_, kMasterLockNames,
+                        "master_lock_wait_microseconds", "lock",
+                        "Time spent waiting for contended master locks");
+
     return ss.str();
 }
 
@@ -485,6 +610,30 @@ std::string MasterMetricManager::get_summary_string() {
         << "keys=" << evicted_key_count << ", "
         << "size=" << format_bytes(evicted_size);
 
+    int64_t dedup_hits = dedup_hits_.value();
+    if (dedup_hits > 0) {
+        ss << " | Dedup: hits=" << dedup_hits << ", "
+           << "saved=" << format_bytes(dedup_saved_size_.value());
+    }
+
+    int64_t disk_spills = disk_spills_.value();
+    if (disk_spills > 0) {
+        ss << " | Disk: spills=" << disk_spills << ", "
+           << "spilled=" << format_bytes(disk_spilled_size_.value()) << ", "
+           << "promotions=" << disk_promotions_.value();
+    }
+
+    // Tail latency of the data path
+    auto p99_us = [this](MasterRpc rpc) {
+        return rpc_latency(rpc).GetSnapshot().QuantileNs(0.99) / 1000.0;
+    };
+    ss << " | p99 (us): " << std::fixed << std::setprecision(1)
+       << "PutStart=" << p99_us(MasterRpc::PUT_START) << ", "
+       << "GetReplicaList=" << p99_us(MasterRpc::GET_REPLICA_LIST) << ", "
+       << "ShardLockWait="
+       << lock_wait(MasterLock::METADATA_SHARD).GetSnapshot().QuantileNs(0.99) /
+              1000.0;
+
     return ss.str();
 }
 
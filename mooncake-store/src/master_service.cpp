@@ -1,5 +1,6 @@
 #include "master_service.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <queue>
@@ -14,14 +15,16 @@ MasterService::MasterService(bool enable_gc, uint64_t default_kv_lease_ttl,
                              double eviction_ratio,
                              double eviction_high_watermark_ratio,
                              ViewVersionId view_version,
-                             int64_t client_live_ttl_sec, bool enable_ha)
+                             int64_t client_live_ttl_sec, bool enable_ha,
+                             bool enable_prefix_index)
     : allocation_strategy_(std::make_shared<RandomAllocationStrategy>()),
       enable_gc_(enable_gc),
       default_kv_lease_ttl_(default_kv_lease_ttl),
       eviction_ratio_(eviction_ratio),
       eviction_high_watermark_ratio_(eviction_high_watermark_ratio),
       client_live_ttl_sec_(client_live_ttl_sec),
-      enable_ha_(enable_ha) {
+      enable_ha_(enable_ha),
+      enable_prefix_index_(enable_prefix_index) {
     if (eviction_ratio_ < 0.0 || eviction_ratio_ > 1.0) {
         LOG(ERROR) << "Eviction ratio must be between 0.0 and 1.0, "
                    << "current value: " << eviction_ratio_;
@@ -151,7 +154,7 @@ ErrorCode MasterService::ReMountSegment(const std::vector<Segment>& segments,
 
 void MasterService::ClearInvalidHandles() {
     for (auto& shard : metadata_shards_) {
-        std::unique_lock lock(shard.mutex);
+        auto lock = LockShard(shard);
         auto it = shard.metadata.begin();
         while (it != shard.metadata.end()) {
             // Check if the object has any invalid replicas
@@ -173,6 +176,43 @@ void MasterService::ClearInvalidHandles() {
     }
 }
 
+void MasterService::ReleaseStalePins(
+    const std::vector<UUID>& expired_clients) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& shard : metadata_shards_) {
+        auto lock = LockShard(shard);
+        for (auto& [key, metadata] : shard.metadata) {
+            if (metadata.pins.empty()) {
+                continue;
+            }
+            for (auto it = metadata.pins.begin(); it != metadata.pins.end();) {
+                const bool expired =
+                    std::find(expired_clients.begin(), expired_clients.end(),
+                              it->first) != expired_clients.end();
+                const bool timed_out =
+                    !enable_ha_ && now >= it->second.deadline;
+                if (!expired && !timed_out) {
+                    ++it;
+                    continue;
+                }
+                LOG(INFO) << "key=" << key << ", client_id=" << it->first
+                          << ", action="
+                          << (expired ? "release_expired_client_pin"
+                                      : "release_timed_out_pin");
+                it = metadata.pins.erase(it);
+            }
+            // Same as the last UnpinKey
+            if (metadata.pins.empty()) {
+                if (enable_gc_) {
+                    MarkForGC(key, 1000);
+                } else {
+                    metadata.GrantLease(default_kv_lease_ttl_);
+                }
+            }
+        }
+    }
+}
+
 ErrorCode MasterService::UnmountSegment(const UUID& segment_id,
                                         const UUID& client_id) {
     size_t metrics_dec_capacity = 0;  // to update the metrics
@@ -203,14 +243,55 @@ ErrorCode MasterService::UnmountSegment(const UUID& segment_id,
 }
 
 ErrorCode MasterService::ExistKey(const std::string& key) {
-    MetadataAccessor accessor(this, key);
-    if (!accessor.Exists()) {
+    auto& shard = metadata_shards_[getShardIndex(key)];
+    auto lock = LockShard(shard);
+    return ExistKeyInShard(shard, key);
+}
+
+std::vector<ErrorCode> MasterService::BatchExistKey(
+    const std::vector<std::string>& keys) {
+    std::vector<ErrorCode> results(keys.size(), ErrorCode::OK);
+    for (const auto& [shard_idx, indices] : GroupKeysByShard(keys)) {
+        auto& shard = metadata_shards_[shard_idx];
+        auto lock = LockShard(shard);
+        for (size_t idx : indices) {
+            results[idx] = ExistKeyInShard(shard, keys[idx]);
+        }
+    }
+    return results;
+}
+
+size_t MasterService::LongestCachedPrefix(
+    const std::vector<std::string>& keys) {
+    size_t limit = enable_prefix_index_ ? prefix_index_.Match(keys)
+                                        : keys.size();
+    for (size_t i = 0; i < limit; ++i) {
+        ErrorCode err = ExistKey(keys[i]);
+        if (err != ErrorCode::OK) {
+            if (enable_prefix_index_ && err == ErrorCode::OBJECT_NOT_FOUND) {
+                prefix_index_.Erase(keys[i]);
+            }
+            return i;
+        }
+    }
+    return limit;
+}
+
+ErrorCode MasterService::ExistKeyInShard(MetadataShard& shard,
+                                         const std::string& key) {
+    auto it = shard.metadata.find(key);
+    if (it != shard.metadata.end() && CleanupStaleHandles(it->second)) {
+        shard.metadata.erase(it);
+        it = shard.metadata.end();
+    }
+    if (it == shard.metadata.end()) {
         VLOG(1) << "key=" << key << ", info=object_not_found";
         return ErrorCode::OBJECT_NOT_FOUND;
     }
 
-    auto& metadata = accessor.Get();
-    if (auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
+    auto& metadata = it->second;
+    auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE);
+    if (status && !metadata.IsOnDisk()) {
         LOG(WARNING) << "key=" << key << ", status=" << *status
                      << ", error=replica_not_ready";
         return ErrorCode::REPLICA_IS_NOT_READY;
@@ -252,7 +333,12 @@ ErrorCode MasterService::GetReplicaList(
         return ErrorCode::OBJECT_NOT_FOUND;
     }
     auto& metadata = accessor.Get();
-    if (auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
+    if (metadata.IsOnDisk()) {
+        // The owner of the disk replica can read it directly, everyone else
+        // has to wait for the promotion
+        TryPromote(key, metadata);
+    } else if (auto status =
+                   metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
         LOG(WARNING) << "key=" << key << ", status=" << *status
                      << ", error=replica_not_ready";
         return ErrorCode::REPLICA_IS_NOT_READY;
@@ -276,6 +362,70 @@ ErrorCode MasterService::GetReplicaList(
     return ErrorCode::OK;
 }
 
+ErrorCode MasterService::PinKey(
+    const std::string& key, const UUID& client_id,
+    std::vector<Replica::Descriptor>& replica_list) {
+    MetadataAccessor accessor(this, key);
+    if (!accessor.Exists()) {
+        VLOG(1) << "key=" << key << ", info=object_not_found";
+        return ErrorCode::OBJECT_NOT_FOUND;
+    }
+    auto& metadata = accessor.Get();
+    if (auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
+        LOG(WARNING) << "key=" << key << ", status=" << *status
+                     << ", error=replica_not_ready";
+        return ErrorCode::REPLICA_IS_NOT_READY;
+    }
+
+    replica_list.clear();
+    replica_list.reserve(metadata.replicas.size());
+    for (const auto& replica : metadata.replicas) {
+        replica_list.emplace_back(replica.get_descriptor());
+    }
+
+    auto& pin = metadata.pins[client_id];
+    ++pin.count;
+    if (!enable_ha_) {
+        pin.deadline = std::chrono::steady_clock::now() +
+                       std::chrono::seconds(client_live_ttl_sec_);
+    }
+    VLOG(1) << "key=" << key << ", client_id=" << client_id
+            << ", pin_count=" << pin.count;
+    return ErrorCode::OK;
+}
+
+ErrorCode MasterService::UnpinKey(const std::string& key,
+                                  const UUID& client_id) {
+    MetadataAccessor accessor(this, key);
+    if (!accessor.Exists()) {
+        VLOG(1) << "key=" << key << ", info=object_not_found";
+        return ErrorCode::OBJECT_NOT_FOUND;
+    }
+    auto& metadata = accessor.Get();
+    auto it = metadata.pins.find(client_id);
+    if (it == metadata.pins.end()) {
+        LOG(ERROR) << "key=" << key << ", client_id=" << client_id
+                   << ", error=object_not_pinned";
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    if (--it->second.count == 0) {
+        metadata.pins.erase(it);
+    }
+    VLOG(1) << "key=" << key << ", client_id=" << client_id
+            << ", pins_left=" << metadata.pins.size();
+
+    // The reader is done with the object, same as at the end of a Get
+    if (metadata.pins.empty()) {
+        if (enable_gc_) {
+            MarkForGC(key, 1000);
+        } else {
+            metadata.GrantLease(default_kv_lease_ttl_);
+        }
+    }
+    return ErrorCode::OK;
+}
+
 ErrorCode MasterService::BatchGetReplicaList(
     const std::vector<std::string>& keys,
     std::unordered_map<std::string, std::vector<Replica::Descriptor>>&
@@ -292,7 +442,8 @@ ErrorCode MasterService::BatchGetReplicaList(
 ErrorCode MasterService::PutStart(
     const std::string& key, uint64_t value_length,
     const std::vector<uint64_t>& slice_lengths, const ReplicateConfig& config,
-    std::vector<Replica::Descriptor>& replica_list) {
+    std::vector<Replica::Descriptor>& replica_list,
+    const CompressionInfo& compression, const ContentHash& content_hash) {
     if (config.replica_num == 0 || value_length == 0) {
         LOG(ERROR) << "key=" << key << ", replica_num=" << config.replica_num
                    << ", value_length=" << value_length
@@ -320,13 +471,29 @@ ErrorCode MasterService::PutStart(
         return ErrorCode::INVALID_PARAMS;
     }
 
+    // Every encoded slice must decode into at most one slice
+    if (compression.codec != CompressionCodec::NONE) {
+        bool valid = compression.raw_sizes.size() == slice_lengths.size();
+        for (size_t i = 0; valid && i < slice_lengths.size(); ++i) {
+            valid = compression.raw_sizes[i] >= slice_lengths[i] &&
+                    compression.raw_sizes[i] <= kMaxSliceSize;
+        }
+        if (!valid) {
+            LOG(ERROR) << "key=" << key << ", codec=" << compression.codec
+                       << ", raw_slice_count=" << compression.raw_sizes.size()
+                       << ", slice_count=" << slice_lengths.size()
+                       << ", error=invalid_compression_info";
+            return ErrorCode::INVALID_PARAMS;
+        }
+    }
+
     VLOG(1) << "key=" << key << ", value_length=" << value_length
             << ", slice_count=" << slice_lengths.size() << ", config=" << config
             << ", action=put_start_begin";
 
     // Lock the shard and check if object already exists
     size_t shard_idx = getShardIndex(key);
-    std::unique_lock<std::mutex> lock(metadata_shards_[shard_idx].mutex);
+    auto lock = LockShard(metadata_shards_[shard_idx]);
 
     auto it = metadata_shards_[shard_idx].metadata.find(key);
     if (it != metadata_shards_[shard_idx].metadata.end() &&
@@ -338,6 +505,36 @@ ErrorCode MasterService::PutStart(
     // Initialize object metadata
     ObjectMetadata metadata;
     metadata.size = value_length;
+    metadata.content_hash = content_hash;
+
+    if (!content_hash.empty()) {
+        const auto& raw_slice_lengths =
+            compression.codec != CompressionCodec::NONE ? compression.raw_sizes
+                                                        : slice_lengths;
+        std::vector<Replica> shared_replicas;
+        uint64_t shared_size = 0;
+        if (LookupContent(content_hash, raw_slice_lengths, config.replica_num,
+                          shared_replicas, shared_size)) {
+            VLOG(1) << "key=" << key << ", content_hash=" << content_hash
+                    << ", replica_count=" << shared_replicas.size()
+                    << ", action=put_deduplicated";
+            MasterMetricManager::instance().inc_dedup_hit(shared_size);
+            metadata.size = shared_size;
+            metadata.replicas = std::move(shared_replicas);
+            metadata.GrantLease(0);
+
+            replica_list.clear();
+            replica_list.reserve(metadata.replicas.size());
+            for (const auto& replica : metadata.replicas) {
+                replica_list.emplace_back(replica.get_descriptor());
+            }
+            metadata_shards_[shard_idx].metadata[key] = std::move(metadata);
+            if (enable_prefix_index_) {
+                prefix_index_.Insert(key);
+            }
+            return ErrorCode::OK;
+        }
+    }
 
     // Allocate replicas
     std::vector<Replica> replicas;
@@ -375,7 +572,8 @@ ErrorCode MasterService::PutStart(
                 handles.emplace_back(std::move(handle));
             }
 
-            replicas.emplace_back(std::move(handles), ReplicaStatus::PROCESSING);
+            replicas.emplace_back(std::move(handles), ReplicaStatus::PROCESSING,
+                                  compression);
         }
     }
 
@@ -407,9 +605,200 @@ ErrorCode MasterService::PutEnd(const std::string& key) {
     // Set lease timeout to now, indicating that the object has no lease
     // at beginning
     metadata.GrantLease(0);
+    if (!metadata.content_hash.empty()) {
+        PublishContent(metadata);
+    }
+    if (enable_prefix_index_) {
+        prefix_index_.Insert(key);
+    }
     return ErrorCode::OK;
 }
 
+bool MasterService::LookupContent(
+    const ContentHash& hash, const std::vector<uint64_t>& raw_slice_lengths,
+    size_t max_replicas, std::vector<Replica>& replicas, uint64_t& size) {
+    auto& shard = getContentShard(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(hash);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    const auto& entry = it->second;
+    // The same bytes cut into other slices cannot be read with the slices of
+    // the new put, so they are stored again
+    if (entry.raw_slice_lengths != raw_slice_lengths) {
+        VLOG(1) << "content_hash=" << hash
+                << ", slice_count=" << raw_slice_lengths.size()
+                << ", indexed_slice_count=" << entry.raw_slice_lengths.size()
+                << ", info=content_slice_layout_mismatch";
+        return false;
+    }
+
+    replicas.clear();
+    for (const auto& weak_buffers : entry.replicas) {
+        if (replicas.size() == max_replicas) {
+            break;
+        }
+        std::vector<std::shared_ptr<AllocatedBuffer>> buffers;
+        buffers.reserve(weak_buffers.size());
+        for (const auto& weak_buffer : weak_buffers) {
+            auto buffer = weak_buffer.lock();
+            if (!buffer || !buffer->isAllocatorValid()) {
+                break;
+            }
+            buffers.push_back(std::move(buffer));
+        }
+        if (buffers.size() == weak_buffers.size()) {
+            replicas.emplace_back(std::move(buffers), ReplicaStatus::COMPLETE,
+                                  entry.compression);
+        }
+    }
+    if (replicas.empty()) {
+        // Every object holding this content is gone
+        shard.entries.erase(it);
+        return false;
+    }
+    size = entry.size;
+    return true;
+}
+
+void MasterService::PublishContent(const ObjectMetadata& metadata) {
+    ContentEntry entry;
+    entry.size = metadata.size;
+    if (!metadata.replicas.empty()) {
+        const auto& replica = metadata.replicas.front();
+        entry.compression = replica.compression();
+        if (entry.compression.codec != CompressionCodec::NONE) {
+            entry.raw_slice_lengths = entry.compression.raw_sizes;
+        } else {
+            for (const auto& buffer : replica.buffers()) {
+                entry.raw_slice_lengths.push_back(buffer->size());
+            }
+        }
+    }
+    for (const auto& replica : metadata.replicas) {
+        std::vector<std::weak_ptr<AllocatedBuffer>> weak_buffers(
+            replica.buffers().begin(), replica.buffers().end());
+        entry.replicas.push_back(std::move(weak_buffers));
+    }
+
+    auto& shard = getContentShard(metadata.content_hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // A newer object replaces the entry, since the older one may be about to
+    // be removed or evicted
+    shard.entries[metadata.content_hash] = std::move(entry);
+}
+
+void MasterService::SweepContentIndex() {
+    size_t swept = 0;
+    for (auto& shard : content_shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            bool alive = false;
+            for (const auto& weak_buffers : it->second.replicas) {
+                if (!weak_buffers.empty() && !weak_buffers.front().expired()) {
+                    alive = true;
+                    break;
+                }
+            }
+            if (alive) {
+                ++it;
+            } else {
+                it = shard.entries.erase(it);
+                ++swept;
+            }
+        }
+    }
+    if (swept > 0) {
+        VLOG(1) << "swept_content_entries=" << swept
+                << ", action=content_index_swept";
+    }
+}
+
+void MasterService::SweepDiskTier() {
+    auto now = std::chrono::steady_clock::now();
+    std::unordered_map<UUID, uint64_t, boost::hash<UUID>>
+        reclaim_bytes;  // owner -> bytes
+    {
+        std::lock_guard<std::mutex> lock(disk_tier_mutex_);
+        for (auto& [segment_name, owner] : disk_tier_owners_) {
+            if (owner.reclaim_bytes > 0) {
+                reclaim_bytes[owner.client_id] += owner.reclaim_bytes;
+                owner.reclaim_bytes = 0;
+            }
+        }
+    }
+
+    struct DiskObject {
+        std::chrono::steady_clock::time_point lease_timeout;
+        std::string key;
+        UUID owner;
+        uint64_t size;
+    };
+    std::vector<DiskObject> candidates;
+    long reaped = 0;
+    for (auto& shard : metadata_shards_) {
+        auto lock = LockShard(shard);
+        for (auto& [key, metadata] : shard.metadata) {
+            if (!metadata.IsOnDisk()) {
+                continue;
+            }
+            if (DropStalePromotion(key, metadata, now)) {
+                ++reaped;
+            }
+            const UUID& owner = metadata.replicas.front().disk_location().owner;
+            if (metadata.replicas.size() == 1 &&
+                metadata.IsLeaseExpired(now) && reclaim_bytes.count(owner)) {
+                candidates.push_back(
+                    {metadata.lease_timeout, key, owner, metadata.size});
+            }
+        }
+    }
+
+    // Drop the least recently used objects first
+    std::sort(candidates.begin(), candidates.end(),
+              [](const DiskObject& lhs, const DiskObject& rhs) {
+                  return lhs.lease_timeout < rhs.lease_timeout;
+              });
+    long dropped = 0;
+    for (const auto& candidate : candidates) {
+        uint64_t& bytes = reclaim_bytes[candidate.owner];
+        if (bytes == 0 || Remove(candidate.key) != ErrorCode::OK) {
+            continue;
+        }
+        bytes -= std::min(bytes, candidate.size);
+        ++dropped;
+    }
+    if (dropped > 0) {
+        MasterMetricManager::instance().dec_key_count(dropped);
+    }
+    if (reaped > 0 || dropped > 0) {
+        VLOG(1) << "reaped_promotions=" << reaped
+                << ", dropped_disk_objects=" << dropped
+                << ", action=disk_tier_swept";
+    }
+}
+
+void MasterService::SweepPrefixIndex() {
+    size_t swept = 0;
+    for (const auto& key : prefix_index_.Keys()) {
+        bool exists;
+        {
+            auto& shard = metadata_shards_[getShardIndex(key)];
+            auto lock = LockShard(shard);
+            exists = shard.metadata.count(key) > 0;
+        }
+        if (!exists) {
+            prefix_index_.Erase(key);
+            ++swept;
+        }
+    }
+    if (swept > 0) {
+        VLOG(1) << "swept_prefix_entries=" << swept
+                << ", action=prefix_index_swept";
+    }
+}
+
 ErrorCode MasterService::PutRevoke(const std::string& key) {
     MetadataAccessor accessor(this, key);
     if (!accessor.Exists()) {
@@ -482,27 +871,58 @@ ErrorCode MasterService::BatchPutRevoke(const std::vector<std::string>& keys) {
 }
 
 ErrorCode MasterService::Remove(const std::string& key) {
-    MetadataAccessor accessor(this, key);
-    if (!accessor.Exists()) {
+    auto& shard = metadata_shards_[getShardIndex(key)];
+    auto lock = LockShard(shard);
+    return RemoveInShard(shard, key);
+}
+
+std::vector<ErrorCode> MasterService::BatchRemove(
+    const std::vector<std::string>& keys) {
+    std::vector<ErrorCode> results(keys.size(), ErrorCode::OK);
+    for (const auto& [shard_idx, indices] : GroupKeysByShard(keys)) {
+        auto& shard = metadata_shards_[shard_idx];
+        auto lock = LockShard(shard);
+        for (size_t idx : indices) {
+            results[idx] = RemoveInShard(shard, keys[idx]);
+        }
+    }
+    return results;
+}
+
+ErrorCode MasterService::RemoveInShard(MetadataShard& shard,
+                                       const std::string& key) {
+    auto it = shard.metadata.find(key);
+    if (it != shard.metadata.end() && CleanupStaleHandles(it->second)) {
+        shard.metadata.erase(it);
+        it = shard.metadata.end();
+    }
+    if (it == shard.metadata.end()) {
         VLOG(1) << "key=" << key << ", error=object_not_found";
         return ErrorCode::OBJECT_NOT_FOUND;
     }
 
-    auto& metadata = accessor.Get();
+    auto& metadata = it->second;
 
     if (!metadata.IsLeaseExpired()) {
         VLOG(1) << "key=" << key << ", error=object_has_lease";
         return ErrorCode::OBJECT_HAS_LEASE;
     }
 
-    if (auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
+    // An object on disk can go unless it is being promoted
+    auto now = std::chrono::steady_clock::now();
+    DropStalePromotion(key, metadata, now);
+    const bool on_disk =
+        metadata.IsOnDisk() && metadata.replicas.size() == 1;
+    if (auto status = metadata.HasDiffRepStatus(ReplicaStatus::COMPLETE);
+        status && !on_disk) {
         LOG(ERROR) << "key=" << key << ", status=" << *status
                    << ", error=invalid_replica_status";
         return ErrorCode::REPLICA_IS_NOT_READY;
     }
 
     // Remove object metadata
-    accessor.Erase();
+    DropDiskReplicas(key, metadata);
+    shard.metadata.erase(it);
     return ErrorCode::OK;
 }
 
@@ -514,7 +934,7 @@ long MasterService::RemoveAll() {
     auto now = std::chrono::steady_clock::now();
 
     for (auto& shard : metadata_shards_) {
-        std::unique_lock lock(shard.mutex);
+        auto lock = LockShard(shard);
         if (shard.metadata.empty()) {
             continue;
         }
@@ -523,8 +943,8 @@ long MasterService::RemoveAll() {
         auto it = shard.metadata.begin();
         while (it != shard.metadata.end()) {
             if (it->second.IsLeaseExpired(now)) {
-                total_freed_size +=
-                    it->second.size * it->second.replicas.size();
+                total_freed_size += it->second.FreeableSize();
+                DropDiskReplicas(it->first, it->second);
                 it = shard.metadata.erase(it);
                 removed_count++;
             } else {
@@ -575,10 +995,19 @@ bool MasterService::CleanupStaleHandles(ObjectMetadata& metadata) {
     return metadata.replicas.empty();
 }
 
+std::unordered_map<size_t, std::vector<size_t>>
+MasterService::GroupKeysByShard(const std::vector<std::string>& keys) const {
+    std::unordered_map<size_t, std::vector<size_t>> shard_to_indices;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        shard_to_indices[getShardIndex(keys[i])].push_back(i);
+    }
+    return shard_to_indices;
+}
+
 size_t MasterService::GetKeyCount() const {
     size_t total = 0;
     for (const auto& shard : metadata_shards_) {
-        std::unique_lock lock(shard.mutex);
+        auto lock = LockShard(shard);
         total += shard.metadata.size();
     }
     return total;
@@ -610,11 +1039,276 @@ ErrorCode MasterService::Ping(const UUID& client_id,
     return ErrorCode::OK;
 }
 
+ErrorCode MasterService::FetchDiskTasks(const UUID& client_id,
+                                        std::vector<DiskTask>& tasks) {
+    std::vector<Segment> segments;
+    {
+        ScopedSegmentAccess segment_access =
+            segment_manager_.getSegmentAccess();
+        segment_access.GetClientSegments(client_id, segments);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(disk_tier_mutex_);
+    for (const auto& segment : segments) {
+        // Keep the pending reclaim until SweepDiskTier takes it
+        auto& owner = disk_tier_owners_[segment.name];
+        if (owner.client_id != client_id) {
+            owner.client_id = client_id;
+            owner.reclaim_bytes = 0;
+        }
+        owner.last_poll = now;
+    }
+    tasks.clear();
+    auto it = disk_tasks_.find(client_id);
+    if (it != disk_tasks_.end()) {
+        tasks = std::move(it->second);
+        disk_tasks_.erase(it);
+    }
+    return ErrorCode::OK;
+}
+
+bool MasterService::PushDiskTask(const UUID& client_id,
+                                 const std::string& segment_name,
+                                 DiskTask task) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(disk_tier_mutex_);
+    auto it = disk_tier_owners_.find(segment_name);
+    if (it == disk_tier_owners_.end() || it->second.client_id != client_id ||
+        now - it->second.last_poll >
+            std::chrono::milliseconds(kDiskTierOwnerTtlMs)) {
+        return false;
+    }
+    disk_tasks_[client_id].push_back(std::move(task));
+    return true;
+}
+
+bool MasterService::TrySpill(const std::string& key, ObjectMetadata& metadata,
+                             std::chrono::steady_clock::time_point& now) {
+    const auto& buffers = metadata.replicas.front().buffers();
+    if (buffers.empty()) {
+        return false;
+    }
+    // The owner writes the replica from its own memory
+    const std::string& segment_name = buffers.front()->segment_name();
+    for (const auto& buffer : buffers) {
+        if (buffer->segment_name() != segment_name) {
+            return false;
+        }
+    }
+
+    UUID owner;
+    {
+        std::lock_guard<std::mutex> lock(disk_tier_mutex_);
+        auto it = disk_tier_owners_.find(segment_name);
+        if (it == disk_tier_owners_.end()) {
+            return false;
+        }
+        owner = it->second.client_id;
+    }
+
+    DiskTask task;
+    task.type = DiskTaskType::SPILL;
+    task.key = key;
+    for (const auto& buffer : buffers) {
+        task.buffers.push_back(buffer->get_descriptor());
+    }
+    if (!PushDiskTask(owner, segment_name, std::move(task))) {
+        return false;
+    }
+    metadata.disk_task_deadline =
+        now + std::chrono::milliseconds(kDiskTaskTimeoutMs);
+    VLOG(1) << "key=" << key << ", owner=" << owner
+            << ", action=spill_scheduled";
+    return true;
+}
+
+ErrorCode MasterService::SpillEnd(const std::string& key,
+                                  const DiskLocation& location, bool success) {
+    MetadataAccessor accessor(this, key);
+    if (!accessor.Exists()) {
+        VLOG(1) << "key=" << key << ", info=object_not_found";
+        return ErrorCode::OBJECT_NOT_FOUND;
+    }
+    auto& metadata = accessor.Get();
+    auto now = std::chrono::steady_clock::now();
+    if (!metadata.IsSpilling(now)) {
+        LOG(WARNING) << "key=" << key << ", warn=spill_not_in_progress";
+        return ErrorCode::INVALID_WRITE;
+    }
+    metadata.disk_task_deadline = {};
+
+    if (!success) {
+        // Evict it as if there were no disk tier, and make room on the disk
+        // for the next spills
+        LOG(WARNING) << "key=" << key << ", warn=spill_failed";
+        {
+            std::lock_guard<std::mutex> lock(disk_tier_mutex_);
+            auto it = disk_tier_owners_.find(location.segment_name);
+            if (it != disk_tier_owners_.end() &&
+                it->second.client_id == location.owner) {
+                it->second.reclaim_bytes += metadata.size;
+            }
+        }
+        if (metadata.IsLeaseExpired(now)) {
+            accessor.Erase();
+            MasterMetricManager::instance().dec_key_count(1);
+        }
+        return ErrorCode::OK;
+    }
+
+    // Someone started reading the object from memory meanwhile
+    if (!metadata.IsLeaseExpired(now)) {
+        VLOG(1) << "key=" << key << ", info=spill_cancelled_by_lease";
+        return ErrorCode::OBJECT_HAS_LEASE;
+    }
+
+    const auto& replica = metadata.replicas.front();
+    if (replica.buffers().empty() ||
+        replica.buffers().front()->segment_name() != location.segment_name ||
+        location.size() != metadata.size) {
+        LOG(ERROR) << "key=" << key << ", segment_name="
+                   << location.segment_name << ", size=" << location.size()
+                   << ", error=spill_location_mismatch";
+        return ErrorCode::INVALID_WRITE;
+    }
+
+    // Dropping the memory replicas frees their buffers
+    Replica disk_replica(location, replica.buffers().front()->allocator(),
+                         replica.compression());
+    metadata.replicas.clear();
+    metadata.replicas.push_back(std::move(disk_replica));
+    MasterMetricManager::instance().inc_disk_spill(metadata.size);
+    VLOG(1) << "key=" << key << ", offset=" << location.offset
+            << ", size=" << metadata.size << ", action=object_spilled";
+    return ErrorCode::OK;
+}
+
+void MasterService::TryPromote(const std::string& key,
+                               ObjectMetadata& metadata) {
+    auto now = std::chrono::steady_clock::now();
+    if (metadata.replicas.size() > 1 &&
+        !DropStalePromotion(key, metadata, now)) {
+        // Already being promoted
+        return;
+    }
+
+    // Promote into the segment the object was spilled from, so the owner
+    // fills the buffers from its own disk with a local copy
+    const DiskLocation location = metadata.replicas.front().disk_location();
+    std::vector<std::unique_ptr<AllocatedBuffer>> handles;
+    {
+        ScopedAllocatorAccess allocator_access =
+            segment_manager_.getAllocatorAccess();
+        const auto& allocators_by_name = allocator_access.getAllocatorsByName();
+        auto it = allocators_by_name.find(location.segment_name);
+        if (it == allocators_by_name.end()) {
+            return;
+        }
+        for (uint64_t slice_size : location.slice_sizes) {
+            std::unique_ptr<AllocatedBuffer> handle;
+            for (const auto& allocator : it->second) {
+                handle = allocator->allocate(slice_size);
+                if (handle) {
+                    break;
+                }
+            }
+            if (!handle) {
+                VLOG(1) << "key=" << key << ", info=no_space_to_promote";
+                need_eviction_ = true;
+                return;
+            }
+            handles.push_back(std::move(handle));
+        }
+    }
+
+    Replica replica(std::move(handles), ReplicaStatus::PROCESSING,
+                    metadata.replicas.front().compression());
+    DiskTask task;
+    task.type = DiskTaskType::PROMOTE;
+    task.key = key;
+    task.buffers = replica.get_descriptor().buffer_descriptors;
+    task.location = location;
+    if (!PushDiskTask(location.owner, location.segment_name,
+                      std::move(task))) {
+        return;
+    }
+    metadata.replicas.push_back(std::move(replica));
+    metadata.disk_task_deadline =
+        now + std::chrono::milliseconds(kDiskTaskTimeoutMs);
+    VLOG(1) << "key=" << key << ", owner=" << location.owner
+            << ", action=promotion_scheduled";
+}
+
+bool MasterService::DropStalePromotion(
+    const std::string& key, ObjectMetadata& metadata,
+    std::chrono::steady_clock::time_point& now) {
+    if (!metadata.IsOnDisk() || metadata.replicas.size() < 2 ||
+        now < metadata.disk_task_deadline) {
+        return false;
+    }
+    LOG(WARNING) << "key=" << key << ", warn=promotion_timeout";
+    metadata.replicas.erase(metadata.replicas.begin() + 1,
+                            metadata.replicas.end());
+    metadata.disk_task_deadline = {};
+    return true;
+}
+
+ErrorCode MasterService::PromoteEnd(const std::string& key,
+                                    const DiskLocation& location,
+                                    bool success) {
+    MetadataAccessor accessor(this, key);
+    if (!accessor.Exists()) {
+        VLOG(1) << "key=" << key << ", info=object_not_found";
+        return ErrorCode::OBJECT_NOT_FOUND;
+    }
+    auto& metadata = accessor.Get();
+    if (!metadata.IsOnDisk() || metadata.replicas.size() != 2 ||
+        metadata.replicas.front().disk_location().owner != location.owner ||
+        metadata.replicas.front().disk_location().offset != location.offset) {
+        LOG(WARNING) << "key=" << key << ", warn=promotion_not_in_progress";
+        return ErrorCode::INVALID_WRITE;
+    }
+    metadata.disk_task_deadline = {};
+
+    if (!success) {
+        LOG(WARNING) << "key=" << key << ", warn=promotion_failed";
+        metadata.replicas.pop_back();
+        return ErrorCode::OK;
+    }
+
+    metadata.replicas.back().mark_complete();
+    metadata.replicas.erase(metadata.replicas.begin());
+    MasterMetricManager::instance().inc_disk_promotion();
+    VLOG(1) << "key=" << key << ", action=object_promoted";
+    return ErrorCode::OK;
+}
+
+void MasterService::DropDiskReplicas(const std::string& key,
+                                     const ObjectMetadata& metadata) {
+    for (const auto& replica : metadata.replicas) {
+        if (replica.status() != ReplicaStatus::DISK) {
+            continue;
+        }
+        const auto& location = replica.disk_location();
+        DiskTask task;
+        task.type = DiskTaskType::DROP;
+        task.key = key;
+        task.location = location;
+        if (!PushDiskTask(location.owner, location.segment_name,
+                          std::move(task))) {
+            LOG(WARNING) << "key=" << key << ", owner=" << location.owner
+                         << ", warn=disk_tier_owner_gone";
+        }
+    }
+}
+
 void MasterService::GCThreadFunc() {
     VLOG(1) << "action=gc_thread_started";
 
     std::priority_queue<GCTask*, std::vector<GCTask*>, GCTaskComparator>
         local_pq;
+    uint64_t iteration = 0;
 
     while (gc_running_) {
         GCTask* task = nullptr;
@@ -659,6 +1353,20 @@ void MasterService::GCThreadFunc() {
                 used_ratio - eviction_high_watermark_ratio_ + eviction_ratio_));
         }
 
+        if (++iteration % kContentSweepInterval == 0) {
+            SweepContentIndex();
+            if (enable_prefix_index_) {
+                SweepPrefixIndex();
+            }
+        }
+        if (iteration % kDiskSweepInterval == 0) {
+            SweepDiskTier();
+        }
+        // With HA the client monitor releases the pins of expired clients
+        if (!enable_ha_ && iteration % kPinSweepInterval == 0) {
+            ReleaseStalePins({});
+        }
+
         std::this_thread::sleep_for(
             std::chrono::milliseconds(kGCThreadSleepMs));
     }
@@ -674,6 +1382,8 @@ void MasterService::GCThreadFunc() {
 void MasterService::BatchEvict(double eviction_ratio) {
     auto now = std::chrono::steady_clock::now();
     long evicted_count = 0;
+    long spilled_count = 0;
+    long spilling_count = 0;
     long object_count = 0;
     uint64_t total_freed_size = 0;
 
@@ -683,26 +1393,21 @@ void MasterService::BatchEvict(double eviction_ratio) {
     for (size_t i = 0; i < metadata_shards_.size(); i++) {
         auto& shard =
             metadata_shards_[(start_idx + i) % metadata_shards_.size()];
-        std::unique_lock lock(shard.mutex);
+        auto lock = LockShard(shard);
 
         // object_count must be updated at beginning as it will be used later
         // to compute ideal_evict_num
         object_count += shard.metadata.size();
 
-        // To achieve evicted_count / object_count = eviction_ration,
-        // ideally how many object should be evicted in this shard
-        const long ideal_evict_num =
-            std::ceil(object_count * eviction_ratio_) - evicted_count;
-
-        if (ideal_evict_num <= 0) {
-            // No need to evict any object in this shard
-            continue;
-        }
-
         std::vector<std::chrono::steady_clock::time_point>
             candidates;  // can be removed
         for (auto it = shard.metadata.begin(); it != shard.metadata.end();
              it++) {
+            if (it->second.IsSpilling(now)) {
+                // Its memory is freed once the owner confirms the write
+                spilling_count++;
+                continue;
+            }
             // Only evict objects that have not expired and are complete
             if (it->second.IsLeaseExpired(now) &&
                 !it->second.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
@@ -710,7 +1415,13 @@ void MasterService::BatchEvict(double eviction_ratio) {
             }
         }
 
-        if (!candidates.empty()) {
+        // To achieve evicted_count / object_count = eviction_ration,
+        // ideally how many object should be evicted in this shard
+        const long ideal_evict_num =
+            std::ceil(object_count * eviction_ratio_) - evicted_count -
+            spilled_count - spilling_count;
+
+        if (ideal_evict_num > 0 && !candidates.empty()) {
             long evict_num = std::min(ideal_evict_num, (long)candidates.size());
             long shard_evicted_count =
                 0;  // number of objects evicted from this shard
@@ -723,24 +1434,33 @@ void MasterService::BatchEvict(double eviction_ratio) {
             while (it != shard.metadata.end() &&
                    shard_evicted_count < evict_num) {
                 if (it->second.lease_timeout <= target_timeout &&
-                    !it->second.HasDiffRepStatus(ReplicaStatus::COMPLETE)) {
-                    total_freed_size +=
-                        it->second.size * it->second.replicas.size();
-                    it = shard.metadata.erase(it);
+                    it->second.IsLeaseExpired(now) &&
+                    !it->second.HasDiffRepStatus(ReplicaStatus::COMPLETE) &&
+                    !it->second.IsSpilling(now)) {
+                    if (TrySpill(it->first, it->second, now)) {
+                        // Freed once the owner confirms the write
+                        ++it;
+                        spilled_count++;
+                    } else {
+                        total_freed_size += it->second.FreeableSize();
+                        it = shard.metadata.erase(it);
+                        evicted_count++;
+                    }
                     shard_evicted_count++;
                 } else {
                     ++it;
                 }
             }
-            evicted_count += shard_evicted_count;
         }
     }
 
-    if (evicted_count > 0) {
+    if (evicted_count > 0 || spilled_count > 0) {
         need_eviction_ = false;
         MasterMetricManager::instance().dec_key_count(evicted_count);
         MasterMetricManager::instance().inc_eviction_success(evicted_count,
                                                              total_freed_size);
+    } else if (spilling_count > 0) {
+        // Waiting for the spills in flight to free memory
     } else {
         if (object_count == 0) {
             // No objects to evict, no need to check again
@@ -750,6 +1470,8 @@ void MasterService::BatchEvict(double eviction_ratio) {
     }
     VLOG(1) << "action=evict_objects"
             << ", evicted_count=" << evicted_count
+            << ", spilled_count=" << spilled_count
+            << ", spilling_count=" << spilling_count
             << ", total_freed_size=" << total_freed_size;
 }
 
@@ -779,6 +1501,11 @@ void MasterService::ClientMonitorFunc() {
             }
         }
 
+        // Readers that went away do not release their pins themselves
+        if (!expired_clients.empty()) {
+            ReleaseStalePins(expired_clients);
+        }
+
         // Update the client status to NEED_REMOUNT
         if (!expired_clients.empty()) {
             // Record which segments are unmounted, will be used in the commit
@@ -0,0 +1,127 @@
+#include "prefix_index.h"
+
+#include <mutex>
+
+namespace mooncake {
+
+bool PrefixIndex::ParseKey(std::string_view key, std::string_view& parent,
+                           std::string_view& block) {
+    size_t pos = key.rfind(kSeparator);
+    if (pos == std::string_view::npos || pos + 1 == key.size()) {
+        return false;
+    }
+    parent = key.substr(0, pos);
+    block = key.substr(pos + 1);
+    // A block cannot be its own parent
+    return parent != block;
+}
+
+void PrefixIndex::Insert(const std::string& key) {
+    std::string_view parent, block;
+    if (!ParseKey(key, parent, block)) {
+        return;
+    }
+
+    std::unique_lock lock(mutex_);
+    auto [it, inserted] = nodes_.try_emplace(std::string(block));
+    Node& node = it->second;
+    if (!node.cached) {
+        node.cached = true;
+        ++cached_;
+    }
+    if (!inserted && node.parent == parent) {
+        return;
+    }
+
+    std::string old_parent = std::move(node.parent);
+    node.parent = std::string(parent);
+    if (!parent.empty()) {
+        ++nodes_[std::string(parent)].children;
+    }
+    // A placeholder created for a child has no parent yet
+    if (!inserted && !old_parent.empty()) {
+        auto old_it = nodes_.find(old_parent);
+        if (old_it != nodes_.end()) {
+            --old_it->second.children;
+            PruneLocked(std::move(old_parent));
+        }
+    }
+}
+
+void PrefixIndex::Erase(const std::string& key) {
+    std::string_view parent, block;
+    if (!ParseKey(key, parent, block)) {
+        return;
+    }
+
+    std::unique_lock lock(mutex_);
+    auto it = nodes_.find(std::string(block));
+    if (it == nodes_.end() || !it->second.cached ||
+        it->second.parent != parent) {
+        return;
+    }
+    it->second.cached = false;
+    --cached_;
+    PruneLocked(std::string(block));
+}
+
+void PrefixIndex::PruneLocked(std::string block) {
+    while (true) {
+        auto it = nodes_.find(block);
+        if (it == nodes_.end() || it->second.cached ||
+            it->second.children > 0) {
+            return;
+        }
+        std::string parent = std::move(it->second.parent);
+        nodes_.erase(it);
+        if (parent.empty()) {
+            return;
+        }
+        auto parent_it = nodes_.find(parent);
+        if (parent_it == nodes_.end()) {
+            return;
+        }
+        --parent_it->second.children;
+        block = std::move(parent);
+    }
+}
+
+size_t PrefixIndex::Match(const std::vector<std::string>& keys) const {
+    std::shared_lock lock(mutex_);
+    std::string_view prev_block;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string_view parent, block;
+        if (!ParseKey(keys[i], parent, block)) {
+            return i;
+        }
+        if (i > 0 && parent != prev_block) {
+            return i;
+        }
+        auto it = nodes_.find(std::string(block));
+        if (it == nodes_.end() || !it->second.cached ||
+            it->second.parent != parent) {
+            return i;
+        }
+        prev_block = block;
+    }
+    return keys.size();
+}
+
+std::vector<std::string> PrefixIndex::Keys() const {
+    std::shared_lock lock(mutex_);
+    std::vector<std::string> keys;
+    keys.reserve(cached_);
+    for (const auto& [block, node] : nodes_) {
+        if (node.cached) {
+            keys.push_back(node.parent + kSeparator + block);
+        }
+    }
+    return keys;
+}
+
+size_t PrefixIndex::size() const {
+    std::shared_lock lock(mutex_);
+    return cached_;
+}
+
+}  // namespace mooncake
@@ -1,38 +1,181 @@
 #include "transfer_task.h"
 
+#include <async_simple/Future.h>
+#include <async_simple/Promise.h>
+#include <async_simple/coro/FutureAwaiter.h>
 #include <glog/logging.h>
+#include <numa.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <ylt/coro_io/coro_io.hpp>
 
+#include "client_metric.h"
+#include "common.h"
+#include "fast_memcpy.h"
 #include "utils.h"
 
 namespace mooncake {
 
+// Waits for a transfer give up after this long
+constexpr int64_t kTransferTimeoutSeconds = 60;
+
+// ============================================================================
+// OperationState Implementation
+// ============================================================================
+
+OperationState::~OperationState() {
+    if (metric_ && !result_.has_value()) {
+        metric_->AbandonTransfer();
+    }
+}
+
+void OperationState::track(
+    ClientMetric* metric, Transport::TransferRequest::OpCode op_code,
+    const std::vector<AllocatedBuffer::Descriptor>& handles,
+    std::chrono::steady_clock::time_point start) {
+    if (!metric) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(!result_.has_value());
+    metric_ = metric;
+    op_code_ = op_code;
+    start_ = start;
+    for (const auto& handle : handles) {
+        bytes_ += handle.size_;
+        // The buffers of a replica mostly live on the same segment
+        if (peers_.empty() || peers_.back().first != handle.segment_name_) {
+            peers_.emplace_back(handle.segment_name_, 0);
+        }
+        peers_.back().second += handle.size_;
+    }
+    metric_->StartTransfer();
+}
+
+void OperationState::fail_if_incomplete(ErrorCode error_code) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result_.has_value()) {
+            return;
+        }
+        result_.emplace(error_code);
+        record_completion();
+        run_progress_callbacks();
+    }
+    cv_.notify_all();
+}
+
+void OperationState::notify_progress(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!result_.has_value()) {
+            progress_callbacks_.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+void OperationState::run_progress_callbacks() {
+    for (auto& callback : progress_callbacks_) {
+        callback();
+    }
+    progress_callbacks_.clear();
+}
+
+void OperationState::record_completion() {
+    if (!metric_) {
+        return;
+    }
+    const bool success = result_ == ErrorCode::OK;
+    metric_->RecordTransfer(get_strategy(), op_code_, bytes_,
+                            std::chrono::steady_clock::now() - start_,
+                            success);
+    if (success) {
+        for (const auto& [peer, bytes] : peers_) {
+            metric_->RecordPeerBytes(peer, op_code_, bytes);
+        }
+    }
+}
+
 // ============================================================================
 // MemcpyWorkerPool Implementation
 // ============================================================================
-// Since memcpy is bound by memory bandwidth, we only need one worker thread.
-constexpr int kDefaultMemcpyWorkers = 1;
+constexpr size_t kDefaultMemcpyWorkers = 4;
 
-MemcpyWorkerPool::MemcpyWorkerPool() : shutdown_(false) {
-    VLOG(1) << "Creating MemcpyWorkerPool with " << kDefaultMemcpyWorkers
-            << " workers";
+// Read the worker count from MC_STORE_MEMCPY_THREADS
+static size_t get_memcpy_worker_count() {
+    const size_t default_workers = std::clamp<size_t>(
+        std::thread::hardware_concurrency(), 1, kDefaultMemcpyWorkers);
+    const char* env_value = std::getenv("MC_STORE_MEMCPY_THREADS");
+    if (env_value == nullptr) {
+        return default_workers;
+    }
+    try {
+        size_t workers = std::stoul(env_value);
+        if (workers > 0) {
+            return workers;
+        }
+    } catch (const std::exception&) {
+    }
+    LOG(WARNING) << "Invalid value for MC_STORE_MEMCPY_THREADS: " << env_value
+                 << ", defaulting to " << default_workers;
+    return default_workers;
+}
 
-    // Start worker threads
-    workers_.reserve(kDefaultMemcpyWorkers);
-    for (int i = 0; i < kDefaultMemcpyWorkers; ++i) {
-        workers_.emplace_back(&MemcpyWorkerPool::workerThread, this);
+// NUMA node of the page holding addr, or -1 if unknown (e.g. not faulted in)
+static int get_numa_node_of(const void* addr) {
+    static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(addr) &
+                                         ~(page_size - 1));
+    int status = -1;
+    if (numa_move_pages(0, 1, &page, nullptr, &status, 0) != 0) {
+        return -1;
+    }
+    return status;
+}
+
+MemcpyWorkerPool::MemcpyWorkerPool(size_t num_workers) : shutdown_(false) {
+    if (num_workers == 0) {
+        num_workers = get_memcpy_worker_count();
+    }
+
+    // One queue per NUMA node, its workers bound to the node. With fewer
+    // workers than nodes some nodes would have to be served from another
+    // socket, so all workers share a single unbound queue instead.
+    size_t num_nodes = 1;
+    if (numa_available() >= 0) {
+        num_nodes = std::max(numa_num_configured_nodes(), 1);
+    }
+    const size_t num_queues = num_workers >= num_nodes ? num_nodes : 1;
+    for (size_t i = 0; i < num_queues; ++i) {
+        queues_.push_back(std::make_unique<NodeQueue>());
+    }
+
+    VLOG(1) << "Creating MemcpyWorkerPool with " << num_workers
+            << " workers on " << num_queues << " queues for " << num_nodes
+            << " NUMA nodes";
+
+    // Start worker threads, spread round-robin over the nodes
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.emplace_back(&MemcpyWorkerPool::workerThread, this,
+                              i % num_queues);
     }
 }
 
 MemcpyWorkerPool::~MemcpyWorkerPool() {
     // Signal shutdown
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
         shutdown_.store(true);
     }
-    queue_cv_.notify_all();
+    for (auto& queue : queues_) {
+        queue->cv.notify_all();
+    }
 
     // Wait for all workers to finish
     for (auto& worker : workers_) {
@@ -44,57 +187,128 @@ MemcpyWorkerPool::~MemcpyWorkerPool() {
     VLOG(1) << "MemcpyWorkerPool destroyed";
 }
 
+size_t MemcpyWorkerPool::selectQueue(const void* dest) {
+    if (queues_.size() > 1) {
+        // Queue i serves node i
+        int node = get_numa_node_of(dest);
+        if (node >= 0 && static_cast<size_t>(node) < queues_.size()) {
+            return static_cast<size_t>(node);
+        }
+    }
+    return next_queue_.fetch_add(1, std::memory_order_relaxed) %
+           queues_.size();
+}
+
 void MemcpyWorkerPool::submitTask(MemcpyTask task) {
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (shutdown_.load()) {
-            LOG(WARNING)
-                << "Attempting to submit task to shutdown MemcpyWorkerPool";
-            task.state->set_completed(ErrorCode::TRANSFER_FAIL);
-            return;
+    if (shutdown_.load()) {
+        LOG(WARNING)
+            << "Attempting to submit task to shutdown MemcpyWorkerPool";
+        task.state->set_completed(ErrorCode::TRANSFER_FAIL);
+        return;
+    }
+
+    size_t total_size = 0;
+    for (const auto& op : task.operations) {
+        total_size += op.size;
+    }
+
+    // Handing a small copy to a worker costs more than doing it here
+    if (total_size < kInlineMemcpyThreshold) {
+        for (const auto& op : task.operations) {
+            fast_memcpy(op.dest, op.src, op.size);
+        }
+        task.state->set_completed(ErrorCode::OK);
+        return;
+    }
+
+    // Split the operations into chunks of about kMemcpyChunkSize bytes. Small
+    // operations are packed together, large ones are cut into pieces.
+    std::vector<std::vector<MemcpyOperation>> chunks(1);
+    size_t chunk_bytes = 0;
+    for (const auto& op : task.operations) {
+        size_t offset = 0;
+        while (offset < op.size) {
+            if (chunk_bytes == kMemcpyChunkSize) {
+                chunks.emplace_back();
+                chunk_bytes = 0;
+            }
+            const size_t size =
+                std::min(op.size - offset, kMemcpyChunkSize - chunk_bytes);
+            chunks.back().emplace_back(
+                static_cast<char*>(op.dest) + offset,
+                static_cast<const char*>(op.src) + offset, size);
+            offset += size;
+            chunk_bytes += size;
+        }
+    }
+
+    auto pending = std::make_shared<PendingTask>(std::move(task.state),
+                                                 chunks.size());
+    for (auto& operations : chunks) {
+        auto& queue = *queues_[selectQueue(operations.front().dest)];
+        bool queued = false;
+        {
+            // Checked under the queue lock: the workers only exit once they
+            // have seen shutdown_ set with their queue empty
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!shutdown_.load()) {
+                queue.chunks.push(MemcpyChunk{std::move(operations), pending});
+                queued = true;
+            }
+        }
+        if (queued) {
+            queue.cv.notify_one();
+            continue;
+        }
+        LOG(WARNING) << "MemcpyWorkerPool shut down while submitting a task";
+        pending->failed.store(true);
+        if (pending->remaining_chunks.fetch_sub(1) == 1) {
+            pending->state->set_completed(ErrorCode::TRANSFER_FAIL);
         }
-        task_queue_.push(std::move(task));
     }
-    queue_cv_.notify_one();
 }
 
-void MemcpyWorkerPool::workerThread() {
-    VLOG(2) << "MemcpyWorkerPool worker thread started";
+void MemcpyWorkerPool::workerThread(size_t queue_index) {
+    VLOG(2) << "MemcpyWorkerPool worker thread started on queue "
+            << queue_index;
+    if (queues_.size() > 1) {
+        bindToSocket(static_cast<int>(queue_index));
+    }
 
+    auto& queue = *queues_[queue_index];
     while (true) {
-        MemcpyTask task({}, nullptr);
+        MemcpyChunk chunk;
 
-        // Wait for task or shutdown signal
+        // Wait for a chunk or shutdown signal
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, [this] {
-                return shutdown_.load() || !task_queue_.empty();
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cv.wait(lock, [this, &queue] {
+                return shutdown_.load() || !queue.chunks.empty();
             });
 
-            if (shutdown_.load() && task_queue_.empty()) {
+            if (shutdown_.load() && queue.chunks.empty()) {
                 break;
             }
 
-            if (!task_queue_.empty()) {
-                task = std::move(task_queue_.front());
-                task_queue_.pop();
-            }
+            chunk = std::move(queue.chunks.front());
+            queue.chunks.pop();
         }
 
-        // Execute the task if we have one
-        if (task.state) {
-            try {
-                for (const auto& op : task.operations) {
-                    std::memcpy(op.dest, op.src, op.size);
-                }
-
-                VLOG(2) << "Memcpy task completed successfully with "
-                        << task.operations.size() << " operations";
-                task.state->set_completed(ErrorCode::OK);
-            } catch (const std::exception& e) {
-                LOG(ERROR) << "Exception during async memcpy: " << e.what();
-                task.state->set_completed(ErrorCode::TRANSFER_FAIL);
+        try {
+            for (const auto& op : chunk.operations) {
+                fast_memcpy(op.dest, op.src, op.size);
             }
+        } catch (const std::exception& e) {
+            LOG(ERROR) << "Exception during async memcpy: " << e.what();
+            chunk.pending->failed.store(true);
+        }
+
+        // The last chunk of a task completes it
+        if (chunk.pending->remaining_chunks.fetch_sub(1) == 1) {
+            VLOG(2) << "Memcpy task completed";
+            chunk.pending->state->set_completed(
+                chunk.pending->failed.load() ? ErrorCode::TRANSFER_FAIL
+                                             : ErrorCode::OK);
         }
     }
 
@@ -178,18 +392,35 @@ void TransferEngineOperationState::set_result_internal(ErrorCode error_code) {
     VLOG(1) << "Setting transfer result for batch " << batch_id_ << " to "
             << static_cast<int>(error_code);
     result_.emplace(error_code);
+    record_completion();
+    run_progress_callbacks();
 
     cv_.notify_all();
 }
 
+void TransferEngineOperationState::notify_progress(
+    std::function<void()> callback) {
+    // Read the epoch before checking so that a task finishing in between
+    // runs the callback right away
+    const uint64_t epoch = engine_.getCompletionEpoch(batch_id_);
+    if (is_completed()) {
+        callback();
+        return;
+    }
+    engine_.addCompletionCallback(batch_id_, epoch, std::move(callback));
+}
+
 void TransferEngineOperationState::wait_for_completion() {
     if (is_completed()) {
         return;
     }
 
-    VLOG(1) << "Starting transfer engine polling for batch " << batch_id_;
-    constexpr int64_t timeout_seconds = 60;
+    VLOG(1) << "Waiting for transfer engine completion of batch " << batch_id_;
+    constexpr int64_t timeout_seconds = kTransferTimeoutSeconds;
     constexpr int64_t kOneSecondInNano = 1000 * 1000 * 1000;
+    // The transports wake us up when a task finishes. The bounded wait keeps
+    // slice timeout detection in getTransferStatus() going.
+    constexpr auto kMaxWaitInterval = std::chrono::milliseconds(1);
 
     const int64_t start_ts = getCurrentTimeInNano();
 
@@ -198,21 +429,29 @@ void TransferEngineOperationState::wait_for_completion() {
             timeout_seconds * kOneSecondInNano) {
             LOG(ERROR) << "Failed to complete transfers after "
                        << timeout_seconds << " seconds for batch " << batch_id_;
-            set_result_internal(ErrorCode::TRANSFER_FAIL);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!result_.has_value()) {
+                set_result_internal(ErrorCode::TRANSFER_FAIL);
+            }
             return;
         }
 
-        std::unique_lock<std::mutex> lock(mutex_);
-        check_task_status();
-        if (result_.has_value()) {
-            VLOG(1) << "Transfer engine operation completed for batch "
-                    << batch_id_
-                    << " with result: " << static_cast<int>(result_.value());
-            break;
+        // Read the epoch before checking so that a task finishing in between
+        // makes the wait below return immediately
+        const uint64_t epoch = engine_.getCompletionEpoch(batch_id_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!result_.has_value()) {
+                check_task_status();
+            }
+            if (result_.has_value()) {
+                VLOG(1) << "Transfer engine operation completed for batch "
+                        << batch_id_ << " with result: "
+                        << static_cast<int>(result_.value());
+                return;
+            }
         }
-        // Continue polling
-        VLOG(1) << "Transfer engine operation still pending for batch "
-                << batch_id_;
+        engine_.waitTransferCompletion(batch_id_, epoch, kMaxWaitInterval);
     }
 }
 
@@ -228,6 +467,7 @@ TransferFuture::TransferFuture(std::shared_ptr<OperationState> state)
 bool TransferFuture::isReady() const { return state_->is_completed(); }
 
 ErrorCode TransferFuture::wait() {
+    TraceSpan span("transfer.wait");
     if (!isReady()) {
         state_->wait_for_completion();
     }
@@ -236,19 +476,134 @@ ErrorCode TransferFuture::wait() {
 
 ErrorCode TransferFuture::get() { return wait(); }
 
+namespace {
+// Resumes an asyncWait() once, on whichever comes first of the progress
+// signal of the operation and the recheck timer
+struct AsyncWaitWakeup : std::enable_shared_from_this<AsyncWaitWakeup> {
+    async_simple::Promise<bool> promise;
+    std::atomic<bool> woken{false};
+
+    void wake() {
+        if (woken.exchange(true)) {
+            return;
+        }
+        // Progress is signalled from worker and transport threads that may
+        // hold locks the resumed coroutine needs
+        coro_io::get_global_executor()->schedule(
+            [self = shared_from_this()] { self->promise.setValue(true); });
+    }
+};
+}  // namespace
+
+async_simple::coro::Lazy<ErrorCode> TransferFuture::asyncWait() {
+    // Transports only notice timed-out slices when the status is checked, so
+    // check again after this long even without a progress signal
+    constexpr auto kRecheckInterval = std::chrono::milliseconds(100);
+
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::seconds(kTransferTimeoutSeconds);
+    while (!isReady()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            LOG(ERROR) << "Failed to complete transfer after "
+                       << kTransferTimeoutSeconds << " seconds";
+            state_->fail_if_incomplete(ErrorCode::TRANSFER_FAIL);
+            break;
+        }
+        auto wakeup = std::make_shared<AsyncWaitWakeup>();
+        auto woken = wakeup->promise.getFuture();
+        state_->notify_progress([wakeup] { wakeup->wake(); });
+        coro_io::sleep_for(kRecheckInterval).start([wakeup](auto&&) {
+            wakeup->wake();
+        });
+        co_await std::move(woken);
+    }
+    co_return state_->get_result();
+}
+
 TransferStrategy TransferFuture::strategy() const {
     return state_->get_strategy();
 }
 
+// ============================================================================
+// ContinuationOperationState Implementation
+// ============================================================================
+
+bool ContinuationOperationState::is_completed() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result_.has_value()) {
+            return true;
+        }
+    }
+    if (!inner_.isReady()) {
+        return false;
+    }
+    finish(inner_.get());
+    return true;
+}
+
+void ContinuationOperationState::wait_for_completion() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result_.has_value()) {
+            return;
+        }
+    }
+    finish(inner_.wait());
+}
+
+void ContinuationOperationState::notify_progress(
+    std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result_.has_value()) {
+            callback();
+            return;
+        }
+    }
+    // The waiter runs the continuation once the inner operation is done
+    inner_.state_->notify_progress(std::move(callback));
+}
+
+void ContinuationOperationState::finish(ErrorCode inner_result) {
+    std::lock_guard<std::mutex> continuation_lock(continuation_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Another thread ran the continuation, or a waiter timed out
+        if (result_.has_value()) {
+            return;
+        }
+    }
+    ErrorCode result = inner_result;
+    if (result == ErrorCode::OK) {
+        TraceSpan span("transfer.continuation");
+        result = continuation_();
+    }
+    // Release whatever the continuation holds, e.g. staging buffers
+    continuation_ = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result_.has_value()) {
+            return;
+        }
+        result_.emplace(result);
+        record_completion();
+        run_progress_callbacks();
+    }
+    cv_.notify_all();
+}
+
 // ============================================================================
 // TransferSubmitter Implementation
 // ============================================================================
 
 TransferSubmitter::TransferSubmitter(TransferEngine& engine,
-                                     const std::string& local_hostname)
+                                     const std::string& local_hostname,
+                                     ClientMetric* metric)
     : engine_(engine),
       local_hostname_(local_hostname),
-      memcpy_pool_(std::make_unique<MemcpyWorkerPool>()) {
+      memcpy_pool_(std::make_unique<MemcpyWorkerPool>()),
+      metric_(metric) {
     CHECK(!local_hostname_.empty()) << "Local hostname cannot be empty";
 
     // Read MC_STORE_MEMCPY environment variable, default to true (enabled)
@@ -301,6 +656,8 @@ std::optional<TransferFuture> TransferSubmitter::submitMemcpyOperation(
     const std::vector<AllocatedBuffer::Descriptor>& handles,
     std::vector<Slice>& slices, Transport::TransferRequest::OpCode op_code) {
     auto state = std::make_shared<MemcpyOperationState>();
+    // Small copies complete within submitTask
+    state->track(metric_, op_code, handles, std::chrono::steady_clock::now());
 
     // Create memcpy operations
     std::vector<MemcpyOperation> operations;
@@ -341,29 +698,36 @@ std::optional<TransferFuture> TransferSubmitter::submitMemcpyOperation(
 std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
     const std::vector<AllocatedBuffer::Descriptor>& handles,
     std::vector<Slice>& slices, Transport::TransferRequest::OpCode op_code) {
+    const auto start = std::chrono::steady_clock::now();
+    TraceSpan span("te.submit");
+
     // Create transfer requests
     std::vector<Transport::TransferRequest> requests;
     requests.reserve(handles.size());
 
-    for (size_t i = 0; i < handles.size(); ++i) {
-        const auto& handle = handles[i];
-        const auto& slice = slices[i];
-
-        Transport::SegmentHandle seg =
-            engine_.openSegment(handle.segment_name_);
-        if (seg == static_cast<uint64_t>(ERR_INVALID_ARGUMENT)) {
-            LOG(ERROR) << "Failed to open segment " << handle.segment_name_;
-            return std::nullopt;
-        }
+    {
+        TraceSpan open_span("te.open_segment");
+        for (size_t i = 0; i < handles.size(); ++i) {
+            const auto& handle = handles[i];
+            const auto& slice = slices[i];
+
+            Transport::SegmentHandle seg =
+                engine_.openSegment(handle.segment_name_);
+            if (seg == static_cast<uint64_t>(ERR_INVALID_ARGUMENT)) {
+                LOG(ERROR) << "Failed to open segment "
+                           << handle.segment_name_;
+                return std::nullopt;
+            }
 
-        Transport::TransferRequest request;
-        request.opcode = op_code;
-        request.source = static_cast<char*>(slice.ptr);
-        request.target_id = seg;
-        request.target_offset = handle.buffer_address_;
-        request.length = handle.size_;
+            Transport::TransferRequest request;
+            request.opcode = op_code;
+            request.source = static_cast<char*>(slice.ptr);
+            request.target_id = seg;
+            request.target_offset = handle.buffer_address_;
+            request.length = handle.size_;
 
-        requests.emplace_back(request);
+            requests.emplace_back(request);
+        }
     }
 
     // Allocate batch ID
@@ -390,6 +754,9 @@ std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
     // needed
     auto state = std::make_shared<TransferEngineOperationState>(
         engine_, batch_id, batch_size);
+    // Completion is only noticed when the state is checked, so it cannot
+    // have been recorded yet
+    state->track(metric_, op_code, handles, start);
 
     return TransferFuture(state);
 }
@@ -2,7 +2,11 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <future>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "allocator.h"
 
@@ -178,6 +182,99 @@ TEST_F(SimpleAllocatorTest, StressTest) {
     }
 }
 
+// Test that a freed block is served again from the thread cache
+TEST_F(SimpleAllocatorTest, ThreadCacheReusesBlocks) {
+    const size_t total_size = 1024 * 1024 * 64;  // 64MB
+    SimpleAllocator allocator(total_size);
+
+    void* ptr = allocator.allocate(1024);
+    ASSERT_NE(ptr, nullptr);
+    allocator.deallocate(ptr, 1024);
+
+    // A request of the same size class gets the cached block back
+    void* reused = allocator.allocate(1000);
+    EXPECT_EQ(reused, ptr);
+    allocator.deallocate(reused, 1000);
+}
+
+// Test that concurrent threads never share a block
+TEST_F(SimpleAllocatorTest, ThreadCacheConcurrentAllocations) {
+    const size_t total_size = 1024 * 1024 * 256;  // 256MB
+    SimpleAllocator allocator(total_size);
+
+    const int num_threads = 8;
+    const int num_rounds = 2000;
+    std::vector<std::thread> threads;
+    std::vector<int> corrupted(num_threads, 0);
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<std::pair<void*, size_t>> allocations;
+            for (int i = 0; i < num_rounds; ++i) {
+                size_t size = 1024 * (1 + (i % 8));  // 1KB to 8KB
+                void* ptr = allocator.allocate(size);
+                ASSERT_NE(ptr, nullptr);
+                std::memset(ptr, t, size);
+                allocations.emplace_back(ptr, size);
+                if (allocations.size() < 16) {
+                    continue;
+                }
+                for (const auto& [p, s] : allocations) {
+                    const auto* bytes = static_cast<const unsigned char*>(p);
+                    if (bytes[0] != t || bytes[s - 1] != t) {
+                        ++corrupted[t];
+                    }
+                    allocator.deallocate(p, s);
+                }
+                allocations.clear();
+            }
+            for (const auto& [p, s] : allocations) {
+                allocator.deallocate(p, s);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < num_threads; ++t) {
+        EXPECT_EQ(corrupted[t], 0) << "Thread " << t << " saw corruption";
+    }
+}
+
+// Test that blocks cached by an idle thread are reclaimed when the pool runs
+// out, so another thread can allocate everything the first one released
+TEST_F(SimpleAllocatorTest, ThreadCacheReclaimedFromIdleThread) {
+    const size_t total_size = 1024 * 1024 * 16;  // 16MB
+    SimpleAllocator allocator(total_size);
+
+    std::promise<size_t> allocated;
+    std::promise<void> done;
+    std::thread idle([&]() {
+        std::vector<void*> blocks;
+        while (void* ptr = allocator.allocate(1024)) {
+            blocks.push_back(ptr);
+        }
+        for (void* ptr : blocks) {
+            allocator.deallocate(ptr, 1024);
+        }
+        allocated.set_value(blocks.size());
+        // Stay alive so the thread cache is not drained on exit
+        done.get_future().wait();
+    });
+
+    size_t idle_count = allocated.get_future().get();
+    ASSERT_GT(idle_count, 0u);
+    std::vector<void*> blocks;
+    while (void* ptr = allocator.allocate(1024)) {
+        blocks.push_back(ptr);
+    }
+    EXPECT_EQ(blocks.size(), idle_count);
+    for (void* ptr : blocks) {
+        allocator.deallocate(ptr, 1024);
+    }
+    done.set_value();
+    idle.join();
+}
+
 }  // namespace mooncake
 
 int main(int argc, char** argv) {
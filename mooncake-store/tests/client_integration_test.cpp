@@ -2,8 +2,13 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <async_simple/coro/Collect.h>
+#include <async_simple/coro/SyncAwait.h>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -206,6 +211,228 @@ TEST_F(ClientIntegrationTest, BasicPutGetOperations) {
     client_buffer_allocator_->deallocate(buffer, test_data.size());
 }
 
+// Test reading a byte range that spans several slices
+TEST_F(ClientIntegrationTest, RangedGetOperation) {
+    const std::string key = "test_ranged_get_key";
+    const size_t slice_size = 1024;
+    const size_t slice_count = 4;
+    const size_t total_size = slice_size * slice_count;
+
+    void* buffer = client_buffer_allocator_->allocate(total_size);
+    for (size_t i = 0; i < total_size; ++i) {
+        static_cast<uint8_t*>(buffer)[i] = static_cast<uint8_t>(i % 251);
+    }
+    std::vector<Slice> slices;
+    for (size_t i = 0; i < slice_count; ++i) {
+        slices.emplace_back(
+            Slice{static_cast<char*>(buffer) + i * slice_size, slice_size});
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_EQ(test_client_->Put(key, slices, config), ErrorCode::OK);
+
+    // A range starting inside slice 1 and ending inside slice 3
+    const size_t offset = slice_size + 100;
+    const size_t length = slice_size * 2;
+    void* range_buffer = client_buffer_allocator_->allocate(length);
+    std::vector<Slice> range_slices;
+    range_slices.emplace_back(Slice{range_buffer, length});
+    ASSERT_EQ(test_client_->Get(key, offset, length, range_slices),
+              ErrorCode::OK);
+    ASSERT_EQ(memcmp(range_buffer, static_cast<char*>(buffer) + offset, length),
+              0);
+
+    // Out-of-bounds ranges are rejected
+    EXPECT_EQ(test_client_->Get(key, total_size - 10, 20, range_slices),
+              ErrorCode::INVALID_PARAMS);
+
+    client_buffer_allocator_->deallocate(range_buffer, length);
+    client_buffer_allocator_->deallocate(buffer, total_size);
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
+}
+
+// Test that a compressed put reads back the original data
+TEST_F(ClientIntegrationTest, CompressedPutGetOperations) {
+    const std::string key = "test_compressed_put_get_key";
+    const size_t slice_size = 64 * 1024;
+    const size_t slice_count = 2;
+    const size_t total_size = slice_size * slice_count;
+
+    // fp16-like values whose high bytes repeat, plus a random slice that
+    // does not compress and must be stored as is
+    void* buffer = client_buffer_allocator_->allocate(total_size);
+    auto* values = static_cast<uint16_t*>(buffer);
+    for (size_t i = 0; i < slice_size / sizeof(uint16_t); ++i) {
+        values[i] = static_cast<uint16_t>(0x3c00 + i % 97);
+    }
+    std::mt19937 rng(42);
+    for (size_t i = slice_size; i < total_size; ++i) {
+        static_cast<uint8_t*>(buffer)[i] = static_cast<uint8_t>(rng());
+    }
+    std::vector<Slice> slices;
+    for (size_t i = 0; i < slice_count; ++i) {
+        slices.emplace_back(
+            Slice{static_cast<char*>(buffer) + i * slice_size, slice_size});
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.codec = CompressionCodec::ZLIB;
+    config.shuffle_bytes = sizeof(uint16_t);
+    ASSERT_EQ(test_client_->Put(key, slices, config), ErrorCode::OK);
+
+    Client::ObjectInfo object_info;
+    ASSERT_EQ(test_client_->Query(key, object_info), ErrorCode::OK);
+    const auto& replica = object_info.replica_list[0];
+    ASSERT_TRUE(replica.is_compressed());
+    EXPECT_EQ(replica.data_size(), total_size);
+    EXPECT_LT(replica.buffer_descriptors[0].size_, slice_size);
+    EXPECT_EQ(replica.buffer_descriptors[1].size_, slice_size);
+
+    void* get_buffer = client_buffer_allocator_->allocate(total_size);
+    std::vector<Slice> get_slices;
+    for (size_t i = 0; i < slice_count; ++i) {
+        get_slices.emplace_back(
+            Slice{static_cast<char*>(get_buffer) + i * slice_size, slice_size});
+    }
+    ASSERT_EQ(test_client_->Get(key, get_slices), ErrorCode::OK);
+    ASSERT_EQ(memcmp(get_buffer, buffer, total_size), 0);
+
+    auto stats = test_client_->GetCompressionStats();
+    EXPECT_GT(stats.ratio(), 1.0);
+    EXPECT_EQ(stats.decompressed_bytes, slice_size);
+
+    // Ranges of compressed objects cannot be read
+    EXPECT_EQ(test_client_->Get(key, 0, 100, get_slices),
+              ErrorCode::INVALID_PARAMS);
+
+    // Batch puts do not compress
+    std::unordered_map<std::string, std::vector<Slice>> batched_slices;
+    batched_slices.emplace(key + "_batch", slices);
+    EXPECT_EQ(test_client_->BatchPut({key + "_batch"}, batched_slices, config),
+              ErrorCode::INVALID_PARAMS);
+
+    client_buffer_allocator_->deallocate(get_buffer, total_size);
+    client_buffer_allocator_->deallocate(buffer, total_size);
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
+}
+
+// Test that identical values under different keys share their buffers
+TEST_F(ClientIntegrationTest, DeduplicatedPutGetOperations) {
+    const std::string key1 = "test_dedup_key_1";
+    const std::string key2 = "test_dedup_key_2";
+    const size_t data_size = 64 * 1024;
+
+    void* buffer = client_buffer_allocator_->allocate(data_size);
+    for (size_t i = 0; i < data_size; ++i) {
+        static_cast<uint8_t*>(buffer)[i] = static_cast<uint8_t>(i % 251);
+    }
+    std::vector<Slice> slices;
+    slices.emplace_back(Slice{buffer, data_size});
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.dedup = true;
+    ASSERT_EQ(test_client_->Put(key1, slices, config), ErrorCode::OK);
+    ASSERT_EQ(test_client_->Put(key2, slices, config), ErrorCode::OK);
+
+    Client::ObjectInfo info1, info2;
+    ASSERT_EQ(test_client_->Query(key1, info1), ErrorCode::OK);
+    ASSERT_EQ(test_client_->Query(key2, info2), ErrorCode::OK);
+    EXPECT_EQ(info1.replica_list[0].buffer_descriptors[0].buffer_address_,
+              info2.replica_list[0].buffer_descriptors[0].buffer_address_);
+
+    // The second key stays readable after the first one is removed
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key1), ErrorCode::OK);
+
+    void* get_buffer = client_buffer_allocator_->allocate(data_size);
+    std::vector<Slice> get_slices;
+    get_slices.emplace_back(Slice{get_buffer, data_size});
+    ASSERT_EQ(test_client_->Get(key2, get_slices), ErrorCode::OK);
+    ASSERT_EQ(memcmp(get_buffer, buffer, data_size), 0);
+
+    // Batch puts do not deduplicate
+    std::unordered_map<std::string, std::vector<Slice>> batched_slices;
+    batched_slices.emplace("test_dedup_key_3", slices);
+    EXPECT_EQ(
+        test_client_->BatchPut({"test_dedup_key_3"}, batched_slices, config),
+        ErrorCode::INVALID_PARAMS);
+
+    client_buffer_allocator_->deallocate(get_buffer, data_size);
+    client_buffer_allocator_->deallocate(buffer, data_size);
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key2), ErrorCode::OK);
+}
+
+// Test many concurrent AsyncPut/AsyncGet operations driven by one thread
+TEST_F(ClientIntegrationTest, AsyncPutGetOperations) {
+    constexpr size_t kNumKeys = 16;
+    const std::string test_data = "Hello, Async World!";
+
+    std::vector<std::string> keys;
+    std::vector<std::vector<Slice>> put_slices(kNumKeys);
+    std::vector<std::vector<Slice>> get_slices(kNumKeys);
+    std::vector<void*> buffers;
+    for (size_t i = 0; i < kNumKeys; ++i) {
+        keys.push_back("test_async_key_" + std::to_string(i));
+        void* put_buffer = client_buffer_allocator_->allocate(test_data.size());
+        memcpy(put_buffer, test_data.data(), test_data.size());
+        put_slices[i].emplace_back(Slice{put_buffer, test_data.size()});
+        void* get_buffer = client_buffer_allocator_->allocate(test_data.size());
+        get_slices[i].emplace_back(Slice{get_buffer, test_data.size()});
+        buffers.push_back(put_buffer);
+        buffers.push_back(get_buffer);
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    std::vector<async_simple::coro::Lazy<ErrorCode>> puts;
+    for (size_t i = 0; i < kNumKeys; ++i) {
+        puts.push_back(test_client_->AsyncPut(keys[i], put_slices[i], config));
+    }
+    auto put_results =
+        async_simple::coro::syncAwait(async_simple::coro::collectAll(
+            std::move(puts)));
+    for (auto& result : put_results) {
+        ASSERT_EQ(result.value(), ErrorCode::OK);
+    }
+
+    std::vector<async_simple::coro::Lazy<ErrorCode>> gets;
+    for (size_t i = 0; i < kNumKeys; ++i) {
+        gets.push_back(test_client_->AsyncGet(keys[i], get_slices[i]));
+    }
+    auto get_results =
+        async_simple::coro::syncAwait(async_simple::coro::collectAll(
+            std::move(gets)));
+    for (size_t i = 0; i < kNumKeys; ++i) {
+        ASSERT_EQ(get_results[i].value(), ErrorCode::OK);
+        ASSERT_EQ(memcmp(get_slices[i][0].ptr, test_data.data(),
+                         test_data.size()),
+                  0);
+    }
+
+    for (void* buffer : buffers) {
+        client_buffer_allocator_->deallocate(buffer, test_data.size());
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    for (const auto& key : keys) {
+        ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
+    }
+}
+
 // Test Remove operation
 TEST_F(ClientIntegrationTest, RemoveOperation) {
     const std::string test_data = "Test data for removal";
@@ -280,6 +507,54 @@ TEST_F(ClientIntegrationTest, LocalPreferredAllocationTest) {
     ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
 }
 
+// Test zero-copy reads of objects in the client's own segment
+TEST_F(ClientIntegrationTest, GetViewOperation) {
+    const std::string test_data = "Test data for zero-copy views";
+    const std::string key = "get_view_test_key";
+    const std::string remote_key = "get_view_remote_test_key";
+    void* buffer = client_buffer_allocator_->allocate(test_data.size());
+    memcpy(buffer, test_data.data(), test_data.size());
+    std::vector<Slice> slices;
+    slices.emplace_back(Slice{buffer, test_data.size()});
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.preferred_segment = "localhost:17813";  // test_client_'s segment
+    ASSERT_EQ(test_client_->Put(key, slices, config), ErrorCode::OK);
+    config.preferred_segment = "localhost:17812";  // Another client's segment
+    ASSERT_EQ(test_client_->Put(remote_key, slices, config), ErrorCode::OK);
+    client_buffer_allocator_->deallocate(buffer, test_data.size());
+
+    std::unique_ptr<ObjectView> view;
+    ASSERT_EQ(test_client_->GetView(key, view), ErrorCode::OK);
+    ASSERT_TRUE(view != nullptr);
+    ASSERT_EQ(view->size(), test_data.size());
+    std::string viewed;
+    for (const auto& span : view->spans()) {
+        viewed.append(span.data(), span.size());
+    }
+    EXPECT_EQ(viewed, test_data);
+
+    // The object is pinned while the view is alive
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    EXPECT_EQ(test_client_->Remove(key), ErrorCode::OBJECT_HAS_LEASE);
+    EXPECT_EQ(view->Release(), ErrorCode::OK);
+    EXPECT_EQ(view->Release(), ErrorCode::OK);
+
+    // Objects that are not in the local segment cannot be viewed
+    std::unique_ptr<ObjectView> remote_view;
+    EXPECT_EQ(test_client_->GetView(remote_key, remote_view),
+              ErrorCode::INVALID_REPLICA);
+    EXPECT_TRUE(remote_view == nullptr);
+
+    // Clean up
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
+    ASSERT_EQ(test_client_->Remove(remote_key), ErrorCode::OK);
+}
+
 // Test heavy workload operations
 TEST_F(ClientIntegrationTest, DISABLED_AllocateTest) {
     const size_t data_size = 1 * 1024 * 1024;  // 1MB
@@ -473,6 +748,122 @@ TEST_F(ClientIntegrationTest, BatchPutGetOperations) {
     }
 }
 
+
+// Test reads striped over the replicas of an object, and compare their
+// bandwidth with reads from a single replica
+TEST_F(ClientIntegrationTest, StripedGetOperations) {
+    const std::string key = "test_striped_key";
+    const size_t slice_size = 1024 * 1024;
+    const size_t slice_count = 8;
+    const size_t total_size = slice_size * slice_count;
+
+    void* buffer = client_buffer_allocator_->allocate(total_size);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < total_size; ++i) {
+        static_cast<uint8_t*>(buffer)[i] = static_cast<uint8_t>(rng());
+    }
+    std::vector<Slice> slices;
+    for (size_t i = 0; i < slice_count; ++i) {
+        slices.emplace_back(
+            Slice{static_cast<char*>(buffer) + i * slice_size, slice_size});
+    }
+
+    ReplicateConfig config;
+    config.replica_num = 2;
+    ASSERT_EQ(test_client_->Put(key, slices, config), ErrorCode::OK);
+
+    Client::ObjectInfo object_info;
+    ASSERT_EQ(test_client_->Query(key, object_info), ErrorCode::OK);
+    ASSERT_EQ(object_info.replica_list.size(), 2);
+
+    // Readers without a segment of their own, so that no replica is local.
+    // Striping is read from the environment when a client is created.
+    auto reader_allocator = std::make_unique<SimpleAllocator>(total_size * 2);
+    setenv("MC_STORE_STRIPED_READ", "1", 1);
+    auto striped_reader = CreateClient("localhost:17814");
+    unsetenv("MC_STORE_STRIPED_READ");
+    auto plain_reader = CreateClient("localhost:17815");
+    ASSERT_TRUE(striped_reader != nullptr);
+    ASSERT_TRUE(plain_reader != nullptr);
+    for (auto& reader : {striped_reader, plain_reader}) {
+        ASSERT_EQ(reader->RegisterLocalMemory(reader_allocator->getBase(),
+                                              total_size * 2, "cpu:0", false,
+                                              false),
+                  ErrorCode::OK);
+    }
+
+    void* get_buffer = reader_allocator->allocate(total_size);
+    std::vector<Slice> get_slices;
+    for (size_t i = 0; i < slice_count; ++i) {
+        get_slices.emplace_back(
+            Slice{static_cast<char*>(get_buffer) + i * slice_size, slice_size});
+    }
+    std::vector<Slice> whole_slice;
+    whole_slice.emplace_back(Slice{get_buffer, total_size});
+
+    ASSERT_EQ(striped_reader->Get(key, get_slices), ErrorCode::OK);
+    ASSERT_EQ(memcmp(get_buffer, buffer, total_size), 0);
+    memset(get_buffer, 0, total_size);
+    ASSERT_EQ(striped_reader->Get(key, whole_slice), ErrorCode::OK);
+    ASSERT_EQ(memcmp(get_buffer, buffer, total_size), 0);
+
+    // Replica infos with one replica on a segment that doesn't exist
+    std::vector<Client::ObjectInfo> broken_infos(2, object_info);
+    for (size_t r = 0; r < broken_infos.size(); ++r) {
+        for (auto& descriptor :
+             broken_infos[r].replica_list[r].buffer_descriptors) {
+            descriptor.segment_name_ = "localhost:1";
+        }
+    }
+
+    // Slices matching the buffers are read from both replicas, so a single
+    // broken replica fails every get
+    for (const auto& broken_info : broken_infos) {
+        EXPECT_NE(striped_reader->Get(key, broken_info, get_slices),
+                  ErrorCode::OK);
+    }
+
+    // Other slice layouts, and all reads without striping, come from one
+    // randomly selected replica, so some gets pick the intact one
+    auto succeeds_sometimes = [&](const std::shared_ptr<Client>& reader,
+                                  std::vector<Slice>& read_slices) {
+        for (int i = 0; i < 32; ++i) {
+            if (reader->Get(key, broken_infos[1], read_slices) ==
+                ErrorCode::OK) {
+                return true;
+            }
+        }
+        return false;
+    };
+    EXPECT_TRUE(succeeds_sometimes(striped_reader, whole_slice));
+    EXPECT_TRUE(succeeds_sometimes(plain_reader, get_slices));
+
+    // Bandwidth of striped reads and of reads from a single replica
+    constexpr int kRounds = 16;
+    for (auto& reader : {plain_reader, striped_reader}) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < kRounds; ++i) {
+            ASSERT_EQ(reader->Get(key, get_slices), ErrorCode::OK);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        LOG(INFO) << (reader == striped_reader ? "Striped" : "Single replica")
+                  << " read bandwidth: "
+                  << total_size * kRounds / seconds / (1024 * 1024)
+                  << " MB/s";
+    }
+    ASSERT_EQ(memcmp(get_buffer, buffer, total_size), 0);
+
+    reader_allocator->deallocate(get_buffer, total_size);
+    client_buffer_allocator_->deallocate(buffer, total_size);
+    striped_reader.reset();
+    plain_reader.reset();
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_default_kv_lease_ttl));
+    ASSERT_EQ(test_client_->Remove(key), ErrorCode::OK);
+}
+
 }  // namespace testing
 
 }  // namespace mooncake
@@ -0,0 +1,157 @@
+// client_metric_test.cpp
+#include "client_metric.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "transfer_task.h"
+
+namespace mooncake {
+
+static AllocatedBuffer::Descriptor MakeHandle(const std::string& segment,
+                                              uint64_t size) {
+    AllocatedBuffer::Descriptor handle;
+    handle.segment_name_ = segment;
+    handle.size_ = size;
+    return handle;
+}
+
+TEST(ClientMetricTest, RpcScope) {
+    ClientMetric metric;
+    {
+        ClientMetric::RpcScope scope(metric, MasterRpc::GET_REPLICA_LIST);
+        EXPECT_EQ(metric.rpcs_in_flight(), 1);
+    }
+    EXPECT_EQ(metric.rpcs_in_flight(), 0);
+    EXPECT_EQ(
+        metric.rpc_latency(MasterRpc::GET_REPLICA_LIST).GetSnapshot().count,
+        1u);
+    EXPECT_EQ(metric.rpc_latency(MasterRpc::PUT_START).GetSnapshot().count,
+              0u);
+
+    std::string serialized = metric.Serialize();
+    EXPECT_NE(serialized.find("client_rpc_latency_microseconds_count{method="
+                              "\"GetReplicaList\"} 1"),
+              std::string::npos);
+    EXPECT_EQ(serialized.find("method=\"PutStart\""), std::string::npos);
+    EXPECT_NE(serialized.find("client_rpcs_in_flight 0"), std::string::npos);
+}
+
+TEST(ClientMetricTest, TrackedOperations) {
+    ClientMetric metric;
+    std::vector<AllocatedBuffer::Descriptor> handles = {
+        MakeHandle("node0", 100), MakeHandle("node0", 50),
+        MakeHandle("node1", 10)};
+
+    auto state = std::make_shared<MemcpyOperationState>();
+    state->track(&metric, Transport::TransferRequest::WRITE, handles,
+                 std::chrono::steady_clock::now());
+    EXPECT_EQ(metric.transfers_in_flight(), 1);
+    state->set_completed(ErrorCode::OK);
+    EXPECT_EQ(metric.transfers_in_flight(), 0);
+
+    EXPECT_EQ(metric.transfer_bytes(TransferStrategy::LOCAL_MEMCPY,
+                                    Transport::TransferRequest::WRITE),
+              160u);
+    EXPECT_EQ(metric.transfer_bytes(TransferStrategy::LOCAL_MEMCPY,
+                                    Transport::TransferRequest::READ),
+              0u);
+    EXPECT_EQ(metric
+                  .transfer_latency(TransferStrategy::LOCAL_MEMCPY,
+                                    Transport::TransferRequest::WRITE)
+                  .GetSnapshot()
+                  .count,
+              1u);
+    EXPECT_EQ(metric.peer_bytes("node0", Transport::TransferRequest::WRITE),
+              150u);
+    EXPECT_EQ(metric.peer_bytes("node1", Transport::TransferRequest::WRITE),
+              10u);
+    EXPECT_EQ(metric.peer_bytes("node1", Transport::TransferRequest::READ),
+              0u);
+
+    // A failed transfer counts as a failure and moves no bytes
+    state = std::make_shared<MemcpyOperationState>();
+    state->track(&metric, Transport::TransferRequest::READ, handles,
+                 std::chrono::steady_clock::now());
+    state->set_completed(ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(metric.transfer_failures(TransferStrategy::LOCAL_MEMCPY,
+                                       Transport::TransferRequest::READ),
+              1u);
+    EXPECT_EQ(metric.peer_bytes("node0", Transport::TransferRequest::READ),
+              0u);
+
+    // Dropping an operation before it completes leaves nothing in flight
+    state = std::make_shared<MemcpyOperationState>();
+    state->track(&metric, Transport::TransferRequest::READ, handles,
+                 std::chrono::steady_clock::now());
+    EXPECT_EQ(metric.transfers_in_flight(), 1);
+    state.reset();
+    EXPECT_EQ(metric.transfers_in_flight(), 0);
+
+    // Untracked operations are not recorded
+    state = std::make_shared<MemcpyOperationState>();
+    state->track(nullptr, Transport::TransferRequest::WRITE, handles,
+                 std::chrono::steady_clock::now());
+    state->set_completed(ErrorCode::OK);
+    EXPECT_EQ(metric.transfer_bytes(TransferStrategy::LOCAL_MEMCPY,
+                                    Transport::TransferRequest::WRITE),
+              160u);
+}
+
+TEST(ClientMetricTest, Serialize) {
+    ClientMetric metric;
+    metric.StartTransfer();
+    metric.RecordTransfer(TransferStrategy::TRANSFER_ENGINE,
+                          Transport::TransferRequest::READ, 4096,
+                          std::chrono::microseconds(30), true);
+    metric.RecordPeerBytes("node1:12345", Transport::TransferRequest::READ,
+                           4096);
+    metric.IncRetry(ClientRetry::PROMOTION_WAIT, 3);
+    metric.IncRevokedPuts(2);
+
+    std::string serialized = metric.Serialize();
+    for (const char* line :
+         {"client_transfer_bytes_total{strategy=\"transfer_engine\",op="
+          "\"read\"} 4096",
+          "client_transfer_bytes_total{strategy=\"local_memcpy\",op="
+          "\"write\"} 0",
+          "client_transfer_latency_microseconds_count{strategy="
+          "\"transfer_engine\",op=\"read\"} 1",
+          "client_peer_bytes_total{peer=\"node1:12345\",op=\"read\"} 4096",
+          "client_retries_total{reason=\"promotion_wait\"} 3",
+          "client_retries_total{reason=\"master_reconnect\"} 0",
+          "client_revoked_puts_total 2", "client_transfers_in_flight 0"}) {
+        EXPECT_NE(serialized.find(line), std::string::npos) << line;
+    }
+    EXPECT_EQ(serialized.find("client_rpc_latency_microseconds"),
+              std::string::npos);
+}
+
+// Test the derived codec statistics and their export
+TEST(ClientMetricTest, CompressionStats) {
+    ClientMetric metric;
+    metric.RecordCompress(4000, 1000, 2000);
+    metric.RecordDecompress(4000, 1000);
+    auto stats = metric.compression_stats();
+    EXPECT_EQ(stats.compressed_slices, 1u);
+    EXPECT_DOUBLE_EQ(stats.ratio(), 4.0);
+    EXPECT_DOUBLE_EQ(stats.compress_mbps(), 2000.0);
+    EXPECT_DOUBLE_EQ(stats.decompress_mbps(), 4000.0);
+
+    std::string serialized = metric.Serialize();
+    for (const char* line :
+         {"client_compressed_slices_total 1",
+          "client_compression_raw_bytes_total 4000",
+          "client_compression_stored_bytes_total 1000",
+          "client_compression_ratio 4", "client_decompressed_bytes_total 4000",
+          "client_codec_throughput_mbps{op=\"compress\"} 2000",
+          "client_codec_throughput_mbps{op=\"decompress\"} 4000"}) {
+        EXPECT_NE(serialized.find(line), std::string::npos) << line;
+    }
+}
+
+}  // namespace mooncake
@@ -0,0 +1,98 @@
+// compression_test.cpp
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "compression.h"
+
+namespace mooncake {
+
+class CompressionTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        google::InitGoogleLogging("CompressionTest");
+        FLAGS_logtostderr = 1;
+    }
+
+    void TearDown() override { google::ShutdownGoogleLogging(); }
+
+    // fp16-like data with an odd tail byte, so shuffling leaves a remainder
+    static std::vector<char> MakeCompressibleData(size_t elements) {
+        std::vector<char> data(elements * sizeof(uint16_t) + 1);
+        for (size_t i = 0; i < elements; ++i) {
+            uint16_t value = static_cast<uint16_t>(0x3c00 + i % 37);
+            memcpy(data.data() + i * sizeof(uint16_t), &value, sizeof(value));
+        }
+        data.back() = 7;
+        return data;
+    }
+};
+
+// Test round trips with and without byte shuffling
+TEST_F(CompressionTest, ZlibRoundTrip) {
+    ASSERT_TRUE(IsCodecSupported(CompressionCodec::ZLIB));
+    auto data = MakeCompressibleData(100000);
+    for (uint8_t shuffle_bytes : {0, 2, 4}) {
+        std::vector<char> encoded(data.size());
+        size_t encoded_size =
+            CompressSlice(CompressionCodec::ZLIB, shuffle_bytes, data.data(),
+                          data.size(), encoded.data(), encoded.size());
+        ASSERT_GT(encoded_size, 0u);
+        ASSERT_LT(encoded_size, data.size());
+
+        std::vector<char> decoded(data.size());
+        ASSERT_TRUE(DecompressSlice(CompressionCodec::ZLIB, shuffle_bytes,
+                                    encoded.data(), encoded_size,
+                                    decoded.data(), decoded.size()));
+        EXPECT_EQ(decoded, data);
+    }
+}
+
+// Test that data which does not shrink is reported as incompressible
+TEST_F(CompressionTest, IncompressibleData) {
+    std::vector<char> data(64 * 1024);
+    std::mt19937 rng(1);
+    for (auto& c : data) {
+        c = static_cast<char>(rng());
+    }
+    std::vector<char> encoded(data.size());
+    EXPECT_EQ(CompressSlice(CompressionCodec::ZLIB, 0, data.data(),
+                            data.size(), encoded.data(), encoded.size()),
+              0u);
+}
+
+// Test that corrupted input and a wrong raw size are detected
+TEST_F(CompressionTest, DecompressRejectsBadInput) {
+    auto data = MakeCompressibleData(10000);
+    std::vector<char> encoded(data.size());
+    size_t encoded_size =
+        CompressSlice(CompressionCodec::ZLIB, 0, data.data(), data.size(),
+                      encoded.data(), encoded.size());
+    ASSERT_GT(encoded_size, 0u);
+
+    std::vector<char> decoded(data.size() + 1);
+    EXPECT_FALSE(DecompressSlice(CompressionCodec::ZLIB, 0, encoded.data(),
+                                 encoded_size, decoded.data(),
+                                 data.size() + 1));
+    EXPECT_FALSE(DecompressSlice(CompressionCodec::ZLIB, 0, encoded.data(),
+                                 encoded_size / 2, decoded.data(),
+                                 data.size()));
+}
+
+// Test that ParallelFor runs every index exactly once
+TEST_F(CompressionTest, ParallelForCoversAllIndices) {
+    CompressionStage stage(4);
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::atomic<int>> hits(1000);
+        stage.ParallelFor(hits.size(), [&](size_t i) { hits[i]++; });
+        for (const auto& hit : hits) {
+            ASSERT_EQ(hit.load(), 1);
+        }
+    }
+}
+
+}  // namespace mooncake
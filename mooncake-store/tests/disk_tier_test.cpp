@@ -0,0 +1,189 @@
+// disk_tier_test.cpp
+#include "disk_tier.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mooncake {
+
+class DiskTierTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        google::InitGoogleLogging("DiskTierTest");
+        FLAGS_logtostderr = 1;
+        path_ = "/tmp/disk_tier_test_" + std::to_string(getpid());
+    }
+
+    void TearDown() override { google::ShutdownGoogleLogging(); }
+
+    static std::vector<char> MakeData(size_t size, char seed) {
+        std::vector<char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(seed + i % 251);
+        }
+        return data;
+    }
+
+    std::string path_;
+};
+
+// Test that unaligned slices survive a round trip
+TEST_F(DiskTierTest, WriteReadRoundTrip) {
+    auto tier = DiskTier::Create(path_, 64 * 1024 * 1024);
+    ASSERT_NE(tier, nullptr);
+    EXPECT_EQ(access(path_.c_str(), F_OK), 0);
+
+    // Crosses the 4 MiB bounce buffer with an odd sized tail
+    auto first = MakeData(5 * 1024 * 1024 + 3, 1);
+    auto second = MakeData(1000, 2);
+    std::vector<Slice> slices = {{first.data(), first.size()},
+                                 {second.data(), second.size()}};
+    uint64_t offset = 0;
+    ASSERT_EQ(tier->Write(slices, offset), ErrorCode::OK);
+    EXPECT_EQ(offset % DiskTier::kAlignment, 0u);
+    EXPECT_GE(tier->used(), first.size() + second.size());
+
+    std::vector<char> first_out(first.size());
+    std::vector<char> second_out(second.size());
+    std::vector<Slice> out = {{first_out.data(), first_out.size()},
+                              {second_out.data(), second_out.size()}};
+    ASSERT_EQ(tier->Read(offset, out), ErrorCode::OK);
+    EXPECT_EQ(first_out, first);
+    EXPECT_EQ(second_out, second);
+
+    tier->Free(offset);
+    EXPECT_EQ(tier->used(), 0u);
+
+    tier.reset();
+    EXPECT_NE(access(path_.c_str(), F_OK), 0);
+}
+
+// Test that a range of the extent can be read from an unaligned position
+TEST_F(DiskTierTest, ReadRange) {
+    auto tier = DiskTier::Create(path_, 64 * 1024 * 1024);
+    ASSERT_NE(tier, nullptr);
+
+    auto data = MakeData(9 * 1024 * 1024 + 5, 8);
+    std::vector<Slice> slices = {{data.data(), data.size()}};
+    uint64_t offset = 0;
+    ASSERT_EQ(tier->Write(slices, offset), ErrorCode::OK);
+
+    // Spans the 4 MiB bounce buffer twice and ends at the last byte
+    const size_t start = DiskTier::kAlignment + 17;
+    const size_t length = data.size() - start;
+    std::vector<char> head(1000);
+    std::vector<char> tail(length - head.size());
+    std::vector<Slice> out = {{head.data(), head.size()},
+                              {tail.data(), tail.size()}};
+    ASSERT_EQ(tier->Read(offset, out, start), ErrorCode::OK);
+    EXPECT_TRUE(std::equal(head.begin(), head.end(), data.begin() + start));
+    EXPECT_TRUE(std::equal(tail.begin(), tail.end(),
+                           data.begin() + start + head.size()));
+
+    // Past the end of the extent
+    std::vector<Slice> too_far = {{head.data(), head.size()}};
+    EXPECT_EQ(tier->Read(offset, too_far, data.size() + DiskTier::kAlignment),
+              ErrorCode::INVALID_PARAMS);
+}
+
+// Test that reads of unknown or too small extents are rejected
+TEST_F(DiskTierTest, ReadInvalidExtent) {
+    auto tier = DiskTier::Create(path_, 1024 * 1024);
+    ASSERT_NE(tier, nullptr);
+
+    auto data = MakeData(100, 3);
+    std::vector<Slice> slices = {{data.data(), data.size()}};
+    uint64_t offset = 0;
+    ASSERT_EQ(tier->Write(slices, offset), ErrorCode::OK);
+
+    std::vector<char> out(2 * DiskTier::kAlignment);
+    std::vector<Slice> too_large = {{out.data(), out.size()}};
+    EXPECT_EQ(tier->Read(offset, too_large), ErrorCode::INVALID_PARAMS);
+    std::vector<Slice> valid = {{out.data(), data.size()}};
+    EXPECT_EQ(tier->Read(offset + DiskTier::kAlignment, valid),
+              ErrorCode::INVALID_PARAMS);
+}
+
+// Test that a full tier rejects writes and that freed extents are coalesced
+TEST_F(DiskTierTest, FullAndCoalesce) {
+    const size_t extent = 256 * 1024;
+    auto tier = DiskTier::Create(path_, 4 * extent);
+    ASSERT_NE(tier, nullptr);
+
+    auto data = MakeData(extent, 4);
+    std::vector<Slice> slices = {{data.data(), data.size()}};
+    std::vector<uint64_t> offsets(4);
+    for (auto& offset : offsets) {
+        ASSERT_EQ(tier->Write(slices, offset), ErrorCode::OK);
+    }
+    uint64_t offset = 0;
+    EXPECT_EQ(tier->Write(slices, offset), ErrorCode::BUFFER_OVERFLOW);
+
+    // Two adjacent free extents hold an object of twice the size
+    tier->Free(offsets[2]);
+    tier->Free(offsets[1]);
+    auto large = MakeData(2 * extent, 5);
+    std::vector<Slice> large_slices = {{large.data(), large.size()}};
+    ASSERT_EQ(tier->Write(large_slices, offset), ErrorCode::OK);
+    EXPECT_EQ(offset, offsets[1]);
+
+    std::vector<char> out(large.size());
+    std::vector<Slice> out_slices = {{out.data(), out.size()}};
+    ASSERT_EQ(tier->Read(offset, out_slices), ErrorCode::OK);
+    EXPECT_EQ(out, large);
+}
+
+// Test that an extent freed during a read is not reused before it finishes
+TEST_F(DiskTierTest, FreeDuringRead) {
+    const size_t extent = 8 * 1024 * 1024;
+    auto tier = DiskTier::Create(path_, extent);
+    ASSERT_NE(tier, nullptr);
+
+    auto data = MakeData(extent, 6);
+    std::vector<Slice> slices = {{data.data(), data.size()}};
+    uint64_t offset = 0;
+    ASSERT_EQ(tier->Write(slices, offset), ErrorCode::OK);
+
+    auto other = MakeData(extent, 7);
+    std::atomic<long> good_reads{0};
+    std::atomic<bool> freeing{false};
+    std::atomic<bool> corrupted{false};
+    std::thread reader([&]() {
+        std::vector<char> out(extent);
+        std::vector<Slice> out_slices = {{out.data(), out.size()}};
+        while (!freeing.load() &&
+               tier->Read(offset, out_slices) == ErrorCode::OK) {
+            // Never a mix of the two objects
+            if (out != data && out != other) {
+                corrupted = true;
+            }
+            ++good_reads;
+        }
+    });
+    while (good_reads.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    // The only room in the tier is the extent being read
+    freeing = true;
+    tier->Free(offset);
+    std::vector<Slice> other_slices = {{other.data(), other.size()}};
+    uint64_t other_offset = 0;
+    while (tier->Write(other_slices, other_offset) != ErrorCode::OK) {
+        std::this_thread::yield();
+    }
+    reader.join();
+    EXPECT_FALSE(corrupted.load());
+    EXPECT_EQ(other_offset, offset);
+    EXPECT_EQ(tier->used(), extent);
+}
+
+}  // namespace mooncake
@@ -0,0 +1,70 @@
+import os
+import time
+from mooncake.store import MooncakeDistributedStore
+
+# Compares the read bandwidth of `get` (copies into a bytes object) and
+# `get_buffer` (zero-copy buffer) for values from 1 MB to 64 MB.
+#
+# How to test
+# 1. Start mooncake_master and the metadata server
+# 2. Run `python3 ./get_bandwidth_benchmark.py`, configuring the addresses
+#    through the environment variables read in `setup`
+
+VALUE_SIZES_MB = [1, 2, 4, 8, 16, 32, 64]
+
+
+class BandwidthBenchmark:
+    def setup(cls):
+        cls.store = MooncakeDistributedStore()
+        protocol = os.getenv("PROTOCOL", "tcp")
+        device_name = os.getenv("DEVICE_NAME", "ibp6s0")
+        local_hostname = os.getenv("LOCAL_HOSTNAME", "localhost")
+        metadata_server = os.getenv("METADATA_ADDR", "127.0.0.1:2379")
+        global_segment_size = 3200 * 1024 * 1024
+        local_buffer_size = 512 * 1024 * 1024
+        master_server_address = os.getenv("MASTER_SERVER", "127.0.0.1:50051")
+        cls.iterations = int(os.getenv("ITERATIONS", "20"))
+        retcode = cls.store.setup(local_hostname,
+                                  metadata_server,
+                                  global_segment_size,
+                                  local_buffer_size,
+                                  protocol,
+                                  device_name,
+                                  master_server_address)
+        if retcode:
+            exit(1)
+        time.sleep(1)  # Give some time for initialization
+
+    def measure(cls, read, key, size):
+        start = time.perf_counter()
+        for _ in range(cls.iterations):
+            value = read(key)
+            if len(value) != size:
+                print("WARNING: read failed, key", key)
+            # Touch the data so that a lazy view is not favoured
+            memoryview(value)[size - 1]
+            del value
+        elapsed = time.perf_counter() - start
+        return size * cls.iterations / elapsed / (1 << 30)
+
+    def run(cls):
+        print("%-10s %-14s %-14s %-8s" % ("size_mb", "get_GB/s",
+                                          "get_buffer_GB/s", "speedup"))
+        for size_mb in VALUE_SIZES_MB:
+            size = size_mb * 1024 * 1024
+            key = "get_bw_" + str(size_mb)
+            if cls.store.put(key, os.urandom(size)):
+                print("WARNING: put failed, key", key)
+                continue
+            cls.measure(cls.store.get_buffer, key, size)  # Warm up the pools
+            get_gbps = cls.measure(cls.store.get, key, size)
+            buffer_gbps = cls.measure(cls.store.get_buffer, key, size)
+            print("%-10d %-14.2f %-14.2f %-8.2f" % (
+                size_mb, get_gbps, buffer_gbps, buffer_gbps / get_gbps))
+        cls.store.close()
+
+
+if __name__ == '__main__':
+    benchmark = BandwidthBenchmark()
+    benchmark.setup()
+    benchmark.run()
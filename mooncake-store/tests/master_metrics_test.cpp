@@ -162,6 +162,58 @@ TEST_F(MasterMetricsTest, BasicRequestTest) {
     ASSERT_EQ(metrics.get_allocated_size(), 0);
     ASSERT_EQ(metrics.get_total_capacity(), 0);
     ASSERT_DOUBLE_EQ(metrics.get_global_used_ratio(), 0.0);
+
+    // Every handler records its latency
+    ASSERT_EQ(metrics.rpc_latency(MasterRpc::PUT_START).GetSnapshot().count,
+              4u);
+    ASSERT_EQ(
+        metrics.rpc_latency(MasterRpc::GET_REPLICA_LIST).GetSnapshot().count,
+        1u);
+    ASSERT_EQ(metrics.rpc_latency(MasterRpc::PING).GetSnapshot().count, 0u);
+    std::string serialized = metrics.serialize_metrics();
+    ASSERT_NE(serialized.find("# TYPE master_rpc_latency_microseconds summary"),
+              std::string::npos);
+    ASSERT_NE(serialized.find("master_rpc_latency_microseconds_count{method="
+                              "\"PutStart\"} 4"),
+              std::string::npos);
+    ASSERT_EQ(serialized.find("method=\"Ping\""), std::string::npos);
+}
+
+TEST_F(MasterMetricsTest, LatencyHistogramTest) {
+    LatencyHistogram histogram;
+    auto empty = histogram.GetSnapshot();
+    ASSERT_EQ(empty.count, 0u);
+    ASSERT_EQ(empty.QuantileNs(0.99), 0u);
+
+    // 1..1000 us from several threads, so several shards are merged
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (uint64_t us = t + 1; us <= 1000; us += 4) {
+                histogram.Record(us * 1000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto snapshot = histogram.GetSnapshot();
+    ASSERT_EQ(snapshot.count, 1000u);
+    ASSERT_EQ(snapshot.sum_ns, 500500u * 1000);
+    // Quantiles are bucket upper bounds, at most 25% above the exact value
+    for (double q : {0.5, 0.9, 0.99}) {
+        double exact = q * 1000 * 1000;
+        ASSERT_GE(snapshot.QuantileNs(q), exact);
+        ASSERT_LE(snapshot.QuantileNs(q), exact * 1.25);
+    }
+
+    for (uint64_t ns : {0ull, 3ull, 4ull, 1000ull, 123456789ull}) {
+        size_t index = LatencyHistogram::BucketIndex(ns);
+        ASSERT_LT(ns, LatencyHistogram::BucketUpperBound(index));
+        if (index > 0) {
+            ASSERT_GE(ns, LatencyHistogram::BucketUpperBound(index - 1));
+        }
+    }
 }
 
 }  // namespace mooncake::test
@@ -7,6 +7,7 @@
 #include <memory>
 #include <random>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include "types.h"
@@ -252,6 +253,117 @@ TEST_F(MasterServiceTest, PutStartEndFlow) {
     EXPECT_EQ(ReplicaStatus::COMPLETE, replica_list[0].status);
 }
 
+TEST_F(MasterServiceTest, PutStartCompressedObject) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    std::string segment_name = "test_segment";
+
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+    std::string key = "test_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+    CompressionInfo compression;
+    compression.codec = CompressionCodec::ZLIB;
+
+    // Raw sizes must match the slices and never be smaller than them
+    compression.raw_sizes = {4096, 4096};
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->PutStart(key, 1024, {1024}, config, replica_list,
+                                 compression));
+    compression.raw_sizes = {512};
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->PutStart(key, 1024, {1024}, config, replica_list,
+                                 compression));
+
+    compression.raw_sizes = {4096};
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart(key, 1024, {1024}, config,
+                                                replica_list, compression));
+    ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+
+    // The encoding is returned to readers
+    ASSERT_EQ(ErrorCode::OK, service_->GetReplicaList(key, replica_list));
+    ASSERT_EQ(1, replica_list.size());
+    EXPECT_TRUE(replica_list[0].is_compressed());
+    EXPECT_EQ(1024, replica_list[0].buffer_descriptors[0].size_);
+    EXPECT_EQ(4096, replica_list[0].data_size());
+}
+
+TEST_F(MasterServiceTest, PutStartDeduplicatesContent) {
+    const uint64_t kv_lease_ttl = 50;
+    std::unique_ptr<MasterService> service_(
+        new MasterService(false, kv_lease_ttl));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    std::string segment_name = "test_segment";
+
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ContentHash hash{0x1234, 0x5678};
+    std::vector<uint64_t> slice_lengths = {1024, 1024};
+
+    // The first object is written as usual
+    std::vector<Replica::Descriptor> first;
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart("key1", 2048, slice_lengths,
+                                                config, first, {}, hash));
+    ASSERT_EQ(ReplicaStatus::PROCESSING, first[0].status);
+
+    // Identical content is not shared before the first put completes
+    std::vector<Replica::Descriptor> second;
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart("key2", 2048, slice_lengths,
+                                                config, second, {}, hash));
+    ASSERT_EQ(ReplicaStatus::PROCESSING, second[0].status);
+    ASSERT_EQ(ErrorCode::OK, service_->PutRevoke("key2"));
+    ASSERT_EQ(ErrorCode::OK, service_->PutEnd("key1"));
+
+    // Afterwards it maps onto the same buffers and is complete at once
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart("key2", 2048, slice_lengths,
+                                                config, second, {}, hash));
+    ASSERT_EQ(1, second.size());
+    EXPECT_EQ(ReplicaStatus::COMPLETE, second[0].status);
+    for (size_t i = 0; i < slice_lengths.size(); ++i) {
+        EXPECT_EQ(first[0].buffer_descriptors[i].buffer_address_,
+                  second[0].buffer_descriptors[i].buffer_address_);
+    }
+
+    // A different raw size is treated as a different object
+    std::vector<Replica::Descriptor> third;
+    ASSERT_EQ(ErrorCode::OK,
+              service_->PutStart("key3", 1024, {1024}, config, third, {}, hash));
+    EXPECT_EQ(ReplicaStatus::PROCESSING, third[0].status);
+    ASSERT_EQ(ErrorCode::OK, service_->PutRevoke("key3"));
+
+    // So is the same size cut into other slices
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart("key3", 2048, {2048}, config,
+                                                third, {}, hash));
+    EXPECT_EQ(ReplicaStatus::PROCESSING, third[0].status);
+    ASSERT_EQ(ErrorCode::OK, service_->PutRevoke("key3"));
+
+    // The shared buffers outlive the object that first wrote them
+    ASSERT_EQ(ErrorCode::OK, service_->Remove("key1"));
+    std::vector<Replica::Descriptor> replica_list;
+    ASSERT_EQ(ErrorCode::OK, service_->GetReplicaList("key2", replica_list));
+    EXPECT_EQ(first[0].buffer_descriptors[0].buffer_address_,
+              replica_list[0].buffer_descriptors[0].buffer_address_);
+
+    // Once no object holds them, the content is written again
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl * 2));
+    ASSERT_EQ(ErrorCode::OK, service_->Remove("key2"));
+    std::vector<Replica::Descriptor> fourth;
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart("key4", 2048, slice_lengths,
+                                                config, fourth, {}, hash));
+    EXPECT_EQ(ReplicaStatus::PROCESSING, fourth[0].status);
+}
+
 TEST_F(MasterServiceTest, RandomPutStartEndFlow) {
     std::unique_ptr<MasterService> service_(new MasterService());
     constexpr size_t buffer = 0x300000000;
@@ -392,6 +504,63 @@ TEST_F(MasterServiceTest, RandomRemoveObject) {
     }
 }
 
+TEST_F(MasterServiceTest, BatchExistKeyAndBatchRemove) {
+    const uint64_t kv_lease_ttl = 50;
+    std::unique_ptr<MasterService> service_(
+        new MasterService(false, kv_lease_ttl));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    std::string segment_name = "test_segment";
+
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+    // Put enough keys to span several shards, leaving every third key missing
+    std::vector<std::string> keys;
+    for (int i = 0; i < 30; ++i) {
+        std::string key = "batch_key_" + std::to_string(i);
+        keys.push_back(key);
+        if (i % 3 == 0) {
+            continue;
+        }
+        std::vector<uint64_t> slice_lengths = {1024};
+        ReplicateConfig config;
+        config.replica_num = 1;
+        std::vector<Replica::Descriptor> replica_list;
+        ASSERT_EQ(ErrorCode::OK, service_->PutStart(key, 1024, slice_lengths,
+                                                    config, replica_list));
+        ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+    }
+
+    auto exist_results = service_->BatchExistKey(keys);
+    ASSERT_EQ(keys.size(), exist_results.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(i % 3 == 0 ? ErrorCode::OBJECT_NOT_FOUND : ErrorCode::OK,
+                  exist_results[i])
+            << "key=" << keys[i];
+    }
+
+    // Wait for the leases granted by BatchExistKey to expire
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl * 2));
+
+    auto remove_results = service_->BatchRemove(keys);
+    ASSERT_EQ(keys.size(), remove_results.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(i % 3 == 0 ? ErrorCode::OBJECT_NOT_FOUND : ErrorCode::OK,
+                  remove_results[i])
+            << "key=" << keys[i];
+    }
+    EXPECT_EQ(0UL, service_->GetKeyCount());
+
+    // Everything is gone now
+    for (auto err : service_->BatchExistKey(keys)) {
+        EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, err);
+    }
+    EXPECT_TRUE(service_->BatchRemove({}).empty());
+}
+
 TEST_F(MasterServiceTest, RemoveAll) {
     const uint64_t kv_lease_ttl = 50;
     std::unique_ptr<MasterService> service_(new MasterService(false, kv_lease_ttl));
@@ -1139,6 +1308,356 @@ TEST_F(MasterServiceTest, TryEvictLeasedObject) {
     service_->RemoveAll();
 }
 
+TEST_F(MasterServiceTest, PinKeyBlocksRemoval) {
+    const uint64_t kv_lease_ttl = 50;
+    std::unique_ptr<MasterService> service_(
+        new MasterService(false, kv_lease_ttl));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    std::string segment_name = "test_segment";
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+    std::string key = "test_key";
+    std::vector<uint64_t> slice_lengths = {1024};
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+
+    // Pinning requires a complete object
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, service_->PinKey(key, client_id, replica_list));
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart(key, 1024, slice_lengths,
+                                                config, replica_list));
+    EXPECT_EQ(ErrorCode::REPLICA_IS_NOT_READY,
+              service_->PinKey(key, client_id, replica_list));
+    ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+
+    // Pin twice, the object stays until both pins are released
+    ASSERT_EQ(ErrorCode::OK, service_->PinKey(key, client_id, replica_list));
+    ASSERT_EQ(1u, replica_list.size());
+    ASSERT_EQ(ErrorCode::OK, service_->PinKey(key, client_id, replica_list));
+    // A client that holds no pin cannot release someone else's
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->UnpinKey(key, generate_uuid()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(key));
+    EXPECT_EQ(0, service_->RemoveAll());
+
+    ASSERT_EQ(ErrorCode::OK, service_->UnpinKey(key, client_id));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(key));
+
+    // The last unpin grants a regular lease
+    ASSERT_EQ(ErrorCode::OK, service_->UnpinKey(key, client_id));
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(key));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS, service_->UnpinKey(key, client_id));
+    EXPECT_EQ(ErrorCode::OK, service_->Remove(key));
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, service_->UnpinKey(key, client_id));
+}
+
+TEST_F(MasterServiceTest, PinReleasedWhenClientExpires) {
+    const uint64_t kv_lease_ttl = 50;
+    const int64_t client_live_ttl_sec = 1;
+    std::unique_ptr<MasterService> service_(new MasterService(
+        false, kv_lease_ttl, DEFAULT_EVICTION_RATIO,
+        DEFAULT_EVICTION_HIGH_WATERMARK_RATIO, 0, client_live_ttl_sec, true));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    Segment segment(generate_uuid(), "test_segment", buffer, size);
+    UUID owner_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, owner_id));
+
+    std::string key = "test_key";
+    std::vector<uint64_t> slice_lengths = {1024};
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart(key, 1024, slice_lengths,
+                                                config, replica_list));
+    ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+
+    // The reader pins the object once and then goes away without unpinning
+    UUID reader_id = generate_uuid();
+    ViewVersionId view_version;
+    ClientStatus client_status;
+    ASSERT_EQ(ErrorCode::OK,
+              service_->Ping(reader_id, view_version, client_status));
+    ASSERT_EQ(ErrorCode::OK, service_->PinKey(key, reader_id, replica_list));
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(key));
+
+    // Keep the owner alive so only the reader expires
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(client_live_ttl_sec + 3);
+    ErrorCode err = ErrorCode::OBJECT_HAS_LEASE;
+    while (err != ErrorCode::OK && std::chrono::steady_clock::now() < deadline) {
+        ASSERT_EQ(ErrorCode::OK,
+                  service_->Ping(owner_id, view_version, client_status));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        err = service_->Remove(key);
+    }
+    EXPECT_EQ(ErrorCode::OK, err);
+}
+
+// Without HA a pin that is never released times out
+TEST_F(MasterServiceTest, PinTimesOutWithoutHA) {
+    const uint64_t kv_lease_ttl = 50;
+    const int64_t client_live_ttl_sec = 1;
+    std::unique_ptr<MasterService> service_(new MasterService(
+        false, kv_lease_ttl, DEFAULT_EVICTION_RATIO,
+        DEFAULT_EVICTION_HIGH_WATERMARK_RATIO, 0, client_live_ttl_sec, false));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    Segment segment(generate_uuid(), "test_segment", buffer, size);
+    UUID owner_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, owner_id));
+
+    std::string key = "test_key";
+    std::vector<uint64_t> slice_lengths = {1024};
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+    ASSERT_EQ(ErrorCode::OK, service_->PutStart(key, 1024, slice_lengths,
+                                                config, replica_list));
+    ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+
+    // The reader pins the object and crashes before unpinning it
+    UUID reader_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->PinKey(key, reader_id, replica_list));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(key));
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(client_live_ttl_sec + 3);
+    ErrorCode err = ErrorCode::OBJECT_HAS_LEASE;
+    while (err != ErrorCode::OK && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        err = service_->Remove(key);
+    }
+    EXPECT_EQ(ErrorCode::OK, err);
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND,
+              service_->UnpinKey(key, reader_id));
+}
+
+TEST_F(MasterServiceTest, DiskTierSpillAndPromote) {
+    const uint64_t kv_lease_ttl = 50;
+    std::unique_ptr<MasterService> service_(
+        new MasterService(false, kv_lease_ttl));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    constexpr size_t object_size = 1024 * 1024;
+    std::string segment_name = "test_segment";
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+    // Polling makes the client the disk tier of its segments
+    std::vector<DiskTask> tasks;
+    ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+    EXPECT_TRUE(tasks.empty());
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+    for (int i = 0; i < 16; ++i) {
+        std::string key = "test_key" + std::to_string(i);
+        ASSERT_EQ(ErrorCode::OK,
+                  service_->PutStart(key, object_size, {object_size}, config,
+                                     replica_list));
+        ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    ASSERT_NE(ErrorCode::OK,
+              service_->PutStart("test_key16", object_size, {object_size},
+                                 config, replica_list));
+
+    // Eviction hands the objects to the owner instead of dropping them
+    for (int i = 0; i < 100 && tasks.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+    }
+    ASSERT_FALSE(tasks.empty());
+    std::vector<std::pair<std::string, DiskLocation>> spilled;
+    for (const auto& task : tasks) {
+        ASSERT_EQ(DiskTaskType::SPILL, task.type);
+        ASSERT_EQ(1u, task.buffers.size());
+        EXPECT_EQ(segment_name, task.buffers[0].segment_name_);
+        DiskLocation location;
+        location.owner = client_id;
+        location.segment_name = segment_name;
+        location.offset = spilled.size() * object_size;
+        location.slice_sizes = {object_size};
+        ASSERT_EQ(ErrorCode::OK, service_->SpillEnd(task.key, location, true));
+        EXPECT_EQ(ErrorCode::OK, service_->ExistKey(task.key));
+        spilled.emplace_back(task.key, location);
+    }
+    // Spilling twice is rejected
+    EXPECT_EQ(ErrorCode::INVALID_WRITE,
+              service_->SpillEnd(spilled[0].first, spilled[0].second, true));
+
+    // A read schedules a promotion into the segment the object came from
+    const auto& [key, location] = spilled[0];
+    ASSERT_EQ(ErrorCode::OK, service_->GetReplicaList(key, replica_list));
+    ASSERT_EQ(2u, replica_list.size());
+    ASSERT_TRUE(replica_list[0].is_on_disk());
+    EXPECT_EQ(location.offset, replica_list[0].disk_location.offset);
+    EXPECT_EQ(ReplicaStatus::PROCESSING, replica_list[1].status);
+
+    ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+    ASSERT_EQ(1u, tasks.size());
+    EXPECT_EQ(DiskTaskType::PROMOTE, tasks[0].type);
+    EXPECT_EQ(key, tasks[0].key);
+    EXPECT_EQ(location.offset, tasks[0].location.offset);
+    ASSERT_EQ(1u, tasks[0].buffers.size());
+    EXPECT_EQ(segment_name, tasks[0].buffers[0].segment_name_);
+    ASSERT_EQ(ErrorCode::OK, service_->PromoteEnd(key, location, true));
+
+    ASSERT_EQ(ErrorCode::OK, service_->GetReplicaList(key, replica_list));
+    ASSERT_EQ(1u, replica_list.size());
+    EXPECT_FALSE(replica_list[0].is_on_disk());
+    EXPECT_EQ(ReplicaStatus::COMPLETE, replica_list[0].status);
+
+    // Removing an object on disk releases its extent
+    if (spilled.size() > 1) {
+        const auto& [disk_key, disk_location] = spilled[1];
+        ASSERT_EQ(ErrorCode::OK, service_->Remove(disk_key));
+        ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+        ASSERT_EQ(1u, tasks.size());
+        EXPECT_EQ(DiskTaskType::DROP, tasks[0].type);
+        EXPECT_EQ(disk_location.offset, tasks[0].location.offset);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    service_->RemoveAll();
+}
+
+// A disk tier that rejects a spill gets room by dropping its oldest objects
+TEST_F(MasterServiceTest, DiskTierReclaimAfterFailedSpill) {
+    const uint64_t kv_lease_ttl = 50;
+    std::unique_ptr<MasterService> service_(
+        new MasterService(false, kv_lease_ttl));
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    constexpr size_t object_size = 1024 * 1024;
+    std::string segment_name = "test_segment";
+    Segment segment(generate_uuid(), segment_name, buffer, size);
+    UUID client_id = generate_uuid();
+    ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+    std::vector<DiskTask> tasks;
+    ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<Replica::Descriptor> replica_list;
+    int next_key = 0;
+    auto fill_memory = [&]() {
+        for (int i = 0; i < 32; ++i) {
+            std::string key = "test_key" + std::to_string(next_key++);
+            if (service_->PutStart(key, object_size, {object_size}, config,
+                                   replica_list) != ErrorCode::OK) {
+                break;
+            }
+            ASSERT_EQ(ErrorCode::OK, service_->PutEnd(key));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+        ASSERT_NE(ErrorCode::OK,
+                  service_->PutStart("no_space", object_size, {object_size},
+                                     config, replica_list));
+    };
+    DiskLocation location;
+    location.owner = client_id;
+    location.segment_name = segment_name;
+    location.slice_sizes = {object_size};
+
+    // The first objects make it to disk
+    fill_memory();
+    for (int i = 0; i < 100 && tasks.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+    }
+    ASSERT_FALSE(tasks.empty());
+    std::unordered_set<std::string> spilled;
+    for (const auto& task : tasks) {
+        ASSERT_EQ(DiskTaskType::SPILL, task.type);
+        location.offset = spilled.size() * object_size;
+        ASSERT_EQ(ErrorCode::OK, service_->SpillEnd(task.key, location, true));
+        spilled.insert(task.key);
+    }
+
+    // The next one finds the disk full. Only that spill fails, the disk
+    // tier keeps polling without answering the later ones.
+    fill_memory();
+    bool failed = false;
+    std::string dropped_key;
+    for (int i = 0; i < 300 && dropped_key.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_EQ(ErrorCode::OK, service_->FetchDiskTasks(client_id, tasks));
+        for (const auto& task : tasks) {
+            if (task.type == DiskTaskType::SPILL && !failed) {
+                EXPECT_EQ(ErrorCode::OK,
+                          service_->SpillEnd(task.key, location, false));
+                failed = true;
+            } else if (task.type == DiskTaskType::DROP) {
+                dropped_key = task.key;
+            }
+        }
+    }
+    ASSERT_TRUE(failed);
+    ASSERT_FALSE(dropped_key.empty());
+    EXPECT_TRUE(spilled.count(dropped_key));
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, service_->ExistKey(dropped_key));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    service_->RemoveAll();
+}
+
+TEST_F(MasterServiceTest, LongestCachedPrefix) {
+    const uint64_t kv_lease_ttl = 50;
+    for (bool enable_prefix_index : {false, true}) {
+        std::unique_ptr<MasterService> service_(new MasterService(
+            false, kv_lease_ttl, DEFAULT_EVICTION_RATIO,
+            DEFAULT_EVICTION_HIGH_WATERMARK_RATIO, 0,
+            DEFAULT_CLIENT_LIVE_TTL_SEC, false, enable_prefix_index));
+        constexpr size_t buffer = 0x300000000;
+        constexpr size_t size = 1024 * 1024 * 16;
+        Segment segment(generate_uuid(), "test_segment", buffer, size);
+        UUID client_id = generate_uuid();
+        ASSERT_EQ(ErrorCode::OK, service_->MountSegment(segment, client_id));
+
+        std::vector<std::string> chain;
+        std::string parent;
+        for (int i = 0; i < 6; ++i) {
+            std::string block = "hash" + std::to_string(i);
+            chain.push_back(parent + "/" + block);
+            parent = block;
+        }
+        EXPECT_EQ(0u, service_->LongestCachedPrefix(chain));
+
+        ReplicateConfig config;
+        config.replica_num = 1;
+        std::vector<Replica::Descriptor> replica_list;
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_EQ(ErrorCode::OK,
+                      service_->PutStart(chain[i], 1024, {1024}, config,
+                                         replica_list));
+            ASSERT_EQ(ErrorCode::OK, service_->PutEnd(chain[i]));
+        }
+        // An incomplete block ends the prefix
+        ASSERT_EQ(ErrorCode::OK, service_->PutStart(chain[4], 1024, {1024},
+                                                    config, replica_list));
+        EXPECT_EQ(4u, service_->LongestCachedPrefix(chain));
+        EXPECT_EQ(0u, service_->LongestCachedPrefix({}));
+
+        // The matched blocks are leased
+        EXPECT_EQ(ErrorCode::OBJECT_HAS_LEASE, service_->Remove(chain[0]));
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+        ASSERT_EQ(ErrorCode::OK, service_->Remove(chain[2]));
+        EXPECT_EQ(2u, service_->LongestCachedPrefix(chain));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+        service_->RemoveAll();
+    }
+}
+
 }  // namespace mooncake::test
 
 int main(int argc, char** argv) {
@@ -0,0 +1,109 @@
+// prefix_index_test.cpp
+#include "prefix_index.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake {
+
+// Keys of a chain of blocks b0, b1, ...
+static std::vector<std::string> MakeChain(const std::string& prefix,
+                                          size_t length) {
+    std::vector<std::string> keys;
+    std::string parent;
+    for (size_t i = 0; i < length; ++i) {
+        std::string block = prefix + std::to_string(i);
+        keys.push_back(parent + PrefixIndex::kSeparator + block);
+        parent = block;
+    }
+    return keys;
+}
+
+TEST(PrefixIndexTest, ParseKey) {
+    std::string_view parent, block;
+    ASSERT_TRUE(PrefixIndex::ParseKey("a/b", parent, block));
+    EXPECT_EQ(parent, "a");
+    EXPECT_EQ(block, "b");
+    ASSERT_TRUE(PrefixIndex::ParseKey("/b", parent, block));
+    EXPECT_EQ(parent, "");
+    EXPECT_EQ(block, "b");
+    EXPECT_FALSE(PrefixIndex::ParseKey("plain_key", parent, block));
+    EXPECT_FALSE(PrefixIndex::ParseKey("a/", parent, block));
+    EXPECT_FALSE(PrefixIndex::ParseKey("a/a", parent, block));
+}
+
+TEST(PrefixIndexTest, MatchLongestPrefix) {
+    PrefixIndex index;
+    auto chain = MakeChain("b", 8);
+    EXPECT_EQ(index.Match(chain), 0u);
+
+    for (size_t i = 0; i < 5; ++i) {
+        index.Insert(chain[i]);
+    }
+    index.Insert("plain_key");
+    EXPECT_EQ(index.size(), 5u);
+    EXPECT_EQ(index.Match(chain), 5u);
+    EXPECT_EQ(index.Match({}), 0u);
+
+    // A chain may start in the middle
+    std::vector<std::string> tail(chain.begin() + 2, chain.end());
+    EXPECT_EQ(index.Match(tail), 3u);
+
+    // Keys that do not follow each other break the chain
+    std::vector<std::string> broken = {chain[0], chain[2]};
+    EXPECT_EQ(index.Match(broken), 1u);
+    // The same block under another parent does not match
+    std::vector<std::string> other_parent = {chain[0], "x/b1"};
+    EXPECT_EQ(index.Match(other_parent), 1u);
+}
+
+TEST(PrefixIndexTest, EraseAndReinsert) {
+    PrefixIndex index;
+    auto chain = MakeChain("b", 4);
+    for (const auto& key : chain) {
+        index.Insert(key);
+    }
+
+    index.Erase(chain[1]);
+    EXPECT_EQ(index.size(), 3u);
+    EXPECT_EQ(index.Match(chain), 1u);
+    index.Insert(chain[1]);
+    EXPECT_EQ(index.Match(chain), 4u);
+
+    // Erasing with the wrong parent is a no-op
+    index.Erase("x/b2");
+    EXPECT_EQ(index.Match(chain), 4u);
+
+    for (const auto& key : chain) {
+        index.Erase(key);
+    }
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_TRUE(index.Keys().empty());
+}
+
+TEST(PrefixIndexTest, ChildBeforeParent) {
+    PrefixIndex index;
+    auto chain = MakeChain("b", 3);
+    index.Insert(chain[2]);
+    index.Insert(chain[1]);
+    EXPECT_EQ(index.Match(chain), 0u);
+    index.Insert(chain[0]);
+    EXPECT_EQ(index.Match(chain), 3u);
+
+    // Moving a block under another parent releases the old one
+    index.Erase(chain[0]);
+    index.Insert("x/b1");
+    std::vector<std::string> moved = {"x/b1", chain[2]};
+    EXPECT_EQ(index.Match(moved), 2u);
+    EXPECT_EQ(index.Match(chain), 0u);
+
+    auto keys = index.Keys();
+    EXPECT_EQ(keys.size(), 2u);
+    index.Erase("x/b1");
+    index.Erase(chain[2]);
+    EXPECT_EQ(index.size(), 0u);
+}
+
+}  // namespace mooncake
@@ -0,0 +1,135 @@
+#include "replica_selector.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+class ReplicaSelectorTest : public ::testing::Test {
+   protected:
+    static constexpr const char* kLocalSegment = "10.0.0.1:17812";
+
+    void SetUp() override {
+        selector_ = std::make_unique<ReplicaSelector>(kLocalSegment);
+    }
+
+    // Helper function to create a replica whose buffers live on the given
+    // segments
+    static Replica::Descriptor MakeReplica(
+        const std::vector<std::string>& segments,
+        ReplicaStatus status = ReplicaStatus::COMPLETE) {
+        Replica::Descriptor replica;
+        replica.status = status;
+        for (const auto& segment : segments) {
+            replica.buffer_descriptors.push_back(
+                {segment, 1024, 0x1000, BufStatus::COMPLETE});
+        }
+        return replica;
+    }
+
+    std::unique_ptr<ReplicaSelector> selector_;
+};
+
+// Test that no replica is selected when none is complete
+TEST_F(ReplicaSelectorTest, NoCompleteReplica) {
+    std::vector<Replica::Descriptor> replicas{
+        MakeReplica({"10.0.0.2:17812"}, ReplicaStatus::PROCESSING),
+        MakeReplica({kLocalSegment}, ReplicaStatus::INITIALIZED)};
+    EXPECT_FALSE(selector_->Select(replicas).has_value());
+    EXPECT_FALSE(selector_->Select({}).has_value());
+}
+
+// Test locality classification
+TEST_F(ReplicaSelectorTest, Locality) {
+    EXPECT_EQ(selector_->GetLocality(MakeReplica({kLocalSegment})),
+              ReplicaSelector::Locality::LOCAL);
+    EXPECT_EQ(
+        selector_->GetLocality(MakeReplica({kLocalSegment, "10.0.0.1:17813"})),
+        ReplicaSelector::Locality::SAME_HOST);
+    EXPECT_EQ(
+        selector_->GetLocality(MakeReplica({kLocalSegment, "10.0.0.2:17812"})),
+        ReplicaSelector::Locality::REMOTE);
+}
+
+// Test that the local replica wins over same-host and remote replicas
+TEST_F(ReplicaSelectorTest, PrefersLocality) {
+    std::vector<Replica::Descriptor> replicas{
+        MakeReplica({"10.0.0.2:17812"}), MakeReplica({"10.0.0.1:17813"}),
+        MakeReplica({kLocalSegment})};
+    for (int i = 0; i < 20; ++i) {
+        auto idx = selector_->Select(replicas);
+        ASSERT_TRUE(idx.has_value());
+        EXPECT_EQ(*idx, 2u);
+    }
+
+    replicas.pop_back();
+    for (int i = 0; i < 20; ++i) {
+        auto idx = selector_->Select(replicas);
+        ASSERT_TRUE(idx.has_value());
+        EXPECT_EQ(*idx, 1u);
+    }
+}
+
+// Test that incomplete replicas are skipped even if they are local
+TEST_F(ReplicaSelectorTest, SkipsIncompleteLocalReplica) {
+    std::vector<Replica::Descriptor> replicas{
+        MakeReplica({kLocalSegment}, ReplicaStatus::PROCESSING),
+        MakeReplica({"10.0.0.2:17812"})};
+    auto idx = selector_->Select(replicas);
+    ASSERT_TRUE(idx.has_value());
+    EXPECT_EQ(*idx, 1u);
+}
+
+// Test that remote replicas with reads in flight are avoided
+TEST_F(ReplicaSelectorTest, PrefersLeastLoadedRemote) {
+    std::vector<Replica::Descriptor> replicas{
+        MakeReplica({"10.0.0.2:17812"}), MakeReplica({"10.0.0.3:17812"})};
+
+    auto guard = selector_->Acquire(replicas[0]);
+    EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 1);
+    for (int i = 0; i < 20; ++i) {
+        auto idx = selector_->Select(replicas);
+        ASSERT_TRUE(idx.has_value());
+        EXPECT_EQ(*idx, 1u);
+    }
+
+    guard.reset();
+    EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 0);
+}
+
+// Test that equally good replicas are all chosen over time
+TEST_F(ReplicaSelectorTest, SpreadsTies) {
+    std::vector<Replica::Descriptor> replicas{
+        MakeReplica({"10.0.0.2:17812"}), MakeReplica({"10.0.0.3:17812"}),
+        MakeReplica({"10.0.0.4:17812"})};
+    std::set<size_t> chosen;
+    for (int i = 0; i < 200; ++i) {
+        auto idx = selector_->Select(replicas);
+        ASSERT_TRUE(idx.has_value());
+        chosen.insert(*idx);
+    }
+    EXPECT_EQ(chosen.size(), replicas.size());
+}
+
+// Test that guards count each segment once and release on destruction
+TEST_F(ReplicaSelectorTest, LoadGuardLifetime) {
+    auto replica = MakeReplica({"10.0.0.2:17812", "10.0.0.2:17812"});
+    {
+        auto guard1 = selector_->Acquire(replica);
+        EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 1);
+        auto guard2 = selector_->Acquire(replica);
+        EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 2);
+
+        ReplicaSelector::LoadGuard moved = std::move(guard1);
+        EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 2);
+    }
+    EXPECT_EQ(selector_->GetInflight("10.0.0.2:17812"), 0);
+}
+
+}  // namespace mooncake
@@ -1,6 +1,7 @@
 // transfer_task_test.cpp
 #include "transfer_task.h"
 
+#include <async_simple/coro/SyncAwait.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -69,6 +70,97 @@ TEST_F(TransferTaskTest, MemcpyOperationState) {
     EXPECT_EQ(state->get_result(), ErrorCode::OK);
 }
 
+// A waiter that times out fails the operation, a late completion is ignored
+TEST_F(TransferTaskTest, OperationStateFailIfIncomplete) {
+    auto state = std::make_shared<MemcpyOperationState>();
+    state->fail_if_incomplete(ErrorCode::TRANSFER_FAIL);
+    EXPECT_TRUE(state->is_completed());
+    EXPECT_EQ(state->get_result(), ErrorCode::TRANSFER_FAIL);
+
+    state->set_completed(ErrorCode::OK);
+    EXPECT_EQ(state->get_result(), ErrorCode::TRANSFER_FAIL);
+
+    // Completed operations keep their result
+    auto done = std::make_shared<MemcpyOperationState>();
+    done->set_completed(ErrorCode::OK);
+    done->fail_if_incomplete(ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(done->get_result(), ErrorCode::OK);
+}
+
+// The continuation runs once, when the inner operation is seen completed
+TEST_F(TransferTaskTest, ContinuationOperationState) {
+    auto inner = std::make_shared<MemcpyOperationState>();
+    int runs = 0;
+    auto state = std::make_shared<ContinuationOperationState>(
+        TransferFuture(inner), [&runs]() {
+            ++runs;
+            return ErrorCode::INVALID_READ;
+        });
+    EXPECT_FALSE(state->is_completed());
+    EXPECT_EQ(runs, 0);
+
+    inner->set_completed(ErrorCode::OK);
+    EXPECT_TRUE(state->is_completed());
+    EXPECT_TRUE(state->is_completed());
+    state->wait_for_completion();
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(state->get_result(), ErrorCode::INVALID_READ);
+
+    // A failed inner operation skips the continuation
+    auto failed = std::make_shared<MemcpyOperationState>();
+    failed->set_completed(ErrorCode::TRANSFER_FAIL);
+    TransferFuture future(std::make_shared<ContinuationOperationState>(
+        TransferFuture(failed), [&runs]() {
+            ++runs;
+            return ErrorCode::OK;
+        }));
+    EXPECT_EQ(future.get(), ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(runs, 1);
+}
+
+// Progress callbacks run on completion, or right away once completed
+TEST_F(TransferTaskTest, NotifyProgress) {
+    auto inner = std::make_shared<MemcpyOperationState>();
+    auto state = std::make_shared<ContinuationOperationState>(
+        TransferFuture(inner), []() { return ErrorCode::OK; });
+    int inner_calls = 0;
+    int calls = 0;
+    inner->notify_progress([&inner_calls]() { ++inner_calls; });
+    state->notify_progress([&calls]() { ++calls; });
+    EXPECT_EQ(inner_calls, 0);
+    EXPECT_EQ(calls, 0);
+
+    // The continuation waits on the inner operation
+    inner->set_completed(ErrorCode::OK);
+    EXPECT_EQ(inner_calls, 1);
+    EXPECT_EQ(calls, 1);
+
+    EXPECT_TRUE(state->is_completed());
+    state->notify_progress([&calls]() { ++calls; });
+    EXPECT_EQ(calls, 2);
+
+    auto failed = std::make_shared<MemcpyOperationState>();
+    failed->notify_progress([&calls]() { ++calls; });
+    failed->fail_if_incomplete(ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(calls, 3);
+}
+
+// asyncWait resumes on completion instead of the recheck timer
+TEST_F(TransferTaskTest, AsyncWaitResumesOnCompletion) {
+    auto state = std::make_shared<MemcpyOperationState>();
+    TransferFuture future(state);
+    std::thread completer([state]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        state->set_completed(ErrorCode::OK);
+    });
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(async_simple::coro::syncAwait(future.asyncWait()),
+              ErrorCode::OK);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(100));
+    completer.join();
+}
+
 // Test MemcpyWorkerPool basic functionality
 TEST_F(TransferTaskTest, MemcpyWorkerPoolBasic) {
     MemcpyWorkerPool pool;
@@ -144,6 +236,57 @@ TEST_F(TransferTaskTest, MemcpyWorkerPoolMultipleOperations) {
     }
 }
 
+// Test that large operations are split into chunks across several workers
+TEST_F(TransferTaskTest, MemcpyWorkerPoolChunkedCopy) {
+    MemcpyWorkerPool pool(4);
+    EXPECT_EQ(pool.numWorkers(), 4u);
+
+    // Sizes that are not multiples of the chunk size, plus a small one that
+    // gets packed together with the tail of the previous operation
+    const std::vector<size_t> sizes{
+        3 * MemcpyWorkerPool::kMemcpyChunkSize + 4097, 1000,
+        MemcpyWorkerPool::kMemcpyChunkSize - 1};
+
+    std::vector<std::vector<char>> src_buffers(sizes.size());
+    std::vector<std::vector<char>> dest_buffers(sizes.size());
+    std::vector<MemcpyOperation> operations;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        src_buffers[i].resize(sizes[i]);
+        for (size_t j = 0; j < sizes[i]; ++j) {
+            src_buffers[i][j] = static_cast<char>(j * 7 + i);
+        }
+        dest_buffers[i].resize(sizes[i], 'Z');
+        operations.emplace_back(dest_buffers[i].data(), src_buffers[i].data(),
+                                sizes[i]);
+    }
+
+    auto state = std::make_shared<MemcpyOperationState>();
+    pool.submitTask(MemcpyTask(std::move(operations), state));
+    state->wait_for_completion();
+
+    EXPECT_EQ(state->get_result(), ErrorCode::OK);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        EXPECT_EQ(dest_buffers[i], src_buffers[i]);
+    }
+}
+
+// Test that small tasks are completed inline by the submitting thread
+TEST_F(TransferTaskTest, MemcpyWorkerPoolInlineSmallTask) {
+    MemcpyWorkerPool pool(2);
+
+    std::vector<char> src(1024, 'S');
+    std::vector<char> dest(1024, 'D');
+    std::vector<MemcpyOperation> operations;
+    operations.emplace_back(dest.data(), src.data(), src.size());
+
+    auto state = std::make_shared<MemcpyOperationState>();
+    pool.submitTask(MemcpyTask(std::move(operations), state));
+
+    EXPECT_TRUE(state->is_completed());
+    EXPECT_EQ(state->get_result(), ErrorCode::OK);
+    EXPECT_EQ(dest, src);
+}
+
 // Test TransferStrategy enum and stream operator
 TEST_F(TransferTaskTest, TransferStrategyEnum) {
     // Test enum values
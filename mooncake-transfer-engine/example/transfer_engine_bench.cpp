@@ -17,11 +17,14 @@
 #include <signal.h>
 #include <sys/time.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -65,8 +68,10 @@ DEFINE_string(local_server_name, mooncake::getHostname(),
               "Local server name for segment discovery");
 DEFINE_string(metadata_server, "192.168.3.77:2379", "etcd server host address");
 DEFINE_string(mode, "initiator",
-              "Running mode: initiator or target. Initiator node read/write "
-              "data blocks from target node");
+              "Running mode: initiator, target or loopback. Initiator node "
+              "read/write data blocks from target node. Loopback runs both in "
+              "this process over TCP on localhost with CPU memory, neither "
+              "metadata server nor RDMA NIC is needed");
 DEFINE_string(operation, "read", "Operation type: read or write");
 
 DEFINE_string(protocol, "rdma", "Transfer protocol: rdma|tcp");
@@ -173,6 +178,32 @@ static inline std::string calculateRate(uint64_t data_bytes, double duration) {
 volatile bool running = true;
 std::atomic<size_t> total_batch_count(0);
 
+// Time from submitting a batch to the completion of all its requests
+std::mutex batch_latency_mutex;
+std::vector<uint64_t> batch_latency_us;
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+    return sorted[index];
+}
+
+static void reportBatchLatency() {
+    std::vector<uint64_t> latency;
+    {
+        std::lock_guard<std::mutex> lock(batch_latency_mutex);
+        latency.swap(batch_latency_us);
+    }
+    if (latency.empty()) return;
+    std::sort(latency.begin(), latency.end());
+    uint64_t sum = 0;
+    for (auto value : latency) sum += value;
+    LOG(INFO) << "Batch latency (us): avg " << sum / latency.size() << ", p50 "
+              << percentile(latency, 0.5) << ", p99 "
+              << percentile(latency, 0.99) << ", p999 "
+              << percentile(latency, 0.999) << ", max " << latency.back();
+}
+
 Status initiatorWorker(TransferEngine *engine, SegmentID segment_id,
                        int thread_id, void *addr) {
     bindToSocket(thread_id % NR_SOCKETS);
@@ -195,6 +226,7 @@ Status initiatorWorker(TransferEngine *engine, SegmentID segment_id,
         (uint64_t)segment_desc->buffers[thread_id % NR_SOCKETS].addr;
 
     size_t batch_count = 0;
+    std::vector<uint64_t> latency_us;
     while (running) {
         auto batch_id = engine->allocateBatchID(FLAGS_batch_size);
         Status s;
@@ -212,6 +244,7 @@ Status initiatorWorker(TransferEngine *engine, SegmentID segment_id,
             requests.emplace_back(entry);
         }
 
+        auto start_ts = std::chrono::steady_clock::now();
         s = engine->submitTransfer(batch_id, requests);
         if (!s.ok()) LOG(ERROR) << s.ToString();
         LOG_ASSERT(s.ok());
@@ -231,12 +264,22 @@ Status initiatorWorker(TransferEngine *engine, SegmentID segment_id,
             }
         }
 
+        latency_us.push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_ts)
+                .count());
+
         s = engine->freeBatchID(batch_id);
         LOG_ASSERT(s.ok());
         batch_count++;
     }
     LOG(INFO) << "Worker " << thread_id << " stopped!";
     total_batch_count.fetch_add(batch_count);
+    {
+        std::lock_guard<std::mutex> lock(batch_latency_mutex);
+        batch_latency_us.insert(batch_latency_us.end(), latency_us.begin(),
+                                latency_us.end());
+    }
     return Status::OK();
 }
 
@@ -279,6 +322,39 @@ std::string loadNicPriorityMatrix() {
            device_names + "], []]}";
 }
 
+static void runWorkers(TransferEngine *engine, SegmentID segment_id,
+                       const std::vector<void *> &addr) {
+    int buffer_num = addr.size();
+    std::thread workers[FLAGS_threads];
+
+    struct timeval start_tv, stop_tv;
+    gettimeofday(&start_tv, nullptr);
+
+    for (int i = 0; i < FLAGS_threads; ++i)
+        workers[i] = std::thread(initiatorWorker, engine, segment_id, i,
+                                 addr[i % buffer_num]);
+
+    sleep(FLAGS_duration);
+    running = false;
+
+    for (int i = 0; i < FLAGS_threads; ++i) workers[i].join();
+
+    gettimeofday(&stop_tv, nullptr);
+    auto duration = (stop_tv.tv_sec - start_tv.tv_sec) +
+                    (stop_tv.tv_usec - start_tv.tv_usec) / 1000000.0;
+    auto batch_count = total_batch_count.load();
+
+    LOG(INFO) << "numa node num: " << NR_SOCKETS;
+
+    LOG(INFO) << "Test completed: duration " << std::fixed
+              << std::setprecision(2) << duration << ", batch count "
+              << batch_count << ", throughput "
+              << calculateRate(
+                     batch_count * FLAGS_batch_size * FLAGS_block_size,
+                     duration);
+    reportBatchLatency();
+}
+
 int initiator() {
     // disable topology auto discovery for testing.
     auto engine = std::make_unique<TransferEngine>(FLAGS_auto_discovery);
@@ -327,34 +403,7 @@ int initiator() {
 #endif
 
     auto segment_id = engine->openSegment(FLAGS_segment_id.c_str());
-
-    std::thread workers[FLAGS_threads];
-
-    struct timeval start_tv, stop_tv;
-    gettimeofday(&start_tv, nullptr);
-
-    for (int i = 0; i < FLAGS_threads; ++i)
-        workers[i] = std::thread(initiatorWorker, engine.get(), segment_id, i,
-                                 addr[i % buffer_num]);
-
-    sleep(FLAGS_duration);
-    running = false;
-
-    for (int i = 0; i < FLAGS_threads; ++i) workers[i].join();
-
-    gettimeofday(&stop_tv, nullptr);
-    auto duration = (stop_tv.tv_sec - start_tv.tv_sec) +
-                    (stop_tv.tv_usec - start_tv.tv_usec) / 1000000.0;
-    auto batch_count = total_batch_count.load();
-
-    LOG(INFO) << "numa node num: " << NR_SOCKETS;
-
-    LOG(INFO) << "Test completed: duration " << std::fixed
-              << std::setprecision(2) << duration << ", batch count "
-              << batch_count << ", throughput "
-              << calculateRate(
-                     batch_count * FLAGS_batch_size * FLAGS_block_size,
-                     duration);
+    runWorkers(engine.get(), segment_id, addr);
 
     for (int i = 0; i < buffer_num; ++i) {
         engine->unregisterLocalMemory(addr[i]);
@@ -434,6 +483,49 @@ int target() {
     return 0;
 }
 
+static std::unique_ptr<TransferEngine> loopbackEngine(
+    std::vector<void *> &addr) {
+    auto engine = std::make_unique<TransferEngine>(false);
+    // Listens on a free port of localhost, peers are found by handshake
+    int rc = engine->init(P2PHANDSHAKE, "127.0.0.1", "127.0.0.1",
+                          getDefaultHandshakePort());
+    LOG_ASSERT(!rc);
+    Transport *xport = engine->installTransport("tcp", nullptr);
+    LOG_ASSERT(xport);
+    for (size_t i = 0; i < addr.size(); ++i) {
+        addr[i] = allocateMemoryPool(FLAGS_buffer_size, i, false);
+        rc = engine->registerLocalMemory(addr[i], FLAGS_buffer_size,
+                                         "cpu:" + std::to_string(i));
+        LOG_ASSERT(!rc);
+    }
+    return engine;
+}
+
+int loopback() {
+    if (FLAGS_protocol != "tcp") {
+        LOG(INFO) << "Loopback mode always uses the tcp protocol";
+    }
+    std::vector<void *> target_addr(NR_SOCKETS, nullptr);
+    std::vector<void *> initiator_addr(NR_SOCKETS, nullptr);
+    auto target_engine = loopbackEngine(target_addr);
+    auto initiator_engine = loopbackEngine(initiator_addr);
+
+    auto segment_id =
+        initiator_engine->openSegment(target_engine->getLocalIpAndPort());
+    LOG(INFO) << "Loopback " << FLAGS_operation << ": threads "
+              << FLAGS_threads << ", batch size " << FLAGS_batch_size
+              << ", block size " << FLAGS_block_size;
+    runWorkers(initiator_engine.get(), segment_id, initiator_addr);
+
+    for (int i = 0; i < NR_SOCKETS; ++i) {
+        initiator_engine->unregisterLocalMemory(initiator_addr[i]);
+        freeMemoryPool(initiator_addr[i], FLAGS_buffer_size);
+        target_engine->unregisterLocalMemory(target_addr[i]);
+        freeMemoryPool(target_addr[i], FLAGS_buffer_size);
+    }
+    return 0;
+}
+
 void check_total_buffer_size() {
     uint64_t require_size = FLAGS_block_size * FLAGS_batch_size * FLAGS_threads;
     if (FLAGS_buffer_size < require_size) {
@@ -452,7 +544,10 @@ int main(int argc, char **argv) {
         return initiator();
     else if (FLAGS_mode == "target")
         return target();
+    else if (FLAGS_mode == "loopback")
+        return loopback();
 
-    LOG(ERROR) << "Unsupported mode: must be 'initiator' or 'target'";
+    LOG(ERROR)
+        << "Unsupported mode: must be 'initiator', 'target' or 'loopback'";
     exit(EXIT_FAILURE);
 }
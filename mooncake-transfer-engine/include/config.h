@@ -46,6 +46,9 @@ struct GlobalConfig {
     bool trace = false;
     int64_t slice_timeout = -1;
     bool use_ipv6 = false;
+    size_t tcp_connections_per_peer = 4;
+    size_t tcp_socket_buffer_size = 0;  // 0 leaves it to the kernel
+    size_t tcp_io_threads = 0;          // 0 picks 4 per NUMA node
 };
 
 void loadGlobalConfig(GlobalConfig &config);
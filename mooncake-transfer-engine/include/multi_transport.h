@@ -15,6 +15,8 @@
 #ifndef MULTI_TRANSPORT_H_
 #define MULTI_TRANSPORT_H_
 
+#include <chrono>
+#include <functional>
 #include <unordered_map>
 
 #include "transport/transport.h"
@@ -46,6 +48,22 @@ class MultiTransport {
 
     Status getBatchTransferStatus(BatchID batch_id, TransferStatus &status);
 
+    /// @brief Current completion epoch of a batch. It changes every time a
+    /// task of the batch finishes.
+    uint64_t getCompletionEpoch(BatchID batch_id);
+
+    /// @brief Sleep until the completion epoch of a batch differs from epoch
+    /// or the timeout expires. Read the epoch before checking the transfer
+    /// status so that a completion in between is not missed.
+    void waitTransferCompletion(BatchID batch_id, uint64_t epoch,
+                                std::chrono::microseconds timeout);
+
+    /// @brief Call callback once the completion epoch of a batch differs
+    /// from epoch, right away if it already does. It may run on a transport
+    /// thread with the batch locked, so it must only hand the work off.
+    void addCompletionCallback(BatchID batch_id, uint64_t epoch,
+                               std::function<void()> callback);
+
     Transport *installTransport(const std::string &proto,
                                 std::shared_ptr<Topology> topo);
 
@@ -0,0 +1,163 @@
+// Copyright 2024 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mooncake {
+
+/// A span of a sampled request, e.g. one RPC or one transfer.
+struct TraceEvent {
+    uint64_t trace_id;
+    const char *name;  // Must have static storage duration
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint32_t tid;
+};
+
+/// Records the spans of sampled requests. A request is sampled where it
+/// enters the system (e.g. Client::Get), and its trace id is passed along to
+/// the master and the transfer engine, which record their own spans under the
+/// same id. Timestamps are taken from the wall clock, so that traces dumped
+/// by different processes of one host line up.
+///
+/// Every thread records into its own ring of kRingSize events without locks;
+/// the oldest events are overwritten. The ring of an exited thread is handed
+/// to the next new thread, so there are only as many rings as threads ever
+/// recorded at once. Dumping reads all rings concurrently with recording and
+/// skips events overwritten meanwhile.
+class Tracer {
+   public:
+    static constexpr size_t kRingSize = 8192;
+
+    static Tracer &instance();
+
+    /// @brief Decide whether to trace a new request.
+    /// @return A new trace id, or 0 if the request is not sampled.
+    uint64_t sample();
+
+    /// @brief Fraction of requests to sample, in [0, 1]. Initialized from
+    /// MC_TRACE_SAMPLE_RATE, tracing is off by default.
+    void setSampleRate(double rate);
+    double sampleRate() const;
+
+    void record(uint64_t trace_id, const char *name, uint64_t start_ns,
+                uint64_t end_ns);
+
+    /// @brief Events currently held by the rings, oldest first per ring.
+    std::vector<TraceEvent> events() const;
+
+    /// @brief Number of rings allocated so far.
+    size_t ringCount() const;
+
+    /// @brief Events in the Chrome trace event format, which can be loaded
+    /// into chrome://tracing or Perfetto.
+    std::string dumpChromeTrace() const;
+
+    /// @return 0 on success, -1 if the file cannot be written.
+    int dumpChromeTrace(const std::string &path) const;
+
+    static uint64_t nowNs();
+
+    /// @brief Trace id of the request the calling thread works on, 0 if none.
+    static uint64_t currentTraceId();
+
+   private:
+    friend class TraceScope;
+
+    struct Slot {
+        // Index of the event plus one once written, 0 while being written
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> trace_id{0};
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+        std::atomic<uint32_t> tid{0};
+    };
+
+    struct Ring {
+        uint32_t tid = 0;  // Thread currently recording into the ring
+        std::atomic<uint64_t> head{0};
+        std::array<Slot, kRingSize> slots;
+    };
+
+    Tracer();
+
+    Ring &threadRing();
+
+    std::atomic<uint64_t> sample_threshold_{0};
+    mutable std::mutex rings_mutex_;
+    // Rings outlive their threads, so that their events can still be dumped
+    std::vector<std::shared_ptr<Ring>> rings_;
+    // Rings of exited threads, to be reused by new threads
+    std::vector<std::shared_ptr<Ring>> free_rings_;
+
+    static thread_local uint64_t current_trace_id_;
+};
+
+/// Makes trace_id the current trace of the thread for its lifetime. Must not
+/// span a suspension point of a coroutine, which may resume on another
+/// thread.
+class TraceScope {
+   public:
+    explicit TraceScope(uint64_t trace_id)
+        : prev_(Tracer::current_trace_id_) {
+        Tracer::current_trace_id_ = trace_id;
+    }
+    ~TraceScope() { Tracer::current_trace_id_ = prev_; }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+   private:
+    uint64_t prev_;
+};
+
+/// Records its lifetime as a span named name, if trace_id is set.
+class TraceSpan {
+   public:
+    explicit TraceSpan(const char *name,
+                       uint64_t trace_id = Tracer::currentTraceId())
+        : name_(name),
+          trace_id_(trace_id),
+          start_ns_(trace_id ? Tracer::nowNs() : 0) {}
+
+    ~TraceSpan() {
+        if (trace_id_) {
+            Tracer::instance().record(trace_id_, name_, start_ns_,
+                                      Tracer::nowNs());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+   private:
+    const char *name_;
+    uint64_t trace_id_;
+    uint64_t start_ns_;
+};
+
+}  // namespace mooncake
+
+#endif  // TRACE_H_
@@ -138,6 +138,21 @@ class TransferEngine {
         return result;
     }
 
+    uint64_t getCompletionEpoch(BatchID batch_id) {
+        return multi_transports_->getCompletionEpoch(batch_id);
+    }
+
+    void waitTransferCompletion(BatchID batch_id, uint64_t epoch,
+                                std::chrono::microseconds timeout) {
+        multi_transports_->waitTransferCompletion(batch_id, epoch, timeout);
+    }
+
+    void addCompletionCallback(BatchID batch_id, uint64_t epoch,
+                               std::function<void()> callback) {
+        multi_transports_->addCompletionCallback(batch_id, epoch,
+                                                 std::move(callback));
+    }
+
     Status getBatchTransferStatus(BatchID batch_id, TransferStatus &status) {
         Status result = multi_transports_->getBatchTransferStatus(batch_id, status);
 #ifdef WITH_METRICS
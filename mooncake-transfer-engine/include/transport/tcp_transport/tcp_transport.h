@@ -34,6 +34,7 @@
 namespace mooncake {
 class TransferMetadata;
 class TcpContext;
+class OutgoingConnection;
 
 class TcpTransport : public Transport {
    public:
@@ -76,16 +77,33 @@ class TcpTransport : public Transport {
     int unregisterLocalMemoryBatch(
         const std::vector<void *> &addr_list) override;
 
-    void worker();
+    // Runs the io_context of thread_index, bound to numa_node
+    void worker(size_t thread_index, int numa_node);
 
-    void startTransfer(Slice *slice);
+    // Sends the slices over the connections to their peers, as many
+    // outstanding requests per connection. A slice whose connection breaks
+    // is retried once on another one. On io threads may_block must be
+    // false, peers are then only reached through cached endpoints.
+    void startTransfer(const std::vector<Slice *> &slices,
+                       bool may_block = true);
+
+    // Up to MC_TCP_CONNECTIONS_PER_PEER connections are opened to each peer
+    // and then used in turn. New connections are established in the
+    // background. Returns nullptr if the peer cannot be resolved.
+    std::shared_ptr<OutgoingConnection> getConnection(SegmentID target_id,
+                                                      bool may_block);
+
+    // Looks up the metadata of the peer unless its endpoint is cached or
+    // cached_only is set
+    int resolveEndpoint(SegmentID target_id, asio::ip::tcp::endpoint &endpoint,
+                        bool cached_only = false);
 
     const char *getName() const override { return "tcp"; }
 
    private:
     TcpContext *context_;
     std::atomic_bool running_;
-    std::thread thread_;
+    std::vector<std::thread> threads_;
 };
 }  // namespace mooncake
 
@@ -20,14 +20,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
 
 #include "common/base/status.h"
+#include "trace.h"
 #include "transfer_metadata.h"
 
 namespace mooncake {
@@ -106,6 +111,7 @@ class Transport {
             } local;
             struct {
                 uint64_t dest_addr;
+                uint32_t retry_cnt;
             } tcp;
             struct {
                 uint64_t offset;
@@ -121,16 +127,9 @@ class Transport {
         };
 
        public:
-        void markSuccess() {
-            status = Slice::SUCCESS;
-            __sync_fetch_and_add(&task->transferred_bytes, length);
-            __sync_fetch_and_add(&task->success_slice_count, 1);
-        }
+        void markSuccess();
 
-        void markFailed() {
-            status = Slice::FAILED;
-            __sync_fetch_and_add(&task->failed_slice_count, 1);
-        }
+        void markFailed();
 
         volatile uint64_t ts;
     };
@@ -182,10 +181,17 @@ class Transport {
         volatile uint64_t slice_count = 0;
         volatile uint64_t success_slice_count = 0;
         volatile uint64_t failed_slice_count = 0;
+        // Slices that have started to complete, ahead of the two counters
+        // above. Tells the last slice of the task it is the last.
+        volatile uint64_t completing_slice_count = 0;
         volatile uint64_t transferred_bytes = 0;
         volatile bool is_finished = false;
         uint64_t total_bytes = 0;
         BatchID batch_id = 0;
+        // Sampled request the task belongs to, 0 if not traced. Slices reach
+        // it through their task.
+        uint64_t trace_id = 0;
+        uint64_t submit_ns = 0;
 
         // record the slice list for freeing objects
         std::vector<Slice *> slice_list;
@@ -200,8 +206,21 @@ class Transport {
         size_t batch_size;
         std::vector<TransferTask> task_list;
         void *context;  // for transport implementers.
+
+        // Bumped and broadcast whenever a task of this batch finishes, so
+        // that waiters can sleep instead of polling getTransferStatus().
+        std::mutex completion_mutex;
+        std::condition_variable completion_cv;
+        uint64_t completion_epoch = 0;
+        // Called once, on the next finished task, for waiters that can't
+        // block on completion_cv, e.g. coroutines
+        std::vector<std::function<void()>> completion_callbacks;
     };
 
+    /// @brief Count one finished slice of a task. If that finishes the task,
+    /// wake up the waiters of its batch.
+    static void completeSlice(TransferTask *task, volatile uint64_t *counter);
+
    public:
     virtual ~Transport() {}
 
@@ -269,6 +288,55 @@ class Transport {
 
     virtual const char *getName() const = 0;
 };
+
+inline void Transport::completeSlice(TransferTask *task,
+                                     volatile uint64_t *counter) {
+    if (!task->batch_id) {
+        __sync_fetch_and_add(counter, 1);
+        return;
+    }
+    // Only the last slice of a task takes the batch lock. Once a waiter
+    // observes the task as finished it may free the batch, which takes the
+    // same lock first, so the last counter update happens under the lock.
+    const uint64_t completing =
+        __sync_add_and_fetch(&task->completing_slice_count, 1);
+    if (completing != task->slice_count) {
+        // The task can't be observed as finished before the last slice has
+        // counted itself, and nothing is touched after the update
+        __sync_fetch_and_add(counter, 1);
+        return;
+    }
+    auto &batch_desc = *((BatchDesc *)(task->batch_id));
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    // Slices that completed just before this one may still be about to count
+    // themselves, only a few instructions away
+    while (task->success_slice_count + task->failed_slice_count !=
+           completing - 1) {
+        std::this_thread::yield();
+    }
+    __sync_fetch_and_add(counter, 1);
+    if (task->trace_id) {
+        Tracer::instance().record(task->trace_id, "te.transfer",
+                                  task->submit_ns, Tracer::nowNs());
+    }
+    batch_desc.completion_epoch++;
+    batch_desc.completion_cv.notify_all();
+    for (auto &callback : batch_desc.completion_callbacks) {
+        callback();
+    }
+    batch_desc.completion_callbacks.clear();
+}
+
+inline void Transport::Slice::markSuccess() {
+    status = Slice::SUCCESS;
+    __sync_fetch_and_add(&task->transferred_bytes, length);
+    completeSlice(task, &task->success_slice_count);
+}
+
+inline void Transport::Slice::markFailed() {
+    status = Slice::FAILED;
+    completeSlice(task, &task->failed_slice_count);
+}
 }  // namespace mooncake
 
 #endif  // TRANSPORT_H_
@@ -242,6 +242,38 @@ void loadGlobalConfig(GlobalConfig &config) {
     if (std::getenv("MC_USE_IPV6")) {
         config.use_ipv6 = true;
     }
+
+    const char *tcp_connections_per_peer_env =
+        std::getenv("MC_TCP_CONNECTIONS_PER_PEER");
+    if (tcp_connections_per_peer_env) {
+        int val = atoi(tcp_connections_per_peer_env);
+        if (val > 0 && val <= 256)
+            config.tcp_connections_per_peer = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TCP_CONNECTIONS_PER_PEER";
+    }
+
+    const char *tcp_socket_buffer_size_env =
+        std::getenv("MC_TCP_SOCKET_BUFFER_SIZE");
+    if (tcp_socket_buffer_size_env) {
+        long long val = atoll(tcp_socket_buffer_size_env);
+        if (val >= 0 && val <= (1ll << 30))
+            config.tcp_socket_buffer_size = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TCP_SOCKET_BUFFER_SIZE";
+    }
+
+    const char *tcp_io_threads_env = std::getenv("MC_TCP_IO_THREADS");
+    if (tcp_io_threads_env) {
+        int val = atoi(tcp_io_threads_env);
+        if (val > 0 && val <= 256)
+            config.tcp_io_threads = val;
+        else
+            LOG(WARNING)
+                << "Ignore value from environment variable MC_TCP_IO_THREADS";
+    }
 }
 
 std::string mtuLengthToString(ibv_mtu mtu) {
@@ -60,6 +60,10 @@ Status MultiTransport::freeBatchID(BatchID batch_id) {
                 "BatchID cannot be freed until all tasks are done");
         }
     }
+    {
+        // Wait for a slice that is still signalling completion to let go
+        std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    }
     delete &batch_desc;
 #ifdef CONFIG_USE_BATCH_DESC_SET
     RWSpinlock::WriteGuard guard(batch_desc_lock_);
@@ -76,6 +80,9 @@ Status MultiTransport::submitTransfer(
             "Exceed the limitation of batch capacity");
     }
 
+    TraceSpan span("te.post_slices");
+    const uint64_t trace_id = Tracer::currentTraceId();
+    const uint64_t submit_ns = trace_id ? Tracer::nowNs() : 0;
     size_t task_id = batch_desc.task_list.size();
     batch_desc.task_list.resize(task_id + entries.size());
     struct SubmitTasks {
@@ -90,6 +97,8 @@ Status MultiTransport::submitTransfer(
         assert(transport);
         auto &task = batch_desc.task_list[task_id];
         task.batch_id = batch_id;
+        task.trace_id = trace_id;
+        task.submit_ns = submit_ns;
         ++task_id;
         submit_tasks[transport].request_list.push_back(
             (TransferRequest *)&request);
@@ -147,6 +156,34 @@ Status MultiTransport::getTransferStatus(BatchID batch_id, size_t task_id,
     return Status::OK();
 }
 
+uint64_t MultiTransport::getCompletionEpoch(BatchID batch_id) {
+    auto &batch_desc = *((BatchDesc *)(batch_id));
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    return batch_desc.completion_epoch;
+}
+
+void MultiTransport::waitTransferCompletion(BatchID batch_id, uint64_t epoch,
+                                            std::chrono::microseconds timeout) {
+    auto &batch_desc = *((BatchDesc *)(batch_id));
+    std::unique_lock<std::mutex> lock(batch_desc.completion_mutex);
+    batch_desc.completion_cv.wait_for(lock, timeout, [&] {
+        return batch_desc.completion_epoch != epoch;
+    });
+}
+
+void MultiTransport::addCompletionCallback(BatchID batch_id, uint64_t epoch,
+                                           std::function<void()> callback) {
+    auto &batch_desc = *((BatchDesc *)(batch_id));
+    {
+        std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+        if (batch_desc.completion_epoch == epoch) {
+            batch_desc.completion_callbacks.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
 Status MultiTransport::getBatchTransferStatus(BatchID batch_id, TransferStatus &status) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
     const size_t task_count = batch_desc.task_list.size();
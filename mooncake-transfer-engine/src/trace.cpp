@@ -0,0 +1,212 @@
+// Copyright 2024 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "trace.h"
+
+#include <glog/logging.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace mooncake {
+
+thread_local uint64_t Tracer::current_trace_id_ = 0;
+
+static std::mt19937_64 &threadRandom() {
+    thread_local std::mt19937_64 random(std::random_device{}());
+    return random;
+}
+
+Tracer &Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() {
+    const char *env_value = std::getenv("MC_TRACE_SAMPLE_RATE");
+    if (env_value) {
+        char *end = nullptr;
+        double rate = std::strtod(env_value, &end);
+        if (end != env_value && rate >= 0 && rate <= 1) {
+            setSampleRate(rate);
+            LOG(INFO) << "Tracing " << rate << " of the requests";
+        } else {
+            LOG(WARNING) << "Ignoring invalid MC_TRACE_SAMPLE_RATE="
+                         << env_value;
+        }
+    }
+}
+
+void Tracer::setSampleRate(double rate) {
+    uint64_t threshold = 0;
+    if (rate >= 1) {
+        threshold = UINT64_MAX;
+    } else if (rate > 0) {
+        threshold = static_cast<uint64_t>(rate * 18446744073709551616.0);
+    }
+    sample_threshold_.store(threshold, std::memory_order_relaxed);
+}
+
+double Tracer::sampleRate() const {
+    return sample_threshold_.load(std::memory_order_relaxed) /
+           18446744073709551616.0;
+}
+
+uint64_t Tracer::sample() {
+    const uint64_t threshold =
+        sample_threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) return 0;
+    auto &random = threadRandom();
+    if (threshold != UINT64_MAX && random() >= threshold) return 0;
+    uint64_t trace_id = random();
+    return trace_id ? trace_id : 1;
+}
+
+uint64_t Tracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+uint64_t Tracer::currentTraceId() { return current_trace_id_; }
+
+Tracer::Ring &Tracer::threadRing() {
+    // Returns the ring to the free list when the thread exits
+    struct RingHolder {
+        std::shared_ptr<Ring> ring;
+        ~RingHolder() {
+            if (!ring) return;
+            Tracer &tracer = Tracer::instance();
+            std::lock_guard<std::mutex> lock(tracer.rings_mutex_);
+            tracer.free_rings_.push_back(std::move(ring));
+        }
+    };
+    thread_local RingHolder holder;
+    if (!holder.ring) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        if (!free_rings_.empty()) {
+            holder.ring = std::move(free_rings_.back());
+            free_rings_.pop_back();
+        } else {
+            holder.ring = std::make_shared<Ring>();
+            rings_.push_back(holder.ring);
+        }
+        holder.ring->tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    }
+    return *holder.ring;
+}
+
+size_t Tracer::ringCount() const {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    return rings_.size();
+}
+
+void Tracer::record(uint64_t trace_id, const char *name, uint64_t start_ns,
+                    uint64_t end_ns) {
+    Ring &ring = threadRing();
+    // Only this thread writes the ring, readers validate slots by seq
+    const uint64_t index = ring.head.load(std::memory_order_relaxed);
+    Slot &slot = ring.slots[index % kRingSize];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.trace_id.store(trace_id, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.duration_ns.store(end_ns > start_ns ? end_ns - start_ns : 0,
+                           std::memory_order_relaxed);
+    slot.tid.store(ring.tid, std::memory_order_relaxed);
+    slot.seq.store(index + 1, std::memory_order_release);
+    ring.head.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> Tracer::events() const {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    std::vector<TraceEvent> events;
+    for (const auto &ring : rings) {
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        const uint64_t first = head > kRingSize ? head - kRingSize : 0;
+        for (uint64_t index = first; index < head; ++index) {
+            const Slot &slot = ring->slots[index % kRingSize];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != index + 1) continue;  // Overwritten or being written
+            TraceEvent event;
+            event.trace_id = slot.trace_id.load(std::memory_order_relaxed);
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+            event.duration_ns =
+                slot.duration_ns.load(std::memory_order_relaxed);
+            event.tid = slot.tid.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+// Chrome trace timestamps are in microseconds
+static void writeMicros(std::ostream &os, uint64_t ns) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lu.%03lu", (unsigned long)(ns / 1000),
+             (unsigned long)(ns % 1000));
+    os << buf;
+}
+
+std::string Tracer::dumpChromeTrace() const {
+    const pid_t pid = getpid();
+    std::ostringstream os;
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &event : events()) {
+        if (!first) os << ",";
+        first = false;
+        os << "{\"name\":\"" << event.name
+           << "\",\"cat\":\"mooncake\",\"ph\":\"X\",\"ts\":";
+        writeMicros(os, event.start_ns);
+        os << ",\"dur\":";
+        writeMicros(os, event.duration_ns);
+        os << ",\"pid\":" << pid << ",\"tid\":" << event.tid
+           << ",\"args\":{\"trace_id\":\"" << std::hex << event.trace_id
+           << std::dec << "\"}}";
+    }
+    os << "]}";
+    return os.str();
+}
+
+int Tracer::dumpChromeTrace(const std::string &path) const {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+        PLOG(ERROR) << "Failed to open trace file " << path;
+        return -1;
+    }
+    file << dumpChromeTrace();
+    if (!file) {
+        LOG(ERROR) << "Failed to write trace file " << path;
+        return -1;
+    }
+    return 0;
+}
+
+}  // namespace mooncake
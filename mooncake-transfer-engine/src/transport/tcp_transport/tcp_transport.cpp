@@ -21,182 +21,412 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 #include "common.h"
+#include "config.h"
 #include "transfer_engine.h"
 #include "transfer_metadata.h"
 #include "transport/transport.h"
 
 namespace mooncake {
 using tcpsocket = asio::ip::tcp::socket;
-const static size_t kDefaultBufferSize = 65536;
-
-struct SessionHeader {
-    uint64_t size;
-    uint64_t addr;
+const static size_t kDefaultIoThreadsPerNumaNode = 4;
+const static uint32_t kProtocolMagic = 0x5054434d;  // "MCTP"
+
+// Wire protocol: a connection carries any number of outstanding requests.
+// The initiator sends a RequestHeader per request, followed by the data of
+// writes; the target answers each one with a ResponseHeader, followed by the
+// data of reads. Responses are matched to requests by request_id and may
+// arrive in any order. All fields are little endian.
+struct RequestHeader {
+    uint32_t magic;
     uint8_t opcode;
+    uint8_t padding[3];
+    uint64_t request_id;
+    uint64_t addr;
+    uint64_t size;
 };
 
-struct Session : public std::enable_shared_from_this<Session> {
-    explicit Session(tcpsocket socket) : socket_(std::move(socket)) {}
+struct ResponseHeader {
+    uint32_t magic;
+    int32_t status;  // 0 on success
+    uint64_t request_id;
+    uint64_t size;  // Of the data that follows
+};
 
-    tcpsocket socket_;
-    SessionHeader header_;
-    uint64_t total_transferred_bytes_;
-    char *local_buffer_;
-    std::function<void(TransferStatusEnum)> on_finalize_;
-    std::mutex session_mutex_;
+static void setSocketOptions(tcpsocket &socket) {
+    asio::error_code ec;
+    socket.set_option(asio::ip::tcp::no_delay(true), ec);
+    if (ec) LOG(WARNING) << "Failed to set TCP_NODELAY: " << ec.message();
+    // Left to the kernel's autotuning by default
+    const size_t buffer_size = globalConfig().tcp_socket_buffer_size;
+    if (buffer_size) {
+        socket.set_option(asio::socket_base::send_buffer_size(buffer_size), ec);
+        socket.set_option(asio::socket_base::receive_buffer_size(buffer_size),
+                          ec);
+        if (ec)
+            LOG(WARNING) << "Failed to set socket buffer size: "
+                         << ec.message();
+    }
+}
 
-    void initiate(void *buffer, uint64_t dest_addr, size_t size,
-                  TransferRequest::OpCode opcode) {
-        session_mutex_.lock();
-        local_buffer_ = (char *)buffer;
-        header_.addr = htole64(dest_addr);
-        header_.size = htole64(size);
-        header_.opcode = (uint8_t)opcode;
-        total_transferred_bytes_ = 0;
-        writeHeader();
+// Writes frames in submission order. Frames queued while a write is in
+// progress are sent together by the next one, with a single gather write.
+// Only used from the io thread of the socket.
+class FrameWriter {
+   public:
+    using OnError = std::function<void(const asio::error_code &)>;
+
+    template <typename Header>
+    void queue(const Header &header, const void *data, size_t size) {
+        Frame frame;
+        static_assert(sizeof(Header) <= sizeof(frame.header));
+        memcpy(frame.header, &header, sizeof(Header));
+        frame.header_size = sizeof(Header);
+        frame.data = data;
+        frame.size = size;
+        queued_.push_back(frame);
     }
 
-    void onAccept() {
-        session_mutex_.lock();
-        total_transferred_bytes_ = 0;
-        readHeader();
+    void flush(tcpsocket &socket, std::shared_ptr<void> owner,
+               OnError on_error) {
+        if (writing_ || queued_.empty()) return;
+        writing_ = true;
+        sending_.swap(queued_);
+        buffers_.clear();
+        for (auto &frame : sending_) {
+            buffers_.emplace_back(frame.header, frame.header_size);
+            if (frame.size) buffers_.emplace_back(frame.data, frame.size);
+        }
+        asio::async_write(
+            socket, buffers_,
+            [this, &socket, owner, on_error](const asio::error_code &ec,
+                                             std::size_t) {
+                writing_ = false;
+                sending_.clear();
+                if (ec) {
+                    on_error(ec);
+                    return;
+                }
+                flush(socket, owner, on_error);
+            });
     }
 
    private:
-    void writeHeader() {
-        // LOG(INFO) << "writeHeader";
+    struct Frame {
+        char header[sizeof(RequestHeader)];
+        size_t header_size;
+        const void *data;
+        size_t size;
+    };
+
+    bool writing_ = false;
+    std::vector<Frame> queued_;
+    std::vector<Frame> sending_;
+    std::vector<asio::const_buffer> buffers_;
+};
+
+// Accepted connection, which serves the requests of one initiator. The next
+// request is read while the responses to earlier ones are being sent.
+class IncomingConnection
+    : public std::enable_shared_from_this<IncomingConnection> {
+   public:
+    explicit IncomingConnection(tcpsocket socket)
+        : socket_(std::move(socket)) {}
+
+    void start() { readRequest(); }
+
+   private:
+    void readRequest() {
         auto self(shared_from_this());
-        asio::async_write(
-            socket_, asio::buffer(&header_, sizeof(SessionHeader)),
+        asio::async_read(
+            socket_, asio::buffer(&request_, sizeof(RequestHeader)),
             [this, self](const asio::error_code &ec, std::size_t len) {
-                if (ec || len != sizeof(SessionHeader)) {
-                    LOG(ERROR)
-                        << "Session::writeHeader failed. Error: "
-                        << ec.message() << " (value: " << ec.value() << ")"
-                        << ", bytes written: " << len
-                        << ", expected: " << sizeof(SessionHeader);
-                    if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                if (ec == asio::error::eof && len == 0) {
+                    // The initiator closed the connection between requests
                     return;
                 }
-                if (header_.opcode == (uint8_t)TransferRequest::WRITE)
-                    writeBody();
-                else
-                    readBody();
+                if (ec || le32toh(request_.magic) != kProtocolMagic) {
+                    LOG(ERROR) << "IncomingConnection::readRequest failed. "
+                                  "Error: "
+                               << ec.message() << " (value: " << ec.value()
+                               << "), bytes read: " << len;
+                    close();
+                    return;
+                }
+                const uint64_t request_id = le64toh(request_.request_id);
+                char *addr = (char *)le64toh(request_.addr);
+                const uint64_t size = le64toh(request_.size);
+                if (request_.opcode == (uint8_t)TransferRequest::WRITE) {
+                    readData(request_id, addr, size);
+                } else {
+                    respond(request_id, addr, size);
+                    readRequest();
+                }
             });
     }
 
-    void readHeader() {
-        // LOG(INFO) << "readHeader";
+    void readData(uint64_t request_id, char *addr, uint64_t size) {
         auto self(shared_from_this());
         asio::async_read(
-            socket_, asio::buffer(&header_, sizeof(SessionHeader)),
-            [this, self](const asio::error_code &ec, std::size_t len) {
-                if (ec || len != sizeof(SessionHeader)) {
-                    LOG(ERROR)
-                        << "Session::readHeader failed. Error: " << ec.message()
-                        << " (value: " << ec.value() << ")"
-                        << ", bytes read: " << len
-                        << ", expected: " << sizeof(SessionHeader);
-                    if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+            socket_, asio::buffer(addr, size),
+            [this, self, request_id](const asio::error_code &ec,
+                                     std::size_t len) {
+                if (ec) {
+                    LOG(ERROR) << "IncomingConnection::readData failed. "
+                                  "Error: "
+                               << ec.message() << " (value: " << ec.value()
+                               << "), bytes read: " << len;
+                    close();
                     return;
                 }
-
-                local_buffer_ = (char *)(le64toh(header_.addr));
-                if (header_.opcode == (uint8_t)TransferRequest::WRITE)
-                    readBody();
-                else
-                    writeBody();
+                respond(request_id, nullptr, 0);
+                readRequest();
             });
     }
 
-    void writeBody() {
-        // LOG(INFO) << "writeBody";
+    void respond(uint64_t request_id, const char *data, uint64_t size) {
+        ResponseHeader header;
+        header.magic = htole32(kProtocolMagic);
+        header.status = 0;
+        header.request_id = htole64(request_id);
+        header.size = htole64(size);
+        writer_.queue(header, data, size);
         auto self(shared_from_this());
-        uint64_t size = le64toh(header_.size);
-        char *addr = local_buffer_;
-
-        size_t buffer_size =
-            std::min(kDefaultBufferSize, size - total_transferred_bytes_);
-        if (buffer_size == 0) {
-            if (on_finalize_) on_finalize_(TransferStatusEnum::COMPLETED);
-            session_mutex_.unlock();
-            return;
-        }
+        writer_.flush(socket_, self, [this, self](const asio::error_code &ec) {
+            LOG(ERROR) << "IncomingConnection::respond failed. Error: "
+                       << ec.message() << " (value: " << ec.value() << ")";
+            close();
+        });
+    }
 
-        asio::async_write(
-            socket_, asio::buffer(addr + total_transferred_bytes_, buffer_size),
-            [this, addr, self](const asio::error_code &ec,
-                               std::size_t transferred_bytes) {
+    void close() {
+        asio::error_code ec;
+        socket_.close(ec);
+    }
+
+    tcpsocket socket_;
+    RequestHeader request_;
+    FrameWriter writer_;
+};
+
+// Connection opened by the initiator to a peer. Slices may be submitted from
+// any thread, everything else runs on the io thread of the socket. Requests
+// submitted before the connection is established are sent once it is.
+class OutgoingConnection
+    : public std::enable_shared_from_this<OutgoingConnection> {
+   public:
+    using Slice = Transport::Slice;
+    // Receives the slices left unfinished when the connection breaks
+    using OnClose = std::function<void(OutgoingConnection *,
+                                       std::vector<Slice *> &&)>;
+
+    OutgoingConnection(tcpsocket socket, OnClose on_close)
+        : socket_(std::move(socket)), on_close_(std::move(on_close)) {}
+
+    void connect(const asio::ip::tcp::endpoint &endpoint) {
+        auto self(shared_from_this());
+        asio::post(socket_.get_executor(), [this, self, endpoint]() {
+            socket_.async_connect(
+                endpoint, [this, self](const asio::error_code &ec) {
+                    if (ec) {
+                        close("connect", ec);
+                        return;
+                    }
+                    connected_ = true;
+                    setSocketOptions(socket_);
+                    readResponse();
+                    flush();
+                });
+        });
+    }
+
+    void submit(std::vector<Slice *> &&slices) {
+        auto self(shared_from_this());
+        asio::post(socket_.get_executor(),
+                   [this, self, slices = std::move(slices)]() mutable {
+                       if (closed_) {
+                           on_close_(this, std::move(slices));
+                           return;
+                       }
+                       for (auto slice : slices) send(slice);
+                       if (connected_) flush();
+                   });
+    }
+
+    // Only valid on the io thread, e.g. in the OnClose callback
+    bool connected() const { return connected_; }
+
+   private:
+    void flush() {
+        writer_.flush(
+            socket_, shared_from_this(),
+            [this](const asio::error_code &ec) { close("write", ec); });
+    }
+
+    void send(Slice *slice) {
+        const uint64_t request_id = next_request_id_++;
+        inflight_[request_id] = slice;
+        RequestHeader header;
+        header.magic = htole32(kProtocolMagic);
+        header.opcode = (uint8_t)slice->opcode;
+        memset(header.padding, 0, sizeof(header.padding));
+        header.request_id = htole64(request_id);
+        header.addr = htole64(slice->tcp.dest_addr);
+        header.size = htole64(slice->length);
+        if (slice->opcode == TransferRequest::WRITE)
+            writer_.queue(header, slice->source_addr, slice->length);
+        else
+            writer_.queue(header, nullptr, 0);
+    }
+
+    void readResponse() {
+        auto self(shared_from_this());
+        asio::async_read(
+            socket_, asio::buffer(&response_, sizeof(ResponseHeader)),
+            [this, self](const asio::error_code &ec, std::size_t) {
                 if (ec) {
-                    LOG(ERROR)
-                        << "Session::writeBody failed. Error: " << ec.message()
-                        << " (value: " << ec.value() << ")"
-                        << ", total_transferred_bytes_: "
-                        << total_transferred_bytes_
-                        << ", current transferred_bytes: " << transferred_bytes;
-                    if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                    close("read", ec);
                     return;
                 }
-                total_transferred_bytes_ += transferred_bytes;
-                writeBody();
+                auto it = inflight_.find(le64toh(response_.request_id));
+                if (le32toh(response_.magic) != kProtocolMagic ||
+                    it == inflight_.end()) {
+                    close("read", asio::error::invalid_argument);
+                    return;
+                }
+                Slice *slice = it->second;
+                const uint64_t size = le64toh(response_.size);
+                const bool has_data = slice->opcode == TransferRequest::READ;
+                if (response_.status || size != (has_data ? slice->length : 0)) {
+                    LOG(ERROR) << "OutgoingConnection: request failed on the "
+                                  "target, status: "
+                               << (int32_t)le32toh(response_.status);
+                    inflight_.erase(it);
+                    slice->markFailed();
+                    readResponse();
+                } else if (has_data) {
+                    readData(it->first, slice);
+                } else {
+                    inflight_.erase(it);
+                    slice->markSuccess();
+                    readResponse();
+                }
             });
     }
 
-    void readBody() {
-        // LOG(INFO) << "readBody";
+    // The slice stays in inflight_ while its data is read, so that it is
+    // handed back if the connection breaks. Requests submitted meanwhile may
+    // rehash inflight_, it is looked up again by request_id afterwards.
+    void readData(uint64_t request_id, Slice *slice) {
         auto self(shared_from_this());
-        uint64_t size = le64toh(header_.size);
-        char *addr = local_buffer_;
-
-        size_t buffer_size =
-            std::min(kDefaultBufferSize, size - total_transferred_bytes_);
-        if (buffer_size == 0) {
-            if (on_finalize_) on_finalize_(TransferStatusEnum::COMPLETED);
-            session_mutex_.unlock();
-            return;
-        }
-
         asio::async_read(
-            socket_, asio::buffer(addr + total_transferred_bytes_, buffer_size),
-            [this, addr, self](const asio::error_code &ec,
-                               std::size_t transferred_bytes) {
+            socket_, asio::buffer(slice->source_addr, slice->length),
+            [this, self, request_id, slice](const asio::error_code &ec,
+                                            std::size_t) {
                 if (ec) {
-                    LOG(ERROR)
-                        << "Session::readBody failed. Error: " << ec.message()
-                        << " (value: " << ec.value() << ")"
-                        << ", total_transferred_bytes_: "
-                        << total_transferred_bytes_
-                        << ", current transferred_bytes: " << transferred_bytes;
-                    if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                    close("read", ec);
                     return;
                 }
-                total_transferred_bytes_ += transferred_bytes;
-                readBody();
+                inflight_.erase(request_id);
+                slice->markSuccess();
+                readResponse();
             });
     }
+
+    void close(const char *operation, const asio::error_code &ec) {
+        if (closed_) return;
+        closed_ = true;
+        if (ec != asio::error::eof)
+            LOG(ERROR) << "OutgoingConnection: " << operation
+                       << " failed. Error: " << ec.message()
+                       << " (value: " << ec.value() << ")";
+        asio::error_code ignored;
+        socket_.close(ignored);
+        std::vector<Slice *> unfinished;
+        for (auto &entry : inflight_) unfinished.push_back(entry.second);
+        inflight_.clear();
+        on_close_(this, std::move(unfinished));
+    }
+
+    tcpsocket socket_;
+    OnClose on_close_;
+    bool connected_ = false;
+    bool closed_ = false;
+    uint64_t next_request_id_ = 0;
+    std::unordered_map<uint64_t, Slice *> inflight_;
+    ResponseHeader response_;
+    FrameWriter writer_;
 };
 
+// Each io_context is run by one thread. A connection stays on the
+// io_context it was created on, accepted and initiated connections are
+// spread over all of them in turn.
 struct TcpContext {
-    TcpContext(short port)
-        : acceptor(io_context,
-                   asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {}
+    TcpContext(short port, size_t num_io_threads)
+        : io_contexts(createIoContexts(num_io_threads)),
+          acceptor(*io_contexts[0],
+                   asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {
+        for (auto &io_context : io_contexts)
+            work_guards.push_back(asio::make_work_guard(*io_context));
+    }
+
+    static std::vector<std::unique_ptr<asio::io_context>> createIoContexts(
+        size_t count) {
+        std::vector<std::unique_ptr<asio::io_context>> io_contexts;
+        for (size_t i = 0; i < count; ++i)
+            io_contexts.push_back(std::make_unique<asio::io_context>(1));
+        return io_contexts;
+    }
+
+    asio::io_context &nextIoContext() {
+        return *io_contexts[next_io_context.fetch_add(
+                                std::memory_order_relaxed) %
+                            io_contexts.size()];
+    }
 
     void doAccept() {
-        acceptor.async_accept([this](asio::error_code ec, tcpsocket socket) {
-            if (!ec) std::make_shared<Session>(std::move(socket))->onAccept();
-            doAccept();
-        });
+        acceptor.async_accept(
+            nextIoContext(), [this](asio::error_code ec, tcpsocket socket) {
+                // The acceptor has been closed
+                if (ec == asio::error::operation_aborted) return;
+                // Accept the next connection whatever happens to this one
+                if (!ec) {
+                    try {
+                        setSocketOptions(socket);
+                        std::make_shared<IncomingConnection>(std::move(socket))
+                            ->start();
+                    } catch (std::exception &e) {
+                        LOG(ERROR) << "TcpContext::doAccept failed to start "
+                                      "a connection: "
+                                   << e.what();
+                    }
+                } else {
+                    LOG(WARNING) << "TcpContext::doAccept failed: "
+                                 << ec.message();
+                }
+                doAccept();
+            });
     }
 
-    asio::io_context io_context;
+    struct Peer {
+        std::vector<std::shared_ptr<OutgoingConnection>> connections;
+        size_t next = 0;
+    };
+
+    std::vector<std::unique_ptr<asio::io_context>> io_contexts;
+    // Keep the threads running while there is nothing to do
+    std::vector<asio::executor_work_guard<asio::io_context::executor_type>>
+        work_guards;
     asio::ip::tcp::acceptor acceptor;
+    std::atomic<size_t> next_io_context{0};
+
+    std::mutex pool_mutex;
+    std::unordered_map<SegmentID, Peer> peers;
+    // Resolved listening endpoint of each peer
+    std::unordered_map<SegmentID, asio::ip::tcp::endpoint> endpoints;
 };
 
 TcpTransport::TcpTransport() : context_(nullptr), running_(false) {
@@ -206,8 +436,8 @@ TcpTransport::TcpTransport() : context_(nullptr), running_(false) {
 TcpTransport::~TcpTransport() {
     if (running_) {
         running_ = false;
-        context_->io_context.stop();
-        thread_.join();
+        for (auto &io_context : context_->io_contexts) io_context->stop();
+        for (auto &thread : threads_) thread.join();
     }
 
     if (context_) {
@@ -237,11 +467,21 @@ int TcpTransport::install(std::string &local_server_name,
         return -1;
     }
 
+    const int num_numa_nodes =
+        numa_available() == 0 ? numa_num_configured_nodes() : 1;
+    size_t num_io_threads = globalConfig().tcp_io_threads;
+    if (!num_io_threads)
+        num_io_threads = kDefaultIoThreadsPerNumaNode * num_numa_nodes;
+
     int tcp_port = meta->localRpcMeta().rpc_port + 1;
-    LOG(INFO) << "TcpTransport: listen on port " << tcp_port;
-    context_ = new TcpContext(tcp_port);
+    LOG(INFO) << "TcpTransport: listen on port " << tcp_port << " with "
+              << num_io_threads << " io threads";
+    context_ = new TcpContext(tcp_port, num_io_threads);
+    context_->doAccept();
     running_ = true;
-    thread_ = std::thread(&TcpTransport::worker, this);
+    for (size_t i = 0; i < num_io_threads; ++i)
+        threads_.emplace_back(&TcpTransport::worker, this, i,
+                              i % num_numa_nodes);
     return 0;
 }
 
@@ -324,6 +564,8 @@ Status TcpTransport::submitTransfer(
 
     size_t task_id = batch_desc.task_list.size();
     batch_desc.task_list.resize(task_id + entries.size());
+    std::vector<Slice *> slices;
+    slices.reserve(entries.size());
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
@@ -338,10 +580,12 @@ Status TcpTransport::submitTransfer(
         slice->target_id = request.target_id;
         slice->status = Slice::PENDING;
         slice->ts = 0;
+        slice->tcp.retry_cnt = 0;
         task.slice_list.push_back(slice);
         __sync_fetch_and_add(&task.slice_count, 1);
-        startTransfer(slice);
+        slices.push_back(slice);
     }
+    startTransfer(slices);
 
     return Status::OK();
 }
@@ -349,6 +593,8 @@ Status TcpTransport::submitTransfer(
 Status TcpTransport::submitTransferTask(
     const std::vector<TransferRequest *> &request_list,
     const std::vector<TransferTask *> &task_list) {
+    std::vector<Slice *> slices;
+    slices.reserve(request_list.size());
     for (size_t index = 0; index < request_list.size(); ++index) {
         auto &request = *request_list[index];
         auto &task = *task_list[index];
@@ -362,68 +608,163 @@ Status TcpTransport::submitTransferTask(
         slice->target_id = request.target_id;
         slice->status = Slice::PENDING;
         slice->ts = 0;
+        slice->tcp.retry_cnt = 0;
         task.slice_list.push_back(slice);
         __sync_fetch_and_add(&task.slice_count, 1);
-        startTransfer(slice);
+        slices.push_back(slice);
     }
+    startTransfer(slices);
     return Status::OK();
 }
 
-void TcpTransport::worker() {
+void TcpTransport::worker(size_t thread_index, int numa_node) {
+    if (numa_available() == 0) bindToSocket(numa_node);
+    auto &io_context = *context_->io_contexts[thread_index];
     while (running_) {
         try {
-            context_->doAccept();
-            context_->io_context.run();
+            io_context.run();
         } catch (std::exception &e) {
             LOG(ERROR) << "TcpTransport::worker encountered an exception "
-                          "during doAccept/run: "
+                          "during run: "
                        << e.what();
         }
     }
 }
 
-void TcpTransport::startTransfer(Slice *slice) {
-    try {
-        asio::ip::tcp::resolver resolver(context_->io_context);
-        asio::ip::tcp::socket socket(context_->io_context);
-        auto desc = metadata_->getSegmentDescByID(slice->target_id);
-        if (!desc) {
-            LOG(ERROR) << "TcpTransport::startTransfer failed to get segment "
-                          "description for target_id: "
-                       << slice->target_id;
-            slice->markFailed();
-            return;
+int TcpTransport::resolveEndpoint(SegmentID target_id,
+                                  asio::ip::tcp::endpoint &endpoint,
+                                  bool cached_only) {
+    {
+        std::lock_guard<std::mutex> lock(context_->pool_mutex);
+        auto it = context_->endpoints.find(target_id);
+        if (it != context_->endpoints.end()) {
+            endpoint = it->second;
+            return 0;
         }
+    }
+    if (cached_only) {
+        LOG(ERROR) << "TcpTransport::resolveEndpoint no cached endpoint for "
+                      "target_id: "
+                   << target_id;
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) {
+        LOG(ERROR) << "TcpTransport::resolveEndpoint failed to get segment "
+                      "description for target_id: "
+                   << target_id;
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    TransferMetadata::RpcMetaDesc meta_entry;
+    if (metadata_->getRpcMetaEntry(desc->name, meta_entry)) {
+        LOG(ERROR) << "TcpTransport::resolveEndpoint failed to get RPC meta "
+                      "entry for segment name: "
+                   << desc->name;
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    asio::ip::tcp::resolver resolver(*context_->io_contexts[0]);
+    asio::error_code ec;
+    auto results =
+        resolver.resolve(asio::ip::tcp::v4(), meta_entry.ip_or_host_name,
+                         std::to_string(meta_entry.rpc_port + 1), ec);
+    if (ec || results.empty()) {
+        LOG(ERROR) << "TcpTransport::resolveEndpoint failed to resolve "
+                   << meta_entry.ip_or_host_name << ": " << ec.message();
+        return ERR_INVALID_ARGUMENT;
+    }
+    endpoint = results.begin()->endpoint();
+
+    std::lock_guard<std::mutex> lock(context_->pool_mutex);
+    context_->endpoints[target_id] = endpoint;
+    return 0;
+}
+
+std::shared_ptr<OutgoingConnection> TcpTransport::getConnection(
+    SegmentID target_id, bool may_block) {
+    const size_t max_connections = globalConfig().tcp_connections_per_peer;
+    {
+        std::lock_guard<std::mutex> lock(context_->pool_mutex);
+        auto &peer = context_->peers[target_id];
+        if (peer.connections.size() >= max_connections)
+            return peer.connections[peer.next++ % peer.connections.size()];
+    }
+
+    asio::ip::tcp::endpoint endpoint;
+    if (resolveEndpoint(target_id, endpoint, !may_block)) return nullptr;
+
+    auto connection = std::make_shared<OutgoingConnection>(
+        tcpsocket(context_->nextIoContext()),
+        [this, target_id](OutgoingConnection *connection,
+                          std::vector<Slice *> &&slices) {
+            {
+                std::lock_guard<std::mutex> lock(context_->pool_mutex);
+                auto &connections = context_->peers[target_id].connections;
+                for (auto it = connections.begin(); it != connections.end();
+                     ++it) {
+                    if (it->get() == connection) {
+                        connections.erase(it);
+                        break;
+                    }
+                }
+                // The peer may have restarted elsewhere, resolve it again
+                if (!connection->connected())
+                    context_->endpoints.erase(target_id);
+            }
+            // Requests are idempotent, send them once more on a new
+            // connection in case the peer closed this one while it was idle
+            std::vector<Slice *> retry;
+            for (auto slice : slices) {
+                if (slice->tcp.retry_cnt++ == 0)
+                    retry.push_back(slice);
+                else
+                    slice->markFailed();
+            }
+            // Not from within the callback, which runs on an io thread and
+            // may be inside a handler of this connection
+            if (!retry.empty())
+                asio::post(context_->nextIoContext(), [this, retry]() {
+                    startTransfer(retry, /*may_block=*/false);
+                });
+        });
+
+    {
+        // Checked again, other threads may have opened connections while
+        // the endpoint was resolved
+        std::lock_guard<std::mutex> lock(context_->pool_mutex);
+        auto &peer = context_->peers[target_id];
+        if (peer.connections.size() >= max_connections)
+            return peer.connections[peer.next++ % peer.connections.size()];
+        peer.connections.push_back(connection);
+    }
+    connection->connect(endpoint);
+    return connection;
+}
 
-        TransferMetadata::RpcMetaDesc meta_entry;
-        if (metadata_->getRpcMetaEntry(desc->name, meta_entry)) {
-            LOG(ERROR) << "TcpTransport::startTransfer failed to get RPC meta "
-                          "entry for segment name: "
-                       << desc->name;
-            slice->markFailed();
-            return;
+void TcpTransport::startTransfer(const std::vector<Slice *> &slices,
+                                 bool may_block) {
+    std::unordered_map<SegmentID, std::vector<Slice *>> slices_by_target;
+    for (auto slice : slices)
+        slices_by_target[slice->target_id].push_back(slice);
+
+    for (auto &[target_id, target_slices] : slices_by_target) {
+        // Spread the slices over the connections to the peer, so that they
+        // are sent and received by several io threads
+        const size_t num_connections = std::min(
+            target_slices.size(), globalConfig().tcp_connections_per_peer);
+        for (size_t i = 0; i < num_connections; ++i) {
+            std::vector<Slice *> part;
+            for (size_t j = i; j < target_slices.size(); j += num_connections)
+                part.push_back(target_slices[j]);
+            auto connection = getConnection(target_id, may_block);
+            if (!connection) {
+                for (auto slice : part) slice->markFailed();
+                continue;
+            }
+            connection->submit(std::move(part));
         }
-        auto endpoint_iterator =
-            resolver.resolve(asio::ip::tcp::v4(), meta_entry.ip_or_host_name,
-                             std::to_string(meta_entry.rpc_port + 1));
-        asio::connect(socket, endpoint_iterator);
-        auto session = std::make_shared<Session>(std::move(socket));
-        session->on_finalize_ = [slice](TransferStatusEnum status) {
-            if (status == TransferStatusEnum::COMPLETED)
-                slice->markSuccess();
-            else
-                slice->markFailed();
-        };
-        session->initiate(slice->source_addr, slice->tcp.dest_addr,
-                          slice->length, slice->opcode);
-    } catch (std::exception &e) {
-        LOG(ERROR) << "TcpTransport::startTransfer encountered an ASIO "
-                      "exception. Slice details - source_addr: "
-                   << slice->source_addr << ", length: " << slice->length
-                   << ", opcode: " << (int)slice->opcode
-                   << ", target_id: " << slice->target_id
-                   << ". Exception: " << e.what();
-        slice->markFailed();
     }
 }
 }  // namespace mooncake
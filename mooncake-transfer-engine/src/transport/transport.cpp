@@ -49,6 +49,10 @@ Status Transport::freeBatchID(BatchID batch_id) {
                 "BatchID cannot be freed until all tasks are done");
         }
     }
+    {
+        // Wait for a slice that is still signalling completion to let go
+        std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    }
     delete &batch_desc;
 #ifdef CONFIG_USE_BATCH_DESC_SET
     RWSpinlock::WriteGuard guard(batch_desc_lock_);
@@ -341,6 +341,74 @@ TEST_F(TCPTransportTest, WriteAndRead2test) {
                            kDataLength));
 }
 
+// Many small slices in flight and in sequence, which share the pooled
+// connections to the peer
+TEST_F(TCPTransportTest, ManySmallTransferstest) {
+    const size_t kBlockSize = 4096;
+    const size_t kBatchSize = 64;
+    const size_t kDataLength = kBlockSize * kBatchSize;
+    void *addr = nullptr;
+    const size_t ram_buffer_size = 1ull << 30;
+    // disable topology auto discovery for testing.
+    auto engine = std::make_unique<TransferEngine>(false);
+    auto hostname_port = parseHostNameWithPort(local_server_name);
+    engine->init(metadata_server, local_server_name,
+                 hostname_port.first.c_str(), hostname_port.second);
+    Transport *xport = nullptr;
+    xport = engine->installTransport("tcp", nullptr);
+    LOG_ASSERT(xport != nullptr);
+
+    addr = allocateMemoryPool(ram_buffer_size, 0, false);
+    int rc = engine->registerLocalMemory(addr, ram_buffer_size, "cpu:0");
+    LOG_ASSERT(!rc);
+
+    auto segment_id = engine->openSegment(local_server_name);
+    auto segment_desc = engine->getMetadata()->getSegmentDescByID(segment_id);
+    uint64_t remote_base = (uint64_t)segment_desc->buffers[0].addr;
+    // The target is this process, its region follows the local data
+    uint8_t *local = (uint8_t *)(addr);
+    uint8_t *remote = (uint8_t *)(remote_base) + kDataLength;
+
+    auto transfer = [&](TransferRequest::OpCode opcode) {
+        auto batch_id = engine->allocateBatchID(kBatchSize);
+        std::vector<TransferRequest> requests;
+        for (size_t i = 0; i < kBatchSize; ++i) {
+            TransferRequest entry;
+            entry.opcode = opcode;
+            entry.length = kBlockSize;
+            entry.source = local + i * kBlockSize;
+            entry.target_id = segment_id;
+            entry.target_offset = (uint64_t)(remote + i * kBlockSize);
+            requests.push_back(entry);
+        }
+        Status s = engine->submitTransfer(batch_id, requests);
+        ASSERT_EQ(s, Status::OK());
+        for (size_t task_id = 0; task_id < kBatchSize; ++task_id) {
+            TransferStatus status;
+            do {
+                s = engine->getTransferStatus(batch_id, task_id, status);
+                ASSERT_EQ(s, Status::OK());
+                ASSERT_NE(status.s, TransferStatusEnum::FAILED);
+            } while (status.s != TransferStatusEnum::COMPLETED);
+        }
+        s = engine->freeBatchID(batch_id);
+        ASSERT_EQ(s, Status::OK());
+    };
+
+    for (int round = 0; round < 20; ++round) {
+        for (size_t offset = 0; offset < kDataLength; ++offset)
+            remote[offset] = 'a' + lrand48() % 26;
+        transfer(TransferRequest::READ);
+        ASSERT_EQ(0, memcmp(local, remote, kDataLength));
+
+        for (size_t offset = 0; offset < kDataLength; ++offset)
+            local[offset] = 'a' + lrand48() % 26;
+        transfer(TransferRequest::WRITE);
+        // A write completes once the target has acknowledged it
+        ASSERT_EQ(0, memcmp(local, remote, kDataLength));
+    }
+}
+
 }  // namespace mooncake
 
 int main(int argc, char **argv) {
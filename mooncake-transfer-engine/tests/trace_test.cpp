@@ -0,0 +1,129 @@
+#include "trace.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <thread>
+
+namespace mooncake {
+
+static std::vector<TraceEvent> eventsOf(uint64_t trace_id) {
+    std::vector<TraceEvent> result;
+    for (auto &event : Tracer::instance().events()) {
+        if (event.trace_id == trace_id) result.push_back(event);
+    }
+    return result;
+}
+
+TEST(TraceTest, Sampling) {
+    auto &tracer = Tracer::instance();
+    tracer.setSampleRate(0);
+    for (int i = 0; i < 1000; ++i) ASSERT_EQ(tracer.sample(), 0u);
+    tracer.setSampleRate(1);
+    for (int i = 0; i < 1000; ++i) ASSERT_NE(tracer.sample(), 0u);
+    tracer.setSampleRate(0.5);
+    EXPECT_DOUBLE_EQ(tracer.sampleRate(), 0.5);
+    int sampled = 0;
+    for (int i = 0; i < 10000; ++i) sampled += tracer.sample() != 0;
+    EXPECT_GT(sampled, 4000);
+    EXPECT_LT(sampled, 6000);
+    tracer.setSampleRate(0);
+}
+
+TEST(TraceTest, ScopeAndSpan) {
+    const uint64_t trace_id = 0x5ca1ab1e;
+    EXPECT_EQ(Tracer::currentTraceId(), 0u);
+    {
+        TraceScope scope(trace_id);
+        EXPECT_EQ(Tracer::currentTraceId(), trace_id);
+        TraceSpan span("test.span");
+    }
+    EXPECT_EQ(Tracer::currentTraceId(), 0u);
+    { TraceSpan untraced("test.untraced"); }
+
+    auto events = eventsOf(trace_id);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_STREQ(events[0].name, "test.span");
+    for (auto &event : Tracer::instance().events()) {
+        EXPECT_STRNE(event.name, "test.untraced");
+    }
+}
+
+TEST(TraceTest, RingWraparound) {
+    const uint64_t trace_id = 0xfeed;
+    const size_t total = Tracer::kRingSize + 100;
+    std::thread writer([&] {
+        for (size_t i = 0; i < total; ++i) {
+            Tracer::instance().record(trace_id, "test.wrap", i, i + 1);
+        }
+    });
+    writer.join();
+
+    // Only the newest kRingSize events survive, and they outlive the thread
+    auto events = eventsOf(trace_id);
+    ASSERT_EQ(events.size(), Tracer::kRingSize);
+    EXPECT_EQ(events.front().start_ns, total - Tracer::kRingSize);
+    EXPECT_EQ(events.back().start_ns, total - 1);
+    EXPECT_EQ(events.back().duration_ns, 1u);
+}
+
+TEST(TraceTest, RingReuse) {
+    const uint64_t trace_id = 0x4e4e;
+    const int threads = 16;
+    std::thread first([&] {
+        Tracer::instance().record(trace_id, "test.reuse", 0, 1);
+    });
+    first.join();
+    const size_t rings = Tracer::instance().ringCount();
+    for (int i = 1; i < threads; ++i) {
+        std::thread writer([&] {
+            Tracer::instance().record(trace_id, "test.reuse", i, i + 1);
+        });
+        writer.join();
+    }
+
+    // Threads running one after another share a ring, and their events keep
+    // the id of the thread that recorded them
+    EXPECT_EQ(Tracer::instance().ringCount(), rings);
+    auto events = eventsOf(trace_id);
+    ASSERT_EQ(events.size(), size_t(threads));
+    std::set<uint32_t> tids;
+    for (auto &event : events) tids.insert(event.tid);
+    EXPECT_EQ(tids.size(), size_t(threads));
+}
+
+TEST(TraceTest, ConcurrentDump) {
+    const uint64_t trace_id = 0xc0ffee;
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        uint64_t i = 0;
+        while (!stop.load()) {
+            Tracer::instance().record(trace_id, "test.concurrent", i, i + 10);
+            ++i;
+        }
+    });
+    for (int round = 0; round < 100; ++round) {
+        for (auto &event : eventsOf(trace_id)) {
+            ASSERT_STREQ(event.name, "test.concurrent");
+            ASSERT_EQ(event.duration_ns, 10u);
+        }
+    }
+    stop = true;
+    writer.join();
+}
+
+TEST(TraceTest, ChromeTrace) {
+    Tracer::instance().record(0xabc, "test.chrome", 1234567, 1240000);
+    std::string json = Tracer::instance().dumpChromeTrace();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0),
+              0u);
+    EXPECT_NE(json.find("{\"name\":\"test.chrome\",\"cat\":\"mooncake\","
+                        "\"ph\":\"X\",\"ts\":1234.567,\"dur\":5.433,"),
+              std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"trace_id\":\"abc\"}}"),
+              std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 2), "]}");
+}
+
+}  // namespace mooncake
@@ -21,6 +21,8 @@
 #include <fstream>
 #include <iomanip>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "transfer_engine.h"
 #include "transport/transport.h"
@@ -171,6 +173,73 @@ TEST_F(TransportTest, ReadEmptyFile) {
 
     close(fd);
 }
+
+// Slices completing on several threads wake up the waiter of their batch,
+// which frees the batch as soon as it sees every task finished
+TEST_F(TransportTest, CompletionWakesWaiter) {
+    const size_t kTasks = 16;
+    const size_t kSlicesPerTask = 64;
+    const size_t kWorkers = 8;
+    std::string local_server_name = "127.0.0.1:12345";
+    MultiTransport multi_transport(nullptr, local_server_name);
+
+    for (int round = 0; round < 50; ++round) {
+        auto batch_id = multi_transport.allocateBatchID(kTasks);
+        auto &batch_desc = *((Transport::BatchDesc *)(batch_id));
+        batch_desc.task_list.resize(kTasks);
+        std::vector<Transport::Slice> slices(kTasks * kSlicesPerTask);
+        for (size_t i = 0; i < slices.size(); ++i) {
+            auto &task = batch_desc.task_list[i / kSlicesPerTask];
+            task.batch_id = batch_id;
+            task.slice_count = kSlicesPerTask;
+            slices[i].task = &task;
+            slices[i].length = 1;
+        }
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < kWorkers; ++w) {
+            workers.emplace_back([&slices, w] {
+                for (size_t i = w; i < slices.size(); i += kWorkers) {
+                    // One failed slice fails the first task only
+                    if (i == 0)
+                        slices[i].markFailed();
+                    else
+                        slices[i].markSuccess();
+                }
+            });
+        }
+
+        // The timeout is far longer than the test, only wakeups end the wait
+        const auto start = std::chrono::steady_clock::now();
+        size_t finished = 0;
+        while (finished < kTasks) {
+            const uint64_t epoch =
+                multi_transport.getCompletionEpoch(batch_id);
+            finished = 0;
+            for (size_t task_id = 0; task_id < kTasks; ++task_id) {
+                Transport::TransferStatus status;
+                ASSERT_TRUE(multi_transport
+                                .getTransferStatus(batch_id, task_id, status)
+                                .ok());
+                if (status.s == Transport::TransferStatusEnum::WAITING)
+                    continue;
+                EXPECT_EQ(status.s,
+                          task_id ? Transport::TransferStatusEnum::COMPLETED
+                                  : Transport::TransferStatusEnum::FAILED);
+                ++finished;
+            }
+            if (finished < kTasks)
+                multi_transport.waitTransferCompletion(
+                    batch_id, epoch, std::chrono::seconds(30));
+        }
+        EXPECT_LT(std::chrono::steady_clock::now() - start,
+                  std::chrono::seconds(10));
+
+        // The last slices may still be returning from markSuccess
+        ASSERT_TRUE(multi_transport.freeBatchID(batch_id).ok());
+        for (auto &worker : workers) worker.join();
+    }
+}
 }  // namespace mooncake
 
 int main(int argc, char** argv) {
@@ -163,6 +163,75 @@ class TestDistributedObjectStore(unittest.TestCase):
         time.sleep(DEFAULT_KV_LEASE_TTL / 1000)
         self.assertEqual(self.store.remove(key), 0)
 
+    def test_get_buffer_operations(self):
+        """Test get_buffer for values that span one and several slices."""
+        for size in [64 * 1024, 20 * 1024 * 1024]:
+            key = f"test_get_buffer_key_{size}"
+            test_data = os.urandom(size)
+            self.assertEqual(self.store.put(key, test_data), 0)
+
+            buffer = self.store.get_buffer(key)
+            self.assertIsNotNone(buffer)
+            self.assertEqual(len(buffer), size)
+            self.assertEqual(memoryview(buffer).tobytes(), test_data)
+            self.assertEqual(self.store.get(key), test_data)
+            del buffer
+
+            time.sleep(DEFAULT_KV_LEASE_TTL / 1000)
+            self.assertEqual(self.store.remove(key), 0)
+
+        self.assertIsNone(self.store.get_buffer("test_get_buffer_missing"))
+
+    def test_batch_zero_copy_operations(self):
+        """Test batch_put_from, batch_get_into and batch_put operations."""
+        import ctypes
+
+        num_keys = 4
+        keys = [f"test_batch_zero_copy_key_{i}" for i in range(num_keys)]
+        values = [os.urandom(16 * 1024 + i) for i in range(num_keys)]
+
+        # One registered buffer per key
+        buffer_size = 32 * 1024
+        buffers = [(ctypes.c_ubyte * buffer_size)() for _ in range(num_keys)]
+        buffer_ptrs = [ctypes.addressof(buffer) for buffer in buffers]
+        for ptr in buffer_ptrs:
+            self.assertEqual(self.store.register_buffer(ptr, buffer_size), 0)
+        for buffer, value in zip(buffers, values):
+            ctypes.memmove(buffer, value, len(value))
+
+        # Put all keys from the buffers in one call
+        result = self.store.batch_put_from(keys, buffer_ptrs,
+                                           [len(v) for v in values])
+        self.assertEqual(result, 0, "batch_put_from should succeed")
+        for key, value in zip(keys, values):
+            self.assertEqual(self.store.get(key), value)
+
+        # Read all keys back into the cleared buffers
+        for buffer in buffers:
+            ctypes.memset(buffer, 0, buffer_size)
+        results = self.store.batch_get_into(keys, buffer_ptrs,
+                                            [buffer_size] * num_keys)
+        self.assertEqual(results, [len(v) for v in values])
+        for buffer, value in zip(buffers, values):
+            self.assertEqual(bytes(buffer[:len(value)]), value)
+
+        # Duplicate keys are rejected
+        results = self.store.batch_get_into([keys[0], keys[0]],
+                                            buffer_ptrs[:2],
+                                            [buffer_size] * 2)
+        self.assertTrue(all(r < 0 for r in results))
+
+        # batch_put takes any bytes-like objects
+        put_keys = [f"test_batch_put_key_{i}" for i in range(num_keys)]
+        self.assertEqual(self.store.batch_put(put_keys, values), 0)
+        for key, value in zip(put_keys, values):
+            self.assertEqual(self.store.get(key), value)
+
+        # Cleanup
+        time.sleep(DEFAULT_KV_LEASE_TTL / 1000)
+        self.assertEqual(self.store.batch_remove(keys + put_keys),
+                         [0] * (2 * num_keys))
+
 
     def test_concurrent_stress_with_barrier(self):
         """Test concurrent Put/Get operations with multiple threads using barrier."""